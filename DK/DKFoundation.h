@@ -29,6 +29,8 @@ namespace DKFoundation {}
 #include "DKFoundation/DKAllocator.h"
 #include "DKFoundation/DKAllocatorChain.h"
 #include "DKFoundation/DKFixedSizeAllocator.h"
+#include "DKFoundation/DKArenaAllocator.h"
+#include "DKFoundation/DKAllocationTracker.h"
 #include "DKFoundation/DKTypes.h"
 #include "DKFoundation/DKTypeInfo.h"
 #include "DKFoundation/DKTypeList.h"
@@ -38,12 +40,16 @@ namespace DKFoundation {}
 
 // unicode string
 #include "DKFoundation/DKString.h"
+#include "DKFoundation/DKAtom.h"
 #include "DKFoundation/DKStringU8.h"
 
 // data collections
 #include "DKFoundation/DKArray.h"
 #include "DKFoundation/DKBitArray.h"
 #include "DKFoundation/DKCircularQueue.h"
+#include "DKFoundation/DKHashMap.h"
+#include "DKFoundation/DKHashSet.h"
+#include "DKFoundation/DKHashTable.h"
 #include "DKFoundation/DKLinkedList.h"
 #include "DKFoundation/DKMap.h"
 #include "DKFoundation/DKOrderedArray.h"
@@ -76,20 +82,25 @@ namespace DKFoundation {}
 #include "DKFoundation/DKDataStream.h"
 #include "DKFoundation/DKBuffer.h"
 #include "DKFoundation/DKBufferStream.h"
+#include "DKFoundation/DKBufferedStream.h"
+#include "DKFoundation/DKBufferChain.h"
 
 // file, file-map, and directory
 #include "DKFoundation/DKFile.h"
 #include "DKFoundation/DKFileMap.h"
+#include "DKFoundation/DKAsyncIO.h"
 #include "DKFoundation/DKDirectory.h"
 
 // compressor, archiver
 #include "DKFoundation/DKCompressor.h"
 #include "DKFoundation/DKZipArchiver.h"
 #include "DKFoundation/DKZipUnarchiver.h"
+#include "DKFoundation/DKPackArchive.h"
 
 // XML
 #include "DKFoundation/DKXmlParser.h"
 #include "DKFoundation/DKXmlDocument.h"
+#include "DKFoundation/DKXmlReader.h"
 
 // date time, timer
 #include "DKFoundation/DKTimer.h"
@@ -102,6 +113,7 @@ namespace DKFoundation {}
 // operation, invocation (function utilities)
 #include "DKFoundation/DKFunction.h"
 #include "DKFoundation/DKInvocation.h"
+#include "DKFoundation/DKInlineFunction.h"
 #include "DKFoundation/DKOperation.h"
 #include "DKFoundation/DKValue.h"
 
@@ -115,4 +127,5 @@ namespace DKFoundation {}
 #include "DKFoundation/DKError.h"
 #include "DKFoundation/DKLog.h"
 #include "DKFoundation/DKLogger.h"
+#include "DKFoundation/DKProfiler.h"
 #include "DKFoundation/DKUtils.h"
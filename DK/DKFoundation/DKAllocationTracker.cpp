@@ -0,0 +1,428 @@
+//
+//  File: DKAllocationTracker.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__) || (defined(__linux__) && defined(__GLIBC__))
+#include <execinfo.h>
+#define DKGL_ALLOCATION_TRACKER_BACKTRACE 1
+#endif
+
+#include "DKAllocationTracker.h"
+#include "DKAtomicNumber32.h"
+#include "DKHashMap.h"
+#include "DKMap.h"
+#include "DKSpinLock.h"
+#include "DKCriticalSection.h"
+#include "DKDummyLock.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		// used by DKMemory.cpp, DKObjectRefCounter.cpp
+		DKAtomicNumber32 allocationTrackingEnabled = 0;
+
+		static thread_local const char* currentAllocationTag = NULL;
+		// thread is recording allocation, allocations of tracker are not tracked.
+		static thread_local bool allocationTrackerBusy = false;
+		static thread_local int64_t bytesUntilSample = 0;
+		static thread_local int32_t bytesUntilSampleGeneration = 0;	// sampleGeneration of bytesUntilSample
+		static thread_local uint64_t sampleRandomState = 0;
+
+		struct AllocationTagCounter
+		{
+			const char* tag;
+			size_t liveBytes;
+			size_t liveSamples;
+			uint64_t allocatedBytes;
+			uint64_t freedSamples;
+			double lifetime;
+		};
+
+		// storage of tracker does not use DKMemory functions, because
+		// tracked allocation could be made while allocator lock is held.
+		// (memory pool initialization)
+		struct AllocationTrackerAllocator
+		{
+			enum { Location = DKMemoryLocationCustom };
+			static void* Alloc(size_t s)			{ return ::malloc(s); }
+			static void* Realloc(void* p, size_t s)	{ return ::realloc(p, s); }
+			static void Free(void* p)				{ ::free(p); }
+		};
+
+		struct AllocationTracker
+		{
+			using Allocation = DKAllocationTracker::Allocation;
+			enum { FilterSize = 0x4000 };
+
+			DKSpinLock lock;
+			DKHashMap<const void*, Allocation, DKDummyLock,
+				DKHashKeyHasher<const void*>,
+				DKHashKeyComparator<const void*>,
+				DKMapValueReplacer<Allocation>,
+				AllocationTrackerAllocator> samples;
+			DKMap<const char*, AllocationTagCounter, DKDummyLock,
+				DKMapKeyComparator<const char*>,
+				DKMapValueReplacer<AllocationTagCounter>,
+				AllocationTrackerAllocator> tags;
+			uint64_t sequence = 0;
+			size_t sampleInterval = DKAllocationTracker::DefaultSampleInterval;
+			// increased by Enable(), each thread seeds its sample counter again.
+			DKAtomicNumber32 sampleGeneration;
+			bool captureCallStack = true;
+
+			// number of samples by address hash. frees of addresses not
+			// sampled can be skipped without locking.
+			DKAtomicNumber32 filter[FilterSize];
+
+			static size_t FilterIndex(const void* p)
+			{
+				uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p) >> 4) * 0x9e3779b97f4a7c15ULL;
+				return static_cast<size_t>(h >> 50);	// 14 bits
+			}
+			AllocationTagCounter& TagCounter(const char* tag)
+			{
+				auto* p = tags.Find(tag);
+				if (p == NULL)
+				{
+					AllocationTagCounter c = { tag, 0, 0, 0, 0, 0.0 };
+					tags.Insert(tag, c);
+					p = tags.Find(tag);
+				}
+				return p->value;
+			}
+			void ClearNL()
+			{
+				samples.Clear();
+				tags.Clear();
+				for (DKAtomicNumber32& n : filter)
+					n.Store(0);
+			}
+		};
+		static_assert((1 << 14) == AllocationTracker::FilterSize, "FilterIndex should be changed");
+
+		static AllocationTracker& Tracker()
+		{
+			static AllocationTracker tracker;
+			return tracker;
+		}
+
+		// scope which blocks recursive tracking.
+		struct AllocationTrackerBusyScope
+		{
+			AllocationTrackerBusyScope()	{ allocationTrackerBusy = true; }
+			~AllocationTrackerBusyScope()	{ allocationTrackerBusy = false; }
+		};
+
+		// exponential distribution of sample interval, average is interval.
+		static int64_t NextSampleInterval(size_t interval)
+		{
+			if (sampleRandomState == 0)
+				sampleRandomState = reinterpret_cast<uintptr_t>(&sampleRandomState) ^ DKTimer::SystemTick() ^ 0x2545f4914f6cdd1dULL;
+			// xorshift64
+			uint64_t x = sampleRandomState;
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			sampleRandomState = x;
+			double u = static_cast<double>((x >> 11) + 1) / static_cast<double>(1ULL << 53);	// (0, 1]
+			return static_cast<int64_t>(-log(u) * static_cast<double>(interval)) + 1;
+		}
+
+		NOINLINE static uint32_t CaptureCallStack(void** frames, uint32_t maxFrames)
+		{
+#ifdef _WIN32
+			return ::RtlCaptureStackBackTrace(3, maxFrames, frames, NULL);
+#elif DKGL_ALLOCATION_TRACKER_BACKTRACE
+			void* buffer[DKAllocationTracker::MaxStackFrames + 3];
+			int num = ::backtrace(buffer, maxFrames + 3);
+			if (num <= 3)
+				return 0;
+			memcpy(frames, &buffer[3], sizeof(void*) * (num - 3));
+			return static_cast<uint32_t>(num - 3);
+#else
+			return 0;
+#endif
+		}
+
+		// frames of CaptureCallStack, TrackAllocation and the allocation
+		// function are skipped, TrackAllocation should not be inlined.
+		NOINLINE void TrackAllocation(void* p, size_t size, DKMemoryLocation loc)
+		{
+			if (p == NULL || allocationTrackerBusy)
+				return;
+
+			AllocationTracker& tracker = Tracker();
+			const int32_t generation = tracker.sampleGeneration.Load();
+			const size_t interval = tracker.sampleInterval;
+			if (interval > 1)
+			{
+				// first allocation of thread (or interval changed) should not be
+				// sampled always, counter starts with random interval.
+				if (bytesUntilSampleGeneration != generation)
+				{
+					bytesUntilSampleGeneration = generation;
+					bytesUntilSample = NextSampleInterval(interval);
+				}
+				bytesUntilSample -= static_cast<int64_t>(size);
+				if (bytesUntilSample > 0)
+					return;
+				bytesUntilSample = NextSampleInterval(interval);
+			}
+
+			AllocationTrackerBusyScope busy;
+
+			DKAllocationTracker::Allocation a;
+			a.address = p;
+			a.size = size;
+			// each byte is sampled with probability 1/interval,
+			// allocation of size is sampled with 1 - exp(-size/interval).
+			if (interval > 1 && size > 0)
+			{
+				double prob = 1.0 - exp(-static_cast<double>(size) / static_cast<double>(interval));
+				a.weight = static_cast<size_t>(static_cast<double>(size) / prob);
+			}
+			else
+				a.weight = size;
+			a.location = loc;
+			a.tag = currentAllocationTag;
+			a.tick = DKTimer::SystemTick();
+			a.numFrames = 0;
+			if (tracker.captureCallStack)
+				a.numFrames = CaptureCallStack(a.frames, DKAllocationTracker::MaxStackFrames);
+
+			DKCriticalSection<DKSpinLock> guard(tracker.lock);
+			if (allocationTrackingEnabled.Load() == 0)
+				return;
+
+			a.sequence = tracker.sequence++;
+			if (tracker.samples.Insert(p, a))
+			{
+				tracker.filter[AllocationTracker::FilterIndex(p)].Increment();
+
+				AllocationTagCounter& counter = tracker.TagCounter(a.tag);
+				counter.liveBytes += a.weight;
+				counter.liveSamples++;
+				counter.allocatedBytes += a.weight;
+			}
+		}
+
+		void TrackDeallocation(void* p)
+		{
+			if (p == NULL || allocationTrackerBusy)
+				return;
+
+			AllocationTracker& tracker = Tracker();
+			size_t index = AllocationTracker::FilterIndex(p);
+			if (tracker.filter[index].LoadRelaxed() == 0)
+				return;
+
+			AllocationTrackerBusyScope busy;
+			DKTimer::Tick tick = DKTimer::SystemTick();
+
+			DKCriticalSection<DKSpinLock> guard(tracker.lock);
+			if (auto* pair = tracker.samples.Find(p); pair)
+			{
+				const DKAllocationTracker::Allocation& a = pair->value;
+				AllocationTagCounter& counter = tracker.TagCounter(a.tag);
+				counter.liveBytes -= a.weight;
+				counter.liveSamples--;
+				counter.freedSamples++;
+				counter.lifetime += static_cast<double>(tick - a.tick) / static_cast<double>(DKTimer::SystemTickFrequency());
+
+				tracker.samples.Remove(p);
+				tracker.filter[index].Decrement();
+			}
+		}
+	}
+}
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+DKAllocationTag::DKAllocationTag(const char* name)
+	: previous(currentAllocationTag)
+{
+	currentAllocationTag = name;
+}
+
+DKAllocationTag::~DKAllocationTag()
+{
+	currentAllocationTag = previous;
+}
+
+const char* DKAllocationTag::Current()
+{
+	return currentAllocationTag;
+}
+
+size_t DKAllocationTracker::Snapshot::LiveBytes() const
+{
+	size_t bytes = 0;
+	for (const Allocation& a : allocations)
+		bytes += a.weight;
+	return bytes;
+}
+
+void DKAllocationTracker::Enable(size_t sampleInterval, bool captureCallStack)
+{
+	AllocationTrackerBusyScope busy;
+	AllocationTracker& tracker = Tracker();
+	DKCriticalSection<DKSpinLock> guard(tracker.lock);
+	tracker.sampleInterval = Max(sampleInterval, size_t(1));
+	tracker.captureCallStack = captureCallStack;
+	tracker.sampleGeneration.Increment();
+	allocationTrackingEnabled.Store(1);
+}
+
+void DKAllocationTracker::Disable()
+{
+	AllocationTrackerBusyScope busy;
+	AllocationTracker& tracker = Tracker();
+	DKCriticalSection<DKSpinLock> guard(tracker.lock);
+	allocationTrackingEnabled.Store(0);
+	tracker.ClearNL();
+}
+
+bool DKAllocationTracker::IsEnabled()
+{
+	return allocationTrackingEnabled.Load() != 0;
+}
+
+DKObject<DKAllocationTracker::Snapshot> DKAllocationTracker::TakeSnapshot()
+{
+	// snapshot itself should not be recorded.
+	AllocationTrackerBusyScope busy;
+
+	DKObject<Snapshot> snapshot = DKOBJECT_NEW Snapshot();
+	snapshot->tick = DKTimer::SystemTick();
+
+	// copy into tracker's storage, memory pool should not be used while lock held.
+	DKArray<Allocation, DKDummyLock, AllocationTrackerAllocator> samples;
+	if (true)
+	{
+		AllocationTracker& tracker = Tracker();
+		DKCriticalSection<DKSpinLock> guard(tracker.lock);
+		samples.Reserve(tracker.samples.Count());
+		tracker.samples.EnumerateForward([&](const decltype(tracker.samples)::Pair& pair)
+		{
+			samples.Add(pair.value);
+		});
+	}
+	snapshot->allocations.Add((const Allocation*)samples, samples.Count());
+	snapshot->allocations.Sort([](const Allocation& lhs, const Allocation& rhs)
+	{
+		return lhs.sequence < rhs.sequence;
+	});
+	return snapshot;
+}
+
+DKAllocationTracker::SnapshotDiff DKAllocationTracker::Diff(const Snapshot* older, const Snapshot* newer)
+{
+	AllocationTrackerBusyScope busy;
+
+	SnapshotDiff diff;
+	diff.liveBytesDelta = 0;
+
+	static const Snapshot empty = {};
+	if (older == NULL)
+		older = &empty;
+	if (newer == NULL)
+		newer = &empty;
+
+	// both are ordered by sequence.
+	size_t i = 0, k = 0;
+	const size_t n1 = older->allocations.Count();
+	const size_t n2 = newer->allocations.Count();
+	while (i < n1 || k < n2)
+	{
+		if (k >= n2 || (i < n1 && older->allocations.Value(i).sequence < newer->allocations.Value(k).sequence))
+		{
+			const Allocation& a = older->allocations.Value(i++);
+			diff.freed.Add(a);
+			diff.liveBytesDelta -= static_cast<int64_t>(a.weight);
+		}
+		else if (i >= n1 || newer->allocations.Value(k).sequence < older->allocations.Value(i).sequence)
+		{
+			const Allocation& a = newer->allocations.Value(k++);
+			diff.allocated.Add(a);
+			diff.liveBytesDelta += static_cast<int64_t>(a.weight);
+		}
+		else
+		{
+			i++;
+			k++;
+		}
+	}
+	return diff;
+}
+
+DKArray<DKAllocationTracker::TagStatus> DKAllocationTracker::QueryTagStatus()
+{
+	AllocationTrackerBusyScope busy;
+
+	DKArray<AllocationTagCounter, DKDummyLock, AllocationTrackerAllocator> counters;
+	if (true)
+	{
+		AllocationTracker& tracker = Tracker();
+		DKCriticalSection<DKSpinLock> guard(tracker.lock);
+		counters.Reserve(tracker.tags.Count());
+		tracker.tags.EnumerateForward([&](const decltype(tracker.tags)::Pair& pair)
+		{
+			counters.Add(pair.value);
+		});
+	}
+
+	// merge tags with same name. (string literals of different modules)
+	DKArray<TagStatus> result;
+	DKArray<double> lifetimes;
+	for (const AllocationTagCounter& c : counters)
+	{
+		size_t index = 0;
+		for (; index < result.Count(); ++index)
+		{
+			const char* tag = result.Value(index).tag;
+			if (tag == c.tag || (tag && c.tag && strcmp(tag, c.tag) == 0))
+				break;
+		}
+		if (index == result.Count())
+		{
+			TagStatus s = { c.tag, 0, 0, 0, 0, 0.0 };
+			result.Add(s);
+			lifetimes.Add(0.0);
+		}
+		TagStatus& s = result.Value(index);
+		s.liveBytes += c.liveBytes;
+		s.liveSamples += c.liveSamples;
+		s.allocatedBytes += c.allocatedBytes;
+		s.freedSamples += c.freedSamples;
+		lifetimes.Value(index) += c.lifetime;
+	}
+	for (size_t i = 0; i < result.Count(); ++i)
+	{
+		TagStatus& s = result.Value(i);
+		if (s.freedSamples > 0)
+			s.averageLifetime = lifetimes.Value(i) / static_cast<double>(s.freedSamples);
+	}
+	return result;
+}
+
+void DKAllocationTracker::RecordAllocation(void* p, size_t size, DKMemoryLocation loc)
+{
+	if (allocationTrackingEnabled.LoadRelaxed())
+		TrackAllocation(p, size, loc);
+}
+
+void DKAllocationTracker::RecordDeallocation(void* p)
+{
+	if (allocationTrackingEnabled.LoadRelaxed())
+		TrackDeallocation(p);
+}
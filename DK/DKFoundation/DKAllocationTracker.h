@@ -0,0 +1,130 @@
+//
+//  File: DKAllocationTracker.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKMemory.h"
+#include "DKObject.h"
+#include "DKArray.h"
+#include "DKTimer.h"
+
+namespace DKFoundation
+{
+	/// @brief
+	/// Allocations in scope of this object are attributed to given tag.
+	/// Tag should be string literal, only the pointer is kept.
+	/// @code
+	///  {
+	///      DKAllocationTag tag("Audio");
+	///      decoder = DKOBJECT_NEW AudioDecoder();  // attributed to "Audio"
+	///  }
+	/// @endcode
+	class DKGL_API DKAllocationTag
+	{
+	public:
+		DKAllocationTag(const char* name);
+		~DKAllocationTag();
+
+		/// tag of current thread, NULL if not tagged.
+		static const char* Current();
+
+	private:
+		const char* previous;
+
+		DKAllocationTag(const DKAllocationTag&) = delete;
+		DKAllocationTag& operator = (const DKAllocationTag&) = delete;
+	};
+
+	/**
+	 @brief
+	 Sampling allocation tracker for DKMemoryPool, DKMemoryHeap, DKMemoryVirtual
+	 functions and objects allocated by custom DKAllocator.
+
+	 An allocation is sampled once per sampleInterval bytes on average, and
+	 sampled allocations are recorded with size, tag, allocated time and call
+	 stack. Each sample has weight: estimated bytes the sample represents,
+	 live bytes and growth can be estimated from weights.
+	 Set sampleInterval to 1 to record every allocation.
+
+	 @code
+	  DKAllocationTracker::Enable();
+	  DKObject<DKAllocationTracker::Snapshot> s1 = DKAllocationTracker::TakeSnapshot();
+	  ...
+	  DKObject<DKAllocationTracker::Snapshot> s2 = DKAllocationTracker::TakeSnapshot();
+	  auto diff = DKAllocationTracker::Diff(s1, s2);
+	  for (auto& a : diff.allocated)
+	      printf("%s: %zu bytes\n", a.tag ? a.tag : "untagged", a.weight);
+	 @endcode
+
+	 @note
+	  Memory of custom allocator could be allocated from DKMemoryHeap or
+	  DKMemoryVirtual functions, those are tracked with each location.
+	  Call stack is captured on Win32, Apple and Linux(glibc) only,
+	  frames are return addresses without symbols.
+	 */
+	class DKGL_API DKAllocationTracker
+	{
+	public:
+		enum : size_t
+		{
+			DefaultSampleInterval = 0x80000,	///< 512 KB
+			MaxStackFrames = 16,
+		};
+
+		struct Allocation
+		{
+			const void* address;
+			size_t size;
+			size_t weight;				///< estimated bytes represented by sample
+			DKMemoryLocation location;
+			const char* tag;			///< DKAllocationTag, NULL if not tagged.
+			uint64_t sequence;			///< order of sampled allocations
+			DKTimer::Tick tick;			///< allocated time
+			uint32_t numFrames;
+			void* frames[MaxStackFrames];
+		};
+		struct TagStatus
+		{
+			const char* tag;			///< NULL for untagged allocations
+			size_t liveBytes;			///< estimated
+			size_t liveSamples;
+			uint64_t allocatedBytes;	///< estimated, since enabled
+			uint64_t freedSamples;
+			double averageLifetime;		///< seconds, of freed samples
+		};
+		class DKGL_API Snapshot
+		{
+		public:
+			DKTimer::Tick tick;
+			DKArray<Allocation> allocations;	///< live samples, ordered by sequence
+
+			size_t LiveBytes() const;			///< estimated
+		};
+		struct SnapshotDiff
+		{
+			DKArray<Allocation> allocated;	///< live in newer, not in older
+			DKArray<Allocation> freed;		///< live in older, not in newer
+			int64_t liveBytesDelta;			///< estimated
+		};
+
+		/// start tracking, records are kept until Disable() called.
+		static void Enable(size_t sampleInterval = DefaultSampleInterval, bool captureCallStack = true);
+		/// stop tracking, discard all records.
+		static void Disable();
+		static bool IsEnabled();
+
+		static DKObject<Snapshot> TakeSnapshot();
+		static SnapshotDiff Diff(const Snapshot* older, const Snapshot* newer);
+		/// status of each tag, tags with same name are merged.
+		static DKArray<TagStatus> QueryTagStatus();
+
+		/// record allocation of custom allocator, which is not allocated by
+		/// DKMemory functions or DKObject. (objects are tracked automatically)
+		static void RecordAllocation(void* p, size_t size, DKMemoryLocation loc = DKMemoryLocationCustom);
+		static void RecordDeallocation(void* p);
+	};
+}
@@ -86,10 +86,7 @@ DKAllocator& DKAllocator::DefaultAllocator(DKMemoryLocation loc)
 
 DKGL_API void* operator new (size_t s, DKAllocator& a)
 {
-	void* p = a.Alloc(s);
-	bool b = DKObjectRefCounter::SetRefCounter(p, &a, 0, NULL);
-	DKASSERT_STD_DESC_DEBUG(b, "DKObjectRefCounter failed.");
-	return p;
+	return DKObjectRefCounter::AllocateObject(&a, s);
 }
 
 DKGL_API void operator delete (void* p, DKAllocator& a)
@@ -97,5 +94,5 @@ DKGL_API void operator delete (void* p, DKAllocator& a)
 	DKAllocator* alloc = NULL;
 	DKObjectRefCounter::UnsetRefCounter(p, 0, &alloc);
 	DKASSERT_STD_DESC_DEBUG(alloc == &a, "Wrong allocator object.");
-	a.Dealloc(p);
+	DKObjectRefCounter::DeallocateObject(p, &a);
 }
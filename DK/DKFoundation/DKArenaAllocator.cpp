@@ -0,0 +1,271 @@
+//
+//  File: DKArenaAllocator.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include "DKArenaAllocator.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		static thread_local DKArenaAllocator* currentArena = NULL;
+
+		enum : uint8_t { ArenaPoisonValue = 0xDD };
+	}
+}
+
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+struct DKArenaAllocator::Block
+{
+	Block* next;
+	size_t size;	// data size
+
+	uintptr_t Begin() const	{ return reinterpret_cast<uintptr_t>(this + 1); }
+	uintptr_t End() const	{ return Begin() + size; }
+};
+
+DKArenaAllocator::DKArenaAllocator(size_t bs)
+	: firstBlock(NULL)
+	, currentBlock(NULL)
+	, cursor(0)
+	, limit(0)
+	, lastAllocation(0)
+	, blockSize(Max(bs, size_t(DefaultAlignment)))
+	, used(0)
+	, highWaterMark(0)
+	, numAllocations(0)
+	, allocator(NULL)
+{
+}
+
+DKArenaAllocator::~DKArenaAllocator()
+{
+	DKASSERT_DESC_DEBUG(currentArena != this, "Arena is still bound to current thread!");
+
+	Block* block = firstBlock;
+	while (block)
+	{
+		Block* next = block->next;
+		DKMemoryHeapFree(block);
+		block = next;
+	}
+	if (allocator)
+		delete allocator;
+}
+
+void* DKArenaAllocator::AllocFromNextBlock(size_t s, size_t alignment)
+{
+	// find unused block which has enough space. (kept by Rewind or Reset)
+	Block* block = currentBlock ? currentBlock->next : firstBlock;
+	while (block && block->size < s + alignment + sizeof(AllocationHeader))
+		block = block->next;
+
+	if (block == NULL)
+	{
+		size_t size = Max(blockSize, s + alignment + sizeof(AllocationHeader));
+		block = reinterpret_cast<Block*>(DKMemoryHeapAlloc(sizeof(Block) + size));
+		if (block == NULL)
+			return NULL;	// out of memory!
+		block->size = size;
+		// insert after current block.
+		if (currentBlock)
+		{
+			block->next = currentBlock->next;
+			currentBlock->next = block;
+		}
+		else
+		{
+			block->next = firstBlock;
+			firstBlock = block;
+		}
+	}
+	currentBlock = block;
+	cursor = block->Begin();
+	limit = block->End();
+
+	void* p = Alloc(s, alignment);
+	DKASSERT_DEBUG(p);
+	return p;
+}
+
+void* DKArenaAllocator::Realloc(void* p, size_t s)
+{
+	if (p == NULL)
+		return Alloc(s);
+
+	uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+	DKASSERT_DESC_DEBUG(addr == lastAllocation || Owns(p), "Given address was not allocated from this arena!");
+
+	AllocationHeader& size = reinterpret_cast<AllocationHeader*>(addr)[-1];
+#ifdef DKGL_DEBUG_ENABLED
+	// released (rewound) region is filled with poison value.
+	AllocationHeader poisoned;
+	memset(&poisoned, ArenaPoisonValue, sizeof(AllocationHeader));
+	DKASSERT_DESC_DEBUG(size != poisoned, "Given address was released already!");
+#endif
+	if (addr == lastAllocation && addr + s <= limit)
+	{
+		// resize last allocation in place.
+		used = used - (cursor - addr) + s;
+		if (used > highWaterMark)
+			highWaterMark = used;
+		cursor = addr + s;
+		size = s;
+		return p;
+	}
+
+	// copy old contents, regions can overlap if p is stale (rewound).
+	size_t copy = Min(s, size_t(size));
+	void* ptr = Alloc(s);
+	if (ptr)
+		memmove(ptr, p, copy);
+	return ptr;
+}
+
+DKArenaAllocator::Marker DKArenaAllocator::Mark() const
+{
+	return Marker{ currentBlock, cursor, used };
+}
+
+void DKArenaAllocator::Rewind(const Marker& m)
+{
+	if (m.block == NULL)
+	{
+		Reset();
+		return;
+	}
+#ifdef DKGL_DEBUG_ENABLED
+	for (Block* block = m.block; block; block = block->next)
+	{
+		Poison(block, block == m.block ? m.cursor : block->Begin());
+		if (block == currentBlock)
+			break;
+	}
+#endif
+	currentBlock = m.block;
+	cursor = m.cursor;
+	limit = m.block->End();
+	used = m.used;
+	lastAllocation = 0;
+}
+
+void DKArenaAllocator::Reset()
+{
+#ifdef DKGL_DEBUG_ENABLED
+	for (Block* block = firstBlock; block; block = block->next)
+	{
+		Poison(block, block->Begin());
+		if (block == currentBlock)
+			break;
+	}
+#endif
+	currentBlock = firstBlock;
+	if (currentBlock)
+	{
+		cursor = currentBlock->Begin();
+		limit = currentBlock->End();
+	}
+	else
+	{
+		cursor = 0;
+		limit = 0;
+	}
+	used = 0;
+	numAllocations = 0;
+	lastAllocation = 0;
+}
+
+size_t DKArenaAllocator::Purge()
+{
+	Block* block = NULL;
+	if (used == 0)
+	{
+		// nothing allocated, release all blocks.
+		block = firstBlock;
+		firstBlock = NULL;
+		currentBlock = NULL;
+		cursor = 0;
+		limit = 0;
+		lastAllocation = 0;
+	}
+	else
+	{
+		// release blocks after current block.
+		DKASSERT_DEBUG(currentBlock);
+		block = currentBlock->next;
+		currentBlock->next = NULL;
+	}
+	size_t purged = 0;
+	while (block)
+	{
+		Block* next = block->next;
+		purged += block->size + sizeof(Block);
+		DKMemoryHeapFree(block);
+		block = next;
+	}
+	return purged;
+}
+
+bool DKArenaAllocator::Owns(const void* p) const
+{
+	uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+	for (Block* block = firstBlock; block; block = block->next)
+	{
+		if (block == currentBlock)
+			return addr >= block->Begin() && addr < cursor;
+		if (addr >= block->Begin() && addr < block->End())
+			return true;
+	}
+	return false;
+}
+
+DKArenaAllocator::Statistics DKArenaAllocator::QueryStatistics() const
+{
+	Statistics st = { used, 0, highWaterMark, 0, numAllocations };
+	for (Block* block = firstBlock; block; block = block->next)
+	{
+		st.reserved += block->size;
+		st.numBlocks++;
+	}
+	return st;
+}
+
+void DKArenaAllocator::Poison(Block* block, uintptr_t from)
+{
+	if (from < block->End())
+		memset(reinterpret_cast<void*>(from), ArenaPoisonValue, block->End() - from);
+}
+
+DKAllocator& DKArenaAllocator::AllocatorInstance()
+{
+	struct ArenaAllocator : public DKAllocator
+	{
+		ArenaAllocator(DKArenaAllocator* a) : arena(a) {}
+		void* Alloc(size_t s) override				{ return arena->Alloc(s); }
+		void* Realloc(void* p, size_t s) override	{ return arena->Realloc(p, s); }
+		void Dealloc(void*) override				{}
+		DKMemoryLocation Location() const override	{ return DKMemoryLocationCustom; }
+		DKArenaAllocator* arena;
+	};
+	if (allocator == NULL)
+		allocator = new ArenaAllocator(this);
+	return *allocator;
+}
+
+DKArenaAllocator* DKArenaAllocator::Current()
+{
+	return currentArena;
+}
+
+DKArenaAllocator* DKArenaAllocator::SetCurrent(DKArenaAllocator* arena)
+{
+	DKArenaAllocator* prev = currentArena;
+	currentArena = arena;
+	return prev;
+}
@@ -0,0 +1,186 @@
+//
+//  File: DKArenaAllocator.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <cstddef>
+#include "../DKInclude.h"
+#include "DKAllocator.h"
+#include "DKMemory.h"
+
+namespace DKFoundation
+{
+	/**
+	 @brief
+	 A linear (bump-pointer) allocator with chained memory blocks.
+	 Memory is not freed individually, released all at once by Reset(),
+	 or by Rewind() to the position saved with Mark().
+	 Blocks are kept for reuse, call Purge() to release unused blocks.
+
+	 It is useful for temporary data which has short life cycle,
+	 such as per-frame data.
+
+	 Example:
+	 @code
+	   DKArenaAllocator arena;
+	   {
+	     DKArenaAllocator::Scope scope(arena);           // mark
+	     void* p = arena.Alloc(128);
+	     ...
+	   }                                                 // rewind
+
+	   // use with template containers
+	   {
+	     DKArenaAllocator::ThreadBinding bind(arena);    // current arena of thread
+	     DKArray<int, DKDummyLock, DKArenaAllocator::Policy> tmp;
+	     ...
+	   }
+	   arena.Reset();  // release all (per frame)
+	 @endcode
+
+	 @note
+	  This class is not thread-safe, use one arena per thread.
+	  Debug build fills released memory with 0xDD.
+	  Each allocation has a small header which holds its size for Realloc().
+	 */
+	class DKGL_API DKArenaAllocator
+	{
+		struct Block;
+		using AllocationHeader = size_t;	// size of allocation, stored in front of it.
+	public:
+		enum : size_t
+		{
+			DefaultBlockSize = 0x10000,	///< 64KB
+			DefaultAlignment = alignof(std::max_align_t),
+		};
+
+		/// allocation position, returned by Mark()
+		struct Marker
+		{
+			Block* block;
+			uintptr_t cursor;
+			size_t used;
+		};
+		struct Statistics
+		{
+			size_t used;			///< bytes in use (including headers and alignment padding)
+			size_t reserved;		///< total bytes of all blocks
+			size_t highWaterMark;	///< peak of used bytes
+			size_t numBlocks;
+			size_t numAllocations;	///< number of allocations since last Reset()
+		};
+
+		/// save position when constructed, and rewind when destructed.
+		class Scope
+		{
+		public:
+			Scope(DKArenaAllocator& a) : arena(a), marker(a.Mark()) {}
+			~Scope() { arena.Rewind(marker); }
+		private:
+			Scope(const Scope&) = delete;
+			Scope& operator = (const Scope&) = delete;
+			DKArenaAllocator& arena;
+			Marker marker;
+		};
+		/// set arena as current arena of calling thread until destructed.
+		class ThreadBinding
+		{
+		public:
+			ThreadBinding(DKArenaAllocator& a) : prev(SetCurrent(&a)) {}
+			~ThreadBinding() { SetCurrent(prev); }
+		private:
+			ThreadBinding(const ThreadBinding&) = delete;
+			ThreadBinding& operator = (const ThreadBinding&) = delete;
+			DKArenaAllocator* prev;
+		};
+
+		/// allocator type for template classes, uses current arena of thread.
+		/// Free() does nothing, memory is reclaimed by arena.
+		/// container should not outlive arena's rewind scope.
+		struct Policy
+		{
+			enum { Location = DKMemoryLocationCustom };
+			static void* Alloc(size_t s)
+			{
+				DKArenaAllocator* arena = Current();
+				DKASSERT_DESC_DEBUG(arena, "No arena bound to current thread!");
+				return arena ? arena->Alloc(s) : NULL;
+			}
+			static void* Realloc(void* p, size_t s)
+			{
+				DKArenaAllocator* arena = Current();
+				DKASSERT_DESC_DEBUG(arena, "No arena bound to current thread!");
+				return arena ? arena->Realloc(p, s) : NULL;
+			}
+			static void Free(void*) {}
+		};
+
+		DKArenaAllocator(size_t blockSize = DefaultBlockSize);
+		~DKArenaAllocator();
+
+		FORCEINLINE void* Alloc(size_t s, size_t alignment = DefaultAlignment)
+		{
+			DKASSERT_DEBUG((alignment & (alignment - 1)) == 0);
+			alignment = Max(alignment, sizeof(AllocationHeader));
+			uintptr_t p = (cursor + sizeof(AllocationHeader) + (alignment - 1)) & ~uintptr_t(alignment - 1);
+			if (p + s <= limit && p >= cursor)
+			{
+				used += (p + s) - cursor;
+				if (used > highWaterMark)
+					highWaterMark = used;
+				numAllocations++;
+				lastAllocation = p;
+				cursor = p + s;
+				reinterpret_cast<AllocationHeader*>(p)[-1] = s;
+				return reinterpret_cast<void*>(p);
+			}
+			return AllocFromNextBlock(s, alignment);
+		}
+		/// resize last allocation in place if possible, otherwise allocate new and copy.
+		void* Realloc(void* p, size_t s);
+		/// does nothing, memory is released with Rewind() or Reset().
+		void Free(void*) {}
+
+		Marker Mark() const;
+		/// release all allocations after marker.
+		void Rewind(const Marker&);
+		/// release all allocations.
+		void Reset();
+		/// delete unused blocks, returns bytes released.
+		size_t Purge();
+		/// test p was allocated from this arena.
+		bool Owns(const void* p) const;
+
+		Statistics QueryStatistics() const;
+		void ResetHighWaterMark() { highWaterMark = used; }
+
+		/// DKAllocator instance of this arena. (Dealloc does nothing)
+		DKAllocator& AllocatorInstance();
+
+		/// current arena of calling thread. (NULL if not bound)
+		static DKArenaAllocator* Current();
+		/// set current arena of calling thread, returns previous one.
+		static DKArenaAllocator* SetCurrent(DKArenaAllocator*);
+
+	private:
+		void* AllocFromNextBlock(size_t s, size_t alignment);
+		void Poison(Block* block, uintptr_t from);
+
+		Block* firstBlock;
+		Block* currentBlock;
+		uintptr_t cursor;
+		uintptr_t limit;
+		uintptr_t lastAllocation;
+		size_t blockSize;
+		size_t used;
+		size_t highWaterMark;
+		size_t numAllocations;
+		DKAllocator* allocator;
+
+		DKArenaAllocator(const DKArenaAllocator&) = delete;
+		DKArenaAllocator& operator = (const DKArenaAllocator&) = delete;
+	};
+}
@@ -0,0 +1,495 @@
+//
+//  File: DKAsyncIO.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define DKASYNCIO_IO_URING 1
+#endif
+#endif
+#endif
+
+#include "DKAsyncIO.h"
+#include "DKStream.h"
+#include "DKEventLoop.h"
+#include "DKOperationQueue.h"
+#include "DKThread.h"
+#include "DKCondition.h"
+#include "DKSpinLock.h"
+#include "DKCriticalSection.h"
+#include "DKQueue.h"
+#include "DKLog.h"
+
+namespace DKFoundation::Private
+{
+	namespace
+	{
+		enum : size_t
+		{
+			MaxTransferChunk = 0x40000000,	// 1GB, length of single transfer is 32bit.
+			ThreadPoolSize = 8,
+		};
+
+		struct AsyncIORequest : public DKAsyncIO::Request
+		{
+			intptr_t handle;
+			uint8_t* buffer;
+			size_t size;
+			uint64_t offset;
+			bool write;
+			size_t transferred;
+
+			DKAsyncIO::Completion completion;
+			DKObject<DKEventLoop> eventLoop;
+			DKObject<AsyncIORequest> self;	// retained by engine until completed.
+#ifdef DKASYNCIO_IO_URING
+			struct iovec iov;
+#endif
+			DKCondition cond;
+			size_t result;
+			bool done;
+
+			AsyncIORequest()
+				: handle(-1), buffer(NULL), size(0), offset(0), write(false)
+				, transferred(0), result(DKStream::PositionError), done(false)
+			{
+			}
+			bool IsDone() const override
+			{
+				DKCriticalSection<DKCondition> guard(cond);
+				return done;
+			}
+			size_t Wait() const override
+			{
+				DKCriticalSection<DKCondition> guard(cond);
+				while (!done)
+					cond.Wait();
+				return result;
+			}
+			size_t Remaining() const
+			{
+				return size - transferred;
+			}
+			void Complete(bool succeeded)
+			{
+				{
+					DKCriticalSection<DKCondition> guard(cond);
+					result = succeeded ? transferred : DKStream::PositionError;
+					done = true;
+					cond.Broadcast();
+				}
+				if (completion)
+				{
+					if (eventLoop)
+					{
+						DKObject<AsyncIORequest> req = this;
+						eventLoop->Post([req]() { req->completion(req->result); });
+					}
+					else
+						completion(result);
+				}
+			}
+		};
+
+		class AsyncIOEngine
+		{
+		public:
+			virtual ~AsyncIOEngine() {}
+			virtual void Submit(AsyncIORequest*) = 0;
+			virtual DKAsyncIO::Backend Backend() const = 0;
+		};
+
+		/// blocking positional read/write on thread pool.
+		class ThreadPoolEngine : public AsyncIOEngine
+		{
+		public:
+			ThreadPoolEngine()
+			{
+				queue.SetMaxConcurrentOperations(ThreadPoolSize);
+			}
+			~ThreadPoolEngine()
+			{
+				queue.WaitForCompletion();
+			}
+			void Submit(AsyncIORequest* r) override
+			{
+				DKObject<AsyncIORequest> req = r;
+				queue.Post([req]() mutable { req->Complete(Perform(req)); });
+			}
+			DKAsyncIO::Backend Backend() const override
+			{
+				return DKAsyncIO::BackendThreadPool;
+			}
+		private:
+			static bool Perform(AsyncIORequest* req)
+			{
+				while (req->Remaining() > 0)
+				{
+					uint8_t* p = req->buffer + req->transferred;
+					size_t s = Min(req->Remaining(), size_t(MaxTransferChunk));
+					uint64_t offset = req->offset + req->transferred;
+#ifdef _WIN32
+					OVERLAPPED ov = {};
+					ov.Offset = static_cast<DWORD>(offset & 0xffffffff);
+					ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+					DWORD numBytes = 0;
+					BOOL ret = req->write ?
+						::WriteFile((HANDLE)req->handle, p, (DWORD)s, &numBytes, &ov) :
+						::ReadFile((HANDLE)req->handle, p, (DWORD)s, &numBytes, &ov);
+					if (!ret)
+					{
+						DWORD err = ::GetLastError();
+						if (err == ERROR_HANDLE_EOF)
+							break;
+						DKLogE("DKAsyncIO: %s failed (error:%u)", req->write ? "WriteFile" : "ReadFile", err);
+						return false;
+					}
+					if (numBytes == 0)
+						break;
+					req->transferred += numBytes;
+#else
+					ssize_t ret = req->write ?
+						::pwrite((int)req->handle, p, s, (off_t)offset) :
+						::pread((int)req->handle, p, s, (off_t)offset);
+					if (ret < 0)
+					{
+						if (errno == EINTR || errno == EAGAIN)
+							continue;
+						DKLogE("DKAsyncIO: %s failed: %s", req->write ? "pwrite" : "pread", strerror(errno));
+						return false;
+					}
+					if (ret == 0)
+						break;	// EOF
+					req->transferred += ret;
+#endif
+				}
+				return true;
+			}
+			DKOperationQueue queue;
+		};
+
+#ifdef DKASYNCIO_IO_URING
+		/// io_uring without liburing, submission and completion rings are
+		/// shared with kernel, completions are reaped by single thread.
+		class IOUringEngine : public AsyncIOEngine
+		{
+		public:
+			IOUringEngine()
+				: ringFd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes(NULL)
+				, sqRingSize(0), cqRingSize(0), sqesSize(0)
+				, maxInFlight(0), inFlight(0)
+			{
+			}
+			~IOUringEngine()
+			{
+				if (thread)
+				{
+					// NOP with null user_data terminates completion thread.
+					lock.Lock();
+					io_uring_sqe* sqe = AcquireSQE();
+					sqe->opcode = IORING_OP_NOP;
+					sqe->user_data = 0;
+					CommitSQE();
+					lock.Unlock();
+					Enter(1, 0, 0);
+					thread->WaitTerminate();
+				}
+				if (sqes && sqes != MAP_FAILED)
+					::munmap(sqes, sqesSize);
+				if (cqRing != MAP_FAILED && cqRing != sqRing)
+					::munmap(cqRing, cqRingSize);
+				if (sqRing != MAP_FAILED)
+					::munmap(sqRing, sqRingSize);
+				if (ringFd >= 0)
+					::close(ringFd);
+			}
+			bool Initialize()
+			{
+				io_uring_params params = {};
+				ringFd = (int)::syscall(__NR_io_uring_setup, (unsigned)DKAsyncIO::QueueDepth, &params);
+				if (ringFd < 0)
+				{
+					DKLogW("DKAsyncIO: io_uring_setup failed: %s", strerror(errno));
+					return false;
+				}
+				sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				if (params.features & IORING_FEAT_SINGLE_MMAP)
+					sqRingSize = cqRingSize = Max(sqRingSize, cqRingSize);
+
+				sqRing = ::mmap(0, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+				if (sqRing == MAP_FAILED)
+				{
+					DKLogE("DKAsyncIO: mmap failed: %s", strerror(errno));
+					return false;
+				}
+				if (params.features & IORING_FEAT_SINGLE_MMAP)
+					cqRing = sqRing;
+				else
+				{
+					cqRing = ::mmap(0, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+					if (cqRing == MAP_FAILED)
+					{
+						DKLogE("DKAsyncIO: mmap failed: %s", strerror(errno));
+						return false;
+					}
+				}
+				sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				sqes = reinterpret_cast<io_uring_sqe*>(::mmap(0, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+				if (sqes == MAP_FAILED)
+				{
+					DKLogE("DKAsyncIO: mmap failed: %s", strerror(errno));
+					return false;
+				}
+
+				uint8_t* sq = reinterpret_cast<uint8_t*>(sqRing);
+				sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+				sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+				sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+				sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+				uint8_t* cq = reinterpret_cast<uint8_t*>(cqRing);
+				cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+				cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+				cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+				cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+				// one entry is reserved for termination.
+				maxInFlight = params.sq_entries - 1;
+
+				thread = DKThread::Create(DKFunction(this, &IOUringEngine::CompletionProc)->Invocation());
+				return thread != NULL;
+			}
+			void Submit(AsyncIORequest* req) override
+			{
+				req->self = req;
+				lock.Lock();
+				if (inFlight < maxInFlight)
+				{
+					inFlight++;
+					PrepareSQE(req);
+					lock.Unlock();
+					Enter(1, 0, 0);
+				}
+				else
+				{
+					pending.PushBack(req);
+					lock.Unlock();
+				}
+			}
+			DKAsyncIO::Backend Backend() const override
+			{
+				return DKAsyncIO::BackendIOUring;
+			}
+		private:
+			// lock should be held, entry is not visible to kernel until CommitSQE().
+			io_uring_sqe* AcquireSQE()
+			{
+				unsigned tail = *sqTail;
+				DKASSERT_DEBUG(tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) <= sqMask);
+				unsigned index = tail & sqMask;
+				io_uring_sqe* sqe = &sqes[index];
+				memset(sqe, 0, sizeof(io_uring_sqe));
+				sqArray[index] = index;
+				return sqe;
+			}
+			void CommitSQE()
+			{
+				// publish entry before tail.
+				__atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+			}
+			// lock should be held.
+			void PrepareSQE(AsyncIORequest* req)
+			{
+				req->iov.iov_base = req->buffer + req->transferred;
+				req->iov.iov_len = Min(req->Remaining(), size_t(MaxTransferChunk));
+
+				io_uring_sqe* sqe = AcquireSQE();
+				sqe->opcode = req->write ? IORING_OP_WRITEV : IORING_OP_READV;
+				sqe->fd = (int)req->handle;
+				sqe->off = req->offset + req->transferred;
+				sqe->addr = reinterpret_cast<uint64_t>(&req->iov);
+				sqe->len = 1;
+				sqe->user_data = reinterpret_cast<uint64_t>(req);
+				CommitSQE();
+			}
+			int Enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+			{
+				int ret;
+				do {
+					ret = (int)::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+				} while (ret < 0 && errno == EINTR);
+				return ret;
+			}
+			void CompletionProc()
+			{
+				bool running = true;
+				while (running)
+				{
+					Enter(0, 1, IORING_ENTER_GETEVENTS);
+
+					unsigned head = *cqHead;
+					unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+					while (head != tail)
+					{
+						const io_uring_cqe& cqe = cqes[head & cqMask];
+						AsyncIORequest* req = reinterpret_cast<AsyncIORequest*>(cqe.user_data);
+						int32_t res = cqe.res;
+						head++;
+						__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+						if (req == NULL)
+						{
+							running = false;
+							continue;
+						}
+						if (res < 0 && (res == -EINTR || res == -EAGAIN))
+						{
+							Resubmit(req);
+							continue;
+						}
+						if (res > 0)
+						{
+							req->transferred += res;
+							if (req->Remaining() > 0)
+							{
+								Resubmit(req);	// short transfer
+								continue;
+							}
+						}
+						if (res < 0)
+							DKLogE("DKAsyncIO: %s failed: %s", req->write ? "write" : "read", strerror(-res));
+						Finish(req, res >= 0);
+					}
+				}
+			}
+			void Resubmit(AsyncIORequest* req)
+			{
+				lock.Lock();
+				PrepareSQE(req);
+				lock.Unlock();
+				Enter(1, 0, 0);
+			}
+			void Finish(AsyncIORequest* req, bool succeeded)
+			{
+				// submit pending request with released slot.
+				lock.Lock();
+				AsyncIORequest* next = NULL;
+				if (pending.PopFront(next))
+					PrepareSQE(next);
+				else
+					inFlight--;
+				lock.Unlock();
+				if (next)
+					Enter(1, 0, 0);
+
+				DKObject<AsyncIORequest> r = req->self;
+				req->self = NULL;
+				r->Complete(succeeded);
+			}
+
+			int ringFd;
+			void* sqRing;
+			void* cqRing;
+			io_uring_sqe* sqes;
+			size_t sqRingSize;
+			size_t cqRingSize;
+			size_t sqesSize;
+
+			unsigned* sqHead;
+			unsigned* sqTail;
+			unsigned* sqArray;
+			unsigned sqMask;
+			unsigned* cqHead;
+			unsigned* cqTail;
+			unsigned cqMask;
+			io_uring_cqe* cqes;
+
+			DKSpinLock lock;
+			size_t maxInFlight;
+			size_t inFlight;
+			DKQueue<AsyncIORequest*> pending;
+			DKObject<DKThread> thread;
+		};
+#endif
+
+		AsyncIOEngine* CreateAsyncIOEngine()
+		{
+#ifdef DKASYNCIO_IO_URING
+			IOUringEngine* engine = new IOUringEngine();
+			if (engine->Initialize())
+				return engine;
+			delete engine;
+			DKLogW("DKAsyncIO: io_uring not available, using thread pool.");
+#endif
+			return new ThreadPoolEngine();
+		}
+
+		AsyncIOEngine& AsyncIOEngineInstance()
+		{
+			struct Holder
+			{
+				AsyncIOEngine* engine = CreateAsyncIOEngine();
+				~Holder() { delete engine; }
+			};
+			static Holder holder;
+			return *holder.engine;
+		}
+
+		DKObject<DKAsyncIO::Request> SubmitAsyncIO(intptr_t handle, void* buffer, size_t size, uint64_t offset, bool write,
+												   DKAsyncIO::Completion&& completion, DKEventLoop* eventLoop)
+		{
+			DKObject<AsyncIORequest> req = DKOBJECT_NEW AsyncIORequest();
+			req->handle = handle;
+			req->buffer = reinterpret_cast<uint8_t*>(buffer);
+			req->size = size;
+			req->offset = offset;
+			req->write = write;
+			req->completion = static_cast<DKAsyncIO::Completion&&>(completion);
+			req->eventLoop = eventLoop;
+
+			if (size == 0)
+				req->Complete(true);
+			else
+				AsyncIOEngineInstance().Submit(req);
+			return req.SafeCast<DKAsyncIO::Request>();
+		}
+	}
+}
+
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+DKObject<DKAsyncIO::Request> DKAsyncIO::Read(intptr_t handle, void* buffer, size_t size, uint64_t offset,
+											 Completion&& completion, DKEventLoop* eventLoop)
+{
+	return SubmitAsyncIO(handle, buffer, size, offset, false, static_cast<Completion&&>(completion), eventLoop);
+}
+
+DKObject<DKAsyncIO::Request> DKAsyncIO::Write(intptr_t handle, const void* buffer, size_t size, uint64_t offset,
+											  Completion&& completion, DKEventLoop* eventLoop)
+{
+	return SubmitAsyncIO(handle, const_cast<void*>(buffer), size, offset, true, static_cast<Completion&&>(completion), eventLoop);
+}
+
+DKAsyncIO::Backend DKAsyncIO::ActiveBackend()
+{
+	return AsyncIOEngineInstance().Backend();
+}
@@ -0,0 +1,80 @@
+//
+//  File: DKAsyncIO.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKObject.h"
+#include "DKInlineFunction.h"
+
+namespace DKFoundation
+{
+	class DKEventLoop;
+	/**
+	 @brief
+	 Asynchronous file I/O engine.
+
+	 Requests are pushed into submission queue and completed by background
+	 thread, many requests can be in flight at once.
+	 On Linux, io_uring is used if kernel supports it. Otherwise (or other
+	 platforms) blocking positional read/write is performed in thread pool.
+
+	 Short transfers are continued until requested size is transferred or
+	 end of file reached, like DKFile::Read.
+
+	 Use DKFile::ReadAsync(), DKFile::WriteAsync() for file object.
+
+	 @code
+	  DKObject<DKFile> file = DKFile::Create(path, DKFile::ModeOpenReadOnly, DKFile::ModeShareAll);
+	  // wait with handle
+	  DKObject<DKAsyncIO::Request> req = file->ReadAsync(buffer, size, offset);
+	  size_t read = req->Wait();
+	  // or completion handler, invoked on event-loop thread.
+	  file->ReadAsync(buffer, size, offset, [](size_t read) { ... }, eventLoop);
+	 @endcode
+
+	 @note
+	  Buffer should be valid until request has been completed.
+	  Completion handler without event-loop is invoked on I/O thread,
+	  it should return quickly.
+	 */
+	class DKGL_API DKAsyncIO
+	{
+	public:
+		enum Backend
+		{
+			BackendThreadPool,
+			BackendIOUring,
+		};
+		enum : size_t
+		{
+			QueueDepth = 256,	///< max requests in flight (io_uring)
+		};
+
+		/// completion handle of request.
+		struct Request
+		{
+			virtual ~Request() {}
+			virtual bool IsDone() const = 0;
+			/// wait until done, returns number of bytes transferred.
+			/// returns DKStream::PositionError if failed.
+			virtual size_t Wait() const = 0;
+		};
+		/// invoked with number of bytes transferred. (DKStream::PositionError if failed)
+		using Completion = DKInlineFunction<void (size_t)>;
+
+		/// read from file handle (file descriptor or HANDLE) at offset.
+		/// completion is invoked on eventLoop if provided, otherwise on I/O thread.
+		static DKObject<Request> Read(intptr_t handle, void* buffer, size_t size, uint64_t offset,
+									  Completion&& completion = nullptr, DKEventLoop* eventLoop = NULL);
+		/// write to file handle (file descriptor or HANDLE) at offset.
+		static DKObject<Request> Write(intptr_t handle, const void* buffer, size_t size, uint64_t offset,
+									   Completion&& completion = nullptr, DKEventLoop* eventLoop = NULL);
+
+		/// backend of I/O engine, engine is started with first request.
+		static Backend ActiveBackend();
+	};
+}
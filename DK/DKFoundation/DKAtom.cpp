@@ -0,0 +1,203 @@
+//
+//  File: DKAtom.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include <wchar.h>
+#include <atomic>
+#include <new>
+#include "DKAtom.h"
+#include "DKAllocator.h"
+#include "DKSpinLock.h"
+#include "DKCriticalSection.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		static DKAllocator::Maintainer maintainer;
+
+		// open-addressing table of atoms (linear probing).
+		// slots are written only by shard lock owner, once published slot
+		// never changes. old tables are kept for readers, never released.
+		struct AtomTable
+		{
+			size_t capacity;	// power of two
+			AtomTable* retired;
+			std::atomic<const AtomEntry*> slots[1];
+
+			static AtomTable* Create(size_t capacity, AtomTable* retired)
+			{
+				size_t size = sizeof(AtomTable) + sizeof(std::atomic<const AtomEntry*>) * (capacity - 1);
+				AtomTable* table = reinterpret_cast<AtomTable*>(DKMemoryHeapAlloc(size));
+				DKASSERT_DESC_DEBUG(table, "Out of memory!");
+				if (table == NULL)
+					return NULL;	// out of memory!
+				table->capacity = capacity;
+				table->retired = retired;
+				for (size_t i = 0; i < capacity; ++i)
+					new(&table->slots[i]) std::atomic<const AtomEntry*>(NULL);
+				return table;
+			}
+		};
+
+		struct AtomShard
+		{
+			enum { InitialCapacity = 64 };
+			DKSpinLock lock;
+			std::atomic<AtomTable*> table = NULL;
+			size_t count = 0;	// guarded by lock
+		};
+		enum { NumAtomShardBits = 6, NumAtomShards = 1 << NumAtomShardBits };
+		static AtomShard atomShards[NumAtomShards];
+
+		FORCEINLINE static AtomShard& AtomShardForHash(uint64_t hash)
+		{
+			return atomShards[hash >> (64 - NumAtomShardBits)];
+		}
+
+		static const AtomEntry* FindAtomEntry(const AtomTable* table, uint64_t hash, const DKUniCharW* str, size_t len)
+		{
+			if (table == NULL)
+				return NULL;
+			const size_t mask = table->capacity - 1;
+			for (size_t i = static_cast<size_t>(hash) & mask; ; i = (i + 1) & mask)
+			{
+				const AtomEntry* e = table->slots[i].load(std::memory_order_acquire);
+				if (e == NULL)
+					return NULL;
+				if (e->hash == hash &&
+					e->string.Length() == len &&
+					memcmp((const DKUniCharW*)e->string, str, sizeof(DKUniCharW) * len) == 0)
+					return e;
+			}
+			return NULL;
+		}
+
+		static void InsertAtomEntryNL(AtomTable* table, const AtomEntry* entry)
+		{
+			const size_t mask = table->capacity - 1;
+			size_t i = static_cast<size_t>(entry->hash) & mask;
+			while (table->slots[i].load(std::memory_order_relaxed))
+				i = (i + 1) & mask;
+			table->slots[i].store(entry, std::memory_order_release);
+		}
+
+		static const AtomEntry* LookupAtom(const DKUniCharW* str, size_t len)
+		{
+			if (len == 0)
+				return NULL;
+			uint64_t hash = DKHashString<DKUniCharW>(str);
+			AtomShard& shard = AtomShardForHash(hash);
+			return FindAtomEntry(shard.table.load(std::memory_order_acquire), hash, str, len);
+		}
+
+		static const AtomEntry* InternAtom(const DKUniCharW* str, size_t len)
+		{
+			if (len == 0)
+				return NULL;
+			uint64_t hash = DKHashString<DKUniCharW>(str);
+			AtomShard& shard = AtomShardForHash(hash);
+
+			const AtomEntry* entry = FindAtomEntry(shard.table.load(std::memory_order_acquire), hash, str, len);
+			if (entry)
+				return entry;
+
+			DKCriticalSection<DKSpinLock> guard(shard.lock);
+			AtomTable* table = shard.table.load(std::memory_order_relaxed);
+			entry = FindAtomEntry(table, hash, str, len);	// inserted by other thread?
+			if (entry)
+				return entry;
+
+			// keep load factor below 3/4
+			if (table == NULL || (shard.count + 1) * 4 > table->capacity * 3)
+			{
+				size_t capacity = table ? table->capacity * 2 : size_t(AtomShard::InitialCapacity);
+				AtomTable* newTable = AtomTable::Create(capacity, table);
+				if (newTable == NULL)
+					return NULL;	// null atom, shard is not changed.
+				if (table)
+				{
+					for (size_t i = 0; i < table->capacity; ++i)
+					{
+						if (const AtomEntry* e = table->slots[i].load(std::memory_order_relaxed); e)
+							InsertAtomEntryNL(newTable, e);
+					}
+				}
+				shard.table.store(newTable, std::memory_order_release);
+				table = newTable;
+			}
+
+			AtomEntry* newEntry = new AtomEntry{ hash, DKString(str, len) };
+			InsertAtomEntryNL(table, newEntry);
+			shard.count++;
+			return newEntry;
+		}
+
+		// release string buffers before memory pool destroyed.
+		// atom entries are still valid, but strings are empty.
+		static struct AtomTableFinalizer
+		{
+			~AtomTableFinalizer()
+			{
+				for (AtomShard& shard : atomShards)
+				{
+					DKCriticalSection<DKSpinLock> guard(shard.lock);
+					if (AtomTable* table = shard.table.load(std::memory_order_relaxed); table)
+					{
+						for (size_t i = 0; i < table->capacity; ++i)
+						{
+							if (const AtomEntry* e = table->slots[i].load(std::memory_order_relaxed); e)
+								const_cast<AtomEntry*>(e)->string = DKString();
+						}
+					}
+				}
+			}
+		} atomTableFinalizer;
+	}
+}
+
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+DKAtom::DKAtom(const DKString& str)
+	: entry(InternAtom((const DKUniCharW*)str, str.Length()))
+{
+}
+
+DKAtom::DKAtom(const DKUniCharW* str)
+	: entry(str ? InternAtom(str, wcslen(str)) : NULL)
+{
+}
+
+DKAtom DKAtom::Lookup(const DKString& str)
+{
+	return LookupAtom((const DKUniCharW*)str, str.Length());
+}
+
+DKAtom DKAtom::Lookup(const DKUniCharW* str)
+{
+	if (str)
+		return LookupAtom(str, wcslen(str));
+	return DKAtom();
+}
+
+size_t DKAtom::NumberOfAtoms()
+{
+	size_t num = 0;
+	for (AtomShard& shard : atomShards)
+	{
+		DKCriticalSection<DKSpinLock> guard(shard.lock);
+		num += shard.count;
+	}
+	return num;
+}
+
+const DKString& DKAtom::EmptyString()
+{
+	static const DKString empty;
+	return empty;
+}
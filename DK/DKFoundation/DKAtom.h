@@ -0,0 +1,80 @@
+//
+//  File: DKAtom.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKString.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		struct AtomEntry
+		{
+			uint64_t hash;
+			DKString string;
+		};
+	}
+
+	/**
+	 @brief
+	 Interned string. An atom is a pointer to unique entry of global table,
+	 atoms of same string are identical.
+
+	 Equality and hash of atom is O(1), can be used as key of DKHashMap, DKMap.
+	 (DKMap is ordered by entry address, not by string)
+	 Interned strings are never released while process running.
+	 Creating atom from string is lock-free if the string is interned already,
+	 use Lookup() to find atom without interning.
+
+	 @code
+	  DKAtom name(L"Bone01");
+	  DKAnimation::NodeIndex index = animation->IndexOfNode(name);
+	 @endcode
+
+	 @note
+	  Empty string is null atom.
+	 */
+	class DKGL_API DKAtom
+	{
+	public:
+		constexpr DKAtom() : entry(NULL) {}
+		explicit DKAtom(const DKString& str);
+		explicit DKAtom(const DKUniCharW* str);
+
+		/// find atom of interned string, returns null atom if not interned.
+		static DKAtom Lookup(const DKString& str);
+		static DKAtom Lookup(const DKUniCharW* str);
+
+		/// number of interned strings.
+		static size_t NumberOfAtoms();
+
+		FORCEINLINE const DKString& String() const	{ return entry ? entry->string : EmptyString(); }
+		FORCEINLINE uint64_t Hash() const			{ return entry ? entry->hash : 0; }
+		FORCEINLINE bool IsNull() const				{ return entry == NULL; }
+
+		FORCEINLINE bool operator == (const DKAtom& rhs) const	{ return entry == rhs.entry; }
+		FORCEINLINE bool operator != (const DKAtom& rhs) const	{ return entry != rhs.entry; }
+		FORCEINLINE bool operator < (const DKAtom& rhs) const	{ return entry < rhs.entry; }
+		FORCEINLINE bool operator > (const DKAtom& rhs) const	{ return entry > rhs.entry; }
+
+	private:
+		FORCEINLINE DKAtom(const Private::AtomEntry* e) : entry(e) {}
+		static const DKString& EmptyString();
+
+		const Private::AtomEntry* entry;
+	};
+
+	/// Template Spealization for DKAtom. (for DKHashMap, DKHashSet)
+	template <> struct DKHashKeyHasher<DKAtom>
+	{
+		uint64_t operator () (const DKAtom& atom) const
+		{
+			return atom.Hash();
+		}
+	};
+}
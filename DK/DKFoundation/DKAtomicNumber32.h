@@ -2,10 +2,11 @@
 //  File: DKAtomicNumber32.h
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2016 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
 #pragma once
+#include <atomic>
 #include "../DKInclude.h"
 
 namespace DKFoundation
@@ -13,25 +14,88 @@ namespace DKFoundation
 	/// @brief A number object which can be increased or decreased atomically.
 	///
 	/// This class does not provide any numeric operators. (except assign)
-	class DKGL_API DKAtomicNumber32
+	/// Functions without memory order are sequentially consistent.
+	/// Relaxed, Acquire, Release variants can be used for performance
+	/// critical path, when ordering of other memory access is not required.
+	/// (ex: statistics counter with Relaxed, reference counter decrement with Release)
+	class DKAtomicNumber32
 	{
 	public:
 		typedef int32_t Value;
-		DKAtomicNumber32(Value initialValue = 0);
-		~DKAtomicNumber32();
-
-		Value Increment();			///< +1, returns previous value.
-		Value Decrement();			///< -1, returns previous value.
-		Value Add(Value addend);		///< +addend, returns previous value.
-		Value Exchange(Value value);	///< set value, returns previous value.
+		constexpr DKAtomicNumber32(Value initialValue = 0) : atomic(initialValue) {}
+		~DKAtomicNumber32() {}
 
+		FORCEINLINE Value Increment(std::memory_order order = std::memory_order_seq_cst)	///< +1, returns previous value.
+		{
+			return atomic.fetch_add(1, order);
+		}
+		FORCEINLINE Value Decrement(std::memory_order order = std::memory_order_seq_cst)	///< -1, returns previous value.
+		{
+			return atomic.fetch_sub(1, order);
+		}
+		FORCEINLINE Value Add(Value addend, std::memory_order order = std::memory_order_seq_cst)	///< +addend, returns previous value.
+		{
+			return atomic.fetch_add(addend, order);
+		}
+		FORCEINLINE Value AddAndFetch(Value addend, std::memory_order order = std::memory_order_seq_cst)	///< +addend, returns new value.
+		{
+			return atomic.fetch_add(addend, order) + addend;
+		}
+		FORCEINLINE Value Exchange(Value value, std::memory_order order = std::memory_order_seq_cst)	///< set value, returns previous value.
+		{
+			return atomic.exchange(value, order);
+		}
 		/// compare and set when equal. return true when operation succeeded.
-		bool CompareAndSet(Value comparand, Value value);
+		FORCEINLINE bool CompareAndSet(Value comparand, Value value, std::memory_order order = std::memory_order_seq_cst)
+		{
+			return atomic.compare_exchange_strong(comparand, value, order);
+		}
+		FORCEINLINE Value Load(std::memory_order order = std::memory_order_seq_cst) const
+		{
+			return atomic.load(order);
+		}
+		FORCEINLINE void Store(Value value, std::memory_order order = std::memory_order_seq_cst)
+		{
+			atomic.store(value, order);
+		}
+
+		FORCEINLINE Value IncrementRelaxed()	{ return Increment(std::memory_order_relaxed); }
+		FORCEINLINE Value IncrementAcquire()	{ return Increment(std::memory_order_acquire); }
+		FORCEINLINE Value IncrementRelease()	{ return Increment(std::memory_order_release); }
+		FORCEINLINE Value DecrementRelaxed()	{ return Decrement(std::memory_order_relaxed); }
+		FORCEINLINE Value DecrementAcquire()	{ return Decrement(std::memory_order_acquire); }
+		FORCEINLINE Value DecrementRelease()	{ return Decrement(std::memory_order_release); }
+		FORCEINLINE Value AddRelaxed(Value addend)	{ return Add(addend, std::memory_order_relaxed); }
+		FORCEINLINE Value AddAcquire(Value addend)	{ return Add(addend, std::memory_order_acquire); }
+		FORCEINLINE Value AddRelease(Value addend)	{ return Add(addend, std::memory_order_release); }
+		FORCEINLINE Value ExchangeRelaxed(Value value)	{ return Exchange(value, std::memory_order_relaxed); }
+		FORCEINLINE Value ExchangeAcquire(Value value)	{ return Exchange(value, std::memory_order_acquire); }
+		FORCEINLINE Value ExchangeRelease(Value value)	{ return Exchange(value, std::memory_order_release); }
+		FORCEINLINE bool CompareAndSetRelaxed(Value comparand, Value value)	{ return CompareAndSet(comparand, value, std::memory_order_relaxed); }
+		FORCEINLINE bool CompareAndSetAcquire(Value comparand, Value value)	{ return CompareAndSet(comparand, value, std::memory_order_acquire); }
+		FORCEINLINE bool CompareAndSetRelease(Value comparand, Value value)	{ return CompareAndSet(comparand, value, std::memory_order_release); }
+		FORCEINLINE Value LoadRelaxed() const	{ return Load(std::memory_order_relaxed); }
+		FORCEINLINE Value LoadAcquire() const	{ return Load(std::memory_order_acquire); }
+		FORCEINLINE void StoreRelaxed(Value value)	{ Store(value, std::memory_order_relaxed); }
+		FORCEINLINE void StoreRelease(Value value)	{ Store(value, std::memory_order_release); }
 
-		DKAtomicNumber32& operator = (Value value);
-		DKAtomicNumber32& operator += (Value value);
-		operator Value () const;
+		FORCEINLINE DKAtomicNumber32& operator = (Value value)
+		{
+			atomic.store(value);
+			return *this;
+		}
+		FORCEINLINE DKAtomicNumber32& operator += (Value value)
+		{
+			atomic.fetch_add(value);
+			return *this;
+		}
+		FORCEINLINE operator Value () const
+		{
+			return atomic.load();
+		}
 	private:
-		volatile Value atomic;
+		DKAtomicNumber32(const DKAtomicNumber32&) = delete;
+		DKAtomicNumber32& operator = (const DKAtomicNumber32&) = delete;
+		std::atomic<Value> atomic;
 	};
 }
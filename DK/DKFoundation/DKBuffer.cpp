@@ -389,6 +389,14 @@ DKObject<DKBuffer> DKBuffer::Base64Decode(const DKStringW& str, DKAllocator& all
 	return NULL;
 }
 
+DKObject<DKBuffer> DKBuffer::Base64Decode(const char* str, size_t len, DKAllocator& alloc)
+{
+	DKObject<DKBuffer> buff = DKOBJECT_NEW DKBuffer(alloc);
+	if (Private::Base64Decode(str, len, buff))
+		return buff;
+	return NULL;
+}
+
 DKObject<DKBuffer> DKBuffer::Compress(const DKCompressor& compressor, DKAllocator& alloc) const
 {
 	const void* p = this->LockShared();
@@ -50,6 +50,7 @@ namespace DKFoundation
 		bool Base64Encode(DKStringW& strOut) const;
 		static DKObject<DKBuffer> Base64Decode(const DKStringU8& str, DKAllocator& alloc = DKAllocator::DefaultAllocator());
 		static DKObject<DKBuffer> Base64Decode(const DKStringW& str, DKAllocator& alloc = DKAllocator::DefaultAllocator());
+		static DKObject<DKBuffer> Base64Decode(const char* str, size_t len, DKAllocator& alloc = DKAllocator::DefaultAllocator());
 
 		/// create object from file or URL.
 		static DKObject<DKBuffer> Create(const DKString& url, DKAllocator& alloc = DKAllocator::DefaultAllocator());
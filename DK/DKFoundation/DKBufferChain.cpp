@@ -0,0 +1,271 @@
+//
+//  File: DKBufferChain.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include "DKBufferChain.h"
+#include "DKBuffer.h"
+#include "DKFile.h"
+
+using namespace DKFoundation;
+
+DKBufferChain::DKBufferChain()
+	: length(0)
+{
+}
+
+DKBufferChain::DKBufferChain(const DKBufferChain& c)
+	: segments(c.segments)
+	, offsets(c.offsets)
+	, length(c.length)
+{
+}
+
+DKBufferChain::DKBufferChain(DKBufferChain&& c)
+	: segments(static_cast<DKArray<DKObject<DKData>>&&>(c.segments))
+	, offsets(static_cast<DKArray<size_t>&&>(c.offsets))
+	, length(c.length)
+{
+	c.length = 0;
+}
+
+DKBufferChain::~DKBufferChain()
+{
+}
+
+void DKBufferChain::Append(DKData* data)
+{
+	if (data)
+	{
+		size_t len = data->Length();
+		if (len > 0)	// empty segment is not stored.
+		{
+			segments.Add(data);
+			offsets.Add(length);
+			length += len;
+		}
+	}
+}
+
+void DKBufferChain::Append(DKData* data, size_t offset, size_t len)
+{
+	if (data)
+	{
+		if (offset == 0 && len >= data->Length())
+			Append(data);
+		else
+			Append(data->Slice(offset, len));
+	}
+}
+
+void DKBufferChain::Append(const DKBufferChain& chain)
+{
+	if (&chain == this)
+	{
+		DKBufferChain tmp(chain);
+		Append(tmp);
+		return;
+	}
+	segments.Reserve(segments.Count() + chain.segments.Count());
+	offsets.Reserve(offsets.Count() + chain.offsets.Count());
+	for (size_t i = 0; i < chain.segments.Count(); ++i)
+	{
+		segments.Add(chain.segments.Value(i));
+		offsets.Add(length + chain.offsets.Value(i));
+	}
+	length += chain.length;
+}
+
+void DKBufferChain::Append(const void* p, size_t len)
+{
+	if (p && len > 0)
+		Append(DKBuffer::Create(p, len));
+}
+
+void DKBufferChain::Clear()
+{
+	segments.Clear();
+	offsets.Clear();
+	length = 0;
+}
+
+DKData* DKBufferChain::Segment(size_t index) const
+{
+	return const_cast<DKData*>(segments.Value(index).Ptr());
+}
+
+size_t DKBufferChain::SegmentOffset(size_t index) const
+{
+	return offsets.Value(index);
+}
+
+size_t DKBufferChain::SegmentIndex(size_t offset) const
+{
+	if (offset >= length)
+		return segments.Count();
+	size_t index = offsets.UpperBound(offset, [](size_t lhs, size_t rhs) { return lhs < rhs; });
+	DKASSERT_DEBUG(index > 0);
+	return index - 1;
+}
+
+size_t DKBufferChain::CopyBytes(size_t offset, void* p, size_t len) const
+{
+	if (offset >= length)
+		return 0;
+	len = Min(len, length - offset);
+
+	uint8_t* dst = reinterpret_cast<uint8_t*>(p);
+	size_t copied = 0;
+	for (size_t i = SegmentIndex(offset); copied < len && i < segments.Count(); ++i)
+	{
+		const DKData* data = segments.Value(i);
+		size_t begin = offset + copied - offsets.Value(i);
+		size_t s = Min(len - copied, data->Length() - begin);
+
+		const uint8_t* src = reinterpret_cast<const uint8_t*>(data->LockShared());
+		memcpy(&dst[copied], &src[begin], s);
+		data->UnlockShared();
+		copied += s;
+	}
+	return copied;
+}
+
+DKBufferChain DKBufferChain::SubChain(size_t offset, size_t len) const
+{
+	DKBufferChain chain;
+	if (offset < length)
+	{
+		len = Min(len, length - offset);
+		size_t end = offset + len;
+		for (size_t i = SegmentIndex(offset); i < segments.Count() && offsets.Value(i) < end; ++i)
+		{
+			DKData* data = const_cast<DKData*>(segments.Value(i).Ptr());
+			size_t segBegin = offsets.Value(i);
+			size_t begin = Max(offset, segBegin) - segBegin;
+			size_t s = Min(end - segBegin, data->Length()) - begin;
+			chain.Append(data, begin, s);
+		}
+	}
+	return chain;
+}
+
+DKObject<DKData> DKBufferChain::Flatten(size_t offset, size_t len) const
+{
+	if (offset >= length)
+		return DKBuffer::Create(NULL, 0).SafeCast<DKData>();
+	len = Min(len, length - offset);
+
+	size_t index = SegmentIndex(offset);
+	DKData* data = const_cast<DKData*>(segments.Value(index).Ptr());
+	size_t begin = offset - offsets.Value(index);
+	if (begin + len <= data->Length())
+	{
+		if (begin == 0 && len == data->Length())
+			return data;
+		return data->Slice(begin, len);
+	}
+
+	DKObject<DKBuffer> buffer = DKBuffer::Create(NULL, len);
+	if (buffer == NULL)
+		return NULL;	// out of memory!
+	void* p = buffer->LockExclusive();
+	CopyBytes(offset, p, len);
+	buffer->UnlockExclusive();
+	return buffer.SafeCast<DKData>();
+}
+
+bool DKBufferChain::WriteToStream(DKStream* stream) const
+{
+	if (stream && stream->IsWritable())
+	{
+		DKFile* file = dynamic_cast<DKFile*>(stream);
+		if (file)	// gather write
+			return file->Write(*this) == length;
+
+		for (const DKObject<DKData>& data : segments)
+		{
+			if (!data->WriteToStream(stream))
+				return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+DKBufferChain& DKBufferChain::operator = (const DKBufferChain& c)
+{
+	if (this != &c)
+	{
+		segments = c.segments;
+		offsets = c.offsets;
+		length = c.length;
+	}
+	return *this;
+}
+
+DKBufferChain& DKBufferChain::operator = (DKBufferChain&& c)
+{
+	if (this != &c)
+	{
+		segments = static_cast<DKArray<DKObject<DKData>>&&>(c.segments);
+		offsets = static_cast<DKArray<size_t>&&>(c.offsets);
+		length = c.length;
+		c.length = 0;
+	}
+	return *this;
+}
+
+DKBufferChainStream::DKBufferChainStream(const DKBufferChain& c)
+	: chain(c)
+	, offset(0)
+{
+}
+
+DKBufferChainStream::DKBufferChainStream(DKBufferChain&& c)
+	: chain(static_cast<DKBufferChain&&>(c))
+	, offset(0)
+{
+}
+
+DKBufferChainStream::~DKBufferChainStream()
+{
+}
+
+DKStream::Position DKBufferChainStream::SetCurrentPosition(Position p)
+{
+	if (p <= chain.Length())
+		this->offset = p;
+	else
+		return PositionError;
+	return this->offset;
+}
+
+DKStream::Position DKBufferChainStream::CurrentPosition() const
+{
+	return this->offset;
+}
+
+DKStream::Position DKBufferChainStream::RemainLength() const
+{
+	return chain.Length() - this->offset;
+}
+
+DKStream::Position DKBufferChainStream::TotalLength() const
+{
+	return chain.Length();
+}
+
+size_t DKBufferChainStream::Read(void* p, size_t s)
+{
+	size_t numRead = chain.CopyBytes(this->offset, p, s);
+	this->offset += numRead;
+	return numRead;
+}
+
+size_t DKBufferChainStream::Write(const void*, size_t)
+{
+	return 0;
+}
@@ -0,0 +1,114 @@
+//
+//  File: DKBufferChain.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKObject.h"
+#include "DKArray.h"
+#include "DKData.h"
+#include "DKStream.h"
+
+namespace DKFoundation
+{
+	/**
+	 @brief
+	 Sequence of data segments (rope), treated as one contiguous byte range.
+
+	 Segments are retained without copying content, appending data or
+	 sub-range of data does not copy bytes. (see DKData::Slice)
+	 Use DKBufferChainStream to read chain with stream interface,
+	 DKFile::Write(const DKBufferChain&) writes all segments with single
+	 system call. (writev)
+
+	 @code
+	  DKBufferChain chain;
+	  chain.Append(header);             // DKData
+	  chain.Append(archive, 128, 4096); // sub-range of archive
+	  file->Write(chain);
+	 @endcode
+
+	 @note
+	  This class is not thread-safe.
+	  Length of segment is cached when appended, segment data should not be
+	  resized while it is in chain.
+	 */
+	class DKGL_API DKBufferChain
+	{
+	public:
+		DKBufferChain();
+		DKBufferChain(const DKBufferChain&);
+		DKBufferChain(DKBufferChain&&);
+		~DKBufferChain();
+
+		/// append data segment, data is retained.
+		void Append(DKData* data);
+		/// append sub-range of data segment.
+		void Append(DKData* data, size_t offset, size_t length);
+		/// append all segments of chain.
+		void Append(const DKBufferChain& chain);
+		/// append copy of bytes.
+		void Append(const void* p, size_t length);
+		void Clear();
+
+		/// total length of all segments
+		size_t Length() const				{ return length; }
+		size_t NumberOfSegments() const		{ return segments.Count(); }
+		DKData* Segment(size_t index) const;
+		/// offset of segment in chain.
+		size_t SegmentOffset(size_t index) const;
+		/// index of segment which contains offset.
+		/// returns NumberOfSegments() if offset is out of range.
+		size_t SegmentIndex(size_t offset) const;
+
+		/// copy bytes, returns number of bytes copied.
+		size_t CopyBytes(size_t offset, void* p, size_t length) const;
+		/// sub-range of chain, segments are shared.
+		DKBufferChain SubChain(size_t offset, size_t length) const;
+		/// contiguous data of range.
+		/// returns slice of segment without copying if range is in one segment.
+		DKObject<DKData> Flatten(size_t offset = 0, size_t length = ~size_t(0)) const;
+
+		bool WriteToStream(DKStream* stream) const;
+
+		DKBufferChain& operator = (const DKBufferChain&);
+		DKBufferChain& operator = (DKBufferChain&&);
+
+	private:
+		DKArray<DKObject<DKData>> segments;
+		DKArray<size_t> offsets;	// start offset of each segment
+		size_t length;
+	};
+
+	/// @brief Read-only stream object for DKBufferChain
+	class DKGL_API DKBufferChainStream : public DKStream
+	{
+	public:
+		DKBufferChainStream(const DKBufferChain&);
+		DKBufferChainStream(DKBufferChain&&);
+		~DKBufferChainStream();
+
+		Position SetCurrentPosition(Position p) override;
+		Position CurrentPosition() const override;
+		Position RemainLength() const override;
+		Position TotalLength() const override;
+
+		size_t Read(void* p, size_t s) override;
+		size_t Write(const void* p, size_t s) override;
+
+		bool IsReadable() const override { return true; }
+		bool IsSeekable() const override { return true; }
+		bool IsWritable() const override { return false; }
+
+		const DKBufferChain& Chain() const { return chain; }
+
+	private:
+		DKBufferChain chain;
+		size_t offset;
+		DKBufferChainStream(const DKBufferChainStream&) = delete;
+		DKBufferChainStream& operator = (const DKBufferChainStream&) = delete;
+	};
+}
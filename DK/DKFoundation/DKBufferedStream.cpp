@@ -0,0 +1,210 @@
+//
+//  File: DKBufferedStream.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include "DKBufferedStream.h"
+
+using namespace DKFoundation;
+
+DKBufferedStream::DKBufferedStream(DKStream* s, size_t size)
+	: stream(s)
+	, bufferSize(Max(size, size_t(256)))
+	, writeLength(0)
+	, readOffset(0)
+	, readLength(0)
+	, writeFailed(false)
+{
+}
+
+DKBufferedStream::~DKBufferedStream()
+{
+	FlushWrite();
+	DiscardRead();
+}
+
+bool DKBufferedStream::FlushWrite()
+{
+	if (writeLength > 0)
+	{
+		size_t wrote = stream->Write((uint8_t*)buffer, writeLength);
+		bool result = wrote == writeLength;
+		writeLength = 0;
+		if (!result)
+			writeFailed = true;
+		return result;
+	}
+	return true;
+}
+
+void DKBufferedStream::DiscardRead()
+{
+	if (readOffset < readLength)
+	{
+		// give unread bytes back to stream.
+		Position pos = stream->CurrentPosition();
+		if (pos != PositionError)
+			stream->SetCurrentPosition(pos - (readLength - readOffset));
+	}
+	readOffset = 0;
+	readLength = 0;
+}
+
+bool DKBufferedStream::Flush()
+{
+	bool result = false;
+	if (stream)
+	{
+		result = FlushWrite() && !writeFailed;
+		DiscardRead();
+	}
+	writeFailed = false;
+	return result;
+}
+
+DKStream::Position DKBufferedStream::SetCurrentPosition(Position p)
+{
+	if (stream == NULL || !FlushWrite())
+		return PositionError;
+
+	if (readLength > 0)
+	{
+		Position pos = stream->CurrentPosition();
+		if (pos != PositionError && pos >= readLength)
+		{
+			Position bufferBegin = pos - readLength;
+			if (p >= bufferBegin && p <= pos)	// in read buffer
+			{
+				readOffset = static_cast<size_t>(p - bufferBegin);
+				return p;
+			}
+		}
+		readOffset = 0;
+		readLength = 0;
+	}
+	return stream->SetCurrentPosition(p);
+}
+
+DKStream::Position DKBufferedStream::CurrentPosition() const
+{
+	if (stream)
+	{
+		Position pos = stream->CurrentPosition();
+		if (pos != PositionError)
+			return pos + writeLength - (readLength - readOffset);
+	}
+	return PositionError;
+}
+
+DKStream::Position DKBufferedStream::RemainLength() const
+{
+	Position total = TotalLength();
+	Position pos = CurrentPosition();
+	if (total != PositionError && pos != PositionError && total > pos)
+		return total - pos;
+	return 0;
+}
+
+DKStream::Position DKBufferedStream::TotalLength() const
+{
+	if (stream)
+	{
+		Position total = stream->TotalLength();
+		if (total != PositionError && writeLength > 0)
+		{
+			Position pos = CurrentPosition();
+			if (pos != PositionError)
+				return Max(total, pos);
+		}
+		return total;
+	}
+	return 0;
+}
+
+size_t DKBufferedStream::Read(void* p, size_t s)
+{
+	if (stream == NULL || p == NULL)
+		return 0;
+	if (writeLength > 0 && !FlushWrite())
+		return 0;
+
+	uint8_t* dst = reinterpret_cast<uint8_t*>(p);
+	size_t totalRead = 0;
+	while (s > 0)
+	{
+		if (readOffset < readLength)
+		{
+			size_t n = Min(s, readLength - readOffset);
+			memcpy(dst, &((uint8_t*)buffer)[readOffset], n);
+			readOffset += n;
+			dst += n;
+			s -= n;
+			totalRead += n;
+			continue;
+		}
+		readOffset = 0;
+		readLength = 0;
+
+		size_t numRead;
+		if (s >= bufferSize)	// read directly
+		{
+			numRead = stream->Read(dst, s);
+			if (numRead == 0 || numRead == (size_t)-1)
+				break;
+			dst += numRead;
+			s -= numRead;
+			totalRead += numRead;
+		}
+		else
+		{
+			if (buffer.Count() < bufferSize)
+				buffer.Resize(bufferSize);
+			numRead = stream->Read((uint8_t*)buffer, bufferSize);
+			if (numRead == 0 || numRead == (size_t)-1)
+				break;
+			readLength = numRead;
+		}
+	}
+	return totalRead;
+}
+
+size_t DKBufferedStream::Write(const void* p, size_t s)
+{
+	if (stream == NULL || p == NULL || s == 0)
+		return 0;
+
+	if (readLength > 0)
+		DiscardRead();
+
+	if (writeLength + s > bufferSize)
+	{
+		if (!FlushWrite())
+			return 0;
+	}
+	if (s >= bufferSize)	// write directly
+		return stream->Write(p, s);
+
+	if (buffer.Count() < bufferSize)
+		buffer.Resize(bufferSize);
+	memcpy(&((uint8_t*)buffer)[writeLength], p, s);
+	writeLength += s;
+	return s;
+}
+
+bool DKBufferedStream::IsReadable() const
+{
+	return stream && stream->IsReadable();
+}
+
+bool DKBufferedStream::IsWritable() const
+{
+	return stream && stream->IsWritable();
+}
+
+bool DKBufferedStream::IsSeekable() const
+{
+	return stream && stream->IsSeekable();
+}
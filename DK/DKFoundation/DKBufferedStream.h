@@ -0,0 +1,81 @@
+//
+//  File: DKBufferedStream.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKStream.h"
+#include "DKObject.h"
+#include "DKArray.h"
+
+namespace DKFoundation
+{
+	/**
+	 @brief
+	 Stream object which buffers reads and writes of another stream.
+
+	 Small writes are coalesced into buffer and written to the stream at once,
+	 small reads are served from buffer filled with large read.
+	 Writes larger than buffer are passed to the stream directly.
+
+	 @code
+	  DKObject<DKFile> file = DKFile::Create(path, DKFile::ModeOpenNew, DKFile::ModeShareExclusive);
+	  DKBufferedStream stream(file);
+	  variant.ExportStream(&stream);
+	  if (!stream.Flush())
+	      ...
+	 @endcode
+
+	 @note
+	  Pending writes are flushed when object destroyed, but error can be
+	  detected only with Flush().
+	  Unread bytes in buffer are given back to the stream by seeking back,
+	  only seekable stream can be read through this object.
+	  This class is not thread-safe.
+	 */
+	class DKGL_API DKBufferedStream : public DKStream
+	{
+	public:
+		enum : size_t { DefaultBufferSize = 0x10000 };
+
+		DKBufferedStream(DKStream* stream, size_t bufferSize = DefaultBufferSize);
+		~DKBufferedStream();
+
+		Position SetCurrentPosition(Position p) override;
+		Position CurrentPosition() const override;
+		Position RemainLength() const override;
+		Position TotalLength() const override;
+
+		size_t Read(void* p, size_t s) override;
+		size_t Write(const void* p, size_t s) override;
+
+		bool IsReadable() const override;
+		bool IsWritable() const override;
+		bool IsSeekable() const override;
+
+		/// write pending data to stream, discard read buffer.
+		/// returns false if data could not be written.
+		bool Flush();
+
+		DKStream* Stream()				{ return stream; }
+		const DKStream* Stream() const	{ return stream; }
+
+	private:
+		bool FlushWrite();
+		void DiscardRead();
+
+		DKObject<DKStream> stream;
+		DKArray<uint8_t> buffer;	// allocated when first used
+		size_t bufferSize;
+		size_t writeLength;		// pending bytes to write
+		size_t readOffset;		// read buffer: [readOffset, readLength)
+		size_t readLength;
+		bool writeFailed;
+
+		DKBufferedStream(const DKBufferedStream&) = delete;
+		DKBufferedStream& operator = (const DKBufferedStream&) = delete;
+	};
+}
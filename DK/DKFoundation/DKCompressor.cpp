@@ -10,7 +10,9 @@
 
 #include "../Libs/zlib/zlib.h"
 
+#define ZSTD_STATIC_LINKING_ONLY	// dictionary stream API, zstd is linked statically.
 #include "../Libs/zstd/lib/zstd.h"
+#include "../Libs/zstd/lib/dictBuilder/zdict.h"
 
 #include "../Libs/lz4/lib/lz4.h"
 #include "../Libs/lz4/lib/lz4hc.h"
@@ -19,7 +21,15 @@
 
 #include "DKCompressor.h"
 #include "DKEndianness.h"
+#include "DKOperationQueue.h"
+#include "DKCondition.h"
+#include "DKArray.h"
+#include "DKMap.h"
+#include "DKBuffer.h"
+#include "DKCriticalSection.h"
+#include "DKUtils.h"
 #include "DKLog.h"
+#include "DKProfiler.h"
 
 #define COMPRESSION_CHUNK_SIZE 0x40000
 
@@ -174,7 +184,23 @@ namespace DKFoundation::Private
         return false;
     }
 
-    static bool CompressZstd(DKStream* input, DKStream* output, int level)
+    // Zstd stream contexts are cached per thread, to reduce setup cost of
+    // compressing many small data. (context of ZstdMax is not cached, it's too large)
+    struct ZstdThreadContext
+    {
+        ZSTD_CStream* cstream = nullptr;
+        ZSTD_DStream* dstream = nullptr;
+        ~ZstdThreadContext()
+        {
+            if (cstream)
+                ZSTD_freeCStream(cstream);
+            if (dstream)
+                ZSTD_freeDStream(dstream);
+        }
+    };
+    static thread_local ZstdThreadContext zstdThreadContext;
+
+    static bool CompressZstd(DKStream* input, DKStream* output, int level, const ZSTD_CDict* cdict)
     {
         CompressorBuffer inputBuffer(ZSTD_CStreamInSize());
         CompressorBuffer outputBuffer(ZSTD_CStreamOutSize());
@@ -197,12 +223,15 @@ namespace DKFoundation::Private
         };
         ZSTD_CStream* const cstream = ZSTD_createCStream_advanced(customMem);
 #else
-        ZSTD_CStream* const cstream = ZSTD_createCStream();
+        ZSTD_CStream* const cstream = zstdThreadContext.cstream ? zstdThreadContext.cstream : ZSTD_createCStream();
+        zstdThreadContext.cstream = nullptr;
 #endif
         if (cstream)
         {
             bool result = false;
-            size_t const initResult = ZSTD_initCStream(cstream, level);
+            size_t const initResult = cdict ?
+                ZSTD_initCStream_usingCDict(cstream, cdict) :
+                ZSTD_initCStream(cstream, level);
             if (ZSTD_isError(initResult))
             {
                 DKLogE("DKCompressor::Compress error: ZSTD_initCStream failed: %s",
@@ -269,7 +298,10 @@ namespace DKFoundation::Private
                     }
                 }
             }
-            ZSTD_freeCStream(cstream);
+            if (level <= ZSTD_CLEVEL_DEFAULT && zstdThreadContext.cstream == nullptr)
+                zstdThreadContext.cstream = cstream;
+            else
+                ZSTD_freeCStream(cstream);
             return result;
         }
         else
@@ -279,7 +311,7 @@ namespace DKFoundation::Private
         return false;
     }
 
-    static bool DecompressZstd(DKStream* input, DKStream* output)
+    static bool DecompressZstd(DKStream* input, DKStream* output, const ZSTD_DDict* ddict)
     {
         CompressorBuffer inputBuffer(ZSTD_DStreamInSize());
         CompressorBuffer outputBuffer(ZSTD_DStreamOutSize());
@@ -302,12 +334,15 @@ namespace DKFoundation::Private
         };
         ZSTD_DStream* const dstream = ZSTD_createDStream_advanced(customMem);
 #else
-        ZSTD_DStream* const dstream = ZSTD_createDStream();
+        ZSTD_DStream* const dstream = zstdThreadContext.dstream ? zstdThreadContext.dstream : ZSTD_createDStream();
+        zstdThreadContext.dstream = nullptr;
 #endif
         if (dstream)
         {
             bool result = false;
-            size_t const initResult = ZSTD_initDStream(dstream);
+            size_t const initResult = ddict ?
+                ZSTD_initDStream_usingDDict(dstream, ddict) :
+                ZSTD_initDStream(dstream);
             if (ZSTD_isError(initResult))
             {
                 DKLogE("DKCompressor::Compress error: ZSTD_initDStream failed: %s",
@@ -355,7 +390,10 @@ namespace DKFoundation::Private
                 }
             }
 
-            ZSTD_freeDStream(dstream);
+            if (zstdThreadContext.dstream == nullptr)
+                zstdThreadContext.dstream = dstream;
+            else
+                ZSTD_freeDStream(dstream);
             return result;
         }
         else
@@ -640,12 +678,610 @@ namespace DKFoundation::Private
         return false;
     }
 
+    struct CompressorDictionaryAccess
+    {
+        using Dictionary = DKCompressor::Dictionary;
+
+        static const ZSTD_CDict* CDict(const Dictionary* dict, DKCompressor::Method method)
+        {
+            const int index = (method == DKCompressor::ZstdMax) ? 1 : 0;
+            DKCriticalSection<DKSpinLock> guard(dict->lock);
+            if (dict->cdict[index] == nullptr)
+            {
+                const void* p = dict->data->LockShared();
+                dict->cdict[index] = ZSTD_createCDict(p, dict->data->Length(), index ? 19 : ZSTD_CLEVEL_DEFAULT);
+                dict->data->UnlockShared();
+                if (dict->cdict[index] == nullptr)
+                    DKLogE("DKCompressor Error: ZSTD_createCDict failed");
+            }
+            return reinterpret_cast<const ZSTD_CDict*>(dict->cdict[index]);
+        }
+        static const ZSTD_DDict* DDict(const Dictionary* dict)
+        {
+            DKCriticalSection<DKSpinLock> guard(dict->lock);
+            if (dict->ddict == nullptr)
+            {
+                const void* p = dict->data->LockShared();
+                dict->ddict = ZSTD_createDDict(p, dict->data->Length());
+                dict->data->UnlockShared();
+                if (dict->ddict == nullptr)
+                    DKLogE("DKCompressor Error: ZSTD_createDDict failed");
+            }
+            return reinterpret_cast<const ZSTD_DDict*>(dict->ddict);
+        }
+        static void Release(Dictionary* dict)
+        {
+            for (void* cdict : dict->cdict)
+            {
+                if (cdict)
+                    ZSTD_freeCDict(reinterpret_cast<ZSTD_CDict*>(cdict));
+            }
+            if (dict->ddict)
+                ZSTD_freeDDict(reinterpret_cast<ZSTD_DDict*>(dict->ddict));
+        }
+    };
+
+    struct CompressorDictionaryRegistry
+    {
+        DKSpinLock lock;
+        DKMap<uint32_t, DKObject<DKCompressor::Dictionary>> dictionaries;
+
+        static CompressorDictionaryRegistry& Instance()
+        {
+            static CompressorDictionaryRegistry registry;
+            return registry;
+        }
+    };
+
+    // find registered dictionary of zstd frame.
+    // returns false if frame requires dictionary which is not registered.
+    static bool FindZstdFrameDictionary(const void* p, size_t n, DKObject<DKCompressor::Dictionary>& dict, const ZSTD_DDict*& ddict)
+    {
+        ddict = nullptr;
+        unsigned dictID = ZSTD_getDictID_fromFrame(p, n);
+        if (dictID)
+        {
+            dict = DKCompressor::FindDictionary(dictID);
+            if (dict == nullptr)
+            {
+                DKLogE("DKCompressor Error: Dictionary (ID:%u) not found!", dictID);
+                return false;
+            }
+            ddict = CompressorDictionaryAccess::DDict(dict);
+            return ddict != nullptr;
+        }
+        return true;
+    }
+
+    // Block container of DKCompressor::CompressParallel
+    //  header: 'D','K','C','B', version(1), method(1), reserved(2), blockSize(4)
+    //  blocks: compressedSize(4), originalSize(4), compressed data
+    //  end:    compressedSize(4) = 0, originalSize(4) = 0
+    // all integers are little-endian.
+    enum : uint32_t
+    {
+        BlockContainerMagic = 0x42434B44U,	// 'DKCB'
+        BlockContainerVersion = 1,
+        BlockContainerMaxBlockSize = 0x40000000U,	// 1GB
+    };
+    struct BlockContainerHeader
+    {
+        uint32_t magic;
+        uint8_t version;
+        uint8_t method;
+        uint16_t reserved;
+        uint32_t blockSize;
+    };
+    struct BlockHeader
+    {
+        uint32_t compressedSize;
+        uint32_t originalSize;
+    };
+    static_assert(sizeof(BlockContainerHeader) == 12, "Invalid header size");
+    static_assert(sizeof(BlockHeader) == 8, "Invalid header size");
+
+    static bool IsBlockContainer(const void* p, size_t n)
+    {
+        return n >= sizeof(uint32_t) &&
+            DKLittleEndianToSystem(reinterpret_cast<const uint32_t*>(p)[0]) == BlockContainerMagic;
+    }
+
+    struct CompressorBlock
+    {
+        void* input;
+        size_t inputLength;
+        void* output;
+        size_t outputLength;
+        bool done;
+        bool result;
+
+        CompressorBlock() : input(nullptr), inputLength(0), output(nullptr), outputLength(0), done(true), result(false) {}
+        ~CompressorBlock()
+        {
+            if (input)
+                DKFree(input);
+            if (output)
+                DKFree(output);
+        }
+        bool Reserve(size_t inputSize, size_t outputSize)
+        {
+            void* p = DKRealloc(input, inputSize);
+            if (p == nullptr)
+                return false;
+            input = p;
+            p = DKRealloc(output, outputSize);
+            if (p == nullptr)
+                return false;
+            output = p;
+            return true;
+        }
+    };
+
+    static LZ4F_preferences_t LZ4BlockPreferences(DKCompressor::Method method)
+    {
+        LZ4F_preferences_t prefs = {};
+        prefs.compressionLevel = (method == DKCompressor::LZ4HC) ? 9 : 0;
+        prefs.frameInfo.blockMode = LZ4F_blockLinked;
+        prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+        prefs.frameInfo.blockSizeID = LZ4F_max4MB;
+        return prefs;
+    }
+
+    static size_t CompressBlockBound(DKCompressor::Method method, size_t length)
+    {
+        switch (method)
+        {
+        case DKCompressor::Zlib:
+            return compressBound((uLong)length);
+        case DKCompressor::Zstd:
+        case DKCompressor::ZstdMax:
+            return ZSTD_compressBound(length);
+        case DKCompressor::LZ4:
+        case DKCompressor::LZ4HC:
+        {
+            LZ4F_preferences_t prefs = LZ4BlockPreferences(method);
+            return LZ4F_compressFrameBound(length, &prefs);
+        }
+        }
+        return 0;
+    }
+
+    // compress single block into independent zlib, zstd or lz4 frame.
+    static bool CompressBlock(DKCompressor::Method method, CompressorBlock& block, size_t outputCapacity, const ZSTD_CDict* cdict)
+    {
+        switch (method)
+        {
+        case DKCompressor::Zlib:
+        {
+            uLongf outputLength = (uLongf)outputCapacity;
+            int err = compress2((Bytef*)block.output, &outputLength, (const Bytef*)block.input, (uLong)block.inputLength, 5);
+            if (err == Z_OK)
+            {
+                block.outputLength = outputLength;
+                return true;
+            }
+            DKLogE("DKCompressor::CompressParallel error: zlib error: %d", err);
+            return false;
+        }
+        case DKCompressor::Zstd:
+        case DKCompressor::ZstdMax:
+        {
+            int level = (method == DKCompressor::ZstdMax) ? 19 : ZSTD_CLEVEL_DEFAULT;
+            size_t result = 0;
+            if (cdict)
+            {
+                ZSTD_CCtx* cctx = ZSTD_createCCtx();
+                if (cctx == nullptr)
+                {
+                    DKLogE("DKCompressor::CompressParallel error: ZSTD_createCCtx failed");
+                    return false;
+                }
+                result = ZSTD_compress_usingCDict(cctx, block.output, outputCapacity, block.input, block.inputLength, cdict);
+                ZSTD_freeCCtx(cctx);
+            }
+            else
+                result = ZSTD_compress(block.output, outputCapacity, block.input, block.inputLength, level);
+            if (!ZSTD_isError(result))
+            {
+                block.outputLength = result;
+                return true;
+            }
+            DKLogE("DKCompressor::CompressParallel error: %s", ZSTD_getErrorName(result));
+            return false;
+        }
+        case DKCompressor::LZ4:
+        case DKCompressor::LZ4HC:
+        {
+            LZ4F_preferences_t prefs = LZ4BlockPreferences(method);
+            size_t result = LZ4F_compressFrame(block.output, outputCapacity, block.input, block.inputLength, &prefs);
+            if (!LZ4F_isError(result))
+            {
+                block.outputLength = result;
+                return true;
+            }
+            DKLogE("DKCompressor::CompressParallel error: LZ4 Encoding error: %s", LZ4F_getErrorName(result));
+            return false;
+        }
+        }
+        return false;
+    }
+
+    // decompress single frame, output length must be original size.
+    static bool DecompressBlock(DKCompressor::Method method, CompressorBlock& block)
+    {
+        switch (method)
+        {
+        case DKCompressor::Zlib:
+        {
+            uLongf outputLength = (uLongf)block.outputLength;
+            int err = uncompress((Bytef*)block.output, &outputLength, (const Bytef*)block.input, (uLong)block.inputLength);
+            if (err == Z_OK && outputLength == block.outputLength)
+                return true;
+            DKLogE("DKCompressor::Decompress error: zlib error: %d", err);
+            return false;
+        }
+        case DKCompressor::Zstd:
+        case DKCompressor::ZstdMax:
+        {
+            DKObject<DKCompressor::Dictionary> dict;
+            const ZSTD_DDict* ddict;
+            if (!FindZstdFrameDictionary(block.input, block.inputLength, dict, ddict))
+                return false;
+            size_t result = 0;
+            if (ddict)
+            {
+                ZSTD_DCtx* dctx = ZSTD_createDCtx();
+                if (dctx == nullptr)
+                {
+                    DKLogE("DKCompressor::Decompress error: ZSTD_createDCtx failed");
+                    return false;
+                }
+                result = ZSTD_decompress_usingDDict(dctx, block.output, block.outputLength, block.input, block.inputLength, ddict);
+                ZSTD_freeDCtx(dctx);
+            }
+            else
+                result = ZSTD_decompress(block.output, block.outputLength, block.input, block.inputLength);
+            if (!ZSTD_isError(result) && result == block.outputLength)
+                return true;
+            DKLogE("DKCompressor::Decompress error: %s",
+                   ZSTD_isError(result) ? ZSTD_getErrorName(result) : "Invalid block size");
+            return false;
+        }
+        case DKCompressor::LZ4:
+        case DKCompressor::LZ4HC:
+        {
+            LZ4F_decompressionContext_t ctx;
+            LZ4F_errorCode_t err = LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION);
+            if (LZ4F_isError(err))
+            {
+                DKLogE("DKCompressor::Decompress error: LZ4 Decoder error: %s", LZ4F_getErrorName(err));
+                return false;
+            }
+            const uint8_t* src = reinterpret_cast<const uint8_t*>(block.input);
+            uint8_t* dst = reinterpret_cast<uint8_t*>(block.output);
+            size_t srcRemain = block.inputLength;
+            size_t dstRemain = block.outputLength;
+            size_t hint = 1;
+            while (hint != 0 && srcRemain > 0)
+            {
+                size_t srcSize = srcRemain;
+                size_t dstSize = dstRemain;
+                hint = LZ4F_decompress(ctx, dst, &dstSize, src, &srcSize, NULL);
+                if (LZ4F_isError(hint))
+                {
+                    DKLogE("DKCompressor::Decompress error: LZ4 Decoder error: %s", LZ4F_getErrorName(hint));
+                    break;
+                }
+                if (srcSize == 0 && dstSize == 0)
+                    break;	// no progress
+                src += srcSize;
+                srcRemain -= srcSize;
+                dst += dstSize;
+                dstRemain -= dstSize;
+            }
+            LZ4F_freeDecompressionContext(ctx);
+            return hint == 0 && dstRemain == 0;
+        }
+        }
+        return false;
+    }
+
+    // Read blocks from input in order, process them with queue concurrently,
+    // and write processed blocks to output in order.
+    // readBlock returns 1 if block was read, 0 if end of input, -1 on error.
+    template <typename ReadBlock, typename ProcessBlock, typename WriteBlock>
+    static bool ProcessBlocksParallel(DKOperationQueue* queue,
+                                      ReadBlock&& readBlock,
+                                      ProcessBlock&& processBlock,
+                                      WriteBlock&& writeBlock)
+    {
+        DKObject<DKOperationQueue> localQueue;
+        if (queue == nullptr)
+        {
+            localQueue = DKOBJECT_NEW DKOperationQueue();
+            localQueue->SetMaxConcurrentOperations(Max(DKNumberOfProcessors(), 1U));
+            queue = localQueue;
+        }
+        // keep double blocks of threads, to fill idle threads while writing.
+        const size_t numBlocks = Max(queue->MaxConcurrentOperations(), size_t(1)) * 2;
+        DKArray<CompressorBlock> blocks;
+        blocks.Resize(numBlocks);
+
+        DKCondition cond;
+        uint64_t readIndex = 0;
+        uint64_t writeIndex = 0;
+        bool inputEnd = false;
+        bool failed = false;
+        while (true)
+        {
+            while (!inputEnd && !failed && readIndex - writeIndex < numBlocks)
+            {
+                CompressorBlock& block = blocks.Value(readIndex % numBlocks);
+                int r = readBlock(block);
+                if (r <= 0)
+                {
+                    inputEnd = true;
+                    failed = r < 0;
+                    break;
+                }
+                block.done = false;
+                queue->Post([&block, &cond, &processBlock]
+                {
+                    bool result = processBlock(block);
+                    cond.Lock();
+                    block.result = result;
+                    block.done = true;
+                    cond.Broadcast();
+                    cond.Unlock();
+                });
+                readIndex++;
+            }
+            if (writeIndex == readIndex)
+                break;
+
+            // wait and write blocks in order. (remaining blocks should be
+            // processed before return, even if failed)
+            CompressorBlock& block = blocks.Value(writeIndex % numBlocks);
+            cond.Lock();
+            while (!block.done)
+                cond.Wait();
+            cond.Unlock();
+            if (!failed)
+                failed = !block.result || !writeBlock(block);
+            writeIndex++;
+        }
+        return !failed;
+    }
+
+    static bool CompressBlocks(DKStream* input, DKStream* output, DKCompressor::Method method, size_t blockSize, const ZSTD_CDict* cdict, DKOperationQueue* queue)
+    {
+        BlockContainerHeader header = {
+            DKSystemToLittleEndian(uint32_t(BlockContainerMagic)),
+            BlockContainerVersion,
+            uint8_t(method),
+            0,
+            DKSystemToLittleEndian(uint32_t(blockSize))
+        };
+        if (output->Write(&header, sizeof(header)) != sizeof(header))
+        {
+            DKLogE("DKCompressor Error: Output stream error!");
+            return false;
+        }
+
+        const size_t outputCapacity = CompressBlockBound(method, blockSize);
+        auto readBlock = [&](CompressorBlock& block)->int
+        {
+            if (!block.Reserve(blockSize, outputCapacity))
+            {
+                DKLogE("DKCompressor Error: Out of memory!");
+                return -1;
+            }
+            // fill block, stream can return less than requested.
+            size_t length = 0;
+            while (length < blockSize)
+            {
+                size_t read = input->Read(reinterpret_cast<uint8_t*>(block.input) + length, blockSize - length);
+                if (read == DKStream::PositionError)
+                {
+                    DKLogE("DKCompressor Error: Input stream error!");
+                    return -1;
+                }
+                if (read == 0)
+                    break;
+                length += read;
+            }
+            block.inputLength = length;
+            return length > 0 ? 1 : 0;
+        };
+        auto processBlock = [&](CompressorBlock& block)->bool
+        {
+            return CompressBlock(method, block, outputCapacity, cdict);
+        };
+        auto writeBlock = [&](CompressorBlock& block)->bool
+        {
+            BlockHeader bh = {
+                DKSystemToLittleEndian(uint32_t(block.outputLength)),
+                DKSystemToLittleEndian(uint32_t(block.inputLength))
+            };
+            if (output->Write(&bh, sizeof(bh)) != sizeof(bh) ||
+                output->Write(block.output, block.outputLength) != block.outputLength)
+            {
+                DKLogE("DKCompressor Error: Output stream error!");
+                return false;
+            }
+            return true;
+        };
+        if (ProcessBlocksParallel(queue, readBlock, processBlock, writeBlock))
+        {
+            BlockHeader end = { 0, 0 };
+            if (output->Write(&end, sizeof(end)) == sizeof(end))
+                return true;
+            DKLogE("DKCompressor Error: Output stream error!");
+        }
+        return false;
+    }
+
+    static bool ReadFully(DKStream* input, void* p, size_t length)
+    {
+        size_t total = 0;
+        while (total < length)
+        {
+            size_t read = input->Read(reinterpret_cast<uint8_t*>(p) + total, length - total);
+            if (read == DKStream::PositionError || read == 0)
+                return false;
+            total += read;
+        }
+        return true;
+    }
+
+    static bool DecompressBlocks(DKStream* input, DKStream* output, DKOperationQueue* queue)
+    {
+        BlockContainerHeader header;
+        if (!ReadFully(input, &header, sizeof(header)))
+        {
+            DKLogE("DKCompressor Error: Input stream error!");
+            return false;
+        }
+        const uint32_t blockSize = DKLittleEndianToSystem(header.blockSize);
+        const DKCompressor::Method method = static_cast<DKCompressor::Method>(header.method);
+        if (DKLittleEndianToSystem(header.magic) != BlockContainerMagic ||
+            header.version != BlockContainerVersion ||
+            method > DKCompressor::LZ4HC ||
+            blockSize == 0 || blockSize > BlockContainerMaxBlockSize)
+        {
+            DKLogE("DKCompressor Error: Invalid block container header!");
+            return false;
+        }
+        const size_t maxCompressedSize = CompressBlockBound(method, blockSize);
+
+        bool endOfBlocks = false;
+        auto readBlock = [&](CompressorBlock& block)->int
+        {
+            BlockHeader bh;
+            if (!ReadFully(input, &bh, sizeof(bh)))
+            {
+                DKLogE("DKCompressor Error: Input stream error!");
+                return -1;
+            }
+            block.inputLength = DKLittleEndianToSystem(bh.compressedSize);
+            block.outputLength = DKLittleEndianToSystem(bh.originalSize);
+            if (block.inputLength == 0 && block.outputLength == 0)
+            {
+                endOfBlocks = true;
+                return 0;
+            }
+            if (block.inputLength == 0 || block.inputLength > maxCompressedSize ||
+                block.outputLength == 0 || block.outputLength > blockSize)
+            {
+                DKLogE("DKCompressor Error: Invalid block header!");
+                return -1;
+            }
+            if (!block.Reserve(block.inputLength, block.outputLength))
+            {
+                DKLogE("DKCompressor Error: Out of memory!");
+                return -1;
+            }
+            if (!ReadFully(input, block.input, block.inputLength))
+            {
+                DKLogE("DKCompressor Error: Input stream error!");
+                return -1;
+            }
+            return 1;
+        };
+        auto processBlock = [&](CompressorBlock& block)->bool
+        {
+            return DecompressBlock(method, block);
+        };
+        auto writeBlock = [&](CompressorBlock& block)->bool
+        {
+            if (output->Write(block.output, block.outputLength) != block.outputLength)
+            {
+                DKLogE("DKCompressor Error: Output stream error!");
+                return false;
+            }
+            return true;
+        };
+        return ProcessBlocksParallel(queue, readBlock, processBlock, writeBlock) && endOfBlocks;
+    }
 }
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
-DKCompressor::DKCompressor(Method m)
+DKCompressor::Dictionary::Dictionary(DKData* d, uint32_t id)
+	: data(d)
+	, dictID(id)
+	, cdict{ NULL, NULL }
+	, ddict(NULL)
+{
+}
+
+DKCompressor::Dictionary::~Dictionary()
+{
+	CompressorDictionaryAccess::Release(this);
+}
+
+DKObject<DKCompressor::Dictionary> DKCompressor::Dictionary::Train(const DKData* const* samples, size_t numSamples, size_t maxSize)
+{
+	DKArray<size_t> sampleSizes;
+	sampleSizes.Reserve(numSamples);
+	size_t totalSize = 0;
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		size_t length = samples[i] ? samples[i]->Length() : 0;
+		sampleSizes.Add(length);
+		totalSize += length;
+	}
+	if (totalSize == 0 || maxSize == 0)
+		return NULL;
+
+	// samples should be continuous.
+	CompressorBuffer samplesBuffer(totalSize);
+	CompressorBuffer dictBuffer(maxSize);
+	if (samplesBuffer.buffer == nullptr || dictBuffer.buffer == nullptr)
+	{
+		DKLogE("DKCompressor Error: Out of memory!");
+		return NULL;
+	}
+	uint8_t* p = reinterpret_cast<uint8_t*>(samplesBuffer.buffer);
+	for (size_t i = 0; i < numSamples; ++i)
+	{
+		if (sampleSizes.Value(i) > 0)
+		{
+			memcpy(p, samples[i]->LockShared(), sampleSizes.Value(i));
+			samples[i]->UnlockShared();
+			p += sampleSizes.Value(i);
+		}
+	}
+	size_t result = ZDICT_trainFromBuffer(dictBuffer.buffer, maxSize,
+										  samplesBuffer.buffer, sampleSizes, (unsigned)numSamples);
+	if (ZDICT_isError(result))
+	{
+		DKLogE("DKCompressor::Dictionary error: %s", ZDICT_getErrorName(result));
+		return NULL;
+	}
+	return Create(DKBuffer::Create(dictBuffer.buffer, result));
+}
+
+DKObject<DKCompressor::Dictionary> DKCompressor::Dictionary::Create(const DKData* data)
+{
+	if (data && data->Length() > 0)
+	{
+		DKObject<DKData> buffer = DKBuffer::Create(data).SafeCast<DKData>();
+		if (buffer)
+		{
+			uint32_t dictID = ZDICT_getDictID(buffer->LockShared(), buffer->Length());
+			buffer->UnlockShared();
+			if (dictID)
+				return DKOBJECT_NEW Dictionary(buffer, dictID);
+			DKLogE("DKCompressor::Dictionary error: Invalid dictionary (no dictionary ID)");
+		}
+	}
+	return NULL;
+}
+
+DKCompressor::DKCompressor(Method m, Dictionary* dict)
 	: method(m)
+	, dictionary(dict)
 {
 }
 
@@ -653,8 +1289,46 @@ DKCompressor::~DKCompressor()
 {
 }
 
+bool DKCompressor::RegisterDictionary(Dictionary* dict)
+{
+	if (dict)
+	{
+		CompressorDictionaryRegistry& registry = CompressorDictionaryRegistry::Instance();
+		DKCriticalSection<DKSpinLock> guard(registry.lock);
+		if (registry.dictionaries.Insert(dict->ID(), dict))
+			return true;
+		auto p = registry.dictionaries.Find(dict->ID());
+		return p && p->value == dict;
+	}
+	return false;
+}
+
+void DKCompressor::UnregisterDictionary(Dictionary* dict)
+{
+	if (dict)
+	{
+		CompressorDictionaryRegistry& registry = CompressorDictionaryRegistry::Instance();
+		DKCriticalSection<DKSpinLock> guard(registry.lock);
+		auto p = registry.dictionaries.Find(dict->ID());
+		if (p && p->value == dict)
+			registry.dictionaries.Remove(dict->ID());
+	}
+}
+
+DKObject<DKCompressor::Dictionary> DKCompressor::FindDictionary(uint32_t dictID)
+{
+	CompressorDictionaryRegistry& registry = CompressorDictionaryRegistry::Instance();
+	DKCriticalSection<DKSpinLock> guard(registry.lock);
+	auto p = registry.dictionaries.Find(dictID);
+	if (p)
+		return p->value;
+	return NULL;
+}
+
 bool DKCompressor::Compress(DKStream* input, DKStream* output) const
 {
+	DKPROFILE_SCOPE("DKCompressor::Compress");
+
 	if (input == NULL || input->IsReadable() == false)
 		return false;
 	if (output == NULL || output->IsWritable() == false)
@@ -666,10 +1340,12 @@ bool DKCompressor::Compress(DKStream* input, DKStream* output) const
         return CompressDeflate(input, output, 5); // Z_DEFAULT_COMPRESSION is 6
         break;
     case Zstd:
-        return CompressZstd(input, output, ZSTD_CLEVEL_DEFAULT);
+        return CompressZstd(input, output, ZSTD_CLEVEL_DEFAULT,
+                            dictionary ? CompressorDictionaryAccess::CDict(dictionary, method) : nullptr);
         break;
     case ZstdMax:
-        return CompressZstd(input, output, 19);// Clamp(19, int(ZSTD_CLEVEL_DEFAULT), ZSTD_maxCLevel()));
+        return CompressZstd(input, output, 19,// Clamp(19, int(ZSTD_CLEVEL_DEFAULT), ZSTD_maxCLevel()));
+                            dictionary ? CompressorDictionaryAccess::CDict(dictionary, method) : nullptr);
         break;
     case LZ4:
         return CompressLZ4(input, output, 0);
@@ -682,8 +1358,37 @@ bool DKCompressor::Compress(DKStream* input, DKStream* output) const
     return false;
 }
 
-bool DKCompressor::Decompress(DKStream* input, DKStream* output)
+bool DKCompressor::CompressParallel(DKStream* input, DKStream* output, DKOperationQueue* queue, size_t blockSize) const
+{
+	DKPROFILE_SCOPE("DKCompressor::CompressParallel");
+
+	if (input == NULL || input->IsReadable() == false)
+		return false;
+	if (output == NULL || output->IsWritable() == false)
+		return false;
+
+    switch (method)
+    {
+    case Zlib:
+    case Zstd:
+    case ZstdMax:
+    case LZ4:
+    case LZ4HC:
+        blockSize = Clamp(blockSize, size_t(0x10000), size_t(BlockContainerMaxBlockSize));
+        return CompressBlocks(input, output, method, blockSize,
+                              (dictionary && (method == Zstd || method == ZstdMax)) ?
+                              CompressorDictionaryAccess::CDict(dictionary, method) : nullptr,
+                              queue);
+        break;
+    }
+    DKLogE("DKCompressor::CompressParallel error: Unknown format.");
+    return false;
+}
+
+bool DKCompressor::Decompress(DKStream* input, DKStream* output, DKOperationQueue* queue)
 {
+	DKPROFILE_SCOPE("DKCompressor::Decompress");
+
 	if (input == NULL || input->IsReadable() == false)
 		return false;
 	if (output == NULL || output->IsWritable() == false)
@@ -769,6 +1474,9 @@ bool DKCompressor::Decompress(DKStream* input, DKStream* output)
         return false;
     }
 
+    if (IsBlockContainer(bufferedInputStream.preloadedData, bufferedInputStream.preloadedLength))
+        return DecompressBlocks(&bufferedInputStream, output, queue);
+
     Method method;
     if (DetectMethod(bufferedInputStream.preloadedData, bufferedInputStream.preloadedLength, method))
     {
@@ -779,8 +1487,13 @@ bool DKCompressor::Decompress(DKStream* input, DKStream* output)
             break;
         case Zstd:
         case ZstdMax:
-            return DecompressZstd(&bufferedInputStream, output);
-            break;
+        {
+            DKObject<Dictionary> dict;
+            const ZSTD_DDict* ddict;
+            if (FindZstdFrameDictionary(bufferedInputStream.preloadedData, bufferedInputStream.preloadedLength, dict, ddict))
+                return DecompressZstd(&bufferedInputStream, output, ddict);
+            return false;
+        }
         case LZ4:
         case LZ4HC:
             return DecompressLZ4(&bufferedInputStream, output);
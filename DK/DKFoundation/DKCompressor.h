@@ -9,11 +9,32 @@
 #include "../DKInclude.h"
 #include "DKStream.h"
 #include "DKFunction.h"
+#include "DKData.h"
+#include "DKSpinLock.h"
 
 namespace DKFoundation
 {
+	class DKOperationQueue;
+	namespace Private { struct CompressorDictionaryAccess; }
 	/** @brief
 	 A compression utility class, supports ZLib, Zstd, LZ4 compression.
+
+	 CompressParallel() splits input into independent blocks and compresses
+	 them concurrently with DKOperationQueue. Compressed blocks are written
+	 in order, in a block container format. Decompress() detects the container
+	 and decompresses blocks concurrently.
+
+	 Small data (a few KB) can be compressed with Zstd dictionary for better
+	 ratio. Dictionary can be trained from samples and stored with Data().
+	 Compressed data has dictionary ID, Decompress() finds dictionary from
+	 registered dictionaries with RegisterDictionary().
+
+	 @code
+	  DKObject<DKCompressor::Dictionary> dict = DKCompressor::Dictionary::Train(samples, numSamples);
+	  DKCompressor::RegisterDictionary(dict);
+	  DKObject<DKBuffer> compressed = DKBuffer::Compress(DKCompressor(DKCompressor::Zstd, dict), p, len);
+	  DKObject<DKBuffer> data = compressed->Decompress();
+	 @endcode
 	 */
 	class DKCompressor
 	{
@@ -30,13 +51,59 @@ namespace DKFoundation
             BestRatio = ZstdMax,
             Fastest = LZ4,
 		};
-		DKCompressor(Method);
+		enum : size_t
+		{
+			DefaultBlockSize = 0x400000,	///< 4MB, block size of CompressParallel()
+		};
+
+		/// Zstd dictionary, created CDict, DDict are cached.
+		class Dictionary
+		{
+		public:
+			enum : size_t { DefaultSize = 0x1c000 };	///< 112KB
+
+			/// train dictionary from samples. (samples should be similar small data)
+			static DKObject<Dictionary> Train(const DKData* const* samples, size_t numSamples, size_t maxSize = DefaultSize);
+			/// create dictionary from data of Train(). (or 'zstd --train')
+			static DKObject<Dictionary> Create(const DKData* data);
+
+			~Dictionary();
+
+			uint32_t ID() const			{ return dictID; }
+			const DKData* Data() const	{ return data; }
+
+		private:
+			friend struct Private::CompressorDictionaryAccess;
+			Dictionary(DKData*, uint32_t);
+			Dictionary(const Dictionary&) = delete;
+			Dictionary& operator = (const Dictionary&) = delete;
+
+			DKObject<DKData> data;
+			uint32_t dictID;
+			mutable DKSpinLock lock;
+			mutable void* cdict[2];	///< ZSTD_CDict, for Zstd, ZstdMax
+			mutable void* ddict;	///< ZSTD_DDict
+		};
+
+		/// dictionary is used for Zstd, ZstdMax only.
+		DKCompressor(Method, Dictionary* dictionary = NULL);
 		~DKCompressor();
 
 		bool Compress(DKStream* input, DKStream* output) const;
-		static bool Decompress(DKStream* input, DKStream* output);
+		/// compress input blocks concurrently with queue.
+		/// a temporary queue with all processors is used if queue is NULL.
+		bool CompressParallel(DKStream* input, DKStream* output, DKOperationQueue* queue = NULL, size_t blockSize = DefaultBlockSize) const;
+		/// decompress any format of Compress(), CompressParallel().
+		/// blocks of CompressParallel() output are decompressed concurrently with queue.
+		static bool Decompress(DKStream* input, DKStream* output, DKOperationQueue* queue = NULL);
+
+		/// register dictionary for Decompress(). returns false if other dictionary has same ID.
+		static bool RegisterDictionary(Dictionary*);
+		static void UnregisterDictionary(Dictionary*);
+		static DKObject<Dictionary> FindDictionary(uint32_t dictID);
 
 	private:
 		Method method;
+		DKObject<Dictionary> dictionary;
 	};
 }
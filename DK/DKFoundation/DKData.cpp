@@ -9,7 +9,75 @@
 #include "DKFile.h"
 #include "DKFunction.h"
 
+namespace DKFoundation
+{
+	namespace Private
+	{
+		struct DataSlice : public DKData
+		{
+			DKObject<DKData> source;
+			size_t offset;
+			size_t length;
+
+			size_t Length() const override
+			{
+				// source can be shrunk. (DKBuffer)
+				size_t len = source->Length();
+				if (offset >= len)
+					return 0;
+				return Min(length, len - offset);
+			}
+			bool IsReadable() const override	{ return source->IsReadable(); }
+			bool IsWritable() const override	{ return source->IsWritable(); }
+			bool IsExcutable() const override	{ return source->IsExcutable(); }
+			bool IsTransient() const override	{ return source->IsTransient(); }
+
+			const void* LockShared() const override
+			{
+				return Offset(source->LockShared());
+			}
+			bool TryLockShared(const void** ptr) const override
+			{
+				const void* p = NULL;
+				if (source->TryLockShared(&p))
+				{
+					if (ptr)
+						*ptr = Offset(p);
+					return true;
+				}
+				return false;
+			}
+			void UnlockShared() const override	{ source->UnlockShared(); }
+
+			void* LockExclusive() override
+			{
+				return const_cast<void*>(Offset(source->LockExclusive()));
+			}
+			bool TryLockExclusive(void** ptr) override
+			{
+				void* p = NULL;
+				if (source->TryLockExclusive(&p))
+				{
+					if (ptr)
+						*ptr = const_cast<void*>(Offset(p));
+					return true;
+				}
+				return false;
+			}
+			void UnlockExclusive() override		{ source->UnlockExclusive(); }
+
+			const void* Offset(const void* p) const
+			{
+				if (p)
+					return reinterpret_cast<const char*>(p) + offset;
+				return NULL;
+			}
+		};
+	}
+}
+
 using namespace DKFoundation;
+using namespace DKFoundation::Private;
 
 
 DKObject<DKData> DKData::StaticData(void* p, size_t len, bool readonly, DKOperation* cleanup)
@@ -205,3 +273,25 @@ DKObject<DKData> DKData::ImmutableData() const
 	}
 	return NULL;
 }
+
+DKObject<DKData> DKData::Slice(size_t offset, size_t length) const
+{
+	const DKData* source = this;
+	const DataSlice* slice = dynamic_cast<const DataSlice*>(this);
+	if (slice)
+	{
+		source = slice->source;
+		offset = Min(offset, slice->length);
+		length = Min(length, slice->length - offset);
+		offset += slice->offset;
+	}
+	size_t len = source->Length();
+	offset = Min(offset, len);
+	length = Min(length, len - offset);
+
+	DKObject<DataSlice> data = DKOBJECT_NEW DataSlice();
+	data->source = const_cast<DKData*>(source);
+	data->offset = offset;
+	data->length = length;
+	return data.SafeCast<DKData>();
+}
@@ -66,6 +66,13 @@ namespace DKFoundation
 		/// Clone immutable data object.
 		virtual DKObject<DKData> ImmutableData() const;
 
+		/// Create a view of sub-range without copying content.
+		/// The view retains this object and locks this object when it is locked.
+		/// offset and length are clipped to the length of this object.
+		/// Slice of slice refers original data directly.
+		/// @note this object should be managed by DKObject to be retained.
+		DKObject<DKData> Slice(size_t offset, size_t length) const;
+
 
 		DKData(DKData&&) = delete;
 		DKData(const DKData&) = delete;
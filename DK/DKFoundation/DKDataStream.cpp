@@ -33,7 +33,7 @@ DKDataStream::~DKDataStream()
 
 DKStream::Position DKDataStream::SetCurrentPosition(Position p)
 {
-	if (p < TotalLength())
+	if (p <= TotalLength())	// can be end of data, same as after Read() all.
 		this->offset = p;
 	else
 		return PositionError;
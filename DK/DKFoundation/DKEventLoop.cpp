@@ -7,12 +7,13 @@
 
 #include "DKObject.h"
 #include "DKEventLoop.h"
-#include "DKMap.h"
+#include "DKHashMap.h"
 #include "DKArray.h"
 #include "DKSpinLock.h"
 #include "DKFunction.h"
 #include "DKLog.h"
 #include "DKCondition.h"
+#include "DKProfiler.h"
 
 namespace DKFoundation::Private
 {
@@ -22,7 +23,7 @@ namespace DKFoundation::Private
     FORCEINLINE void PerformOperationInsidePool(DKOperation* op) { op->Perform(); }
 #endif
 
-    typedef DKMap<DKThread::ThreadId, DKObject<DKEventLoop>, DKDummyLock> EventLoopMap;
+    typedef DKHashMap<DKThread::ThreadId, DKObject<DKEventLoop>, DKDummyLock> EventLoopMap;
     static EventLoopMap& GetEventLoopMap()
     {
         static EventLoopMap eventLoopMap;
@@ -73,7 +74,21 @@ namespace DKFoundation::Private
         return found;
     }
 
-    static DKCondition resultCond;
+    struct InlineFunctionOperation : public DKOperation
+    {
+        InlineFunctionOperation(DKInlineFunction<void ()>&& fn) : function(static_cast<DKInlineFunction<void ()>&&>(fn)) {}
+        void Perform() const override { function(); }
+        DKInlineFunction<void ()> function;
+    };
+
+    // condition to wake threads waiting for results of commands.
+    // shared with PendingState objects, could be alive longer than DKEventLoop.
+    struct EventLoopCompletionSignal
+    {
+        DKCondition cond;
+        DKAtomicNumber32 numWaiters;
+    };
+
     struct EventLoopPendingState : public DKEventLoop::PendingState
     {
         enum State
@@ -83,81 +98,167 @@ namespace DKFoundation::Private
             StateProcessed,
             StateRevoked,
         };
-        mutable State state;
+        mutable DKAtomicNumber32 state;
+        mutable DKObject<EventLoopCompletionSignal> signal;
 
-        EventLoopPendingState() : state(StatePending)
+        EventLoopPendingState(EventLoopCompletionSignal* s) : state(StatePending), signal(s)
         {
         }
         bool EnterOperation() const
         {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            if (state == StatePending)
-            {
-                state = StateProcessing;
-                return true;
-            }
-            return false;
-        }
-        void LeaveOperation() const
-        {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            DKASSERT(state == StateProcessing);
-            state = StateProcessed;
-            resultCond.Broadcast();
-        }
-        bool Revoke() const override
-        {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            if (state == StatePending)
-            {
-                state = StateRevoked;
-                resultCond.Broadcast();
-            }
-            return state == StateRevoked;
-        }
-        bool Result() const override
-        {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            while (state != StateProcessed && state != StateRevoked)
-                resultCond.Wait();
-
-            return state == StateProcessed;
+            return state.CompareAndSet(StatePending, StateProcessing);
         }
+        void LeaveOperation() const;
+        bool Revoke() const override;
+        bool Result() const override;
         bool IsDone() const override
         {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            return state == StateProcessed;
+            return state.Load() == StateProcessed;
         }
         bool IsRevoked() const override
         {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            return state == StateRevoked;
+            return state.Load() == StateRevoked;
         }
         bool IsPending() const override
         {
-            DKCriticalSection<DKCondition> guard(resultCond);
-            return state == StatePending;
+            return state.Load() == StatePending;
         }
     };
+
+    // d-ary heap of commands, the first item is the earliest.
+    template <typename Command, typename Less>
+    static void HeapPush(DKArray<Command*>& heap, Command* cmd, Less less)
+    {
+        constexpr size_t d = 4;
+        size_t index = heap.Add(cmd);
+        while (index > 0)
+        {
+            size_t parent = (index - 1) / d;
+            if (!less(cmd, heap.Value(parent)))
+                break;
+            heap.Value(index) = heap.Value(parent);
+            index = parent;
+        }
+        heap.Value(index) = cmd;
+    }
+    template <typename Command, typename Less>
+    static Command* HeapPop(DKArray<Command*>& heap, Less less)
+    {
+        constexpr size_t d = 4;
+        DKASSERT_DEBUG(heap.Count() > 0);
+        Command* top = heap.Value(0);
+        Command* last = heap.Value(heap.Count() - 1);
+        heap.Remove(heap.Count() - 1);
+        size_t count = heap.Count();
+        if (count > 0)
+        {
+            size_t index = 0;
+            while (true)
+            {
+                size_t child = index * d + 1;
+                if (child >= count)
+                    break;
+                size_t end = Min(child + d, count);
+                size_t minChild = child;
+                for (size_t i = child + 1; i < end; ++i)
+                {
+                    if (less(heap.Value(i), heap.Value(minChild)))
+                        minChild = i;
+                }
+                if (!less(heap.Value(minChild), last))
+                    break;
+                heap.Value(index) = heap.Value(minChild);
+                index = minChild;
+            }
+            heap.Value(index) = last;
+        }
+        return top;
+    }
 }
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
-bool DKEventLoop::InternalCommandCompareOrder(const InternalCommandTick& lhs, const InternalCommandTick& rhs)
+struct DKEventLoop::InternalCommand
 {
-	return lhs.fire < rhs.fire;
+    enum Type
+    {
+        TypeImmediate,
+        TypeTick,
+        TypeTime,
+    };
+    DKObject<DKOperation>   operation;
+    DKObject<PendingState>  state;
+    InternalCommand*        next;
+    uint64_t                sequence;   // order of commands posted.
+    Type                    type;
+    DKTimer::Tick           fireTick;
+    DKDateTime              fireTime;
+
+    static bool CompareTick(const InternalCommand* lhs, const InternalCommand* rhs)
+    {
+        if (lhs->fireTick == rhs->fireTick)
+            return lhs->sequence < rhs->sequence;
+        return lhs->fireTick < rhs->fireTick;
+    }
+    static bool CompareTime(const InternalCommand* lhs, const InternalCommand* rhs)
+    {
+        if (lhs->fireTime == rhs->fireTime)
+            return lhs->sequence < rhs->sequence;
+        return lhs->fireTime < rhs->fireTime;
+    }
+};
+
+void EventLoopPendingState::LeaveOperation() const
+{
+    DKASSERT(state.Load() == StateProcessing);
+    state.Store(StateProcessed);
+    if (signal->numWaiters.Load() > 0)
+    {
+        DKCriticalSection<DKCondition> guard(signal->cond);
+        signal->cond.Broadcast();
+    }
 }
 
-bool DKEventLoop::InternalCommandCompareOrder(const InternalCommandTime& lhs, const InternalCommandTime& rhs)
+bool EventLoopPendingState::Revoke() const
 {
-	return lhs.fire < rhs.fire;
+    if (state.CompareAndSet(StatePending, StateRevoked))
+    {
+        if (signal->numWaiters.Load() > 0)
+        {
+            DKCriticalSection<DKCondition> guard(signal->cond);
+            signal->cond.Broadcast();
+        }
+    }
+    return state.Load() == StateRevoked;
+}
+
+bool EventLoopPendingState::Result() const
+{
+    auto isFinished = [this]()
+    {
+        auto s = state.Load();
+        return s == StateProcessed || s == StateRevoked;
+    };
+    if (!isFinished())
+    {
+        DKCriticalSection<DKCondition> guard(signal->cond);
+        signal->numWaiters.Increment();
+        while (!isFinished())
+            signal->cond.Wait();
+        signal->numWaiters.Decrement();
+    }
+    return state.Load() == StateProcessed;
 }
 
 DKEventLoop::DKEventLoop()
-: running(false)
+: incomingCommands(NULL)
+, readyQueueFront(NULL)
+, readyQueueBack(NULL)
+, commandSequence(0)
+, numWaiters(0)
+, completion(DKOBJECT_NEW EventLoopCompletionSignal())
 , threadId(DKThread::invalidId)
-, commandQueueTick(&DKEventLoop::InternalCommandCompareOrder)
-, commandQueueTime(&DKEventLoop::InternalCommandCompareOrder)
+, running(false)
 {
 }
 
@@ -200,18 +301,66 @@ bool DKEventLoop::IsRunning() const
 	return false;
 }
 
-void DKEventLoop::InternalPostCommand(const InternalCommandTick& cmd)
+void DKEventLoop::InternalPostCommand(InternalCommand* cmd)
+{
+	// push to lock-free stack, commands will be reordered by MoveIncomingCommandsNL().
+	InternalCommand* top = incomingCommands.load(std::memory_order_relaxed);
+	do {
+		cmd->next = top;
+	} while (!incomingCommands.compare_exchange_weak(top, cmd, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+	// wake up waiting thread.
+	if (numWaiters.Load() > 0)
+	{
+		DKCriticalSection<DKCondition> guard(commandQueueCond);
+		commandQueueCond.Signal();
+	}
+}
+
+bool DKEventLoop::HasIncomingCommands() const
 {
-	DKCriticalSection<DKCondition> guard(commandQueueCond);
-	commandQueueTick.Insert(cmd);
-	commandQueueCond.Signal();
+	return incomingCommands.load(std::memory_order_seq_cst) != NULL;
 }
 
-void DKEventLoop::InternalPostCommand(const InternalCommandTime& cmd)
+void DKEventLoop::MoveIncomingCommandsNL()
 {
-	DKCriticalSection<DKCondition> guard(commandQueueCond);
-	commandQueueTime.Insert(cmd);
-	commandQueueCond.Signal();
+	InternalCommand* cmd = incomingCommands.exchange(NULL, std::memory_order_acquire);
+	if (cmd == NULL)
+		return;
+
+	// reverse stack to get commands in posted order.
+	InternalCommand* list = NULL;
+	while (cmd)
+	{
+		InternalCommand* next = cmd->next;
+		cmd->next = list;
+		list = cmd;
+		cmd = next;
+	}
+	while (list)
+	{
+		cmd = list;
+		list = list->next;
+		cmd->next = NULL;
+		cmd->sequence = commandSequence++;
+
+		switch (cmd->type)
+		{
+		case InternalCommand::TypeImmediate:
+			if (readyQueueBack)
+				readyQueueBack->next = cmd;
+			else
+				readyQueueFront = cmd;
+			readyQueueBack = cmd;
+			break;
+		case InternalCommand::TypeTick:
+			HeapPush(commandQueueTick, cmd, &InternalCommand::CompareTick);
+			break;
+		case InternalCommand::TypeTime:
+			HeapPush(commandQueueTime, cmd, &InternalCommand::CompareTime);
+			break;
+		}
+	}
 }
 
 bool DKEventLoop::BindThread()
@@ -247,9 +396,9 @@ void DKEventLoop::Stop()
 {
 	if (IsRunning())
 	{
-		this->Post(DKFunction([this]() {
+		this->Post([this]() {
 			this->running = false;
-		})->Invocation());
+		});
 	}
 }
 
@@ -257,13 +406,22 @@ DKObject<DKEventLoop::PendingState> DKEventLoop::Post(const DKOperation* operati
 {
 	if (operation)
 	{
-		InternalCommandTick cmd;
-		cmd.operation = const_cast<DKOperation*>(operation);
-		cmd.state = DKOBJECT_NEW EventLoopPendingState();
-		cmd.fire = DKTimer::SystemTick() + static_cast<DKTimer::Tick>(DKTimer::SystemTickFrequency() * Max(delay, 0.0));
+		InternalCommand* cmd = new InternalCommand();
+		cmd->operation = const_cast<DKOperation*>(operation);
+		cmd->state = DKOBJECT_NEW EventLoopPendingState(completion);
+		cmd->fireTick = DKTimer::SystemTick();
+		if (delay > 0.0)
+		{
+			cmd->type = InternalCommand::TypeTick;
+			cmd->fireTick += static_cast<DKTimer::Tick>(DKTimer::SystemTickFrequency() * delay);
+		}
+		else
+		{
+			cmd->type = InternalCommand::TypeImmediate;
+		}
+		DKObject<PendingState> state = cmd->state;
 		InternalPostCommand(cmd);
-
-		return cmd.state;
+		return state;
 	}
 	else
 	{
@@ -278,13 +436,14 @@ DKObject<DKEventLoop::PendingState> DKEventLoop::Post(const DKOperation* operati
 {
 	if (operation)
 	{
-		InternalCommandTime cmd;
-		cmd.operation = const_cast<DKOperation*>(operation);
-		cmd.state = DKOBJECT_NEW EventLoopPendingState();
-		cmd.fire = runAfter;
+		InternalCommand* cmd = new InternalCommand();
+		cmd->operation = const_cast<DKOperation*>(operation);
+		cmd->state = DKOBJECT_NEW EventLoopPendingState(completion);
+		cmd->type = InternalCommand::TypeTime;
+		cmd->fireTime = runAfter;
+		DKObject<PendingState> state = cmd->state;
 		InternalPostCommand(cmd);
-
-		return cmd.state;
+		return state;
 	}
 	else
 	{
@@ -295,6 +454,22 @@ DKObject<DKEventLoop::PendingState> DKEventLoop::Post(const DKOperation* operati
 	return NULL;
 }
 
+DKObject<DKEventLoop::PendingState> DKEventLoop::Post(DKInlineFunction<void ()>&& function, double delay)
+{
+	DKObject<DKOperation> op = NULL;
+	if (function)
+		op = DKOBJECT_NEW InlineFunctionOperation(static_cast<DKInlineFunction<void ()>&&>(function));
+	return this->Post(static_cast<const DKOperation*>(op), delay);
+}
+
+DKObject<DKEventLoop::PendingState> DKEventLoop::Post(DKInlineFunction<void ()>&& function, const DKDateTime& runAfter)
+{
+	DKObject<DKOperation> op = NULL;
+	if (function)
+		op = DKOBJECT_NEW InlineFunctionOperation(static_cast<DKInlineFunction<void ()>&&>(function));
+	return this->Post(static_cast<const DKOperation*>(op), runAfter);
+}
+
 bool DKEventLoop::Process(const DKOperation* op)
 {
 	if (op)
@@ -315,22 +490,28 @@ bool DKEventLoop::Process(const DKOperation* op)
 
 size_t DKEventLoop::RevokeAll()
 {
-	DKCriticalSection<DKCondition> guard(this->commandQueueCond);
-
-	//DKTimer::Tick tick = DKTimer::SystemTick();
+	DKCriticalSection<DKSpinLock> guard(this->commandQueueLock);
+	MoveIncomingCommandsNL();
 
-	size_t numItems = this->commandQueueTick.Count() + this->commandQueueTime.Count();
-
-	auto revoke = [](const InternalCommand& ic)
+	size_t numItems = 0;
+	auto revoke = [&numItems](InternalCommand* ic)
 	{
-		const EventLoopPendingState* state = ic.state.StaticCast<EventLoopPendingState>();
+		const EventLoopPendingState* state = ic->state.StaticCast<EventLoopPendingState>();
 		if (state)
 			state->Revoke();
+		delete ic;
+		numItems++;
 	};
 
-	for (const InternalCommand& ic : this->commandQueueTick)
+	while (InternalCommand* ic = this->readyQueueFront)
+	{
+		this->readyQueueFront = ic->next;
 		revoke(ic);
-	for (const InternalCommand& ic : this->commandQueueTime)
+	}
+	this->readyQueueBack = NULL;
+	for (InternalCommand* ic : this->commandQueueTick)
+		revoke(ic);
+	for (InternalCommand* ic : this->commandQueueTime)
 		revoke(ic);
 
 	this->commandQueueTick.Clear();
@@ -340,29 +521,31 @@ size_t DKEventLoop::RevokeAll()
 
 bool DKEventLoop::GetNextLoopIntervalNL(double* d) const
 {
-	DKTimer::Tick currentTick = DKTimer::SystemTick();
-	DKDateTime currentDate = DKDateTime::Now();
+	if (readyQueueFront || HasIncomingCommands())
+	{
+		*d = 0.0;
+		return true;
+	}
 
-	size_t numTickCmd = 0;
-	size_t numTimeCmd = 0;
+	size_t numTickCmd = commandQueueTick.Count();
+	size_t numTimeCmd = commandQueueTime.Count();
 	double tickDelay = 0;
 	double timeDelay = 0;
 
-	numTickCmd = commandQueueTick.Count();
-	numTimeCmd = commandQueueTime.Count();
-
-	double freq = 1.0 / static_cast<double>(DKTimer::SystemTickFrequency());
 	if (numTickCmd > 0)
 	{
-		const InternalCommandTick& cmd = commandQueueTick.Value(0);
-		if (cmd.fire > currentTick && freq > 0)
-			tickDelay = static_cast<double>(cmd.fire - currentTick) * freq;
+		DKTimer::Tick currentTick = DKTimer::SystemTick();
+		double freq = 1.0 / static_cast<double>(DKTimer::SystemTickFrequency());
+		const InternalCommand* cmd = commandQueueTick.Value(0);
+		if (cmd->fireTick > currentTick && freq > 0)
+			tickDelay = static_cast<double>(cmd->fireTick - currentTick) * freq;
 	}
 	if (numTimeCmd > 0)
 	{
-		const InternalCommandTime& cmd = commandQueueTime.Value(0);
-		if (cmd.fire > currentDate)
-			timeDelay = cmd.fire.Interval(currentDate);
+		DKDateTime currentDate = DKDateTime::Now();
+		const InternalCommand* cmd = commandQueueTime.Value(0);
+		if (cmd->fireTime > currentDate)
+			timeDelay = cmd->fireTime.Interval(currentDate);
 	}
 
 	if (numTickCmd > 0 || numTimeCmd > 0)
@@ -385,9 +568,14 @@ bool DKEventLoop::GetNextLoopIntervalNL(double* d) const
 void DKEventLoop::WaitNextLoop()
 {
 	DKCriticalSection<DKCondition> guard(this->commandQueueCond);
+	numWaiters.Increment();
 
 	double d = 0.0;
-	if (GetNextLoopIntervalNL(&d))
+	commandQueueLock.Lock();
+	bool pending = GetNextLoopIntervalNL(&d);
+	commandQueueLock.Unlock();
+
+	if (pending)
 	{
 		d = Max(d, 0.0);
 		if (d > 0.0)
@@ -397,35 +585,43 @@ void DKEventLoop::WaitNextLoop()
 	{
 		this->commandQueueCond.Wait();
 	}
+	numWaiters.Decrement();
 }
 
 bool DKEventLoop::WaitNextLoopTimeout(double t)
 {
+	bool result = false;
 	if (t > 0.0)
 	{
 		DKCriticalSection<DKCondition> guard(this->commandQueueCond);
+		numWaiters.Increment();
 
 		double d = 0.0;
-		if (GetNextLoopIntervalNL(&d))
+		commandQueueLock.Lock();
+		bool pending = GetNextLoopIntervalNL(&d);
+		commandQueueLock.Unlock();
+
+		if (pending)
 		{
 			double delay = Clamp(d, 0.0, t);
 			if (delay > 0.0)
 			{
 				this->commandQueueCond.WaitTimeout(delay);
 			}
-			return delay < t;
+			result = delay < t;
 		}
 		else
 		{
 			this->commandQueueCond.WaitTimeout(t);
 		}
+		numWaiters.Decrement();
 	}
-	return false;
+	return result;
 }
 
 double DKEventLoop::PendingEventInterval() const
 {
-	DKCriticalSection<DKCondition> guard(this->commandQueueCond);
+	DKCriticalSection<DKSpinLock> guard(this->commandQueueLock);
 
 	double d = 0.0;
 	if (GetNextLoopIntervalNL(&d))
@@ -444,38 +640,44 @@ bool DKEventLoop::Dispatch()
 {
 	DKASSERT_DEBUG(this->threadId == DKThread::CurrentThreadId());
 
-	DKObject<DKOperation> operation = NULL;
-	DKObject<PendingState> state = NULL;
-
-	commandQueueCond.Lock();
+	InternalCommand* cmd = NULL;
 
-	DKDateTime currentTime = DKDateTime::Now();
-	DKTimer::Tick currentTick = DKTimer::SystemTick();
+	commandQueueLock.Lock();
+	MoveIncomingCommandsNL();
 
-	if (operation == NULL && this->commandQueueTick.Count() > 0)
+	if (this->commandQueueTick.Count() > 0)
 	{
-		const InternalCommandTick& cmd = this->commandQueueTick.Value(0);
-		if (cmd.fire <= currentTick)
+		InternalCommand* top = this->commandQueueTick.Value(0);
+		if (top->fireTick <= DKTimer::SystemTick())
 		{
-			operation = cmd.operation;
-			state = cmd.state;
-			this->commandQueueTick.Remove(0);
+			// delayed command could be earlier than ready queue.
+			if (readyQueueFront == NULL || InternalCommand::CompareTick(top, readyQueueFront))
+				cmd = HeapPop(this->commandQueueTick, &InternalCommand::CompareTick);
 		}
 	}
-	if (operation == NULL && this->commandQueueTime.Count() > 0)
+	if (cmd == NULL && readyQueueFront)
 	{
-		const InternalCommandTime& cmd = this->commandQueueTime.Value(0);
-		if (cmd.fire <= currentTime)
-		{
-			operation = cmd.operation;
-			state = cmd.state;
-			this->commandQueueTime.Remove(0);
-		}
+		cmd = readyQueueFront;
+		readyQueueFront = cmd->next;
+		if (readyQueueFront == NULL)
+			readyQueueBack = NULL;
+	}
+	if (cmd == NULL && this->commandQueueTime.Count() > 0)
+	{
+		InternalCommand* top = this->commandQueueTime.Value(0);
+		if (top->fireTime <= DKDateTime::Now())
+			cmd = HeapPop(this->commandQueueTime, &InternalCommand::CompareTime);
 	}
-	commandQueueCond.Unlock();
+	commandQueueLock.Unlock();
 
-	if (operation)
+	if (cmd)
 	{
+		DKPROFILE_SCOPE("DKEventLoop::Dispatch");
+
+		DKObject<DKOperation> operation = cmd->operation;
+		DKObject<PendingState> state = cmd->state;
+		delete cmd;
+
 		struct OpWrapper : public DKOperation
 		{
 			OpWrapper(DKEventLoop* e, DKOperation* o) : el(e), op(o) {}
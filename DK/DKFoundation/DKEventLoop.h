@@ -6,18 +6,23 @@
 //
 
 #pragma once
+#include <atomic>
 #include "../DKInclude.h"
 #include "DKObject.h"
 #include "DKThread.h"
 #include "DKOperation.h"
+#include "DKInlineFunction.h"
 #include "DKDateTime.h"
 #include "DKSpinLock.h"
 #include "DKOrderedArray.h"
 #include "DKTimer.h"
 #include "DKCondition.h"
+#include "DKArray.h"
+#include "DKAtomicNumber32.h"
 
 namespace DKFoundation
 {
+	namespace Private { struct EventLoopCompletionSignal; }
 	/**
 	 @brief
 	 Install the Event-Loop system on the thread that called DKEventLoop::Run().
@@ -40,6 +45,9 @@ namespace DKFoundation
 				   if system time has changed, calling operations will adjusted.
 
 	 @note
+	  Post() pushes operation to lock-free queue, it does not block caller.
+	  Delayed operations are ordered with heap when the loop dispatches them.
+
 	  To make Event-Loop working on a new thread, create a DKThread object and call
 	  'DKEventLoop::Run()' inside new working thread.
 
@@ -114,6 +122,10 @@ namespace DKFoundation
 		/// @param operation an operation object.
 		/// @param runAfter specific date/time to execute operation
 		virtual DKObject<PendingState> Post(const DKOperation* operation, const DKDateTime& runAfter);
+		/// Enqueue function object, (without DKFunction, DKInvocation)
+		/// function will be wrapped with a single operation object.
+		DKObject<PendingState> Post(DKInlineFunction<void ()>&& function, double delay = 0);
+		DKObject<PendingState> Post(DKInlineFunction<void ()>&& function, const DKDateTime& runAfter);
 
 		/// Enqueue operation and wait until done.
 		/// if the function called on working-thread, the operation will be executed immediately.
@@ -154,26 +166,28 @@ namespace DKFoundation
 	private:
 		bool GetNextLoopIntervalNL(double*) const;
 
-		struct InternalCommand
-		{
-			DKObject<DKOperation>	operation;
-			DKObject<PendingState>	state;
+		struct InternalCommand;
+		void InternalPostCommand(InternalCommand* cmd);
+		void MoveIncomingCommandsNL();
+		bool HasIncomingCommands() const;
 
-			virtual ~InternalCommand() {}
-		};
-		struct InternalCommandTick : public InternalCommand { DKTimer::Tick fire; };
-		struct InternalCommandTime : public InternalCommand { DKDateTime fire; };
-		void InternalPostCommand(const InternalCommandTick& cmd);
-		void InternalPostCommand(const InternalCommandTime& cmd);
+		// commands are pushed to lock-free stack by any thread,
+		// and moved to queues by the thread which dispatches commands.
+		std::atomic<InternalCommand*>	incomingCommands;
 
-		DKCondition								commandQueueCond;
-		DKOrderedArray<InternalCommandTick>		commandQueueTick;
-		DKOrderedArray<InternalCommandTime>		commandQueueTime;
+		// queues, guarded by commandQueueLock.
+		mutable DKSpinLock				commandQueueLock;
+		InternalCommand*				readyQueueFront;	// FIFO, without delay
+		InternalCommand*				readyQueueBack;
+		DKArray<InternalCommand*>		commandQueueTick;	// 4-ary heap, by tick
+		DKArray<InternalCommand*>		commandQueueTime;	// 4-ary heap, by date
+		uint64_t						commandSequence;
+
+		DKCondition							commandQueueCond;	// wait for next loop
+		DKAtomicNumber32					numWaiters;
+		DKObject<Private::EventLoopCompletionSignal>	completion;	// shared with PendingState
 
 		DKThread::ThreadId	threadId;
 		bool				running;
-
-		static bool InternalCommandCompareOrder(const InternalCommandTick&, const InternalCommandTick&);
-		static bool InternalCommandCompareOrder(const InternalCommandTime&, const InternalCommandTime&);
 	};
 }
@@ -16,7 +16,9 @@
 #else
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #endif
 
 #include "DKFile.h"
@@ -560,6 +562,109 @@ size_t DKFile::Write(DKStream* s)
 	return 0;
 }
 
+size_t DKFile::Write(const DKBufferChain& chain)
+{
+	if (this->file == DKFILE_INVALID_FILE_HANDLE)
+		return (size_t)-1;
+
+	const size_t numSegments = chain.NumberOfSegments();
+	DKArray<const void*> buffers;
+	buffers.Reserve(numSegments);
+	for (size_t i = 0; i < numSegments; ++i)
+		buffers.Add(chain.Segment(i)->LockShared());
+
+	size_t totalWritten = 0;
+#ifdef _WIN32
+	for (size_t i = 0; i < numSegments; ++i)
+	{
+		size_t len = chain.Segment(i)->Length();
+		size_t numWrote = this->Write(buffers.Value(i), len);
+		if (numWrote == (size_t)-1)
+			break;
+		totalWritten += numWrote;
+		if (numWrote < len)
+			break;
+	}
+#else
+#ifdef IOV_MAX
+	const size_t maxIOV = IOV_MAX;
+#else
+	const size_t maxIOV = 16;
+#endif
+	DKArray<struct iovec> iov;
+	iov.Reserve(Min(numSegments, maxIOV));
+
+	size_t index = 0;
+	size_t offset = 0;	// offset of first segment, after short write.
+	while (index < numSegments)
+	{
+		iov.Clear();
+		for (size_t i = index; i < numSegments && iov.Count() < maxIOV; ++i)
+		{
+			struct iovec v;
+			v.iov_base = const_cast<char*>(reinterpret_cast<const char*>(buffers.Value(i)));
+			v.iov_len = chain.Segment(i)->Length();
+			if (i == index)
+			{
+				v.iov_base = reinterpret_cast<char*>(v.iov_base) + offset;
+				v.iov_len -= offset;
+			}
+			iov.Add(v);
+		}
+		ssize_t numWrote = ::writev((int)this->file, iov, (int)iov.Count());
+		if (numWrote < 0 && errno == EINTR)
+			continue;
+		if (numWrote <= 0)
+			break;
+		totalWritten += numWrote;
+
+		// skip written segments.
+		size_t written = numWrote;
+		while (index < numSegments && written > 0)
+		{
+			size_t remains = chain.Segment(index)->Length() - offset;
+			if (written < remains)
+			{
+				offset += written;
+				written = 0;
+			}
+			else
+			{
+				written -= remains;
+				offset = 0;
+				index++;
+			}
+		}
+	}
+#endif
+	for (size_t i = 0; i < numSegments; ++i)
+		chain.Segment(i)->UnlockShared();
+
+	return totalWritten;
+}
+
+DKObject<DKAsyncIO::Request> DKFile::ReadAsync(void* p, size_t s, uint64_t offset, DKAsyncIO::Completion&& completion, DKEventLoop* eventLoop) const
+{
+	DKObject<DKFile> self = const_cast<DKFile*>(this);
+	return DKAsyncIO::Read(this->file, p, s, offset, [self, fn = static_cast<DKAsyncIO::Completion&&>(completion)](size_t r)
+	{
+		if (fn)
+			fn(r);
+	}, eventLoop);
+}
+
+DKObject<DKAsyncIO::Request> DKFile::WriteAsync(const void* p, size_t s, uint64_t offset, DKAsyncIO::Completion&& completion, DKEventLoop* eventLoop)
+{
+	DKASSERT_DESC_DEBUG(this->modeOpen != ModeOpenReadOnly, "File is read-only!");
+
+	DKObject<DKFile> self = this;
+	return DKAsyncIO::Write(this->file, p, s, offset, [self, fn = static_cast<DKAsyncIO::Completion&&>(completion)](size_t r)
+	{
+		if (fn)
+			fn(r);
+	}, eventLoop);
+}
+
 bool DKFile::GetInfo(const DKString& file, FileInfo& info)
 {
 	if (file.Length() == 0)
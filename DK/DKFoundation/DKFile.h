@@ -11,6 +11,8 @@
 #include "DKString.h"
 #include "DKBuffer.h"
 #include "DKDateTime.h"
+#include "DKBufferChain.h"
+#include "DKAsyncIO.h"
 
 namespace DKFoundation
 {
@@ -70,6 +72,19 @@ namespace DKFoundation
 		size_t Write(const void* p, size_t s) override;
 		size_t Write(const DKData *p);
 		size_t Write(DKStream* s);
+		/// write all segments of chain. (gather write)
+		size_t Write(const DKBufferChain& chain);
+
+		/// asynchronous read at offset, current position is not changed.
+		/// file object is retained until request has been completed.
+		/// see DKAsyncIO for details.
+		DKObject<DKAsyncIO::Request> ReadAsync(void* p, size_t s, uint64_t offset,
+											   DKAsyncIO::Completion&& completion = nullptr,
+											   DKEventLoop* eventLoop = NULL) const;
+		/// asynchronous write at offset, current position is not changed.
+		DKObject<DKAsyncIO::Request> WriteAsync(const void* p, size_t s, uint64_t offset,
+												DKAsyncIO::Completion&& completion = nullptr,
+												DKEventLoop* eventLoop = NULL);
 
 		bool GetInfo(FileInfo& info) const; ///< get file info (for this object)
 		FileInfo GetInfo() const;
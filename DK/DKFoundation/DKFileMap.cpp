@@ -361,7 +361,10 @@ DKObject<DKFileMap> DKFileMap::Open(const DKString &file, size_t size, bool writ
 #if defined(__APPLE__) && defined(__MACH__)
 		int mmapFlags = MAP_FILE | MAP_SHARED;
 #else
-		if (fcntl(fd, F_SETLK, writable ? F_WRLCK : F_RDLCK) == -1)
+		struct flock fl = {};
+		fl.l_type = writable ? F_WRLCK : F_RDLCK;
+		fl.l_whence = SEEK_SET;	// l_start, l_len = 0: entire file
+		if (fcntl(fd, F_SETLK, &fl) == -1)
 			DKLog("fcntl failed: %s\n", strerror(errno));
 		int mmapFlags = MAP_FILE | MAP_SHARED;
 #endif
@@ -101,78 +101,23 @@ namespace DKFoundation
 				return NULL;
 
 			CriticalSection guard(lock);
+			return AllocInternal();
+		}
 
-			if (cachedChunk && cachedChunk->occupied < MaxUnitsPerChunk)
-			{
-				uintptr_t ptr = AllocUnit(cachedChunk);
-				DKASSERT_MEM_DEBUG(ptr);
-				return reinterpret_cast<void*>(ptr);
-			}
-			// find unoccupied unit from each chunks.
-			for (size_t i = 0; i < numChunks; ++i)
-			{
-				if (chunkTable[i].occupied < MaxUnitsPerChunk)
-				{
-					cachedChunk = &chunkTable[i];
-					uintptr_t ptr = AllocUnit(cachedChunk);
-					DKASSERT_MEM_DEBUG(ptr);
-					return reinterpret_cast<void*>(ptr);
-				}
-			}
-			// no space, create new chunk.
-			cachedChunk = NULL;
-			if (numChunks > 0)
-			{
-				ChunkInfo* table = (ChunkInfo*)BaseAllocator::Realloc(chunkTable, sizeof(ChunkInfo) * (numChunks + 1));
-				if (table == NULL) // out of memory!
-					return NULL;
-				chunkTable = table;
-
-				ChunkInfo chunk;
-				if (!AllocChunk(&chunk))
-					return NULL;	// out of memory!
-
-				uintptr_t pos = reinterpret_cast<uintptr_t>(
-															std::upper_bound(&chunkTable[0], &chunkTable[numChunks], chunk.address,
-																			 [](uintptr_t lhs, const ChunkInfo& rhs)
-																			 {
-																				 return lhs < rhs.address;
-																			 }));
-				size_t chunkIndex = (pos - reinterpret_cast<uintptr_t>(&chunkTable[0])) / sizeof(ChunkInfo);
-
-				if (chunkIndex < numChunks)
-				{
-#if 1
-					memmove(&chunkTable[chunkIndex + 1], &chunkTable[chunkIndex], sizeof(ChunkInfo) * (numChunks - chunkIndex));
-#else
-					for (size_t i = numChunks; i > chunkIndex; --i)
-						chunkTable[i] = chunkTable[i-1];
-#endif
-				}
-				chunkTable[chunkIndex] = chunk;
-				cachedChunk = &chunkTable[chunkIndex];
-			}
-			else
+		/// allocate multiple units with single lock.
+		/// returns number of units allocated.
+		size_t AllocUnits(void** units, size_t count)
+		{
+			CriticalSection guard(lock);
+			size_t n = 0;
+			while (n < count)
 			{
-				chunkTable = (ChunkInfo*)BaseAllocator::Alloc(sizeof(ChunkInfo) * (numChunks + 1));
-				if (chunkTable == NULL)
-					return NULL; // out of memory!
-
-				cachedChunk = &chunkTable[numChunks];
-				if (!AllocChunk(cachedChunk)) // out of memory!
-				{
-					BaseAllocator::Free(chunkTable);
-					chunkTable = NULL;
-					cachedChunk = NULL;
-					return NULL;
-				}
+				void* p = AllocInternal();
+				if (p == NULL)
+					break;	// out of memory!
+				units[n++] = p;
 			}
-			DKASSERT_MEM_DEBUG(cachedChunk);
-			numChunks++;
-
-			uintptr_t ptr = AllocUnit(cachedChunk);
-			DKASSERT_MEM_DEBUG(ptr);
-			return reinterpret_cast<void*>(ptr);
+			return n;
 		}
 
 		void Dealloc(void* ptr)
@@ -204,27 +149,36 @@ namespace DKFoundation
 		bool ConditionalDeallocAndPurge(void* ptr, size_t threshold, size_t* bytesPurged)
 		{
 			if (ptr)
+				return ConditionalDeallocUnitsAndPurge(&ptr, 1, threshold, bytesPurged) == 1;
+			return false;
+		}
+
+		/// deallocate multiple units with single lock, and purge unoccupied
+		/// chunks if reserved units exceeds threshold.
+		/// returns number of units deallocated.
+		size_t ConditionalDeallocUnitsAndPurge(void* const* units, size_t count, size_t threshold, size_t* bytesPurged)
+		{
+			size_t n = 0;
+			CriticalSection guard(lock);
+			if (numChunks > 0)
 			{
-				CriticalSection guard(lock);
-				if (numChunks > 0)
+				for (size_t i = 0; i < count; ++i)
 				{
-					if (FindChunkAndDealloc(reinterpret_cast<uintptr_t>(ptr)))
+					if (units[i] && FindChunkAndDealloc(reinterpret_cast<uintptr_t>(units[i])))
+						n++;
+				}
+				if (n > 0 && this->emptyChunks > 0)
+				{
+					if ((this->numChunks * MaxUnitsPerChunk) >=
+						(this->numAllocated + threshold + MaxUnitsPerChunk))
 					{
-						if (this->emptyChunks > 0)
-						{
-							if ((this->numChunks * MaxUnitsPerChunk) >=
-								(this->numAllocated + threshold + MaxUnitsPerChunk))
-							{
-								size_t purged = PurgeInternal();
-								if (bytesPurged)
-									*bytesPurged = purged;
-							}
-						}
-						return true;
+						size_t purged = PurgeInternal();
+						if (bytesPurged)
+							*bytesPurged = purged;
 					}
 				}
 			}
-			return false;
+			return n;
 		}
 
 		/// returns Chunk starting address if ptr was allocated from this object.
@@ -353,6 +307,81 @@ namespace DKFoundation
 		DKFixedSizeAllocator& operator = (const DKFixedSizeAllocator&) = delete;
 
 	private:
+		FORCEINLINE void* AllocInternal()
+		{
+			if (cachedChunk && cachedChunk->occupied < MaxUnitsPerChunk)
+			{
+				uintptr_t ptr = AllocUnit(cachedChunk);
+				DKASSERT_MEM_DEBUG(ptr);
+				return reinterpret_cast<void*>(ptr);
+			}
+			// find unoccupied unit from each chunks.
+			for (size_t i = 0; i < numChunks; ++i)
+			{
+				if (chunkTable[i].occupied < MaxUnitsPerChunk)
+				{
+					cachedChunk = &chunkTable[i];
+					uintptr_t ptr = AllocUnit(cachedChunk);
+					DKASSERT_MEM_DEBUG(ptr);
+					return reinterpret_cast<void*>(ptr);
+				}
+			}
+			// no space, create new chunk.
+			cachedChunk = NULL;
+			if (numChunks > 0)
+			{
+				ChunkInfo* table = (ChunkInfo*)BaseAllocator::Realloc(chunkTable, sizeof(ChunkInfo) * (numChunks + 1));
+				if (table == NULL) // out of memory!
+					return NULL;
+				chunkTable = table;
+
+				ChunkInfo chunk;
+				if (!AllocChunk(&chunk))
+					return NULL;	// out of memory!
+
+				uintptr_t pos = reinterpret_cast<uintptr_t>(
+															std::upper_bound(&chunkTable[0], &chunkTable[numChunks], chunk.address,
+																			 [](uintptr_t lhs, const ChunkInfo& rhs)
+																			 {
+																				 return lhs < rhs.address;
+																			 }));
+				size_t chunkIndex = (pos - reinterpret_cast<uintptr_t>(&chunkTable[0])) / sizeof(ChunkInfo);
+
+				if (chunkIndex < numChunks)
+				{
+#if 1
+					memmove(&chunkTable[chunkIndex + 1], &chunkTable[chunkIndex], sizeof(ChunkInfo) * (numChunks - chunkIndex));
+#else
+					for (size_t i = numChunks; i > chunkIndex; --i)
+						chunkTable[i] = chunkTable[i-1];
+#endif
+				}
+				chunkTable[chunkIndex] = chunk;
+				cachedChunk = &chunkTable[chunkIndex];
+			}
+			else
+			{
+				chunkTable = (ChunkInfo*)BaseAllocator::Alloc(sizeof(ChunkInfo) * (numChunks + 1));
+				if (chunkTable == NULL)
+					return NULL; // out of memory!
+
+				cachedChunk = &chunkTable[numChunks];
+				if (!AllocChunk(cachedChunk)) // out of memory!
+				{
+					BaseAllocator::Free(chunkTable);
+					chunkTable = NULL;
+					cachedChunk = NULL;
+					return NULL;
+				}
+			}
+			DKASSERT_MEM_DEBUG(cachedChunk);
+			numChunks++;
+
+			uintptr_t ptr = AllocUnit(cachedChunk);
+			DKASSERT_MEM_DEBUG(ptr);
+			return reinterpret_cast<void*>(ptr);
+		}
+
 		FORCEINLINE bool AllocChunk(ChunkInfo* info)
 		{
 			uintptr_t ptr = reinterpret_cast<uintptr_t>(UnitAllocator::Alloc(AlignedChunkSize));
@@ -7,8 +7,37 @@
 
 #include <memory.h>
 #include <math.h>
+#include <atomic>
 #include "DKHash.h"
 #include "DKEndianness.h"
+#include "DKOperationQueue.h"
+#include "DKOperation.h"
+#include "DKFileMap.h"
+#include "DKFile.h"
+#include "DKBuffer.h"
+#include "DKUtils.h"
+#include "DKLog.h"
+
+#define XXH_PRIVATE_API	// include xxhash functions as static.
+#include "../Libs/zstd/lib/common/xxhash.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define HASH_X86_ACCELERATION 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#else
+#define HASH_X86_ACCELERATION 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HASH_TARGET(x)	__attribute__((target(x)))
+#else
+#define HASH_TARGET(x)
+#endif
 
 using namespace DKFoundation;
 
@@ -18,6 +47,9 @@ using namespace DKFoundation;
 //  MD5 was implemented based on RFC 1320, 1321
 //  SHA1 was implemented based on NIST FIPS 18001, RFC 3174
 //  SHA256,384,512 was implemented based on NIST FIPS 180-2
+//  SHA1, SHA256 use SHA-NI instructions if available. (x86)
+//  CRC32 uses PCLMULQDQ folding, CRC32C uses SSE4.2 instruction if available.
+//  XXH64 uses xxHash library bundled with zstd.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -145,51 +177,236 @@ namespace DKFoundation
 			ctx->len = 64;
 		}
 
+		////////////////////////////////////////////////////////////////////////////////
+		// CPU features for accelerated hash functions. (detected at run-time)
+		struct HashCPUFeatures
+		{
+			bool sse42;		// CRC32C instruction
+			bool pclmul;	// carry-less multiplication, CRC32 folding
+			bool sha;		// SHA-NI (SHA1, SHA256)
+
+			HashCPUFeatures() : sse42(false), pclmul(false), sha(false)
+			{
+#if HASH_X86_ACCELERATION
+				uint32_t r[4];
+				HashCPUID(0, r);
+				const uint32_t maxLeaf = r[0];
+				if (maxLeaf >= 1)
+				{
+					HashCPUID(1, r);
+					const bool ssse3 = (r[2] >> 9) & 1;
+					const bool sse41 = (r[2] >> 19) & 1;
+					sse42 = (r[2] >> 20) & 1;
+					pclmul = sse41 && ((r[2] >> 1) & 1);
+					if (maxLeaf >= 7)
+					{
+						HashCPUID(7, r);
+						sha = ssse3 && sse41 && ((r[1] >> 29) & 1);
+					}
+				}
+#endif
+			}
+#if HASH_X86_ACCELERATION
+			static void HashCPUID(uint32_t leaf, uint32_t r[4])
+			{
+#ifdef _MSC_VER
+				__cpuidex(reinterpret_cast<int*>(r), leaf, 0);
+#else
+				__cpuid_count(leaf, 0, r[0], r[1], r[2], r[3]);
+#endif
+			}
+#endif
+		};
+		static const HashCPUFeatures& HashCPU()
+		{
+			static const HashCPUFeatures features;
+			return features;
+		}
+
+		////////////////////////////////////////////////////////////////////////////////
+		// CRC32 slice-by-8 tables, generated at compile time.
+		struct CRC32Table
+		{
+			uint32_t table[8][256];
+
+			constexpr CRC32Table(uint32_t poly) : table{}
+			{
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					uint32_t c = i;
+					for (int k = 0; k < 8; ++k)
+						c = (c & 1) ? (c >> 1) ^ poly : (c >> 1);
+					table[0][i] = c;
+				}
+				for (int n = 1; n < 8; ++n)
+				{
+					for (uint32_t i = 0; i < 256; ++i)
+						table[n][i] = (table[n - 1][i] >> 8) ^ table[0][table[n - 1][i] & 0xff];
+				}
+			}
+		};
+		static constexpr CRC32Table crc32Table(0xEDB88320);		// CRC32 (IEEE 802.3)
+		static constexpr CRC32Table crc32cTable(0x82F63B78);	// CRC32C (Castagnoli)
+
+		static uint32_t CRC32SliceBy8(const CRC32Table& t, uint32_t crc, const uint8_t* p, size_t len)
+		{
+			while (len >= 8)
+			{
+				uint32_t a, b;
+				memcpy(&a, p, 4);
+				memcpy(&b, p + 4, 4);
+				a = DKSystemToLittleEndian(a) ^ crc;
+				b = DKSystemToLittleEndian(b);
+				crc = t.table[7][a & 0xff] ^ t.table[6][(a >> 8) & 0xff] ^
+					t.table[5][(a >> 16) & 0xff] ^ t.table[4][a >> 24] ^
+					t.table[3][b & 0xff] ^ t.table[2][(b >> 8) & 0xff] ^
+					t.table[1][(b >> 16) & 0xff] ^ t.table[0][b >> 24];
+				p += 8;
+				len -= 8;
+			}
+			while (len--)
+				crc = t.table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+			return crc;
+		}
+
+#if HASH_X86_ACCELERATION
+		// CRC32 folding with PCLMULQDQ, based on Intel paper:
+		// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+		// len must be multiple of 16, at least 64.
+		HASH_TARGET("sse4.1,pclmul") static uint32_t CRC32FoldPCLMUL(uint32_t crc, const uint8_t* p, size_t len)
+		{
+			alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+			alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+			alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+			alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+			DKASSERT_DEBUG(len >= 64 && (len % 16) == 0);
+
+			__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+			x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+			x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+			x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+			x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+			x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+			x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+			p += 64;
+			len -= 64;
+
+			// fold 4 x 128 bits in parallel
+			while (len >= 64)
+			{
+				x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+				x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+				x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+				x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+				x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+				x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+				x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+				x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+				x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00)));
+				x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10)));
+				x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20)));
+				x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30)));
+				p += 64;
+				len -= 64;
+			}
+
+			// fold into 128 bits
+			x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+			while (len >= 16)
+			{
+				x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+				x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+				x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+				p += 16;
+				len -= 16;
+			}
+
+			// fold 128 bits to 64 bits
+			x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+			x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+			x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+			x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+			x2 = _mm_srli_si128(x1, 4);
+			x1 = _mm_and_si128(x1, x3);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_xor_si128(x1, x2);
+
+			// Barrett reduction to 32 bits
+			x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+			x2 = _mm_and_si128(x1, x3);
+			x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+			x2 = _mm_and_si128(x2, x3);
+			x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+			x1 = _mm_xor_si128(x1, x2);
+			return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+		}
+
+		HASH_TARGET("sse4.2") static uint32_t CRC32CHardware(uint32_t crc, const uint8_t* p, size_t len)
+		{
+#if defined(__x86_64__) || defined(_M_X64)
+			uint64_t crc64 = crc;
+			for (; len >= 8; p += 8, len -= 8)
+			{
+				uint64_t v;
+				memcpy(&v, p, 8);
+				crc64 = _mm_crc32_u64(crc64, v);
+			}
+			crc = static_cast<uint32_t>(crc64);
+#endif
+			for (; len >= 4; p += 4, len -= 4)
+			{
+				uint32_t v;
+				memcpy(&v, p, 4);
+				crc = _mm_crc32_u32(crc, v);
+			}
+			for (; len > 0; ++p, --len)
+				crc = _mm_crc32_u8(crc, *p);
+			return crc;
+		}
+#endif
+
 		////////////////////////////////////////////////////////////////////////////////
 		// update context digest
 		static void HashUpdate32(HashContext* ctx, const void* p, size_t len)
 		{
-			static const uint32_t K[] =
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(p);
+			uint32_t crc = ~(ctx->hash32[0]);
+#if HASH_X86_ACCELERATION
+			if (len >= 64 && HashCPU().pclmul)
 			{
-				0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
-				0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
-				0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
-				0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
-				0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
-				0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
-				0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
-				0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
-				0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
-				0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
-				0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
-				0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
-				0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
-				0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
-				0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
-				0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
-				0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
-				0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
-				0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
-				0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
-				0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
-				0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
-				0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
-				0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
-				0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
-				0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
-				0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
-				0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
-				0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
-				0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
-				0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
-				0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D,
-			};
+				size_t n = len & ~size_t(15);
+				crc = CRC32FoldPCLMUL(crc, data, n);
+				data += n;
+				len -= n;
+			}
+#endif
+			crc = CRC32SliceBy8(crc32Table, crc, data, len);
+			ctx->hash32[0] = ~crc;
+		}
 
+		static void HashUpdate32C(HashContext* ctx, const void* p, size_t len)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(p);
 			uint32_t crc = ~(ctx->hash32[0]);
-
-			for (size_t i = 0; i < len; i++)
-				crc = K[ (crc ^ ((const uint8_t*)p)[i]) & 0xff] ^ (crc >> 8);
-
+#if HASH_X86_ACCELERATION
+			if (HashCPU().sse42)
+				crc = CRC32CHardware(crc, data, len);
+			else
+#endif
+			crc = CRC32SliceBy8(crc32cTable, crc, data, len);
 			ctx->hash32[0] = ~crc;
 		}
 
@@ -265,8 +482,110 @@ namespace DKFoundation
 			}
 		}
 
+		static const uint32_t sha256K[] = {
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+		};
+
+#if HASH_X86_ACCELERATION
+		// SHA1 rounds with SHA-NI, 4 rounds per instruction.
+		// Message schedule W[i] (4 words) is kept in 4 registers, W[i & 3].
+		template <int F> HASH_TARGET("sha,sse4.1,ssse3")
+		static FORCEINLINE void HashRounds160SHANI(__m128i& abcd, __m128i& e, __m128i (&w)[4], int first, const uint8_t* p)
+		{
+			const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+			for (int i = first; i < first + 5; ++i)
+			{
+				if (i < 4)
+					w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16)), mask);
+				else
+					w[i & 3] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[i & 3], w[(i + 1) & 3]), w[(i + 2) & 3]), w[(i + 3) & 3]);
+
+				__m128i e1 = (i == 0) ? _mm_add_epi32(e, w[0]) : _mm_sha1nexte_epu32(e, w[i & 3]);
+				e = abcd;
+				abcd = _mm_sha1rnds4_epu32(abcd, e1, F);
+			}
+		}
+		HASH_TARGET("sha,sse4.1,ssse3") static void HashDigest160SHANI(HashContext* ctx, const void* p, size_t count)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(p);
+			__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctx->hash32)), 0x1B);
+			__m128i e0 = _mm_set_epi32(static_cast<int>(ctx->hash32[4]), 0, 0, 0);
+			__m128i w[4];
+
+			for (size_t i = 0; i < count; ++i, data += 64)
+			{
+				const __m128i abcdSave = abcd;
+				const __m128i e0Save = e0;
+				__m128i e = e0;	// abcd of previous 4 rounds, e0 for first round.
+
+				HashRounds160SHANI<0>(abcd, e, w, 0, data);
+				HashRounds160SHANI<1>(abcd, e, w, 5, data);
+				HashRounds160SHANI<2>(abcd, e, w, 10, data);
+				HashRounds160SHANI<3>(abcd, e, w, 15, data);
+
+				e0 = _mm_sha1nexte_epu32(e, e0Save);
+				abcd = _mm_add_epi32(abcd, abcdSave);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(ctx->hash32), _mm_shuffle_epi32(abcd, 0x1B));
+			ctx->hash32[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+		}
+
+		// SHA256 rounds with SHA-NI, state is kept as (ABEF, CDGH).
+		HASH_TARGET("sha,sse4.1,ssse3") static void HashDigest256SHANI(HashContext* ctx, const void* p, size_t count)
+		{
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(p);
+			const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+			__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&ctx->hash32[0])), 0xB1);		// CDAB
+			__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&ctx->hash32[4])), 0x1B);	// EFGH
+			__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);		// ABEF
+			state1 = _mm_blend_epi16(state1, tmp, 0xF0);			// CDGH
+			__m128i w[4];
+
+			for (size_t i = 0; i < count; ++i, data += 64)
+			{
+				const __m128i abefSave = state0;
+				const __m128i cdghSave = state1;
+
+				for (int n = 0; n < 16; ++n)
+				{
+					if (n < 4)
+						w[n] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + n * 16)), mask);
+					else
+						w[n & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(w[n & 3], w[(n + 1) & 3]),
+																	  _mm_alignr_epi8(w[(n + 3) & 3], w[(n + 2) & 3], 4)),
+														w[(n + 3) & 3]);
+
+					__m128i msg = _mm_add_epi32(w[n & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&sha256K[n * 4])));
+					state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+					state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+				}
+				state0 = _mm_add_epi32(state0, abefSave);
+				state1 = _mm_add_epi32(state1, cdghSave);
+			}
+
+			tmp = _mm_shuffle_epi32(state0, 0x1B);					// FEBA
+			state1 = _mm_shuffle_epi32(state1, 0xB1);				// DCHG
+			state0 = _mm_blend_epi16(tmp, state1, 0xF0);			// DCBA
+			state1 = _mm_alignr_epi8(state1, tmp, 8);				// HGFE
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&ctx->hash32[0]), state0);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&ctx->hash32[4]), state1);
+		}
+#endif
+
 		static void HashDigest160(HashContext* ctx, const void* p, size_t count)
 		{
+#if HASH_X86_ACCELERATION
+			if (HashCPU().sha)
+				return HashDigest160SHANI(ctx, p, count);
+#endif
 			uint32_t A,B,C,D,E,T;
 			uint32_t W[80];
 
@@ -318,17 +637,11 @@ namespace DKFoundation
 
 		static void HashDigest256(HashContext* ctx, const void* p, size_t count)
 		{
+#if HASH_X86_ACCELERATION
+			if (HashCPU().sha)
+				return HashDigest256SHANI(ctx, p, count);
+#endif
 			uint32_t A,B,C,D,E,F,G,H;
-			static const uint32_t K[] = {
-				0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-				0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-				0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-				0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-				0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-				0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-				0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-				0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-			};
 			uint32_t W[64];
 			for (size_t i = 0; i < count; i++)
 			{
@@ -363,7 +676,7 @@ namespace DKFoundation
 					t2 = s0 + maj;
 					s1 = HASH_RIGHT_ROTATE32(E,6) ^ HASH_RIGHT_ROTATE32(E,11) ^ HASH_RIGHT_ROTATE32(E,25);
 					ch = (E & F) ^ ((~E) & G);
-					t1 = H + s1 + ch + K[n] + W[n];
+					t1 = H + s1 + ch + sha256K[n] + W[n];
 
 					H = G;
 					G = F;
@@ -632,6 +945,60 @@ namespace DKFoundation
 		}
 		return false;
 	}
+	DKGL_API DKHashResultCRC32C DKHashCRC32C(const void* p, size_t len)
+	{
+		Private::HashContext ctx;
+		Private::HashInit32(&ctx);
+		Private::HashUpdate32C(&ctx, p, len);
+
+		DKHashResultCRC32C res;
+		res.digest[0] = ctx.hash32[0];
+		return res;
+	}
+	DKGL_API bool DKHashCRC32C(DKStream* stream, DKHashResultCRC32C& result)
+	{
+		if (stream && stream->IsReadable())
+		{
+			char buff[STREAM_BUFFER_SIZE];
+			Private::HashContext ctx;
+			Private::HashInit32(&ctx);
+			size_t read = 0;
+			do {
+				read = stream->Read(buff, STREAM_BUFFER_SIZE);
+				if (read == DKStream::PositionError)
+					return false;
+				Private::HashUpdate32C(&ctx, buff, read);
+			} while (read);
+			result.digest[0] = ctx.hash32[0];
+			return true;
+		}
+		return false;
+	}
+	DKGL_API DKHashResultXXH64 DKHashXXH64(const void* p, size_t len, uint64_t seed)
+	{
+		DKHashResultXXH64 res;
+		res.digest[0] = XXH64(p, len, seed);
+		return res;
+	}
+	DKGL_API bool DKHashXXH64(DKStream* stream, DKHashResultXXH64& result, uint64_t seed)
+	{
+		if (stream && stream->IsReadable())
+		{
+			char buff[STREAM_BUFFER_SIZE];
+			XXH64_state_t state;
+			XXH64_reset(&state, seed);
+			size_t read = 0;
+			do {
+				read = stream->Read(buff, STREAM_BUFFER_SIZE);
+				if (read == DKStream::PositionError)
+					return false;
+				XXH64_update(&state, buff, read);
+			} while (read);
+			result.digest[0] = XXH64_digest(&state);
+			return true;
+		}
+		return false;
+	}
 	DKGL_API DKHashResultMD5 DKHashMD5(const void* p, size_t len)
 	{
 		DEBUG_CHECK_RUNTIME_ENDIANNESS;
@@ -1042,3 +1409,83 @@ DKHashResult512 DKHash512::Result() const
 		res.digest[i] = ctxt->hash32[i];
 	return res;
 }
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		DKGL_API bool HashParallel(size_t count, const DKInlineFunction<bool (size_t)>& fn, DKOperationQueue* queue)
+		{
+			if (count == 0)
+				return true;
+
+			struct Context
+			{
+				size_t count;
+				const DKInlineFunction<bool (size_t)>& fn;
+				std::atomic<size_t> next;
+				std::atomic<bool> failed;
+
+				void Process()
+				{
+					for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+					{
+						if (!fn(i))
+							failed = true;
+					}
+				}
+			} context = { count, fn, {0}, {false} };
+
+			struct Operation : public DKOperation
+			{
+				Context* context;
+				Operation(Context* c) : context(c) {}
+				void Perform() const override { context->Process(); }
+			};
+
+			DKObject<DKOperationQueue> localQueue;
+			if (queue == NULL)
+			{
+				localQueue = DKOBJECT_NEW DKOperationQueue();
+				localQueue->SetMaxConcurrentOperations(Max(DKNumberOfProcessors(), 1U));
+				queue = localQueue;
+			}
+
+			// calling thread is also a worker.
+			const size_t numWorkers = Min(Max(queue->MaxConcurrentOperations(), size_t(1)), count) - 1;
+			DKArray<DKObject<DKOperationQueue::OperationSync>> workers;
+			workers.Reserve(numWorkers);
+			for (size_t i = 0; i < numWorkers; ++i)
+			{
+				DKObject<Operation> op = DKOBJECT_NEW Operation(&context);
+				workers.Add(queue->ProcessAsync(op));
+			}
+			context.Process();
+
+			// cancel workers not started yet, (can be called from queue's thread)
+			// wait for workers executing.
+			for (DKOperationQueue::OperationSync* sync : workers)
+			{
+				if (!sync->Cancel())
+					sync->Sync();
+			}
+			return !context.failed;
+		}
+
+		DKGL_API DKObject<DKData> HashMapFile(const DKString& file)
+		{
+			DKFile::FileInfo info;
+			if (DKFile::GetInfo(file, info))
+			{
+				if (info.size == 0)
+					return DKBuffer::Create(NULL, 0).SafeCast<DKData>();
+
+				DKObject<DKFileMap> fileMap = DKFileMap::Open(file, 0, false);
+				if (fileMap)
+					return fileMap.SafeCast<DKData>();
+			}
+			DKLogE("DKHash Error: Cannot open file: %ls", (const wchar_t*)file);
+			return NULL;
+		}
+	}
+}
@@ -11,9 +11,14 @@
 #include "DKEndianness.h"
 #include "DKString.h"
 #include "DKStream.h"
+#include "DKData.h"
+#include "DKArray.h"
+#include "DKInlineFunction.h"
 
 namespace DKFoundation
 {
+	class DKOperationQueue;
+
 	/// @brief Hash context, returned by DKHash
 	///
 	/// You can access digest result or represent as a string.
@@ -26,12 +31,12 @@ namespace DKFoundation
 		BASE digest[Length]; ///< hash digest in unit size (usually uint32_t)
 		int Compare(const DKHashResult& r) const
 		{
-			int d = 0;
-			for (int i = 0; d == 0 && i < Length; ++i)
+			for (int i = 0; i < Length; ++i)
 			{
-				d = static_cast<int>(this->digest[i] - r.digest[i]);
+				if (this->digest[i] != r.digest[i])
+					return this->digest[i] > r.digest[i] ? 1 : -1;
 			}
-			return d;
+			return 0;
 		}
 
 		bool operator == (const DKHashResult& r) const		{return Compare(r) == 0;}
@@ -43,7 +48,7 @@ namespace DKFoundation
 
 		DKString String() const ///< represent hash digest as a string
 		{
-			char buff[Length * 8];
+			char buff[Length * sizeof(BASE) * 2];
 			char* tmp = buff;
 			for (size_t i = 0; i < Length; ++i)
 			{
@@ -58,13 +63,17 @@ namespace DKFoundation
 					*(tmp++) = v2 <= 9 ? v2 + '0' : 'a' + (v2 - 10);
 				}
 			}
-			return DKString(buff, Length * 8);
+			return DKString(buff, Length * sizeof(BASE) * 2);
 		}
 	};
 	
 	/// Hash context for CRC32
 	typedef DKHashResult<uint32_t, 32>	DKHashResult32;
 	typedef DKHashResult<uint32_t, 32>	DKHashResultCRC32;
+	typedef DKHashResult<uint32_t, 32>	DKHashResultCRC32C;
+	/// Hash context for XXH64
+	typedef DKHashResult<uint64_t, 64>	DKHashResult64;
+	typedef DKHashResult<uint64_t, 64>	DKHashResultXXH64;
 	/// Hash context for MD5
 	typedef DKHashResult<uint32_t, 128>	DKHashResult128;
 	typedef DKHashResult<uint32_t, 128>	DKHashResultMD5;
@@ -87,6 +96,14 @@ namespace DKFoundation
 	/// CRC32
 	DKGL_API DKHashResultCRC32 DKHashCRC32(const void* p, size_t len);
 	DKGL_API bool DKHashCRC32(DKStream*, DKHashResultCRC32&);
+	/// CRC32C (Castagnoli polynomial, not compatible with CRC32)
+	/// uses SSE4.2 CRC32 instruction if available.
+	DKGL_API DKHashResultCRC32C DKHashCRC32C(const void* p, size_t len);
+	DKGL_API bool DKHashCRC32C(DKStream*, DKHashResultCRC32C&);
+	/// XXH64, fast non-cryptographic hash for hash table, content addressing.
+	/// not suitable for security purpose, use SHA2 instead.
+	DKGL_API DKHashResultXXH64 DKHashXXH64(const void* p, size_t len, uint64_t seed = 0);
+	DKGL_API bool DKHashXXH64(DKStream*, DKHashResultXXH64&, uint64_t seed = 0);
 	/// MD5
 	DKGL_API DKHashResultMD5 DKHashMD5(const void* p, size_t len);
 	DKGL_API bool DKHashMD5(DKStream*, DKHashResultMD5&);
@@ -191,4 +208,118 @@ namespace DKFoundation
 		DKHash512() : DKHash(Type512) {}
 		DKHashResult512 Result() const;
 	};
+
+	namespace Private
+	{
+		/// invoke fn with index [0, count) concurrently with queue.
+		/// calling thread also participates, returns false if any fn failed.
+		DKGL_API bool HashParallel(size_t count, const DKInlineFunction<bool (size_t)>& fn, DKOperationQueue* queue);
+		/// map file to read contents. (empty file returns empty data)
+		DKGL_API DKObject<DKData> HashMapFile(const DKString& file);
+
+		template <typename Hash> auto HashData(const void* p, size_t len)
+		{
+			Hash hash;
+			hash.Initialize();
+			hash.Update(p, len);
+			hash.Finalize();
+			return hash.Result();
+		}
+	}
+
+	/**
+	 Hash multiple data concurrently with DKOperationQueue.
+	 Hash is one of DKHash32, DKHash128, DKHash160, ... DKHash512.
+	 Results are stored in order of input, failed item has zero digest.
+	 Returns false if any item failed.
+	 If queue is NULL, temporary queue is used. (number of processors)
+
+	 @code
+	  DKArray<DKHashResultSHA256> results;
+	  DKHashBatch<DKHash256>(files, files.Count(), results, queue);
+	 @endcode
+	 */
+	template <typename Hash, typename Result = decltype(Hash().Result())>
+	bool DKHashBatch(const DKData* const* data, size_t count, DKArray<Result>& results, DKOperationQueue* queue = NULL)
+	{
+		results.Clear();
+		results.Resize(count, Result{});
+		return Private::HashParallel(count, [&](size_t i)
+		{
+			if (data[i] == NULL)
+				return false;
+			results.Value(i) = Private::HashData<Hash>(data[i]->LockShared(), data[i]->Length());
+			data[i]->UnlockShared();
+			return true;
+		}, queue);
+	}
+	/// Hash multiple files concurrently, files are mapped with DKFileMap.
+	template <typename Hash, typename Result = decltype(Hash().Result())>
+	bool DKHashBatch(const DKString* files, size_t count, DKArray<Result>& results, DKOperationQueue* queue = NULL)
+	{
+		results.Clear();
+		results.Resize(count, Result{});
+		return Private::HashParallel(count, [&](size_t i)
+		{
+			DKObject<DKData> data = Private::HashMapFile(files[i]);
+			if (data == NULL)
+				return false;
+			results.Value(i) = Private::HashData<Hash>(data->LockShared(), data->Length());
+			data->UnlockShared();
+			return true;
+		}, queue);
+	}
+
+	/**
+	 Tree hash: data is split into blocks, blocks are hashed concurrently.
+	 Result is hash of concatenated block digests (big-endian), it is
+	 different from hash of entire data, and depends on blockSize.
+	 Data smaller than blockSize is hashed as a single block.
+	 */
+	template <typename Hash, typename Result = decltype(Hash().Result())>
+	bool DKHashTree(const DKData* data, Result& result, size_t blockSize = 0x400000, DKOperationQueue* queue = NULL)
+	{
+		if (data == NULL || blockSize == 0)
+			return false;
+
+		const size_t length = data->Length();
+		const size_t numBlocks = Max((length + blockSize - 1) / blockSize, size_t(1));
+		DKArray<Result> blocks;
+		blocks.Resize(numBlocks);
+
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(data->LockShared());
+		bool succeeded = Private::HashParallel(numBlocks, [&](size_t i)
+		{
+			const size_t offset = i * blockSize;
+			blocks.Value(i) = Private::HashData<Hash>(p + offset, Min(blockSize, length - offset));
+			return true;
+		}, queue);
+		data->UnlockShared();
+
+		if (succeeded)
+		{
+			Hash hash;
+			hash.Initialize();
+			for (const Result& r : blocks)
+			{
+				for (int i = 0; i < Result::Length; ++i)
+				{
+					auto v = DKSystemToBigEndian(r.digest[i]);
+					hash.Update(&v, sizeof(v));
+				}
+			}
+			hash.Finalize();
+			result = hash.Result();
+		}
+		return succeeded;
+	}
+	/// Tree hash of file, file is mapped with DKFileMap.
+	template <typename Hash, typename Result = decltype(Hash().Result())>
+	bool DKHashTree(const DKString& file, Result& result, size_t blockSize = 0x400000, DKOperationQueue* queue = NULL)
+	{
+		DKObject<DKData> data = Private::HashMapFile(file);
+		if (data)
+			return DKHashTree<Hash, Result>(data, result, blockSize, queue);
+		return false;
+	}
 }
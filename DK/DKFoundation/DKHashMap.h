@@ -0,0 +1,392 @@
+//
+//  File: DKHashMap.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <initializer_list>
+#include "../DKInclude.h"
+#include "DKHashTable.h"
+#include "DKMap.h"
+#include "DKDummyLock.h"
+#include "DKCriticalSection.h"
+#include "DKTypeTraits.h"
+
+namespace DKFoundation
+{
+	/**
+	 @brief
+	 unordered associative container. (using open-addressing DKHashTable internally)
+	 Provides same interface as DKMap, but items are not sorted.
+	 Use DKMap instead if you need ordered enumeration.
+
+	 Insert: insert value if key is not exists.
+	 Update: set value for key whether key is exists or not.
+
+	 insertion, deletion, lookup is thread-safe.
+	 If you need to modify value directly, you should have lock object.
+
+	 @note
+	  Unlike DKMap, address of Pair can be changed by insertion or deletion.
+	  (items are stored in flat array and relocated when table grows)
+	  Do not keep Pair pointer after modifying map.
+
+	 Example:
+	 @code
+		{
+			typename MyMapType::CriticalSection section(map.lock);	// lock with critical-section
+			MyMapType::Pair* p = map.Find(something);
+			.... // do something with p
+		}	// auto-unlock by critical-section end
+	 @endcode
+
+	 To enumerate items:
+	 @code
+	  typedef DKHashMap<Key,Value> MyMap;
+	  MyMap map;
+	  auto enumerator1 = [](const MyMap::Pair& pair) {...}
+	  auto enumerator2 = [](const MyMap::Pair& pair, bool* stop) {...}
+	  map.EnumerateForward(enumerator1);
+	  map.EnumerateForward(enumerator2);	// cancellable by set bool to true.
+
+	  // range-based for loop (caller should lock map if needed)
+	  for (MyMap::Pair& pair : map) {...}
+	 @endcode
+
+	 @tparam Key            key type
+	 @tparam ValueT         value type
+	 @tparam Lock           locking class
+	 @tparam KeyHasher      key hash function
+	 @tparam KeyComparator  key equality function
+	 @tparam ValueReplacer  value copy/swap function
+
+	 @see DKHashTable, DKMap
+	 */
+	template <
+		typename Key,											// key type
+		typename ValueT,										// value type
+		typename Lock = DKDummyLock,							// lock
+		typename KeyHasher = DKHashKeyHasher<Key>,				// key hash
+		typename KeyComparator = DKHashKeyComparator<Key>,		// key equality
+		typename ValueReplacer = DKMapValueReplacer<ValueT>,	// copy value
+		typename Allocator = DKMemoryDefaultAllocator			// memory allocator
+	>
+	class DKHashMap
+	{
+		// Item stored with non-const key, to be relocated without copying key.
+		typedef DKMapPair<Key, ValueT> Item;
+	public:
+		typedef DKMapPair<const Key, ValueT>	Pair;
+		typedef DKCriticalSection<Lock>			CriticalSection;
+		typedef DKTypeTraits<Key>				KeyTraits;
+		typedef DKTypeTraits<ValueT>			ValueTraits;
+		typedef DKHashTable<Item, Allocator>	Container;
+
+		static_assert(sizeof(Item) == sizeof(Pair), "Pair layout mismatch");
+
+		constexpr static size_t SlotSize() { return Container::SlotSize(); }
+
+		template <typename PairT, typename MapT> class IteratorT
+		{
+		public:
+			IteratorT(MapT& m, size_t i) : map(m), index(i) {}
+			PairT& operator * () const		{ return reinterpret_cast<PairT&>(map.container.ItemAt(index)); }
+			PairT* operator -> () const		{ return &(operator * ()); }
+			IteratorT& operator ++ ()		{ index = map.container.Next(index); return *this; }
+			bool operator != (const IteratorT& it) const { return index != it.index; }
+			bool operator == (const IteratorT& it) const { return index == it.index; }
+		private:
+			MapT& map;
+			size_t index;
+		};
+		typedef IteratorT<Pair, DKHashMap> Iterator;
+		typedef IteratorT<const Pair, const DKHashMap> ConstIterator;
+
+		KeyHasher hasher;
+		KeyComparator comparator;
+		ValueReplacer replacer;
+
+		/// lock is public. to provde lock object from outside!
+		/// FindNoLock, CountNoLock is usable regardless of locking.
+		Lock	lock;
+
+		DKHashMap()
+		{
+		}
+		DKHashMap(DKHashMap&& m)
+			: hasher(static_cast<KeyHasher&&>(m.hasher))
+			, comparator(static_cast<KeyComparator&&>(m.comparator))
+			, replacer(static_cast<ValueReplacer&&>(m.replacer))
+			, container(static_cast<Container&&>(m.container))
+		{
+		}
+		DKHashMap(const DKHashMap& m)
+		{
+			CriticalSection guard(m.lock);
+			container = m.container;
+			hasher = m.hasher;
+			comparator = m.comparator;
+			replacer = m.replacer;
+		}
+		DKHashMap(std::initializer_list<Pair> il)
+		{
+			container.Reserve(il.size());
+			for (const Pair& p : il)
+				InsertNoLock(p.key, p.value);
+		}
+		~DKHashMap()
+		{
+			Clear();
+		}
+		/// overwrite value if key is exists, or insert item.
+		void Update(const Pair& p)
+		{
+			Update(p.key, p.value);
+		}
+		void Update(Pair&& p)
+		{
+			Update(p.key, static_cast<ValueT&&>(p.value));
+		}
+		void Update(const Key& k, const ValueT& v)
+		{
+			CriticalSection guard(lock);
+			Item* item = FindItemNoLock(k);
+			if (item)
+				replacer(item->value, v);
+			else
+				container.InsertUnique(hasher(k), Item(k, v));
+		}
+		void Update(const Key& k, ValueT&& v)
+		{
+			CriticalSection guard(lock);
+			Item* item = FindItemNoLock(k);
+			if (item)
+				replacer(item->value, v);
+			else
+				container.InsertUnique(hasher(k), Item(k, static_cast<ValueT&&>(v)));
+		}
+		void Update(const Pair* p, size_t size)
+		{
+			for (size_t i = 0; i < size; i++)
+				Update(p[i]);
+		}
+		void Update(std::initializer_list<Pair> il)
+		{
+			for (const Pair& p : il)
+				Update(p);
+		}
+		/// insert item if key is not exist, fails otherwise.
+		bool Insert(const Pair& p)
+		{
+			CriticalSection guard(lock);
+			return InsertNoLock(p.key, p.value);
+		}
+		bool Insert(Pair&& p)
+		{
+			CriticalSection guard(lock);
+			return InsertNoLock(p.key, static_cast<ValueT&&>(p.value));
+		}
+		bool Insert(const Key& k, const ValueT& v)
+		{
+			CriticalSection guard(lock);
+			return InsertNoLock(k, v);
+		}
+		bool Insert(const Key& k, ValueT&& v)
+		{
+			CriticalSection guard(lock);
+			return InsertNoLock(k, static_cast<ValueT&&>(v));
+		}
+		size_t Insert(std::initializer_list<Pair> il)
+		{
+			size_t n = 0;
+			CriticalSection guard(lock);
+			for (const Pair& p : il)
+			{
+				if (InsertNoLock(p.key, p.value))
+					n++;
+			}
+			return n;
+		}
+		void Remove(const Key& k)
+		{
+			CriticalSection guard(lock);
+			container.Remove(k, hasher(k), [this](const Item& item, const Key& key)
+			{
+				return comparator(item.key, key);
+			});
+		}
+		void Remove(std::initializer_list<Key> il)
+		{
+			for (const Key& k : il)
+				Remove(k);
+		}
+		void Clear()
+		{
+			CriticalSection guard(lock);
+			container.Clear();
+		}
+		/// reserve storage for n items.
+		void Reserve(size_t n)
+		{
+			CriticalSection guard(lock);
+			container.Reserve(n);
+		}
+		/// release all items and storage.
+		void Shrink()
+		{
+			CriticalSection guard(lock);
+			container.Shrink();
+		}
+		Pair* Find(const Key& k)
+		{
+			return const_cast<Pair*>(static_cast<const DKHashMap&>(*this).Find(k));
+		}
+		const Pair* Find(const Key& k) const
+		{
+			CriticalSection guard(lock);
+			return FindNoLock(k);
+		}
+		/// Perform search operation without locking.
+		/// useful if you have locked already in your context.
+		Pair* FindNoLock(const Key& k)
+		{
+			return reinterpret_cast<Pair*>(FindItemNoLock(k));
+		}
+		const Pair* FindNoLock(const Key& k) const
+		{
+			return reinterpret_cast<const Pair*>(const_cast<DKHashMap&>(*this).FindItemNoLock(k));
+		}
+		/// if key 'k' is not exist, an new value inserted and returns.
+		ValueT& Value(const Key& k)
+		{
+			CriticalSection guard(lock);
+			Item* item = FindItemNoLock(k);
+			if (item == NULL)
+				item = container.InsertUnique(hasher(k), Item(k, ValueT()));
+			DKASSERT_DESC(item, "Out of memory!");
+			return item->value;
+		}
+		bool IsEmpty() const
+		{
+			CriticalSection guard(lock);
+			return container.Count() == 0;
+		}
+		size_t Count() const
+		{
+			CriticalSection guard(lock);
+			return container.Count();
+		}
+		size_t CountNoLock() const
+		{
+			return container.Count();
+		}
+		DKHashMap& operator = (DKHashMap&& m)
+		{
+			if (this != &m)
+			{
+				CriticalSection guard(lock);
+				container = static_cast<Container&&>(m.container);
+				hasher = static_cast<KeyHasher&&>(m.hasher);
+				comparator = static_cast<KeyComparator&&>(m.comparator);
+				replacer = static_cast<ValueReplacer&&>(m.replacer);
+			}
+			return *this;
+		}
+		DKHashMap& operator = (const DKHashMap& m)
+		{
+			if (this != &m)
+			{
+				CriticalSection guardOther(m.lock);
+				CriticalSection guardSelf(lock);
+
+				container = m.container;
+				hasher = m.hasher;
+				comparator = m.comparator;
+				replacer = m.replacer;
+			}
+			return *this;
+		}
+		DKHashMap& operator = (std::initializer_list<Pair> il)
+		{
+			CriticalSection guard(lock);
+			container.Clear();
+			for (const Pair& p : il)
+				InsertNoLock(p.key, p.value);
+			return *this;
+		}
+
+		/// range-based for loop support.
+		/// iterator is not thread-safe, caller should lock map while iterating.
+		Iterator begin()				{ return Iterator(*this, container.First()); }
+		Iterator end()					{ return Iterator(*this, container.Capacity()); }
+		ConstIterator begin() const		{ return ConstIterator(*this, container.First()); }
+		ConstIterator end() const		{ return ConstIterator(*this, container.Capacity()); }
+
+		/// EnumerateForward: enumerate all items. (unordered)
+		/// You cannot insert, remove items while enumerating. (container is read-only)
+		/// enumerator can be lambda or any function type that can receive arguments (VALUE&) or (VALUE&, bool*)
+		/// (VALUE&, bool*) type can cancel iteration by set boolean value to true.
+		template <typename T> void EnumerateForward(T&& enumerator)
+		{
+			using Func = typename DKFunctionType<T>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<Pair&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<Pair&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (VALUE&) or (VALUE&,bool*)");
+
+			EnumerateForward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+		/// lambda enumerator (const VALUE&) or (const VALUE&, bool*) function type.
+		template <typename T> void EnumerateForward(T&& enumerator) const
+		{
+			using Func = typename DKFunctionType<T>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<const Pair&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<const Pair&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (const VALUE&) or (const VALUE&,bool*)");
+
+			EnumerateForward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+
+	private:
+		Item* FindItemNoLock(const Key& k)
+		{
+			return const_cast<Item*>(container.Find(k, hasher(k), [this](const Item& item, const Key& key)
+			{
+				return comparator(item.key, key);
+			}));
+		}
+		template <typename V> bool InsertNoLock(const Key& k, V&& v)
+		{
+			if (FindItemNoLock(k))
+				return false;
+			return container.InsertUnique(hasher(k), Item(k, std::forward<V>(v))) != NULL;
+		}
+		// lambda enumerator (VALUE&)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<1>)
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](Item& val, bool*) {enumerator(reinterpret_cast<Pair&>(val));});
+		}
+		// lambda enumerator (const VALUE&)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<1>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](const Item& val, bool*) {enumerator(reinterpret_cast<const Pair&>(val));});
+		}
+		// lambda enumerator (VALUE&, bool*)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<2>)
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](Item& val, bool* stop) {enumerator(reinterpret_cast<Pair&>(val), stop);});
+		}
+		// lambda enumerator (const VALUE&, bool*)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<2>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](const Item& val, bool* stop) {enumerator(reinterpret_cast<const Pair&>(val), stop);});
+		}
+
+		Container	container;
+	};
+}
@@ -0,0 +1,245 @@
+//
+//  File: DKHashSet.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <initializer_list>
+#include "../DKInclude.h"
+#include "DKHashTable.h"
+#include "DKDummyLock.h"
+#include "DKCriticalSection.h"
+#include "DKTypeTraits.h"
+
+namespace DKFoundation
+{
+	/// @brief An unordered set container class. using open-addressing DKHashTable internally.
+	/// Provides same interface as DKSet, but elements are not sorted.
+	///
+	/// @tparam Value		value type
+	/// @tparam Lock		thread-lock type
+	/// @tparam Hasher		element hash function
+	/// @tparam Comparator	element equality function
+	/// @tparam Allocator	element allocator
+	template <
+		typename Value,
+		typename Lock = DKDummyLock,
+		typename Hasher = DKHashKeyHasher<Value>,
+		typename Comparator = DKHashKeyComparator<Value>,
+		typename Allocator = DKMemoryDefaultAllocator
+	>
+	class DKHashSet
+	{
+	public:
+		typedef DKCriticalSection<Lock>			CriticalSection;
+		typedef DKTypeTraits<Value>				ValueTraits;
+		typedef DKHashTable<Value, Allocator>	Container;
+
+		constexpr static size_t SlotSize() { return Container::SlotSize(); }
+
+		class ConstIterator
+		{
+		public:
+			ConstIterator(const Container& c, size_t i) : container(c), index(i) {}
+			const Value& operator * () const	{ return container.ItemAt(index); }
+			const Value* operator -> () const	{ return &container.ItemAt(index); }
+			ConstIterator& operator ++ ()		{ index = container.Next(index); return *this; }
+			bool operator != (const ConstIterator& it) const { return index != it.index; }
+			bool operator == (const ConstIterator& it) const { return index == it.index; }
+		private:
+			const Container& container;
+			size_t index;
+		};
+
+		Hasher hasher;
+		Comparator comparator;
+
+		/// lock is public. allow object being locked manually.
+		/// ContainsNoLock(), CountNoLock() is available when object has been locked.
+		Lock	lock;
+
+		DKHashSet()
+		{
+		}
+		DKHashSet(DKHashSet&& s)
+			: container(static_cast<Container&&>(s.container))
+		{
+		}
+		/// copy constructor. same type of DKHashSet object are allowed only.
+		DKHashSet(const DKHashSet& s)
+		{
+			CriticalSection guard(s.lock);
+			container = s.container;
+		}
+		DKHashSet(const Value* v, size_t n)
+		{
+			container.Reserve(n);
+			for (size_t i = 0; i < n; ++i)
+				InsertNoLock(v[i]);
+		}
+		DKHashSet(std::initializer_list<Value> il)
+		{
+			container.Reserve(il.size());
+			for (const Value& v : il)
+				InsertNoLock(v);
+		}
+		~DKHashSet()
+		{
+		}
+		void Insert(const Value& v)
+		{
+			CriticalSection guard(lock);
+			InsertNoLock(v);
+		}
+		void Insert(Value&& v)
+		{
+			CriticalSection guard(lock);
+			InsertNoLock(static_cast<Value&&>(v));
+		}
+		void Insert(const Value* v, size_t n)
+		{
+			CriticalSection guard(lock);
+			for (size_t i = 0; i < n; ++i)
+				InsertNoLock(v[i]);
+		}
+		void Insert(std::initializer_list<Value> il)
+		{
+			CriticalSection guard(lock);
+			for (const Value& v : il)
+				InsertNoLock(v);
+		}
+		/// import other set.
+		/// The other set can have different template parameters except Value.
+		template <typename ...Args> DKHashSet& Union(const DKHashSet<Value, Args...>& s)
+		{
+			CriticalSection guard(lock);
+			s.EnumerateForward([this](const Value& val) { InsertNoLock(val); });
+			return *this;
+		}
+		/// exclude elements in other set
+		/// The other set can have different template parameters except Value
+		template <typename ...Args> DKHashSet& Intersect(const DKHashSet<Value, Args...>& s)
+		{
+			CriticalSection guard(lock);
+			s.EnumerateForward([this](const Value& val) { RemoveNoLock(val); });
+			return *this;
+		}
+		void Remove(const Value& v)
+		{
+			CriticalSection guard(lock);
+			RemoveNoLock(v);
+		}
+		void Remove(std::initializer_list<Value> il)
+		{
+			CriticalSection guard(lock);
+			for (const Value& v : il)
+				RemoveNoLock(v);
+		}
+		void Clear()
+		{
+			CriticalSection guard(lock);
+			container.Clear();
+		}
+		/// reserve storage for n elements.
+		void Reserve(size_t n)
+		{
+			CriticalSection guard(lock);
+			container.Reserve(n);
+		}
+		bool Contains(const Value& v) const
+		{
+			CriticalSection guard(lock);
+			return ContainsNoLock(v);
+		}
+		bool ContainsNoLock(const Value& v) const
+		{
+			return container.Find(v, hasher(v), comparator) != NULL;
+		}
+		bool IsEmpty() const
+		{
+			CriticalSection guard(lock);
+			return container.Count() == 0;
+		}
+		size_t Count() const
+		{
+			CriticalSection guard(lock);
+			return container.Count();
+		}
+		size_t CountNoLock() const
+		{
+			return container.Count();
+		}
+		DKHashSet& operator = (DKHashSet&& s)
+		{
+			if (this != &s)
+			{
+				CriticalSection guard(lock);
+				container = static_cast<Container&&>(s.container);
+			}
+			return *this;
+		}
+		DKHashSet& operator = (const DKHashSet& s)
+		{
+			if (this != &s)
+			{
+				CriticalSection guardOther(s.lock);
+				CriticalSection guardSelf(lock);
+
+				container = s.container;
+			}
+			return *this;
+		}
+		DKHashSet& operator = (std::initializer_list<Value> il)
+		{
+			CriticalSection guard(lock);
+			container.Clear();
+			for (const Value& v : il)
+				InsertNoLock(v);
+			return *this;
+		}
+
+		/// range-based for loop support. (READ-ONLY)
+		/// iterator is not thread-safe, caller should lock set while iterating.
+		ConstIterator begin() const		{ return ConstIterator(container, container.First()); }
+		ConstIterator end() const		{ return ConstIterator(container, container.Capacity()); }
+
+		/// lambda enumerator (const VALUE&) or (const VALUE&, bool*) are allowed.
+		/// enumerating objects are READ-ONLY. values cannot be modified.
+		template <typename T> void EnumerateForward(T&& enumerator) const
+		{
+			using Func = typename DKFunctionType<T>::Signature;
+			enum {ValidatePType1 = Func::template CanInvokeWithParameterTypes<const Value&>()};
+			enum {ValidatePType2 = Func::template CanInvokeWithParameterTypes<const Value&, bool*>()};
+			static_assert(ValidatePType1 || ValidatePType2, "enumerator's parameter is not compatible with (const VALUE&) or (const VALUE&,bool*)");
+
+			EnumerateForward(std::forward<T>(enumerator), typename Func::ParameterNumber());
+		}
+	private:
+		template <typename V> void InsertNoLock(V&& v)
+		{
+			uint64_t h = hasher(v);
+			if (container.Find(v, h, comparator) == NULL)
+				container.InsertUnique(h, Value(std::forward<V>(v)));
+		}
+		void RemoveNoLock(const Value& v)
+		{
+			container.Remove(v, hasher(v), comparator);
+		}
+		// lambda enumerator (const VALUE&)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<1>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward([&enumerator](const Value& val, bool*) {enumerator(val);});
+		}
+		// lambda enumerator (const VALUE&, bool*)
+		template <typename T> void EnumerateForward(T&& enumerator, DKNumber<2>) const
+		{
+			CriticalSection guard(lock);
+			container.EnumerateForward(enumerator);
+		}
+
+		Container container;
+	};
+}
@@ -0,0 +1,416 @@
+//
+//  File: DKHashTable.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "../DKInclude.h"
+#include "DKMemory.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		/// 64bit integer finalizer (from MurmurHash3 fmix64)
+		FORCEINLINE uint64_t DKHashMix64(uint64_t k)
+		{
+			k ^= k >> 33;
+			k *= 0xff51afd7ed558ccdULL;
+			k ^= k >> 33;
+			k *= 0xc4ceb9fe1a85ec53ULL;
+			k ^= k >> 33;
+			return k;
+		}
+		/// hash null-terminated string of any character type. (FNV-1a, 64bit)
+		template <typename CharT> FORCEINLINE uint64_t DKHashString(const CharT* str)
+		{
+			uint64_t h = 0xcbf29ce484222325ULL;
+			if (str)
+			{
+				for (; *str; ++str)
+				{
+					h ^= static_cast<uint64_t>(*str);
+					h *= 0x100000001b3ULL;
+				}
+			}
+			return DKHashMix64(h);
+		}
+	}
+
+	/// @brief Key hash function for DKHashMap, DKHashSet.
+	/// integer, enum and pointer types are supported by default.
+	/// DKString types are specialized in DKString.h
+	/// To use other types as key, provide specialization of this template
+	/// or pass custom hasher to the container.
+	template <typename Key> struct DKHashKeyHasher
+	{
+		uint64_t operator () (const Key& k) const
+		{
+			static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value || std::is_pointer<Key>::value,
+						  "Key type must be integral, enum or pointer, or need to be specialized.");
+
+			if constexpr (std::is_pointer<Key>::value)
+				return Private::DKHashMix64(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(k)));
+			else
+				return Private::DKHashMix64(static_cast<uint64_t>(k));
+		}
+	};
+	/// @brief Key equality function for DKHashMap, DKHashSet.
+	template <typename Key> struct DKHashKeyComparator
+	{
+		bool operator () (const Key& lhs, const Key& rhs) const
+		{
+			return lhs == rhs;
+		}
+	};
+
+	/**
+	 @brief
+	 open-addressing hash table with Robin Hood probing. (used by DKHashMap, DKHashSet)
+
+	 Items are stored in a flat array and located with linear probing.
+	 Each slot keeps 32bit hash value and probe distance in a separate
+	 metadata array, so lookup touches item only when hash value matched.
+	 Item being removed with backward-shift deletion (no tombstones).
+
+	 @note
+	  This class is not thread-safe. Item address can be changed by
+	  insertion or removal, do not keep pointer of item.
+	  Item type must be move constructible.
+	 */
+	template <typename Item, typename Allocator = DKMemoryDefaultAllocator>
+	class DKHashTable
+	{
+		struct Slot
+		{
+			uint32_t hash;
+			uint32_t distance;	///< probe distance + 1, 0 for empty slot.
+		};
+		enum : size_t { MinimumCapacity = 8 };
+
+	public:
+		constexpr static size_t SlotSize() { return sizeof(Slot) + sizeof(Item); }
+
+		DKHashTable()
+			: slots(NULL), items(NULL), capacity(0), count(0)
+		{
+		}
+		DKHashTable(DKHashTable&& t)
+			: slots(t.slots), items(t.items), capacity(t.capacity), count(t.count)
+		{
+			t.slots = NULL;
+			t.items = NULL;
+			t.capacity = 0;
+			t.count = 0;
+		}
+		DKHashTable(const DKHashTable& t)
+			: slots(NULL), items(NULL), capacity(0), count(0)
+		{
+			CopyFrom(t);
+		}
+		~DKHashTable()
+		{
+			Clear();
+			Deallocate();
+		}
+		DKHashTable& operator = (DKHashTable&& t)
+		{
+			if (this != &t)
+			{
+				Clear();
+				Deallocate();
+				slots = t.slots;
+				items = t.items;
+				capacity = t.capacity;
+				count = t.count;
+				t.slots = NULL;
+				t.items = NULL;
+				t.capacity = 0;
+				t.count = 0;
+			}
+			return *this;
+		}
+		DKHashTable& operator = (const DKHashTable& t)
+		{
+			if (this != &t)
+			{
+				Clear();
+				CopyFrom(t);
+			}
+			return *this;
+		}
+
+		/// fold 64bit hash into stored 32bit.
+		FORCEINLINE static uint32_t FoldHash(uint64_t h)
+		{
+			return static_cast<uint32_t>(h ^ (h >> 32));
+		}
+
+		/// find item with key. equal(const Item&, const K&) returns true if matched.
+		template <typename K, typename Equal>
+		const Item* Find(const K& key, uint64_t hash, Equal&& equal) const
+		{
+			if (count == 0)
+				return NULL;
+			const uint32_t h = FoldHash(hash);
+			const size_t mask = capacity - 1;
+			size_t index = h & mask;
+			for (uint32_t dist = 1; ; ++dist)
+			{
+				const Slot& s = slots[index];
+				if (s.distance < dist)	// empty slot or richer item.
+					return NULL;
+				if (s.hash == h && equal(items[index], key))
+					return &items[index];
+				index = (index + 1) & mask;
+			}
+			return NULL;
+		}
+
+		/// insert item without checking duplication.
+		/// (caller should check key is not exists with Find())
+		/// returns address of inserted item, NULL if out of memory.
+		Item* InsertUnique(uint64_t hash, Item&& item)
+		{
+			if ((count + 1) * 8 > capacity * 7)
+			{
+				if (!Rehash(capacity > 0 ? capacity * 2 : MinimumCapacity))
+					return NULL;	// out of memory!
+			}
+			return InsertSlot(FoldHash(hash), static_cast<Item&&>(item));
+		}
+
+		/// remove item with key, returns true if item removed.
+		template <typename K, typename Equal>
+		bool Remove(const K& key, uint64_t hash, Equal&& equal)
+		{
+			const Item* p = Find(key, hash, std::forward<Equal>(equal));
+			if (p)
+			{
+				RemoveAt(static_cast<size_t>(p - items));
+				return true;
+			}
+			return false;
+		}
+
+		/// destroy all items, memory remains allocated.
+		void Clear()
+		{
+			if (count > 0)
+			{
+				for (size_t i = 0; i < capacity; ++i)
+				{
+					if (slots[i].distance)
+					{
+						items[i].~Item();
+						slots[i].distance = 0;
+					}
+				}
+				count = 0;
+			}
+		}
+		/// destroy all items and release memory.
+		void Shrink()
+		{
+			Clear();
+			Deallocate();
+		}
+		/// make room for n items. (avoid rehash while inserting)
+		void Reserve(size_t n)
+		{
+			size_t c = MinimumCapacity;
+			while (n * 8 > c * 7)
+				c = c * 2;
+			if (c > capacity)
+				Rehash(c);
+		}
+
+		size_t Count() const		{ return count; }
+		size_t Capacity() const		{ return capacity; }
+
+		/// slot iteration. Next() returns capacity if no more item.
+		size_t First() const
+		{
+			return Next(static_cast<size_t>(-1));
+		}
+		size_t Next(size_t index) const
+		{
+			for (++index; index < capacity; ++index)
+			{
+				if (slots[index].distance)
+					return index;
+			}
+			return capacity;
+		}
+		Item& ItemAt(size_t index)				{ return items[index]; }
+		const Item& ItemAt(size_t index) const	{ return items[index]; }
+
+		/// enumerator (Item&, bool*)
+		template <typename T> void EnumerateForward(T&& enumerator)
+		{
+			bool stop = false;
+			for (size_t i = 0; i < capacity && !stop; ++i)
+			{
+				if (slots[i].distance)
+					enumerator(items[i], &stop);
+			}
+		}
+		template <typename T> void EnumerateForward(T&& enumerator) const
+		{
+			bool stop = false;
+			for (size_t i = 0; i < capacity && !stop; ++i)
+			{
+				if (slots[i].distance)
+					enumerator(static_cast<const Item&>(items[i]), &stop);
+			}
+		}
+
+	private:
+		FORCEINLINE static void Relocate(Item* dst, Item* src)
+		{
+			new(dst) Item(static_cast<Item&&>(*src));
+			src->~Item();
+		}
+		Item* InsertSlot(uint32_t h, Item&& item)
+		{
+			DKASSERT_DEBUG(count < capacity);
+
+			const size_t mask = capacity - 1;
+			size_t index = h & mask;
+			Slot slot = { h, 1 };
+			Item* inserted = NULL;
+
+			// item being inserted (or displaced) goes to 'carry'
+			alignas(Item) unsigned char carryBuffer[sizeof(Item)];
+			Item* carry = new(carryBuffer) Item(static_cast<Item&&>(item));
+
+			while (true)
+			{
+				Slot& s = slots[index];
+				if (s.distance == 0)
+				{
+					Relocate(&items[index], carry);
+					s = slot;
+					count++;
+					return inserted ? inserted : &items[index];
+				}
+				if (s.distance < slot.distance)
+				{
+					// steal slot from richer item. (Robin Hood)
+					alignas(Item) unsigned char tmpBuffer[sizeof(Item)];
+					Item* tmp = reinterpret_cast<Item*>(tmpBuffer);
+					Relocate(tmp, &items[index]);
+					Relocate(&items[index], carry);
+					Relocate(carry, tmp);
+
+					Slot t = s;
+					s = slot;
+					slot = t;
+					if (inserted == NULL)
+						inserted = &items[index];
+				}
+				slot.distance++;
+				index = (index + 1) & mask;
+			}
+			return NULL;
+		}
+		void RemoveAt(size_t index)
+		{
+			DKASSERT_DEBUG(slots[index].distance);
+
+			const size_t mask = capacity - 1;
+			items[index].~Item();
+			// backward-shift following items.
+			size_t next = (index + 1) & mask;
+			while (slots[next].distance > 1)
+			{
+				Relocate(&items[index], &items[next]);
+				slots[index].hash = slots[next].hash;
+				slots[index].distance = slots[next].distance - 1;
+				index = next;
+				next = (next + 1) & mask;
+			}
+			slots[index].distance = 0;
+			count--;
+		}
+		// table remains unchanged if allocation failed.
+		bool Rehash(size_t newCapacity)
+		{
+			DKASSERT_DEBUG((newCapacity & (newCapacity - 1)) == 0);
+			DKASSERT_DEBUG(newCapacity > count);
+
+			Slot* oldSlots = slots;
+			Item* oldItems = items;
+			size_t oldCapacity = capacity;
+
+			if (!Allocate(newCapacity))
+				return false;
+			count = 0;
+			for (size_t i = 0; i < oldCapacity; ++i)
+			{
+				if (oldSlots[i].distance)
+				{
+					InsertSlot(oldSlots[i].hash, static_cast<Item&&>(oldItems[i]));
+					oldItems[i].~Item();
+				}
+			}
+			if (oldSlots)
+				Allocator::Free(oldSlots);
+			return true;
+		}
+		void CopyFrom(const DKHashTable& t)
+		{
+			if (t.count == 0)
+				return;
+			if (capacity != t.capacity)
+			{
+				Deallocate();
+				if (!Allocate(t.capacity))
+					return;	// out of memory!
+			}
+			for (size_t i = 0; i < capacity; ++i)
+			{
+				slots[i] = t.slots[i];
+				if (slots[i].distance)
+					new(&items[i]) Item(t.items[i]);
+			}
+			count = t.count;
+		}
+		constexpr static size_t ItemsOffset(size_t c)
+		{
+			return (c * sizeof(Slot) + alignof(Item) - 1) & ~(alignof(Item) - 1);
+		}
+		bool Allocate(size_t c)
+		{
+			void* p = Allocator::Alloc(ItemsOffset(c) + c * sizeof(Item));
+			DKASSERT_DESC_DEBUG(p, "Out of memory!");
+			if (p == NULL)
+				return false;
+			slots = reinterpret_cast<Slot*>(p);
+			items = reinterpret_cast<Item*>(reinterpret_cast<uint8_t*>(p) + ItemsOffset(c));
+			capacity = c;
+			for (size_t i = 0; i < c; ++i)
+				slots[i].distance = 0;
+			return true;
+		}
+		void Deallocate()
+		{
+			DKASSERT_DEBUG(count == 0);
+			if (slots)
+				Allocator::Free(slots);
+			slots = NULL;
+			items = NULL;
+			capacity = 0;
+		}
+
+		Slot* slots;
+		Item* items;
+		size_t capacity;	///< power of two
+		size_t count;
+	};
+}
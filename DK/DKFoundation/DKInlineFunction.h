@@ -0,0 +1,230 @@
+//
+//  File: DKInlineFunction.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "../DKInclude.h"
+#include "DKMemory.h"
+
+namespace DKFoundation
+{
+	template <typename Function, size_t InlineSize = 48> class DKInlineFunction;
+
+	/**
+	 @brief
+	 A move-only function object with inline storage (small buffer).
+	 template parameter must be function type. (ex: DKInlineFunction<void (int)>)
+
+	 Unlike DKFunction, this object is not reference counted and does not
+	 allocate memory when the callable fits in InlineSize bytes.
+	 (most lambdas capturing a few pointers or DKObjects)
+	 Larger callable is stored in heap.
+
+	 Example:
+	 @code
+	   DKInlineFunction<void (int)> fn = [obj](int n) { obj->Do(n); };
+	   fn(3);
+
+	   DKArray<DKInlineFunction<void ()>> commands;
+	   commands.Add([=] { ... });
+	   for (auto& c : commands)
+	     c();
+
+	   // bind member function
+	   DKInlineFunction<void (int)> fn2(obj, &MyClass::Function);
+	 @endcode
+
+	 @note
+	  Callable stored inline is moved by DKArray with memory reallocation,
+	  it must not have pointer to itself. (same as other DKArray elements)
+	  Use DKFunction if the function object should be shared or copied.
+	 */
+	template <typename R, typename... Ps, size_t InlineSize>
+	class DKInlineFunction<R (Ps...), InlineSize>
+	{
+		struct Operations
+		{
+			R (*invoke)(void*, Ps...);
+			void (*relocate)(void* dst, void* src);	///< move to dst and destroy src
+			void (*destroy)(void*);
+		};
+		template <typename F> static R InvokeFunction(F& fn, Ps... vs)
+		{
+			if constexpr (std::is_void<R>::value)
+				fn(std::forward<Ps>(vs)...);
+			else
+				return fn(std::forward<Ps>(vs)...);
+		}
+		template <typename F, bool Inline> struct Manager;
+		template <typename F> struct Manager<F, true> // stored in inline buffer
+		{
+			static F* Get(void* p)					{ return reinterpret_cast<F*>(p); }
+			template <typename T> static bool Create(void* p, T&& fn)
+			{
+				new(p) F(std::forward<T>(fn));
+				return true;
+			}
+			static R Invoke(void* p, Ps... vs)		{ return InvokeFunction(*Get(p), std::forward<Ps>(vs)...); }
+			static void Relocate(void* dst, void* src)
+			{
+				new(dst) F(static_cast<F&&>(*Get(src)));
+				Get(src)->~F();
+			}
+			static void Destroy(void* p)			{ Get(p)->~F(); }
+		};
+		template <typename F> struct Manager<F, false> // stored in heap
+		{
+			static F* Get(void* p)					{ return *reinterpret_cast<F**>(p); }
+			template <typename T> static bool Create(void* p, T&& fn)
+			{
+				void* mem = DKMemoryDefaultAllocator::Alloc(sizeof(F));
+				DKASSERT_DESC_DEBUG(mem, "Out of memory!");
+				if (mem == NULL)
+					return false;	// out of memory!
+				*reinterpret_cast<F**>(p) = new(mem) F(std::forward<T>(fn));
+				return true;
+			}
+			static R Invoke(void* p, Ps... vs)		{ return InvokeFunction(*Get(p), std::forward<Ps>(vs)...); }
+			static void Relocate(void* dst, void* src)
+			{
+				*reinterpret_cast<F**>(dst) = Get(src);
+			}
+			static void Destroy(void* p)
+			{
+				F* f = Get(p);
+				f->~F();
+				DKMemoryDefaultAllocator::Free(f);
+			}
+		};
+		template <typename F> constexpr static bool CanStoreInline()
+		{
+			return sizeof(F) <= InlineSize &&
+				alignof(F) <= alignof(std::max_align_t) &&
+				std::is_move_constructible<F>::value;
+		}
+		template <typename F> static const Operations* OperationsOf()
+		{
+			using M = Manager<F, CanStoreInline<F>()>;
+			static const Operations ops = { &M::Invoke, &M::Relocate, &M::Destroy };
+			return &ops;
+		}
+		template <typename T> using EnableIfCallable = std::enable_if_t<
+			!std::is_same<std::decay_t<T>, DKInlineFunction>::value &&
+			std::is_invocable_r<R, std::decay_t<T>&, Ps...>::value>;
+
+	public:
+		using ReturnType = R;
+		enum : size_t { InlineCapacity = InlineSize };
+
+		/// test given callable type can be stored without allocation.
+		template <typename T> constexpr static bool IsInlineStorable()
+		{
+			return CanStoreInline<std::decay_t<T>>();
+		}
+
+		DKInlineFunction() : ops(NULL) {}
+		DKInlineFunction(std::nullptr_t) : ops(NULL) {}
+		/// function pointer, lambda or function object.
+		template <typename T, typename = EnableIfCallable<T>> DKInlineFunction(T&& fn) : ops(NULL)
+		{
+			Assign(std::forward<T>(fn));
+		}
+		/// class member function. (obj: object pointer or DKObject)
+		template <typename T, typename Func, typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
+		DKInlineFunction(T&& obj, Func fn) : ops(NULL)
+		{
+			Assign([obj = std::forward<T>(obj), fn](Ps... vs) mutable -> R
+			{
+				return ((*obj).*fn)(std::forward<Ps>(vs)...);
+			});
+		}
+		DKInlineFunction(DKInlineFunction&& fn) : ops(fn.ops)
+		{
+			if (ops)
+			{
+				ops->relocate(storage, fn.storage);
+				fn.ops = NULL;
+			}
+		}
+		~DKInlineFunction()
+		{
+			Reset();
+		}
+
+		DKInlineFunction& operator = (DKInlineFunction&& fn)
+		{
+			if (this != &fn)
+			{
+				Reset();
+				if (fn.ops)
+				{
+					fn.ops->relocate(storage, fn.storage);
+					ops = fn.ops;
+					fn.ops = NULL;
+				}
+			}
+			return *this;
+		}
+		DKInlineFunction& operator = (std::nullptr_t)
+		{
+			Reset();
+			return *this;
+		}
+		template <typename T, typename = EnableIfCallable<T>> DKInlineFunction& operator = (T&& fn)
+		{
+			Reset();
+			Assign(std::forward<T>(fn));
+			return *this;
+		}
+
+		void Reset()
+		{
+			if (ops)
+			{
+				ops->destroy(storage);
+				ops = NULL;
+			}
+		}
+
+		explicit operator bool () const { return ops != NULL; }
+
+		/// direct call, function must be valid.
+		FORCEINLINE R Invoke(Ps... vs) const
+		{
+			DKASSERT_DEBUG(ops);
+			return ops->invoke(storage, std::forward<Ps>(vs)...);
+		}
+		FORCEINLINE R operator () (Ps... vs) const
+		{
+			DKASSERT_DEBUG(ops);
+			return ops->invoke(storage, std::forward<Ps>(vs)...);
+		}
+
+	private:
+		template <typename T> void Assign(T&& fn)
+		{
+			using F = std::decay_t<T>;
+			if constexpr (std::is_pointer<F>::value || std::is_member_pointer<F>::value)
+			{
+				if (fn == NULL)
+					return;
+			}
+			// function remains empty if allocation failed.
+			if (Manager<F, CanStoreInline<F>()>::Create(storage, std::forward<T>(fn)))
+				ops = OperationsOf<F>();
+		}
+
+		DKInlineFunction(const DKInlineFunction&) = delete;
+		DKInlineFunction& operator = (const DKInlineFunction&) = delete;
+
+		const Operations* ops;
+		alignas(std::max_align_t) mutable unsigned char storage[InlineSize];
+	};
+}
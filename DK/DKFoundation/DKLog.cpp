@@ -16,20 +16,61 @@
 #include <stdlib.h>
 #include <wchar.h>
 #include <errno.h>
+#include <string.h>
+#include <stdarg.h>
 
 #include "DKLog.h"
 #include "DKString.h"
 #include "DKLogger.h"
+#include "DKMemory.h"
 
 namespace DKFoundation
 {
+	namespace Private
+	{
+		// wide-char arguments (%ls, %lc, %S, %C) cannot be formatted with vsnprintf.
+		static bool HasWideCharFormat(const char* fmt)
+		{
+			for (const char* p = fmt; *p; ++p)
+			{
+				if (*p != '%')
+					continue;
+				++p;
+				if (*p == '%')
+					continue;
+				while (*p && strchr("-+ #0123456789.*hljztL", *p))
+				{
+					if (p[0] == 'l' && (p[1] == 's' || p[1] == 'c'))
+						return true;
+					++p;
+				}
+				if (*p == 'S' || *p == 'C')
+					return true;
+				if (*p == 0)
+					break;
+			}
+			return false;
+		}
+		static void LogSync(DKLogCategory c, const DKString& str)
+		{
+			if (!DKLogger::Broadcast(c, str))
+				fprintf(stderr, "%ls", (const wchar_t*)str);
+		}
+	}
+	using namespace Private;
+
 	DKGL_API void DKLog(DKLogCategory c, const DKString& str)
 	{
 #ifndef DKGL_DEBUG_ENABLED
 		if (c == DKLogCategory::Debug) return;
 #endif
-		if (!DKLogger::Broadcast(c, str))
-			fprintf(stderr, "%ls", (const wchar_t*)str);
+		if (DKLogger::IsAsyncDispatchEnabled())
+		{
+			DKStringU8 str8(str);
+			if (DKLogger::PostRecord(c, (const char*)str8, str8.Bytes()))
+				return;
+		}
+		LogSync(c, str);
 	}
 	DKGL_API void DKLog(DKLogCategory c, const char* fmt, ...)
 	{
@@ -38,7 +79,32 @@ namespace DKFoundation
 #endif
 		va_list ap;
 		va_start(ap, fmt);
-		DKLog(c, DKString::FormatV(fmt, ap));
+		if (DKLogger::IsAsyncDispatchEnabled() && !HasWideCharFormat(fmt))
+		{
+			// format into stack buffer, without DKString conversion.
+			char buffer[1024];
+			va_list ap2;
+			va_copy(ap2, ap);
+			int len = vsnprintf(buffer, sizeof(buffer), fmt, ap2);
+			va_end(ap2);
+			if (len >= 0 && (size_t)len < sizeof(buffer))
+			{
+				if (!DKLogger::PostRecord(c, buffer, len))
+					LogSync(c, DKString(buffer, len));
+			}
+			else if (len >= 0)
+			{
+				char* buff2 = (char*)DKMalloc(len + 1);
+				vsnprintf(buff2, len + 1, fmt, ap);
+				if (!DKLogger::PostRecord(c, buff2, len))
+					LogSync(c, DKString(buff2, len));
+				DKFree(buff2);
+			}
+		}
+		else
+		{
+			DKLog(c, DKString::FormatV(fmt, ap));
+		}
 		va_end(ap);
 	}
 }
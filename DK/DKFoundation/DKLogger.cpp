@@ -5,9 +5,18 @@
 //  Copyright (c) 2004-2017 Hongtae Kim. All rights reserved.
 //
 
+#include <stdio.h>
+#include <string.h>
 #include "DKLog.h"
 #include "DKLogger.h"
 #include "DKSpinLock.h"
+#include "DKMutex.h"
+#include "DKCondition.h"
+#include "DKThread.h"
+#include "DKFunction.h"
+#include "DKAtomicNumber32.h"
+#include "DKAtomicNumber64.h"
+#include "DKMemory.h"
 
 namespace DKFoundation
 {
@@ -23,6 +32,347 @@ namespace DKFoundation
 			static DKArray<DKObject<DKLogger>> loggers;
 			return loggers;
 		}
+
+		// record in ring buffer, followed by UTF-8 message (null-terminated)
+		struct LogRecordHeader
+		{
+			uint32_t size;			// total size, 8 bytes aligned.
+			uint32_t category;		// 0 for padding (end of buffer)
+			int64_t timestamp;		// microseconds since epoch
+			uint64_t threadId;
+			uint32_t length;
+			uint32_t reserved;
+		};
+
+		// single-producer, single-consumer ring buffer of logging thread.
+		struct LogRing
+		{
+			LogRing(size_t size, uintptr_t tid)
+				: capacity(size)
+				, threadId(tid)
+				, abandoned(0)
+			{
+				DKASSERT_DEBUG((size & (size - 1)) == 0);
+				buffer = reinterpret_cast<uint8_t*>(DKMalloc(size));
+			}
+			~LogRing()
+			{
+				DKFree(buffer);
+			}
+
+			DKAtomicNumber64 head;		// read position (dispatcher)
+			uint8_t padding1[64];
+			DKAtomicNumber64 tail;		// write position (logging thread)
+			uint8_t padding2[64];
+
+			uint8_t* buffer;
+			const size_t capacity;
+			const uintptr_t threadId;
+			DKAtomicNumber32 abandoned;	// thread terminated
+
+			// next record, skip padding.
+			const LogRecordHeader* Peek()
+			{
+				int64_t t = tail.Load();
+				int64_t h = head.LoadRelaxed();
+				while (h < t)
+				{
+					const LogRecordHeader* hdr = reinterpret_cast<const LogRecordHeader*>(&buffer[h & (capacity - 1)]);
+					if (hdr->category)
+						return hdr;
+					h += hdr->size;
+					head.StoreRelease(h);
+				}
+				return NULL;
+			}
+			void Pop(const LogRecordHeader* hdr)
+			{
+				head.StoreRelease(head.LoadRelaxed() + hdr->size);
+			}
+			bool IsEmpty() const
+			{
+				return head.Load() == tail.Load();
+			}
+		};
+
+		struct LogDispatcher
+		{
+			LogDispatcher()
+				: bufferSize(0x10000)
+				, policy(DKLogger::OverflowPolicy::Drop)
+				, threadId(DKThread::invalidId)
+				, stop(false)
+			{
+				// loggers should be destroyed after dispatcher.
+				LoggerLock();
+				LoggerArray();
+			}
+			~LogDispatcher()
+			{
+				Shutdown();
+			}
+
+			DKMutex controlLock;		// enable, disable
+			DKSpinLock ringsLock;
+			DKArray<DKObject<LogRing>> rings;
+			DKArray<DKObject<LogRing>> dispatchRings;	// used by dispatcher
+
+			DKAtomicNumber32 enabled;
+			size_t bufferSize;
+			DKLogger::OverflowPolicy policy;
+			DKAtomicNumber64 dropped;
+
+			DKObject<DKThread> thread;
+			uintptr_t threadId;
+			DKCondition dispatchCond;
+			DKAtomicNumber32 waiting;	// dispatcher is waiting for records
+			bool stop;
+			DKCondition flushCond;
+			DKAtomicNumber32 flushRequests;
+			DKAtomicNumber32 writers;	// threads in PostRecord
+
+			void WakeDispatcher()
+			{
+				if (waiting.Load())
+				{
+					dispatchCond.Lock();
+					dispatchCond.Signal();
+					dispatchCond.Unlock();
+				}
+			}
+			bool HasPendingRecords()
+			{
+				DKCriticalSection<DKSpinLock> guard(ringsLock);
+				for (LogRing* ring : rings)
+				{
+					if (!ring->IsEmpty())
+						return true;
+				}
+				return false;
+			}
+			// deliver records of all threads in timestamp order.
+			size_t DispatchRecords()
+			{
+				ringsLock.Lock();
+				dispatchRings = rings;
+				ringsLock.Unlock();
+
+				size_t count = 0;
+				while (true)
+				{
+					LogRing* ring = NULL;
+					const LogRecordHeader* hdr = NULL;
+					for (LogRing* r : dispatchRings)
+					{
+						const LogRecordHeader* h = r->Peek();
+						if (h && (hdr == NULL || h->timestamp < hdr->timestamp))
+						{
+							ring = r;
+							hdr = h;
+						}
+					}
+					if (ring == NULL)
+						break;
+
+					DKLogger::Record record = {
+						static_cast<DKLogger::Category>(hdr->category),
+						DKDateTime(static_cast<uint64_t>(hdr->timestamp / 1000000), static_cast<uint32_t>(hdr->timestamp % 1000000)),
+						static_cast<uintptr_t>(hdr->threadId),
+						reinterpret_cast<const char*>(&hdr[1]),
+						hdr->length
+					};
+					size_t num = 0;
+					if (true)
+					{
+						DKCriticalSection<DKSpinLock> guard(LoggerLock());
+						for (DKLogger* logger : LoggerArray())
+						{
+							logger->LogRecord(record);
+							num++;
+						}
+					}
+					if (num == 0)
+						fprintf(stderr, "%s", record.message);
+
+					ring->Pop(hdr);
+					count++;
+				}
+
+				// remove rings of terminated threads.
+				ringsLock.Lock();
+				for (size_t i = 0; i < rings.Count(); )
+				{
+					LogRing* r = rings.Value(i);
+					if (r->abandoned.Load() && r->IsEmpty())
+						rings.Remove(i);
+					else
+						++i;
+				}
+				ringsLock.Unlock();
+				dispatchRings.Clear();
+				return count;
+			}
+			void Shutdown()
+			{
+				if (DKThread::CurrentThreadId() == threadId)
+					return;	// called by logger.
+
+				DKCriticalSection<DKMutex> guard(controlLock);
+				if (thread)
+				{
+					enabled.Store(0);
+
+					dispatchCond.Lock();
+					stop = true;
+					dispatchCond.Signal();
+					dispatchCond.Unlock();
+
+					thread->WaitTerminate();
+					thread = NULL;
+					threadId = DKThread::invalidId;
+
+					// wait for writers which passed enabled check,
+					// and deliver records written while stopping.
+					while (writers.Load() > 0)
+						DKThread::Yield();
+					DispatchRecords();
+
+					flushCond.Lock();
+					flushCond.Broadcast();
+					flushCond.Unlock();
+				}
+			}
+			void DispatchProc()
+			{
+				threadId = DKThread::CurrentThreadId();
+				while (true)
+				{
+					size_t num = DispatchRecords();
+					if (flushRequests.Load() > 0)
+					{
+						flushCond.Lock();
+						flushCond.Broadcast();
+						flushCond.Unlock();
+					}
+					if (num == 0)
+					{
+						dispatchCond.Lock();
+						if (stop)
+						{
+							dispatchCond.Unlock();
+							break;
+						}
+						waiting.Store(1);
+						if (!HasPendingRecords())
+							dispatchCond.WaitTimeout(0.1);
+						waiting.Store(0);
+						dispatchCond.Unlock();
+					}
+				}
+			}
+		};
+		static LogDispatcher& Dispatcher()
+		{
+			static LogDispatcher dispatcher;
+			return dispatcher;
+		}
+
+		// LogRingHolder : mark ring as abandoned at thread exit.
+		static thread_local LogRing* currentLogRing = NULL;
+		static thread_local bool logRingReleased = false;
+		struct LogRingHolder
+		{
+			~LogRingHolder()
+			{
+				LogRing* ring = currentLogRing;
+				logRingReleased = true;
+				currentLogRing = NULL;
+				if (ring)
+					ring->abandoned.Store(1);
+			}
+		};
+		static thread_local LogRingHolder logRingHolder;
+
+		static LogRing* CurrentLogRing(LogDispatcher& d)
+		{
+			if (currentLogRing == NULL && !logRingReleased)
+			{
+				LogRingHolder& holder = logRingHolder; // register destructor
+				(void)holder;
+
+				size_t size = 0x1000;
+				while (size < d.bufferSize)
+					size = size << 1;
+				DKObject<LogRing> ring = DKOBJECT_NEW LogRing(size, DKThread::CurrentThreadId());
+				DKCriticalSection<DKSpinLock> guard(d.ringsLock);
+				d.rings.Add(ring);
+				currentLogRing = ring;
+			}
+			return currentLogRing;
+		}
+
+		// returns false if record was not accepted (not counted as dropped).
+		static bool WriteLogRecord(LogDispatcher& d, DKLogger::Category c, const char* message, size_t length)
+		{
+			if (!d.enabled.Load(std::memory_order_acquire))
+				return false;
+
+			LogRing* ring = CurrentLogRing(d);
+			if (ring == NULL)
+				return false;
+
+			const size_t capacity = ring->capacity;
+			const size_t headerSize = sizeof(LogRecordHeader);
+			if (headerSize + length + 1 > capacity / 2)
+			{
+				length = capacity / 2 - headerSize - 1;
+				while (length > 0 && (message[length] & 0xc0) == 0x80)	// UTF-8 boundary
+					--length;
+			}
+			const size_t recordSize = (headerSize + length + 1 + 7) & ~size_t(7);
+
+			int64_t t = ring->tail.LoadRelaxed();
+			size_t offset = static_cast<size_t>(t) & (capacity - 1);
+			size_t contiguous = capacity - offset;
+			size_t required = (contiguous < recordSize) ? contiguous + recordSize : recordSize;
+
+			while (static_cast<size_t>(t - ring->head.LoadAcquire()) + required > capacity)
+			{
+				if (d.policy == DKLogger::OverflowPolicy::Drop || DKThread::CurrentThreadId() == d.threadId)
+				{
+					d.dropped.IncrementRelaxed();
+					return true;	// counted as dropped.
+				}
+				d.WakeDispatcher();
+				DKThread::Yield();
+				if (!d.enabled.Load())
+					return false;
+			}
+
+			if (contiguous < recordSize)	// wrap around
+			{
+				LogRecordHeader* pad = reinterpret_cast<LogRecordHeader*>(&ring->buffer[offset]);
+				pad->size = static_cast<uint32_t>(contiguous);
+				pad->category = 0;
+				t += contiguous;
+				offset = 0;
+			}
+			DKDateTime now = DKDateTime::Now();
+			LogRecordHeader* hdr = reinterpret_cast<LogRecordHeader*>(&ring->buffer[offset]);
+			hdr->size = static_cast<uint32_t>(recordSize);
+			hdr->category = static_cast<uint32_t>(c);
+			hdr->timestamp = now.SecondsSinceEpoch() * 1000000 + now.Microsecond();
+			hdr->threadId = ring->threadId;
+			hdr->length = static_cast<uint32_t>(length);
+			hdr->reserved = 0;
+			char* str = reinterpret_cast<char*>(&hdr[1]);
+			memcpy(str, message, length);
+			str[length] = 0;
+
+			ring->tail.Store(t + recordSize);
+			d.WakeDispatcher();
+			return true;
+		}
 	}
 }
 
@@ -84,6 +434,11 @@ bool DKLogger::IsBound() const
 	return false;
 }
 
+void DKLogger::LogRecord(const Record& r)
+{
+	this->Log(r.category, DKString(reinterpret_cast<const DKUniChar8*>(r.message), r.length));
+}
+
 size_t DKLogger::Broadcast(Category c, const DKString& str)
 {
 	size_t num = 0;
@@ -113,3 +468,82 @@ DKObject<DKLogger> DKLogger::CreateSimpleLogger(void (*fn)(Category, const DKStr
 	logger->fn = fn;
 	return logger.SafeCast<DKLogger>();
 }
+
+void DKLogger::EnableAsyncDispatch(size_t bufferSize, OverflowPolicy policy)
+{
+	LogDispatcher& d = Dispatcher();
+	DKCriticalSection<DKMutex> guard(d.controlLock);
+
+	d.bufferSize = bufferSize;
+	d.policy = policy;
+	if (d.thread == NULL)
+	{
+		d.stop = false;
+		d.thread = DKThread::Create(DKFunction(&d, &LogDispatcher::DispatchProc)->Invocation());
+		if (d.thread)
+		{
+			d.threadId = d.thread->Id();
+			d.enabled.Store(1);
+		}
+	}
+}
+
+void DKLogger::DisableAsyncDispatch()
+{
+	Dispatcher().Shutdown();
+}
+
+bool DKLogger::IsAsyncDispatchEnabled()
+{
+	return Dispatcher().enabled.Load(std::memory_order_acquire) != 0;
+}
+
+void DKLogger::Flush()
+{
+	LogDispatcher& d = Dispatcher();
+	if (!d.enabled.Load() || DKThread::CurrentThreadId() == d.threadId)
+		return;
+
+	DKArray<DKObject<LogRing>> rings;
+	DKArray<int64_t> tails;
+	d.ringsLock.Lock();
+	rings = d.rings;
+	d.ringsLock.Unlock();
+	tails.Reserve(rings.Count());
+	for (LogRing* ring : rings)
+		tails.Add(ring->tail.Load());
+
+	d.flushRequests.Increment();
+	d.dispatchCond.Lock();
+	d.dispatchCond.Signal();
+	d.dispatchCond.Unlock();
+
+	d.flushCond.Lock();
+	while (d.enabled.Load())
+	{
+		bool done = true;
+		for (size_t i = 0; i < rings.Count() && done; ++i)
+			done = rings.Value(i)->head.Load() >= tails.Value(i);
+		if (done)
+			break;
+		d.flushCond.WaitTimeout(0.01);
+	}
+	d.flushCond.Unlock();
+	d.flushRequests.Decrement();
+}
+
+bool DKLogger::PostRecord(Category c, const char* message, size_t length)
+{
+	LogDispatcher& d = Dispatcher();
+	// Shutdown waits until writers leave, so that accepted records are
+	// delivered by final dispatch.
+	d.writers.Increment();
+	bool result = WriteLogRecord(d, c, message, length);
+	d.writers.Decrement();
+	return result;
+}
+
+uint64_t DKLogger::NumberOfDroppedRecords()
+{
+	return Dispatcher().dropped.Load();
+}
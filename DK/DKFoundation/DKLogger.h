@@ -9,6 +9,7 @@
 #include "../DKInclude.h"
 #include "DKObject.h"
 #include "DKString.h"
+#include "DKDateTime.h"
 
 namespace DKFoundation
 {
@@ -16,16 +17,45 @@ namespace DKFoundation
 
 	/// @brief a logger class.
 	/// you can sublcass DKLogger to handle log text.
+	///
+	/// Log text is delivered synchronously by default, with calling thread.
+	/// When asynchronous dispatch is enabled, DKLog writes UTF-8 records to
+	/// ring buffer of calling thread without locking, and dispatcher thread
+	/// delivers records to bound loggers in timestamp order.
+	/// @code
+	///  DKLogger::EnableAsyncDispatch(0x10000, DKLogger::OverflowPolicy::Drop);
+	///  DKLog("frame:%d\n", frame);  // does not wait for loggers
+	///  DKLogger::Flush();           // wait until delivered
+	/// @endcode
 	class DKGL_API DKLogger
 	{
 	public:
 		using Category = DKLogCategory;
 
+		/// a log record, delivered by asynchronous dispatcher.
+		struct Record
+		{
+			Category category;
+			DKDateTime timestamp;
+			uintptr_t threadId;		///< DKThread::ThreadId of logging thread
+			const char* message;	///< UTF-8, null-terminated
+			size_t length;
+		};
+		/// behavior when ring buffer of logging thread is full.
+		enum class OverflowPolicy
+		{
+			Drop,	///< discard record
+			Block,	///< wait until dispatcher drains buffer
+		};
+
 		DKLogger();
 		virtual ~DKLogger();
 
 		/// Should override this function, Never call Unbind() in this function!
 		virtual void Log(Category, const DKString&) = 0;
+		/// called by asynchronous dispatcher,
+		/// default implementation calls Log(Category, const DKString&).
+		virtual void LogRecord(const Record&);
 
 		void Bind();	/// bind to system, share ownership with system.
 		void Unbind();
@@ -33,6 +63,21 @@ namespace DKFoundation
 
 		static size_t Broadcast(Category, const DKString&);
 
+		/// start dispatcher thread, bufferSize is size of ring buffer per thread.
+		static void EnableAsyncDispatch(size_t bufferSize = 0x10000, OverflowPolicy = OverflowPolicy::Drop);
+		/// deliver pending records and stop dispatcher thread.
+		static void DisableAsyncDispatch();
+		static bool IsAsyncDispatchEnabled();
+		/// wait until all records written before this call have been delivered.
+		static void Flush();
+		/// write UTF-8 record to ring buffer of current thread.
+		/// returns false if record was not accepted (dispatch is disabled or
+		/// thread is terminating), caller should log synchronously.
+		/// records dropped by overflow policy are counted and returns true.
+		static bool PostRecord(Category, const char* message, size_t length);
+		/// number of records dropped by buffer overflow.
+		static uint64_t NumberOfDroppedRecords();
+
 		static DKObject<DKLogger> CreateSimpleLogger(void(*)(Category, const DKString&));
 	protected:
 		virtual void OnBind() {}
@@ -35,6 +35,7 @@
 #include "DKUtils.h"
 #include "DKUuid.h"
 #include "DKFixedSizeAllocator.h"
+#include "DKAtomicNumber32.h"
 
 
 #define DKLog(...)	fprintf(stderr, __VA_ARGS__)
@@ -45,6 +46,19 @@ namespace DKFoundation
 	{
 		static DKAllocator::Maintainer maintainer;
 
+		// DKAllocationTracker.cpp
+		extern DKAtomicNumber32 allocationTrackingEnabled;
+		void TrackAllocation(void*, size_t, DKMemoryLocation);
+		void TrackDeallocation(void*);
+
+		// not tracked by DKAllocationTracker.
+		static void* UntrackedHeapAlloc(size_t);
+		static void* UntrackedHeapRealloc(void*, size_t);
+		static void  UntrackedHeapFree(void*);
+		static void* UntrackedVirtualAlloc(size_t);
+		static void* UntrackedVirtualRealloc(void*, size_t);
+		static void  UntrackedVirtualFree(void*);
+
 		struct SystemHeapAllocator
 		{
 #ifdef _WIN32
@@ -86,7 +100,13 @@ namespace DKFoundation
 		HANDLE SystemHeapAllocator::heap;
 #endif
 
-		using SystemLargeHeapAllocator = DKMemoryVirtualAllocator;
+		struct SystemLargeHeapAllocator
+		{
+			enum { Location = DKMemoryLocationVirtual };
+			static void* Alloc(size_t s)			{ return UntrackedVirtualAlloc(s); }
+			static void* Realloc(void* p, size_t s)	{ return UntrackedVirtualRealloc(p, s); }
+			static void Free(void* p)				{ UntrackedVirtualFree(p); }
+		};
 
 		// BackendAllocator : allocates all front-end allocators chunks.
 		struct BackendAllocator
@@ -301,6 +321,9 @@ namespace DKFoundation
 			virtual size_t ConditionalPurge(size_t) = 0;
 			virtual bool ConditionalDeallocAndPurge(void*, size_t, size_t*) = 0;
 
+			virtual size_t AllocUnits(void**, size_t) = 0;
+			virtual size_t ConditionalDeallocUnitsAndPurge(void* const*, size_t, size_t, size_t*) = 0;
+
 			virtual size_t NumberOfAllocatedUnits() const = 0;
 			virtual size_t NumberOfUnits() const = 0;
 		};
@@ -344,6 +367,12 @@ namespace DKFoundation
 					return allocator.ConditionalDeallocAndPurge(p, s, bp);
 				}
 
+				size_t AllocUnits(void** units, size_t n) override	{ return allocator.AllocUnits(units, n); }
+				size_t ConditionalDeallocUnitsAndPurge(void* const* units, size_t n, size_t s, size_t* bp) override
+				{
+					return allocator.ConditionalDeallocUnitsAndPurge(units, n, s, bp);
+				}
+
 				size_t NumberOfAllocatedUnits() const override	{ return allocator.NumberOfAllocatedUnits(); }
 				size_t NumberOfUnits() const override			{ return allocator.NumberOfUnits(); }
 
@@ -370,11 +399,92 @@ namespace DKFoundation
 			static int Init(AllocatorUnit*) { return 0; }
 		};
 
+		// ThreadCache : per-thread free-list magazines of small buckets.
+		//   Units are moved between magazines and buckets in batches, so
+		//   bucket lock is acquired once per batch instead of every allocation.
+		//   Each cache has its own lock, which is only contended while
+		//   cache is being drained by other thread. (DKMemoryPoolPurge)
+		struct ThreadCache
+		{
+			enum { NumBuckets = 64 };				// buckets up to 2048 bytes
+			enum { MaxUnitsPerMagazine = 64 };
+			enum { MaxBytesPerMagazine = 8192 };
+
+			struct Magazine
+			{
+				void** units;
+				uint32_t count;
+				uint32_t capacity;
+			};
+
+			static uint32_t MagazineCapacity(size_t unitSize)
+			{
+				return (uint32_t)Min(size_t(MaxUnitsPerMagazine), size_t(MaxBytesPerMagazine) / unitSize);
+			}
+
+			template <typename Pool> void* Alloc(Pool* pool, size_t index)
+			{
+				DKASSERT_MEM_DEBUG(index < NumBuckets);
+				ScopedLock guard(lock);
+				Magazine& m = magazines[index];
+				if (m.count == 0)
+				{
+					// refill half of magazine.
+					m.count = (uint32_t)pool->GetAllocatorUnit(index).allocator->AllocUnits(m.units, Max(m.capacity / 2, 1U));
+					if (m.count == 0)
+						return NULL;	// out of memory!
+				}
+				return m.units[--m.count];
+			}
+			template <typename Pool> void Dealloc(Pool* pool, size_t index, void* p)
+			{
+				DKASSERT_MEM_DEBUG(index < NumBuckets);
+				ScopedLock guard(lock);
+				Magazine& m = magazines[index];
+#if DKGL_MEMORY_DEBUG
+				for (uint32_t i = 0; i < m.count; ++i)
+				{
+					DKASSERT_MEM_DESC_DEBUG(m.units[i] != p, "Memory already freed!");
+				}
+#endif
+				if (m.count == m.capacity)
+				{
+					// flush older half of magazine.
+					uint32_t n = Max(m.capacity / 2, 1U);
+					pool->DeallocUnits(index, m.units, n);
+					m.count -= n;
+					memmove(&m.units[0], &m.units[n], sizeof(void*) * m.count);
+				}
+				m.units[m.count++] = p;
+			}
+			template <typename Pool> void Drain(Pool* pool)
+			{
+				ScopedLock guard(lock);
+				for (size_t i = 0; i < NumBuckets; ++i)
+				{
+					Magazine& m = magazines[i];
+					if (m.count > 0)
+					{
+						pool->DeallocUnits(i, m.units, m.count);
+						m.count = 0;
+					}
+				}
+			}
+
+			using ScopedLock = DKCriticalSection<DKSpinLock>;
+			DKSpinLock lock;
+			ThreadCache* next;
+			ThreadCache* prev;
+			bool detached;	// pool has been destroyed.
+			Magazine magazines[NumBuckets];
+		};
+
 		struct AllocatorPool : public DKAllocator
 		{
 			enum { NumAllocators = 128 };	// allocator buckets
+			static_assert(size_t(ThreadCache::NumBuckets) <= size_t(NumAllocators), "Invalid cache buckets");
 
-			AllocatorPool() : backend(NULL)
+			AllocatorPool() : backend(NULL), threadCaches(NULL), threadCacheSlots(0)
 			{
 #ifdef _WIN32
 				// reserve 64 MB heap
@@ -417,10 +527,27 @@ namespace DKFoundation
 					  chunkSize);
 #endif
 				maxUnitSize = allocators[NumAllocators-1].unitSize;
+
+				for (int i = 0; i < ThreadCache::NumBuckets; ++i)
+				{
+					DKASSERT_MEM_DEBUG(allocators[i].unitSize <= ThreadCache::MaxBytesPerMagazine);
+					threadCacheSlots += ThreadCache::MagazineCapacity(allocators[i].unitSize);
+				}
 			}
 
 			~AllocatorPool()
 			{
+				// return all cached units to buckets, caches will be
+				// released by its thread. (see ThreadCacheHolder)
+				threadCacheLock.Lock();
+				for (ThreadCache* cache = threadCaches; cache; cache = cache->next)
+				{
+					cache->Drain(this);
+					cache->detached = true;
+				}
+				threadCaches = NULL;
+				threadCacheLock.Unlock();
+
 				bool cleanupHeap = true;
 				for (int i = 0; i < NumAllocators; ++i)
 				{
@@ -464,7 +591,7 @@ namespace DKFoundation
 				AllocatorUnit* unit = FindAllocatorForSize(s);
 				DKASSERT_MEM_DEBUG(unit != NULL);
 				DKASSERT_MEM_DEBUG(unit->unitSize >= s);
-				return unit->allocator->Alloc(s);
+				return AllocUnit(unit, s);
 			}
 
 			void* Realloc(void* p, size_t s)
@@ -484,16 +611,13 @@ namespace DKFoundation
 							AllocatorUnit* unit2 = FindAllocatorForSize(s);
 							if (unit2 == unit)
 								return p;
-							p2 = unit2->allocator->Alloc(s);
+							p2 = AllocUnit(unit2, s);
 						}
 						if (p2)
 						{
 							size_t bytesToCopy = Min(s, unit->unitSize);
 							memcpy(p2, p, bytesToCopy);
-							if (!DeallocAndPurge(unit, p))
-							{
-								DKASSERT_MEM_DEBUG(0);
-							}
+							DeallocUnit(unit, p);
 						}
 						return p2;
 					}
@@ -507,7 +631,7 @@ namespace DKFoundation
 						{
 							unit = FindAllocatorForSize(s);
 							DKASSERT_MEM_DEBUG(unit);
-							void* p2 = unit->allocator->Alloc(s);
+							void* p2 = AllocUnit(unit, s);
 							if (p2)
 							{
 								memcpy(p2, p, s);
@@ -527,10 +651,7 @@ namespace DKFoundation
 					AllocatorUnit* unit = FindAllocator(p);
 					if (unit)
 					{
-						if (!DeallocAndPurge(unit, p))
-						{
-							DKASSERT_MEM_DEBUG(0);
-						}
+						DeallocUnit(unit, p);
 						return;
 					}
 
@@ -540,6 +661,8 @@ namespace DKFoundation
 
 			size_t Purge()
 			{
+				DrainThreadCaches();
+
 				size_t bytesPurged = 0;
 				for (int i = 0; i < NumAllocators; ++i)
 				{
@@ -572,7 +695,119 @@ namespace DKFoundation
 				return allocators[index];
 			}
 
+			// return units to bucket (index) with single lock.
+			void DeallocUnits(size_t index, void* const* units, size_t count)
+			{
+				size_t purged = 0;
+				size_t n = allocators[index].allocator->ConditionalDeallocUnitsAndPurge(units, count, 0, &purged);
+				DKASSERT_MEM_DEBUG(n == count);
+				(void)n;
+				if (purged > 0)
+					backend->PurgeThreshold(16);
+			}
+
+			ThreadCache* CreateThreadCache()
+			{
+				size_t size = sizeof(ThreadCache) + sizeof(void*) * threadCacheSlots;
+				ThreadCache* cache = ::new (SystemHeapAllocator::Alloc(size)) ThreadCache();
+				if (cache)
+				{
+					cache->detached = false;
+					void** slots = reinterpret_cast<void**>(&cache[1]);
+					for (int i = 0; i < ThreadCache::NumBuckets; ++i)
+					{
+						ThreadCache::Magazine& m = cache->magazines[i];
+						m.units = slots;
+						m.count = 0;
+						m.capacity = ThreadCache::MagazineCapacity(allocators[i].unitSize);
+						slots += m.capacity;
+					}
+					DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+					cache->prev = NULL;
+					cache->next = threadCaches;
+					if (threadCaches)
+						threadCaches->prev = cache;
+					threadCaches = cache;
+				}
+				return cache;
+			}
+			void DestroyThreadCache(ThreadCache* cache)
+			{
+				DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+				cache->Drain(this);
+				if (cache->prev)
+					cache->prev->next = cache->next;
+				else
+					threadCaches = cache->next;
+				if (cache->next)
+					cache->next->prev = cache->prev;
+				cache->~ThreadCache();
+				SystemHeapAllocator::Free(cache);
+			}
+			void DrainThreadCaches()
+			{
+				DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+				for (ThreadCache* cache = threadCaches; cache; cache = cache->next)
+					cache->Drain(this);
+			}
+			// number of units cached in all threads and number of threads using bucket.
+			void QueryThreadCacheStatus(size_t index, size_t* cachedUnits, size_t* threads)
+			{
+				size_t units = 0;
+				size_t numThreads = 0;
+				if (index < ThreadCache::NumBuckets)
+				{
+					DKCriticalSection<DKSpinLock> guard(threadCacheLock);
+					for (ThreadCache* cache = threadCaches; cache; cache = cache->next)
+					{
+						ThreadCache::ScopedLock guard2(cache->lock);
+						size_t count = cache->magazines[index].count;
+						if (count > 0)
+						{
+							units += count;
+							numThreads++;
+						}
+					}
+				}
+				*cachedUnits = units;
+				*threads = numThreads;
+			}
+			size_t ThreadCacheCapacity(size_t index) const
+			{
+				if (index < ThreadCache::NumBuckets)
+					return ThreadCache::MagazineCapacity(allocators[index].unitSize);
+				return 0;
+			}
+
 		private:
+			FORCEINLINE void* AllocUnit(AllocatorUnit* unit, size_t s)
+			{
+				size_t index = unit - allocators;
+				if (index < ThreadCache::NumBuckets)
+				{
+					if (ThreadCache* cache = CurrentThreadCache())
+						return cache->Alloc(this, index);
+				}
+				return unit->allocator->Alloc(s);
+			}
+			FORCEINLINE void DeallocUnit(AllocatorUnit* unit, void* p)
+			{
+				size_t index = unit - allocators;
+				if (index < ThreadCache::NumBuckets)
+				{
+					if (ThreadCache* cache = CurrentThreadCache())
+					{
+						cache->Dealloc(this, index, p);
+						return;
+					}
+				}
+				if (!DeallocAndPurge(unit, p))
+				{
+					DKASSERT_MEM_DEBUG(0);
+				}
+			}
+			static ThreadCache* CurrentThreadCache();
+
 			FORCEINLINE bool DeallocAndPurge(AllocatorUnit* unit, void* p)
 			{
 				DKASSERT_MEM_DEBUG(unit);
@@ -620,6 +855,10 @@ namespace DKFoundation
 			BackendAllocator* backend;
 			AllocatorUnit allocators[NumAllocators];
 			size_t maxUnitSize;
+
+			DKSpinLock threadCacheLock;
+			ThreadCache* threadCaches;
+			size_t threadCacheSlots;
 		};
 
 		AllocatorPool* GetAllocatorPool()
@@ -647,6 +886,47 @@ namespace DKFoundation
 			return GetAllocatorPool()->Backend();
 		}
 
+		// ThreadCacheHolder : release thread cache at thread exit.
+		// cache pointer and state are kept in trivial thread_local variables,
+		// because members of destroyed object cannot be trusted. (stores in
+		// destructor can be eliminated by compiler)
+		static thread_local ThreadCache* threadCache = NULL;
+		static thread_local bool threadCacheReleased = false;
+		struct ThreadCacheHolder
+		{
+			~ThreadCacheHolder()
+			{
+				ThreadCache* cache = threadCache;
+				threadCacheReleased = true;
+				threadCache = NULL;
+				if (cache)
+				{
+					if (cache->detached)
+					{
+						cache->~ThreadCache();
+						SystemHeapAllocator::Free(cache);
+					}
+					else
+						GetAllocatorPool()->DestroyThreadCache(cache);
+				}
+			}
+		};
+		static thread_local ThreadCacheHolder threadCacheHolder;
+
+		ThreadCache* AllocatorPool::CurrentThreadCache()
+		{
+			if (threadCache == NULL && !threadCacheReleased)
+			{
+				// prevent recursion while creating cache.
+				threadCacheReleased = true;
+				ThreadCacheHolder& holder = threadCacheHolder; // register destructor
+				(void)holder;
+				threadCache = GetAllocatorPool()->CreateThreadCache();
+				threadCacheReleased = false;
+			}
+			return threadCache;
+		}
+
 		// VMSizeInfo : keep track VM-address, size pair.
 		struct VMSizeInfo
 		{
@@ -685,7 +965,7 @@ namespace DKFoundation
 				if (table.capacity <= table.count + 1)
 				{
 					size_t cap = table.capacity + SizeOffset;
-					Info* p = (Info*)DKMemoryHeapRealloc(table.data, cap * sizeof(Info));
+					Info* p = (Info*)UntrackedHeapRealloc(table.data, cap * sizeof(Info));
 					if (p == NULL)		// out of memory.
 						return false;
 					table.capacity = cap;
@@ -730,7 +1010,7 @@ namespace DKFoundation
 				}
 				else
 				{
-					DKMemoryHeapFree(table.data);
+					UntrackedHeapFree(table.data);
 					table.data = NULL;
 					table.capacity = 0;
 				}
@@ -812,237 +1092,294 @@ namespace DKFoundation
 	using namespace Private;
 
 
-	DKGL_API void* DKMemoryHeapAlloc(size_t s)
+	namespace Private
 	{
+		static void* UntrackedHeapAlloc(size_t s)
+		{
 #ifdef _WIN32
-		return ::HeapAlloc(GetProcessHeap(), 0, s);
+			return ::HeapAlloc(GetProcessHeap(), 0, s);
 #else
-		return ::malloc(s);
+			return ::malloc(s);
 #endif
-	}
+		}
 
-	DKGL_API void* DKMemoryHeapRealloc(void* p, size_t s)
-	{
-#ifdef _WIN32
-		if (p == NULL)
-			return DKMemoryHeapAlloc(s);
-		if (s == 0)
+		static void* UntrackedHeapRealloc(void* p, size_t s)
 		{
-			DKMemoryHeapFree(p);
-			return NULL;
-		}
-		return ::HeapReAlloc(GetProcessHeap(), 0, p, s);
+#ifdef _WIN32
+			if (p == NULL)
+				return UntrackedHeapAlloc(s);
+			if (s == 0)
+			{
+				UntrackedHeapFree(p);
+				return NULL;
+			}
+			return ::HeapReAlloc(GetProcessHeap(), 0, p, s);
 #else
-		return ::realloc(p, s);
+			return ::realloc(p, s);
 #endif
-	}
+		}
 
-	DKGL_API void  DKMemoryHeapFree(void* p)
-	{
+		static void  UntrackedHeapFree(void* p)
+		{
 #ifdef _WIN32
-		::HeapFree(GetProcessHeap(), 0, p);
+			::HeapFree(GetProcessHeap(), 0, p);
 #else
-		return ::free(p);
+			return ::free(p);
 #endif
-	}
+		}
 
-	// virtual-address, can commit, decommit.
-	// data will be erased when decommit.
-	DKGL_API void* DKMemoryVirtualAlloc(size_t s)
-	{
-		void* p = NULL;
+		// virtual-address, can commit, decommit.
+		// data will be erased when decommit.
+		static void* UntrackedVirtualAlloc(size_t s)
+		{
+			void* p = NULL;
 
-		size_t pageSize = DKMemoryPageSize();
-		DKASSERT_MEM_DEBUG(pageSize != 0);
+			size_t pageSize = DKMemoryPageSize();
+			DKASSERT_MEM_DEBUG(pageSize != 0);
 
-		if (s == 0)
-			s = pageSize;
-		else if (s % pageSize)
-			s += pageSize - (s % pageSize);
+			if (s == 0)
+				s = pageSize;
+			else if (s % pageSize)
+				s += pageSize - (s % pageSize);
 
-		DKASSERT_MEM_DEBUG((s % pageSize) == 0);
+			DKASSERT_MEM_DEBUG((s % pageSize) == 0);
 
 #ifdef _WIN32
-		p = ::VirtualAlloc(0, s, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-		if (p)
-		{
-			DKASSERT_MEM_DEBUG(VMSizeInfo::Set(p, s));
-		}
+			p = ::VirtualAlloc(0, s, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+			if (p)
+			{
+				DKASSERT_MEM_DEBUG(VMSizeInfo::Set(p, s));
+			}
 #else
-		p = ::mmap(0, s, PROT_READ|PROT_WRITE, MAP_ANON|MAP_PRIVATE, -1, 0);
-		if (p == MAP_FAILED)
-		{
-			DKLog("mmap failed: %s\n", strerror(errno));
-			p = NULL;
-		}
-		else
-		{
-			if (!VMSizeInfo::Set(p, s))
+			p = ::mmap(0, s, PROT_READ|PROT_WRITE, MAP_ANON|MAP_PRIVATE, -1, 0);
+			if (p == MAP_FAILED)
 			{
-				//DKASSERT_MEM_DESC_DEBUG(0, "VMSizeInfo::Set failed.");
-				DKLog("VMSizeInfo::Set failed.\n");
-				// unmap.
-				if (::munmap(p, s) != 0)
+				DKLog("mmap failed: %s\n", strerror(errno));
+				p = NULL;
+			}
+			else
+			{
+				if (!VMSizeInfo::Set(p, s))
 				{
-					DKASSERT_MEM_DESC_DEBUG(0, "munmap failed");
-					DKLog("munmap failed: %s\n", strerror(errno));
+					//DKASSERT_MEM_DESC_DEBUG(0, "VMSizeInfo::Set failed.");
+					DKLog("VMSizeInfo::Set failed.\n");
+					// unmap.
+					if (::munmap(p, s) != 0)
+					{
+						DKASSERT_MEM_DESC_DEBUG(0, "munmap failed");
+						DKLog("munmap failed: %s\n", strerror(errno));
+					}
+					p = NULL;
 				}
-				p = NULL;
 			}
-		}
 #endif
-		return p;
-	}
+			return p;
+		}
 
-	DKGL_API void* DKMemoryVirtualRealloc(void* p, size_t s)
-	{
-		if (p && s)
+		static void* UntrackedVirtualRealloc(void* p, size_t s)
 		{
-			size_t pageSize = DKMemoryPageSize();
-			DKASSERT_MEM_DEBUG(pageSize != 0);
-			size_t alignedSize = s;
-			if (s % pageSize)
-				alignedSize += pageSize - (s % pageSize);
-
-#ifdef _WIN32
-			MEMORY_BASIC_INFORMATION memInfo;
-			if (VirtualQuery(p, &memInfo, sizeof(memInfo)))
+			if (p && s)
 			{
 				size_t pageSize = DKMemoryPageSize();
 				DKASSERT_MEM_DEBUG(pageSize != 0);
+				size_t alignedSize = s;
+				if (s % pageSize)
+					alignedSize += pageSize - (s % pageSize);
 
-				if (alignedSize != memInfo.RegionSize)
+#ifdef _WIN32
+				MEMORY_BASIC_INFORMATION memInfo;
+				if (VirtualQuery(p, &memInfo, sizeof(memInfo)))
 				{
-					void* p2 = ::VirtualAlloc(0, s, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-					if (p2)
+					size_t pageSize = DKMemoryPageSize();
+					DKASSERT_MEM_DEBUG(pageSize != 0);
+
+					if (alignedSize != memInfo.RegionSize)
 					{
-						DKASSERT_MEM_DEBUG(VMSizeInfo::Unset(p));
-						DKASSERT_MEM_DEBUG(VMSizeInfo::Set(p2, alignedSize));
-						memcpy(p2, p, (alignedSize > memInfo.RegionSize ? memInfo.RegionSize : s));
-						::VirtualFree(p, 0, MEM_RELEASE);
+						void* p2 = ::VirtualAlloc(0, s, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+						if (p2)
+						{
+							DKASSERT_MEM_DEBUG(VMSizeInfo::Unset(p));
+							DKASSERT_MEM_DEBUG(VMSizeInfo::Set(p2, alignedSize));
+							memcpy(p2, p, (alignedSize > memInfo.RegionSize ? memInfo.RegionSize : s));
+							::VirtualFree(p, 0, MEM_RELEASE);
+						}
+						p = p2;
 					}
-					p = p2;
-				}
-			}
-			else
-			{
-				DKASSERT_MEM_DESC_DEBUG(0, "VirtualQuery failed.");
-				DKLog("VirtualQuery failed:%ls\n", Win32GetErrorString(::GetLastError()).c_str());
-				p = NULL;
-			}
-#else
-			size_t sizeOrig = VMSizeInfo::Size(p);
-			DKASSERT_MEM_DESC_DEBUG(sizeOrig > 0, "Invalid address.");
-			if (sizeOrig == alignedSize)
-			{
-				return p; // no change.
-			}
-			else if (sizeOrig > alignedSize)			// shrink
-			{
-				uintptr_t p2 = reinterpret_cast<uintptr_t>(p) + alignedSize;
-				size_t len = sizeOrig - alignedSize;
-				DKLog("munmap(%lu, %lu)\n", p2, len);
-				if (::munmap(reinterpret_cast<void*>(p2), len) != 0)
-				{
-					DKLog("munmap failed: %s\n", strerror(errno));
 				}
 				else
 				{
-					VMSizeInfo::Update(p, alignedSize, NULL);
-					return p;
+					DKASSERT_MEM_DESC_DEBUG(0, "VirtualQuery failed.");
+					DKLog("VirtualQuery failed:%ls\n", Win32GetErrorString(::GetLastError()).c_str());
+					p = NULL;
 				}
-			}
-			else	// expand
-			{
-				uintptr_t p2 = reinterpret_cast<uintptr_t>(p) + sizeOrig;
-				size_t len = alignedSize - sizeOrig;
-				// mmap on p2 with len length.
-				// recall mmap for entire region and copy if failed.
-				void* p3 = ::mmap(reinterpret_cast<void*>(p2), len, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
-				if (p3 == MAP_FAILED)
+#else
+				size_t sizeOrig = VMSizeInfo::Size(p);
+				DKASSERT_MEM_DESC_DEBUG(sizeOrig > 0, "Invalid address.");
+				if (sizeOrig == alignedSize)
 				{
-					DKLog("mmap failed: %s\n", strerror(errno));
-					// failed, mmap for entire region and copy!
+					return p; // no change.
 				}
-				else
+				else if (sizeOrig > alignedSize)			// shrink
 				{
-					if (p2 == reinterpret_cast<uintptr_t>(p3))
+					uintptr_t p2 = reinterpret_cast<uintptr_t>(p) + alignedSize;
+					size_t len = sizeOrig - alignedSize;
+					DKLog("munmap(%lu, %lu)\n", p2, len);
+					if (::munmap(reinterpret_cast<void*>(p2), len) != 0)
+					{
+						DKLog("munmap failed: %s\n", strerror(errno));
+					}
+					else
 					{
-						// mmap returned good position!
 						VMSizeInfo::Update(p, alignedSize, NULL);
 						return p;
 					}
+				}
+				else	// expand
+				{
+					uintptr_t p2 = reinterpret_cast<uintptr_t>(p) + sizeOrig;
+					size_t len = alignedSize - sizeOrig;
+					// mmap on p2 with len length.
+					// recall mmap for entire region and copy if failed.
+					void* p3 = ::mmap(reinterpret_cast<void*>(p2), len, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+					if (p3 == MAP_FAILED)
+					{
+						DKLog("mmap failed: %s\n", strerror(errno));
+						// failed, mmap for entire region and copy!
+					}
 					else
 					{
-						DKLog("mmap returns unwanted location(%p != %p). unmap and realloc\n", (const void*)p2, (const void*)p3);
-						if (::munmap(p3, len) != 0)
+						if (p2 == reinterpret_cast<uintptr_t>(p3))
+						{
+							// mmap returned good position!
+							VMSizeInfo::Update(p, alignedSize, NULL);
+							return p;
+						}
+						else
 						{
-							DKLog("munmap failed: %s\n", strerror(errno));
+							DKLog("mmap returns unwanted location(%p != %p). unmap and realloc\n", (const void*)p2, (const void*)p3);
+							if (::munmap(p3, len) != 0)
+							{
+								DKLog("munmap failed: %s\n", strerror(errno));
+							}
 						}
 					}
 				}
+				// mmap with specified range and copy.
+				void* p2 = ::mmap(0, alignedSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+				if (p2 == MAP_FAILED)
+				{
+					DKLog("mmap failed: %s\n", strerror(errno));
+					p = NULL;
+				}
+				else
+				{
+					VMSizeInfo::Unset(p);
+					VMSizeInfo::Set(p2, alignedSize);
+
+					size_t bytesCopy = Min(sizeOrig, alignedSize);
+					::memcpy(p2, p, bytesCopy);
+
+					if (::munmap(p, sizeOrig) != 0)
+					{
+						DKLog("munmap failed: %s\n", strerror(errno));
+					}
+					p = p2;
+				}
+#endif
+				return p;
 			}
-			// mmap with specified range and copy.
-			void* p2 = ::mmap(0, alignedSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
-			if (p2 == MAP_FAILED)
+			else if (p == NULL)
 			{
-				DKLog("mmap failed: %s\n", strerror(errno));
-				p = NULL;
+				return UntrackedVirtualAlloc(s);
 			}
-			else
+			else if (s == 0)
 			{
-				VMSizeInfo::Unset(p);
-				VMSizeInfo::Set(p2, alignedSize);
-
-				size_t bytesCopy = Min(sizeOrig, alignedSize);
-				::memcpy(p2, p, bytesCopy);
+				UntrackedVirtualFree(p);
+				return NULL;
+			}
+			return NULL;
+		}
 
-				if (::munmap(p, sizeOrig) != 0)
+		static void  UntrackedVirtualFree(void* p)
+		{
+			if (p)
+			{
+#ifdef _WIN32
+				DKASSERT_MEM_DEBUG(VMSizeInfo::Unset(p));
+				if (!::VirtualFree(p, 0, MEM_RELEASE))
 				{
-					DKLog("munmap failed: %s\n", strerror(errno));
+					DKASSERT_MEM_DESC_DEBUG(0, "VirtualFree failed");
+					DKLog("VirtualFree failed:%ls\n", Win32GetErrorString(::GetLastError()).c_str());
+				}
+#else
+				size_t s = VMSizeInfo::Size(p);
+				DKASSERT_MEM_DESC_DEBUG(s > 0, "Unallocated address.");
+				if (s > 0)
+				{
+					DKASSERT_MEM_DEBUG((s % DKMemoryPageSize()) == 0);
+					VMSizeInfo::Unset(p);
+					if (::munmap(p, s) != 0)
+					{
+						DKLog("munmap failed: %s\n", strerror(errno));
+					}
 				}
-				p = p2;
-			}
 #endif
-			return p;
+			}
 		}
-		else if (p == NULL)
+	}
+
+	DKGL_API void* DKMemoryHeapAlloc(size_t s)
+	{
+		void* p = UntrackedHeapAlloc(s);
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackAllocation(p, s, DKMemoryLocationHeap);
+		return p;
+	}
+
+	DKGL_API void* DKMemoryHeapRealloc(void* p, size_t s)
+	{
+		if (allocationTrackingEnabled.LoadRelaxed())
 		{
-			return DKMemoryVirtualAlloc(s);
+			TrackDeallocation(p);
+			p = UntrackedHeapRealloc(p, s);
+			TrackAllocation(p, s, DKMemoryLocationHeap);
+			return p;
 		}
-		else if (s == 0)
+		return UntrackedHeapRealloc(p, s);
+	}
+
+	DKGL_API void  DKMemoryHeapFree(void* p)
+	{
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackDeallocation(p);
+		UntrackedHeapFree(p);
+	}
+
+	DKGL_API void* DKMemoryVirtualAlloc(size_t s)
+	{
+		void* p = UntrackedVirtualAlloc(s);
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackAllocation(p, s, DKMemoryLocationVirtual);
+		return p;
+	}
+
+	DKGL_API void* DKMemoryVirtualRealloc(void* p, size_t s)
+	{
+		if (allocationTrackingEnabled.LoadRelaxed())
 		{
-			DKMemoryVirtualFree(p);
-			return NULL;
+			TrackDeallocation(p);
+			p = UntrackedVirtualRealloc(p, s);
+			TrackAllocation(p, s, DKMemoryLocationVirtual);
+			return p;
 		}
-		return NULL;
+		return UntrackedVirtualRealloc(p, s);
 	}
 
 	DKGL_API void  DKMemoryVirtualFree(void* p)
 	{
-		if (p)
-		{
-#ifdef _WIN32
-			DKASSERT_MEM_DEBUG(VMSizeInfo::Unset(p));
-			if (!::VirtualFree(p, 0, MEM_RELEASE))
-			{
-				DKASSERT_MEM_DESC_DEBUG(0, "VirtualFree failed");
-				DKLog("VirtualFree failed:%ls\n", Win32GetErrorString(::GetLastError()).c_str());
-			}
-#else
-			size_t s = VMSizeInfo::Size(p);
-			DKASSERT_MEM_DESC_DEBUG(s > 0, "Unallocated address.");
-			if (s > 0)
-			{
-				DKASSERT_MEM_DEBUG((s % DKMemoryPageSize()) == 0);
-				VMSizeInfo::Unset(p);
-				if (::munmap(p, s) != 0)
-				{
-					DKLog("munmap failed: %s\n", strerror(errno));
-				}
-			}
-#endif
-		}
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackDeallocation(p);
+		UntrackedVirtualFree(p);
 	}
 
 	DKGL_API size_t  DKMemoryVirtualSize(void* p)
@@ -1262,28 +1599,42 @@ namespace DKFoundation
 
 	DKGL_API void* DKMemoryPoolAlloc(size_t s)
 	{
-		return GetAllocatorPool()->Alloc(s);
+		void* p = GetAllocatorPool()->Alloc(s);
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackAllocation(p, s, DKMemoryLocationPool);
+		return p;
 	}
 
 	DKGL_API void* DKMemoryPoolRealloc(void* p, size_t s)
 	{
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackDeallocation(p);
+
 		if (p && s)
 		{
-			return GetAllocatorPool()->Realloc(p, s);
+			p = GetAllocatorPool()->Realloc(p, s);
 		}
 		else if (p == NULL)
 		{
-			return GetAllocatorPool()->Alloc(s);
+			p = GetAllocatorPool()->Alloc(s);
 		}
 		else if (s == 0)
 		{
 			GetAllocatorPool()->Dealloc(p);
+			return NULL;
 		}
-		return NULL;
+		else
+			return NULL;
+
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackAllocation(p, s, DKMemoryLocationPool);
+		return p;
 	}
 	
 	DKGL_API void DKMemoryPoolFree(void* p)
 	{
+		if (allocationTrackingEnabled.LoadRelaxed())
+			TrackDeallocation(p);
 		GetAllocatorPool()->Dealloc(p);
 	}
 	
@@ -1307,10 +1658,13 @@ namespace DKFoundation
 		size_t count = Min(numBuckets, (size_t)AllocatorPool::NumAllocators);
 		for (size_t i = 0; i < count; ++i)
 		{
-			const AllocatorUnit& unit = GetAllocatorPool()->GetAllocatorUnit(i);
+			AllocatorPool* pool = GetAllocatorPool();
+			const AllocatorUnit& unit = pool->GetAllocatorUnit(i);
 			status[i].chunkSize = unit.unitSize;
 			status[i].totalChunks = unit.allocator->NumberOfUnits();
 			status[i].usedChunks = unit.allocator->NumberOfAllocatedUnits();
+			status[i].threadCacheCapacity = pool->ThreadCacheCapacity(i);
+			pool->QueryThreadCacheStatus(i, &status[i].cachedChunks, &status[i].cachingThreads);
 		}
 	}
 }
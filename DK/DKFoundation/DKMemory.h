@@ -49,7 +49,7 @@ namespace DKFoundation
 	DKGL_API void* DKMemoryPoolRealloc(void*, size_t);
 	/// release memory allocated by DKMemoryPoolAlloc
 	DKGL_API void  DKMemoryPoolFree(void*);
-	/// purge unused memory pool chunks
+	/// purge unused memory pool chunks, including units cached by threads.
 	/// @note
 	///   If you run out of memory, call DKAllocatorChain::Cleanup
 	///   instead of calling DKMemoryPoolPurge, which purges memory pool only.
@@ -68,11 +68,13 @@ namespace DKFoundation
 		DKMemoryPoolBucketStatus* buckets = new DKMemoryPoolBucketStatus[numBuckets];
 		DKMemoryPoolQueryAllocationStatus(buckets, numBuckets);
 		for (int i = 0; i < numBuckets; ++i)
-			printf("unit-size:%lu, allocated:%lu, reserved:%lu (usage:%.1f%%)\n",
+			printf("unit-size:%lu, allocated:%lu, reserved:%lu (usage:%.1f%%), cached:%lu (%lu threads)\n",
 				buckets[i].chunkSize,
 				buckets[i].chunkSize * buckets[i].usedChunks, 
 				buckets[i].chunkSize * (buckets[i].totalChunks - buckets[i].usedChunks),
-				double(buckets[i].usedChunks) / double(buckets[i].totalChunks) * 100.0);
+				double(buckets[i].usedChunks) / double(buckets[i].totalChunks) * 100.0,
+				buckets[i].chunkSize * buckets[i].cachedChunks,
+				buckets[i].cachingThreads);
 		printf("MemoryPool Usage: %.1fMB / %.1fMB\n", double(usedBytes) / (1024 * 1024), double(DKMemoryPoolSize()) / (1024 * 1024));
 		delete[] buckets;
 	 @endcode
@@ -83,12 +85,17 @@ namespace DKFoundation
 	{
 		size_t chunkSize;		///< allocation unit size of the allocator
 		size_t totalChunks;		///< total chunks in the allocator
-		size_t usedChunks;		///< allocated units
+		size_t usedChunks;		///< allocated units (including cached units)
+		size_t threadCacheCapacity;	///< max units can be cached per thread
+		size_t cachedChunks;	///< units cached in all threads (not in use)
+		size_t cachingThreads;	///< number of threads have cached units
 	};
 	/// Get number of buckets, a bucket is a unit of sub-allocator in memory pool.
 	/// this value does not change during run-time.
 	DKGL_API size_t DKMemoryPoolNumberOfBuckets();
 	/// Query allocation status of Memory-Pool.
+	/// Small units are cached per thread, cached units will be returned to
+	/// the pool by calling DKMemoryPoolPurge or when the thread exits.
 	/// Do not call this function at exiting.
 	/// @see DKMemoryPoolBucketStatus
 	DKGL_API void DKMemoryPoolQueryAllocationStatus(DKMemoryPoolBucketStatus* status, size_t numBuckets);
@@ -268,7 +268,7 @@ namespace DKFoundation
 					p->~T();
 					if (allocator)
 					{
-						allocator->Dealloc(addr);
+						RefCounter::DeallocateObject(addr, allocator);
 					}
 					else
 					{
@@ -5,12 +5,14 @@
 //  Copyright (c) 2004-2016 Hongtae Kim. All rights reserved.
 //
 
+#include <atomic>
 #include "DKObjectRefCounter.h"
 #include "DKSpinLock.h"
 #include "DKMap.h"
 #include "DKArray.h"
 #include "DKMemory.h"
 #include "DKFixedSizeAllocator.h"
+#include "DKAtomicNumber32.h"
 
 
 namespace DKFoundation
@@ -19,7 +21,97 @@ namespace DKFoundation
 	{
 		static DKAllocator::Maintainer maintainer;
 
+		// DKAllocationTracker.cpp
+		extern DKAtomicNumber32 allocationTrackingEnabled;
+		void TrackAllocation(void*, size_t, DKMemoryLocation);
+		void TrackDeallocation(void*);
+
+		// allocations of DKMemory functions are tracked already.
+		FORCEINLINE static bool IsTrackingAllocator(DKAllocator* alloc)
+		{
+			return allocationTrackingEnabled.LoadRelaxed() && alloc->Location() == DKMemoryLocationCustom;
+		}
+
 		enum {AllocatorTableLength = 977}; // should be prime-number.
+
+		////////////////////////////////////////////////////////////////////////
+		// IntrusiveHeader
+		// ref-count state stored in front of object allocated by DKAllocator.
+		// (DKGL_INTRUSIVE_REFCOUNT)
+		//
+		// Note:
+		//  An object which has weak-ref (DKObject::Ref) is also registered
+		//  to global table, because weak-ref cannot access object header
+		//  before object validation. (object could be destroyed already)
+		//  Weak-ref promotion and destruction of these objects are serialized
+		//  by table lock.
+		struct IntrusiveHeader
+		{
+			enum : uint32_t { FlagWeakRef = 1 };
+
+			std::atomic<DKObjectRefCounter::RefCountValue>	refCount;
+			std::atomic<uintptr_t>							cookie;
+			std::atomic<uint32_t>							flags;
+			DKObjectRefCounter::RefIdValue					refId;
+			DKAllocator*									allocator;
+			void*											block;	// allocated address
+		};
+		// keep object alignment same as allocator's alignment.
+		enum : uintptr_t { IntrusiveHeaderSize = (sizeof(IntrusiveHeader) + 15) & ~uintptr_t(15) };
+		// smallest page size of all supported platforms.
+		// An intrusive object does not placed in front of page, so
+		// we can read header of any (foreign) pointer without page fault.
+		enum : uintptr_t { IntrusivePageSize = 4096 };
+		static_assert(IntrusiveHeaderSize * 2 < IntrusivePageSize, "Header size too big");
+
+		constexpr uintptr_t IntrusiveCookieActive = static_cast<uintptr_t>(0x5a17c0de3e4b9d61ULL);
+		constexpr uintptr_t IntrusiveCookieDetached = static_cast<uintptr_t>(0x1d3ad0b5c62f8e47ULL);
+
+		// IntrusiveHeaderIfMatch reads header of any pointer, including stack
+		// and static objects. The read is out of bounds of such objects and
+		// could race with neighbouring object, but never faults and mismatched
+		// cookie is ignored. The probe is excluded from address, thread
+		// sanitizers, and it should not be inlined into instrumented code.
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define DKGL_INTRUSIVE_PROBE_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define DKGL_INTRUSIVE_PROBE_SANITIZED 1
+#endif
+#endif
+
+#if DKGL_INTRUSIVE_PROBE_SANITIZED
+#ifdef _MSC_VER
+#define DKGL_INTRUSIVE_PROBE NOINLINE __declspec(no_sanitize_address)
+#else
+#define DKGL_INTRUSIVE_PROBE NOINLINE __attribute__((no_sanitize_address, no_sanitize_thread))
+#endif
+#else
+#define DKGL_INTRUSIVE_PROBE FORCEINLINE
+#endif
+
+		DKGL_INTRUSIVE_PROBE IntrusiveHeader* IntrusiveHeaderIfMatch(void* p, uintptr_t magic)
+		{
+			uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+			if ((addr % alignof(IntrusiveHeader)) == 0 &&
+				(addr % IntrusivePageSize) >= IntrusiveHeaderSize)
+			{
+				IntrusiveHeader* header = reinterpret_cast<IntrusiveHeader*>(addr - IntrusiveHeaderSize);
+				if (header->cookie.load(std::memory_order_acquire) == (addr ^ magic))
+					return header;
+			}
+			return NULL;
+		}
+		FORCEINLINE IntrusiveHeader* GetIntrusiveHeader(void* p)
+		{
+#if DKGL_INTRUSIVE_REFCOUNT
+			return IntrusiveHeaderIfMatch(p, IntrusiveCookieActive);
+#else
+			(void)p;
+			return NULL;
+#endif
+		}
+
 		struct AllocationNode
 		{
 			struct NodeInfo
@@ -27,6 +119,7 @@ namespace DKFoundation
 				DKAllocator*								allocator;
 				DKObjectRefCounter::RefIdValue				refId;
 				volatile DKObjectRefCounter::RefCountValue	refCount;
+				IntrusiveHeader*							header; // intrusive object with weak-ref
 			};
 			typedef DKSpinLock							Lock;
 			typedef DKCriticalSection<Lock>				CriticalSection;
@@ -100,15 +193,37 @@ namespace DKFoundation
 			}
 			DKObjectRefCounter::RefIdValue GenerateRefId()
 			{
-				// Maintainer will initialize AllocationTable (see DKAllocatorChain.cpp)
-				static DKAllocator::Maintainer init;
-
-				AllocationTable* table = AllocationTable::Instance();
-				DKCriticalSection<DKSpinLock> guard(table->lock);
+				static std::atomic<DKObjectRefCounter::RefIdValue> counter(0);
+				return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+			}
 
-				static DKObjectRefCounter::RefIdValue counter = 0;
-				DKObjectRefCounter::RefIdValue value = ++counter;
-				return value;
+			// remove ref-count state of intrusive object.
+			// if refCount is not NULL, state will be removed only if ref-count is equal to it.
+			bool DetachIntrusiveObject(void* p, IntrusiveHeader* header, const DKObjectRefCounter::RefCountValue* refCount, DKAllocator** alloc)
+			{
+				uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+				uintptr_t active = addr ^ IntrusiveCookieActive;
+				if (header->flags.load(std::memory_order_acquire) & IntrusiveHeader::FlagWeakRef)
+				{
+					// weak-ref could be promoted while we're here.
+					AllocationNode& node = GetAllocationNode(p);
+					AllocationNode::CriticalSection guard(node.lock);
+					if (refCount && header->refCount.load(std::memory_order_acquire) != *refCount)
+						return false;
+					if (!header->cookie.compare_exchange_strong(active, addr ^ IntrusiveCookieDetached, std::memory_order_acq_rel))
+						return false;
+					node.container.Remove(p);
+				}
+				else
+				{
+					if (refCount && header->refCount.load(std::memory_order_acquire) != *refCount)
+						return false;
+					if (!header->cookie.compare_exchange_strong(active, addr ^ IntrusiveCookieDetached, std::memory_order_acq_rel))
+						return false;
+				}
+				if (alloc)
+					*alloc = header->allocator;
+				return true;
 			}
 		}
 
@@ -137,12 +252,15 @@ bool DKObjectRefCounter::SetRefCounter(void* p, DKAllocator* alloc, RefCountValu
 {
 	if (p)
 	{
+		if (GetIntrusiveHeader(p))
+			return false;
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
 		if (pair == NULL)
 		{
-			AllocationNode::NodeInfo nodeInfo = {alloc, GenerateRefId(), c};
+			AllocationNode::NodeInfo nodeInfo = {alloc, GenerateRefId(), c, NULL};
 			node.container.Insert(p, nodeInfo);
 			if (refId)
 				*refId = nodeInfo.refId;
@@ -156,6 +274,9 @@ bool DKObjectRefCounter::UnsetRefCounterIfEqual(void* p, RefCountValue c, DKAllo
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+			return DetachIntrusiveObject(p, header, &c, alloc);
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -179,6 +300,18 @@ bool DKObjectRefCounter::UnsetRefCounter(void* p, RefCountValue* c, DKAllocator*
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+		{
+			RefCountValue refCount = header->refCount.load(std::memory_order_acquire);
+			if (DetachIntrusiveObject(p, header, NULL, alloc))
+			{
+				if (c)
+					*c = refCount;
+				return true;
+			}
+			return false;
+		}
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -204,7 +337,11 @@ bool DKObjectRefCounter::IncrementRefCount(void* p, RefIdValue id)
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
 		if (pair && pair->value.refId == id)
 		{
-			++(pair->value.refCount);
+			// object is alive while node locked. (see DetachIntrusiveObject)
+			if (pair->value.header)
+				pair->value.header->refCount.fetch_add(1, std::memory_order_relaxed);
+			else
+				++(pair->value.refCount);
 			return true;
 		}
 	}
@@ -215,6 +352,12 @@ bool DKObjectRefCounter::IncrementRefCount(void* p)
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+		{
+			header->refCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -231,6 +374,17 @@ bool DKObjectRefCounter::DecrementRefCount(void* p)
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+		{
+			if (header->refCount.fetch_sub(1, std::memory_order_acq_rel) == 0)
+			{
+				header->refCount.fetch_add(1, std::memory_order_relaxed);
+				DKERROR_THROW_DEBUG("Ref-Count already zero!");
+				return false;
+			}
+			return true;
+		}
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -255,6 +409,16 @@ bool DKObjectRefCounter::DecrementRefCountAndUnsetIfEqual(void* p, RefCountValue
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+		{
+			RefCountValue refCount = header->refCount.fetch_sub(1, std::memory_order_acq_rel);
+			DKASSERT_STD_DEBUG(refCount > 0);
+
+			if (refCount - 1 == c)
+				return DetachIntrusiveObject(p, header, &c, alloc);
+			return false;
+		}
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -285,6 +449,13 @@ bool DKObjectRefCounter::RefCount(void* p, RefCountValue* c)
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+		{
+			if (c)
+				*c = header->refCount.load(std::memory_order_acquire);
+			return true;
+		}
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -302,6 +473,26 @@ bool DKObjectRefCounter::RefId(void* p, RefIdValue* ref)
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+		{
+			if (ref)
+			{
+				// RefId can be used to build weak-ref, register object to table.
+				if ((header->flags.load(std::memory_order_acquire) & IntrusiveHeader::FlagWeakRef) == 0)
+				{
+					AllocationNode& node = GetAllocationNode(p);
+					AllocationNode::CriticalSection guard(node.lock);
+					if (GetIntrusiveHeader(p) != header)
+						return false;
+					AllocationNode::NodeInfo nodeInfo = {header->allocator, header->refId, 0, header};
+					node.container.Update(p, nodeInfo);
+					header->flags.fetch_or(IntrusiveHeader::FlagWeakRef, std::memory_order_acq_rel);
+				}
+				*ref = header->refId;
+			}
+			return true;
+		}
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -319,6 +510,9 @@ DKMemoryLocation DKObjectRefCounter::Location(void* p)
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+			return header->allocator->Location();
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -334,6 +528,9 @@ DKAllocator* DKObjectRefCounter::Allocator(void* p)
 {
 	if (p)
 	{
+		if (IntrusiveHeader* header = GetIntrusiveHeader(p))
+			return header->allocator;
+
 		AllocationNode& node = GetAllocationNode(p);
 		AllocationNode::CriticalSection guard(node.lock);
 		AllocationNode::Container::Pair* pair = node.container.Find(p);
@@ -345,6 +542,80 @@ DKAllocator* DKObjectRefCounter::Allocator(void* p)
 	return NULL;	
 }
 
+void* DKObjectRefCounter::AllocateObject(DKAllocator* alloc, size_t s)
+{
+	DKASSERT_STD_DEBUG(alloc != NULL);
+#if DKGL_INTRUSIVE_REFCOUNT
+	size_t allocSize = s + IntrusiveHeaderSize;
+	void* block = alloc->Alloc(allocSize);
+	if (block == NULL)
+		return NULL;
+	uintptr_t addr = reinterpret_cast<uintptr_t>(block) + IntrusiveHeaderSize;
+	if ((addr % IntrusivePageSize) < IntrusiveHeaderSize)
+	{
+		// object should not be placed in front of page.
+		// allocate again with extra space and move object forward.
+		alloc->Dealloc(block);
+		allocSize += IntrusiveHeaderSize;
+		block = alloc->Alloc(allocSize);
+		if (block == NULL)
+			return NULL;
+		addr = reinterpret_cast<uintptr_t>(block) + IntrusiveHeaderSize;
+		if ((addr % IntrusivePageSize) < IntrusiveHeaderSize)
+			addr += IntrusiveHeaderSize;
+	}
+	IntrusiveHeader* header = new(reinterpret_cast<void*>(addr - IntrusiveHeaderSize)) IntrusiveHeader;
+	header->refCount.store(0, std::memory_order_relaxed);
+	header->flags.store(0, std::memory_order_relaxed);
+	header->refId = GenerateRefId();
+	header->allocator = alloc;
+	header->block = block;
+	header->cookie.store(addr ^ IntrusiveCookieActive, std::memory_order_release);
+	if (IsTrackingAllocator(alloc))
+		TrackAllocation(block, allocSize, DKMemoryLocationCustom);
+	return reinterpret_cast<void*>(addr);
+#else
+	void* p = alloc->Alloc(s);
+	if (p)
+	{
+		[[maybe_unused]] bool b = SetRefCounter(p, alloc, 0, NULL);
+		DKASSERT_STD_DESC_DEBUG(b, "DKObjectRefCounter failed.");
+		if (IsTrackingAllocator(alloc))
+			TrackAllocation(p, s, DKMemoryLocationCustom);
+	}
+	return p;
+#endif
+}
+
+void DKObjectRefCounter::DeallocateObject(void* p, DKAllocator* alloc)
+{
+	DKASSERT_STD_DEBUG(alloc != NULL);
+#if DKGL_INTRUSIVE_REFCOUNT
+	if (IntrusiveHeader* header = IntrusiveHeaderIfMatch(p, IntrusiveCookieDetached))
+	{
+		DKASSERT_MEM_DESC_DEBUG(header->allocator == alloc, "Wrong allocator object.");
+		void* block = header->block;
+		header->cookie.store(0, std::memory_order_relaxed);
+		header->~IntrusiveHeader();
+		if (IsTrackingAllocator(alloc))
+			TrackDeallocation(block);
+		alloc->Dealloc(block);
+		return;
+	}
+	DKASSERT_MEM_DESC_DEBUG(GetIntrusiveHeader(p) == NULL, "Object is still ref-counted!");
+#endif
+	if (IsTrackingAllocator(alloc))
+		TrackDeallocation(p);
+	alloc->Dealloc(p);
+}
+
+bool DKObjectRefCounter::IsIntrusive(void* p)
+{
+	if (p)
+		return GetIntrusiveHeader(p) != NULL;
+	return false;
+}
+
 size_t DKObjectRefCounter::TableSize()
 {
 	return Private::AllocatorTableLength;	
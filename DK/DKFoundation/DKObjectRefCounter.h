@@ -10,6 +10,19 @@
 #include "DKMemory.h"
 #include "DKAllocator.h"
 
+/// Define DKGL_INTRUSIVE_REFCOUNT to store ref-count state of objects
+/// allocated by DKAllocator (operator new with DKAllocator) in a header
+/// placed in front of the object. Ref-count state of these objects will be
+/// updated with single atomic operation, without global table lookup.
+/// Objects which are not allocated by DKAllocator (foreign pointers) are
+/// still tracked by global table.
+/// @note
+///  This should be defined while building DK library only.
+///  DKObject behaves the same regardless of this option.
+#ifndef DKGL_INTRUSIVE_REFCOUNT
+#define DKGL_INTRUSIVE_REFCOUNT 0
+#endif
+
 namespace DKFoundation
 {
 	/// object ref-counter, weak-ref management.
@@ -56,6 +69,19 @@ namespace DKFoundation
 		/// return allocator if object has one.
 		static DKAllocator* Allocator(void*);
 
+		/// allocate memory for object with allocator and begin ref-count state.
+		/// if DKGL_INTRUSIVE_REFCOUNT enabled, ref-count state is stored in
+		/// object header, otherwise global table will be used.
+		static void* AllocateObject(DKAllocator*, size_t);
+		/// release memory of object allocated by AllocateObject.
+		/// ref-count state should be removed before calling this function.
+		/// (by UnsetRefCounter or DecrementRefCountAndUnset..)
+		/// You can use this function for any object which has been
+		/// allocated by DKAllocator.
+		static void DeallocateObject(void*, DKAllocator*);
+		/// determine whether object has its ref-count state in object header.
+		static bool IsIntrusive(void*);
+
 		static size_t TableSize();	///< functions for debugging.
 		static void TableDump(size_t*);	///< functions for debugging.
 	};
@@ -2,9 +2,11 @@
 //  File: DKOperationQueue.cpp
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2016 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
+#include <new>
+#include <atomic>
 #include "DKObject.h"
 #include "DKOperationQueue.h"
 #include "DKFunction.h"
@@ -12,6 +14,8 @@
 #include "DKTimer.h"
 #include "DKCondition.h"
 #include "DKUtils.h"
+#include "DKMemory.h"
+#include "DKProfiler.h"
 
 namespace DKFoundation
 {
@@ -23,36 +27,159 @@ namespace DKFoundation
 		FORCEINLINE void PerformOperationInsidePool(DKOperation* op) { op->Perform(); }
 #endif
 
-		static DKCondition operationStateCond;
 		struct OperationSyncState : public DKOperationQueue::OperationSync
 		{
 			State state;
+			DKCondition cond;
 
 			OperationSyncState() : state(StateUnknown)
 			{
 			}
 			bool Sync()
 			{
-				DKCriticalSection<DKCondition> guard(operationStateCond);
-				while (state == State::StatePending)
-					operationStateCond.Wait();
+				DKCriticalSection<DKCondition> guard(cond);
+				while (state == State::StatePending || state == State::StateExecuting)
+					cond.Wait();
 
 				return state == State::StateProcessed;
 			}
 			bool Cancel()
 			{
-				DKCriticalSection<DKCondition> guard(operationStateCond);
+				DKCriticalSection<DKCondition> guard(cond);
 				if (state == State::StatePending)
 				{
 					state = State::StateCancelled;
+					cond.Broadcast();
 					return true;
 				}
 				return false;
 			}
 			State OperationState()
 			{
+				DKCriticalSection<DKCondition> guard(cond);
 				return state;
 			}
+			/// switch state to Executing, returns false if operation was cancelled.
+			bool Begin()
+			{
+				DKCriticalSection<DKCondition> guard(cond);
+				if (state == State::StatePending)
+				{
+					state = State::StateExecuting;
+					return true;
+				}
+				return false;
+			}
+			void End(State s)
+			{
+				DKCriticalSection<DKCondition> guard(cond);
+				state = s;
+				cond.Broadcast();
+			}
+		};
+
+		/// Chase-Lev work-stealing deque.
+		/// Push, Pop can be called by owner thread only, Steal can be called by any thread.
+		/// see "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al. 2013)
+		template <typename T> class WorkStealingDeque
+		{
+			struct Array
+			{
+				int64_t capacity;
+				Array* retired;		// previous (smaller) array, released with deque.
+				std::atomic<T*>* items;
+
+				std::atomic<T*>& Item(int64_t i) { return items[i & (capacity - 1)]; }
+			};
+		public:
+			WorkStealingDeque(int64_t initialCapacity = 256)
+				: top(0), bottom(0)
+			{
+				array.store(CreateArray(initialCapacity, NULL), std::memory_order_relaxed);
+			}
+			~WorkStealingDeque()
+			{
+				Array* a = array.load(std::memory_order_relaxed);
+				while (a)
+				{
+					Array* r = a->retired;
+					delete[] a->items;
+					delete a;
+					a = r;
+				}
+			}
+			void Push(T* item)
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed);
+				int64_t t = top.load(std::memory_order_acquire);
+				Array* a = array.load(std::memory_order_relaxed);
+				if (b - t > a->capacity - 1)
+				{
+					Array* a2 = CreateArray(a->capacity * 2, a);
+					for (int64_t i = t; i < b; ++i)
+						a2->Item(i).store(a->Item(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+					array.store(a2, std::memory_order_release);
+					a = a2;
+				}
+				a->Item(b).store(item, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			T* Pop()
+			{
+				int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				Array* a = array.load(std::memory_order_relaxed);
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+				T* item = NULL;
+				if (t <= b)
+				{
+					item = a->Item(b).load(std::memory_order_relaxed);
+					if (t == b)	// last item, race with stealers.
+					{
+						if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+							item = NULL;
+						bottom.store(b + 1, std::memory_order_relaxed);
+					}
+				}
+				else
+				{
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+				return item;
+			}
+			/// returns NULL if deque is empty or lost race with other thread.
+			T* Steal()
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t b = bottom.load(std::memory_order_acquire);
+				if (t < b)
+				{
+					Array* a = array.load(std::memory_order_acquire);
+					T* item = a->Item(t).load(std::memory_order_relaxed);
+					if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						return item;
+				}
+				return NULL;
+			}
+			bool IsEmpty() const
+			{
+				return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+			}
+		private:
+			static Array* CreateArray(int64_t capacity, Array* retired)
+			{
+				Array* a = new Array();
+				a->capacity = capacity;
+				a->retired = retired;
+				a->items = new std::atomic<T*>[capacity];
+				return a;
+			}
+			std::atomic<int64_t> top;
+			std::atomic<int64_t> bottom;
+			std::atomic<Array*> array;
 		};
 	}
 }
@@ -60,66 +187,268 @@ namespace DKFoundation
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
+struct DKOperationQueue::Operation
+{
+	DKObject<DKOperation> operation;
+	DKObject<OperationSyncState> sync;
+	DKInlineFunction<void ()> function;	// used if operation is NULL.
+};
+
+struct DKOperationQueue::Worker
+{
+	WorkStealingDeque<Operation> deque;
+	uint32_t seed;		// random victim selection
+	bool running;
+};
+
+struct DKOperationQueue::Scheduler
+{
+	enum { MaxWorkers = 256 };
+	enum { SpinCount = 64 };			// number of retry before parking.
+	enum { MaxInjectionBatch = 32 };	// maximum operations moved from injection queue at once.
+
+	std::atomic<Worker*> workers[MaxWorkers];
+	std::atomic<size_t> numWorkerSlots;
+
+	// global injection queue (operations from non-worker threads)
+	DKQueue<Operation*, DKDummyLock> injectionQueue;
+	DKSpinLock injectionLock;
+
+	std::atomic<size_t> pendingOperations;		// queued operations (not started)
+	std::atomic<size_t> activeOperations;		// operations in process
+	std::atomic<size_t> completedOperations;
+	std::atomic<size_t> sleepingThreads;		// parked threads
+	std::atomic<size_t> completionWaiters;
+	std::atomic<size_t> threadCount;			// available threads count
+	std::atomic<size_t> exitingThreads;			// threads released slot, not terminated yet
+	std::atomic<size_t> maxThreadCount;			// maximum threads count
+	std::atomic<size_t> maxConcurrentOperations;
+
+	DKCondition threadCond;			// thread lifecycle and parking.
+	DKCondition completionCond;		// operation completion (per queue)
+
+	Scheduler()
+		: numWorkerSlots(0)
+		, pendingOperations(0)
+		, activeOperations(0)
+		, completedOperations(0)
+		, sleepingThreads(0)
+		, completionWaiters(0)
+		, threadCount(0)
+		, exitingThreads(0)
+		, maxThreadCount(0)
+		, maxConcurrentOperations(16)
+	{
+		for (std::atomic<Worker*>& w : workers)
+			w.store(NULL, std::memory_order_relaxed);
+	}
+	~Scheduler()
+	{
+		for (std::atomic<Worker*>& w : workers)
+		{
+			Worker* worker = w.load(std::memory_order_relaxed);
+			if (worker)
+				delete worker;
+		}
+	}
+	static Operation* NewOperation(DKOperation* op, OperationSyncState* sync)
+	{
+		return ::new (DKMemoryPoolAllocator::Alloc(sizeof(Operation))) Operation{ op, sync, {} };
+	}
+	static Operation* NewOperation(DKInlineFunction<void ()>&& fn)
+	{
+		return ::new (DKMemoryPoolAllocator::Alloc(sizeof(Operation))) Operation{ NULL, NULL, static_cast<DKInlineFunction<void ()>&&>(fn) };
+	}
+	static void DeleteOperation(Operation* op)
+	{
+		op->~Operation();
+		DKMemoryPoolAllocator::Free(op);
+	}
+	static void CancelOperation(Operation* op)
+	{
+		if (op->sync)
+		{
+			if (op->sync->Begin())
+				op->sync->End(OperationSync::StateCancelled);
+		}
+		DeleteOperation(op);
+	}
+	// wake parked thread if exists.
+	void WakeThread()
+	{
+		if (sleepingThreads.load(std::memory_order_seq_cst) > 0)
+		{
+			threadCond.Lock();
+			threadCond.Signal();
+			threadCond.Unlock();
+		}
+	}
+	void NotifyCompletion()
+	{
+		if (completionWaiters.load(std::memory_order_seq_cst) > 0)
+		{
+			completionCond.Lock();
+			completionCond.Broadcast();
+			completionCond.Unlock();
+		}
+	}
+	// acquire operation for worker (local deque, injection queue, steal)
+	// operation is counted as active when returns.
+	Operation* Acquire(Worker* worker)
+	{
+		if (pendingOperations.load(std::memory_order_relaxed) == 0)
+			return NULL;
+
+		Operation* op = worker->deque.Pop();
+		if (op == NULL)
+		{
+			injectionLock.Lock();
+			size_t count = injectionQueue.Count();
+			if (injectionQueue.PopFront(op))
+			{
+				// move some operations to local deque, to be stolen by other workers.
+				size_t batch = Min(count / Max(threadCount.load(std::memory_order_relaxed), size_t(1)), size_t(MaxInjectionBatch));
+				Operation* op2;
+				for (size_t i = 1; i < batch && injectionQueue.PopFront(op2); ++i)
+					worker->deque.Push(op2);
+			}
+			injectionLock.Unlock();
+		}
+		if (op == NULL)
+		{
+			size_t numSlots = numWorkerSlots.load(std::memory_order_acquire);
+			worker->seed = worker->seed * 1103515245 + 12345;
+			size_t start = (worker->seed >> 16) % Max(numSlots, size_t(1));
+			for (size_t i = 0; i < numSlots && op == NULL; ++i)
+			{
+				Worker* victim = workers[(start + i) % numSlots].load(std::memory_order_acquire);
+				if (victim && victim != worker)
+					op = victim->deque.Steal();
+			}
+		}
+		if (op)
+		{
+			activeOperations.fetch_add(1, std::memory_order_seq_cst);
+			pendingOperations.fetch_sub(1, std::memory_order_seq_cst);
+		}
+		return op;
+	}
+	// remove all pending operations. (called by non-worker thread)
+	void CancelAll()
+	{
+		size_t cancelled = 0;
+		Operation* op;
+
+		injectionLock.Lock();
+		DKQueue<Operation*, DKDummyLock> queue = static_cast<DKQueue<Operation*, DKDummyLock>&&>(injectionQueue);
+		injectionLock.Unlock();
+		while (queue.PopFront(op))
+		{
+			CancelOperation(op);
+			cancelled++;
+		}
+		size_t numSlots = numWorkerSlots.load(std::memory_order_acquire);
+		for (size_t i = 0; i < numSlots; ++i)
+		{
+			Worker* worker = workers[i].load(std::memory_order_acquire);
+			if (worker)
+			{
+				while (!worker->deque.IsEmpty())
+				{
+					if ((op = worker->deque.Steal()) != NULL)
+					{
+						CancelOperation(op);
+						cancelled++;
+					}
+				}
+			}
+		}
+		pendingOperations.fetch_sub(cancelled, std::memory_order_seq_cst);
+		NotifyCompletion();
+	}
+};
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		// worker of current thread, NULL if current thread is not a worker.
+		static thread_local void* currentWorker = NULL;
+		static thread_local void* currentWorkerScheduler = NULL;
+	}
+}
+
 DKOperationQueue::DKOperationQueue(ThreadFilter* f)
-	: maxConcurrentOperations(16)
-	, threadCount(0)
-	, maxThreadCount(0)
-	, activeThreads(0)
+	: scheduler(new Scheduler())
 	, filter(f)
 {
-	maxConcurrentOperations = Max(2, static_cast<int>(DKNumberOfProcessors()) - 1);
+	scheduler->maxConcurrentOperations = Max(2, static_cast<int>(DKNumberOfProcessors()) - 1);
 }
 
 DKOperationQueue::~DKOperationQueue()
 {
-	threadCond.Lock();
-	maxThreadCount = 0;
-	threadCond.Broadcast();
-	while (threadCount > 0)
-		threadCond.Wait();
+	scheduler->threadCond.Lock();
+	scheduler->maxThreadCount = 0;
+	scheduler->threadCond.Broadcast();
+	while (scheduler->threadCount > 0 || scheduler->exitingThreads > 0)
+		scheduler->threadCond.Wait();
+	scheduler->threadCond.Unlock();
 
-	DKASSERT_DEBUG(activeThreads == 0);
+	DKASSERT_DEBUG(scheduler->activeOperations == 0);
 
-	operationStateCond.Lock();
-	auto cancelOps = [](Operation& op)
-	{
-		OperationSyncState* st = op.sync.StaticCast<OperationSyncState>();
-		if (st && st->state == OperationSync::StatePending)
-			st->state = OperationSync::StateCancelled;
-	};
-	operationQueue.EnumerateForward(cancelOps);
-	operationQueue.Clear();
-
-	operationStateCond.Broadcast();
-	operationStateCond.Unlock();
-	threadCond.Unlock();
+	scheduler->CancelAll();
+	delete scheduler;
 }
 
 void DKOperationQueue::SetMaxConcurrentOperations(size_t maxConcurrent)
 {
-	threadCond.Lock();
-	maxConcurrentOperations = Max(maxConcurrent, 1);
-	threadCond.Unlock();
+	scheduler->threadCond.Lock();
+	scheduler->maxConcurrentOperations = Clamp(maxConcurrent, size_t(1), size_t(Scheduler::MaxWorkers));
+	scheduler->maxThreadCount = scheduler->maxConcurrentOperations.load();
+	scheduler->threadCond.Broadcast();	// let excess threads terminate.
+	scheduler->threadCond.Unlock();
 
 	UpdateThreadPool();
 }
 
 size_t DKOperationQueue::MaxConcurrentOperations() const
 {
-	DKCriticalSection<DKCondition> guard(threadCond);
-	return maxConcurrentOperations;
+	DKCriticalSection<DKCondition> guard(scheduler->threadCond);
+	return scheduler->maxConcurrentOperations;
+}
+
+void DKOperationQueue::Enqueue(Operation* op)
+{
+	// count first, operation can be acquired by worker before Push returns.
+	scheduler->pendingOperations.fetch_add(1, std::memory_order_seq_cst);
+
+	if (currentWorker && currentWorkerScheduler == scheduler)
+	{
+		// posted by worker thread, push to local deque.
+		static_cast<Worker*>(currentWorker)->deque.Push(op);
+	}
+	else
+	{
+		scheduler->injectionLock.Lock();
+		scheduler->injectionQueue.PushBack(op);
+		scheduler->injectionLock.Unlock();
+	}
+	UpdateThreadPool();
 }
 
 void DKOperationQueue::Post(DKOperation* operation)
 {
 	if (operation)
 	{
-		Operation op = {operation, NULL};
-		threadCond.Lock();
-		operationQueue.PushBack(op);
-		threadCond.Broadcast();
-		threadCond.Unlock();
-		UpdateThreadPool();
+		Enqueue(Scheduler::NewOperation(operation, NULL));
+	}
+}
+
+void DKOperationQueue::Post(DKInlineFunction<void ()>&& function)
+{
+	if (function)
+	{
+		Enqueue(Scheduler::NewOperation(static_cast<DKInlineFunction<void ()>&&>(function)));
 	}
 }
 
@@ -129,12 +458,7 @@ DKObject<DKOperationQueue::OperationSync> DKOperationQueue::ProcessAsync(DKOpera
 	{
 		DKObject<OperationSyncState> sync = DKOBJECT_NEW OperationSyncState();
 		sync->state = OperationSync::StatePending;
-		Operation op = {operation, sync.StaticCast<OperationSync>()};
-		threadCond.Lock();
-		operationQueue.PushBack(op);
-		threadCond.Broadcast();
-		threadCond.Unlock();
-		UpdateThreadPool();
+		Enqueue(Scheduler::NewOperation(operation, sync));
 
 		return sync.StaticCast<OperationSync>();
 	}
@@ -151,81 +475,132 @@ bool DKOperationQueue::Process(DKOperation* operation)
 
 void DKOperationQueue::UpdateThreadPool()
 {
-	threadCond.Lock();
-	maxThreadCount = maxConcurrentOperations;
-	while (threadCount < maxThreadCount)
+	// wake parked thread first, spawn new thread if all threads are busy.
+	if (scheduler->sleepingThreads.load(std::memory_order_seq_cst) > 0)
 	{
-		if (operationQueue.Count() > threadCount)
+		scheduler->WakeThread();
+	}
+	else if (scheduler->threadCount.load(std::memory_order_relaxed) < scheduler->maxConcurrentOperations.load(std::memory_order_relaxed) &&
+			 scheduler->pendingOperations.load(std::memory_order_relaxed) > 0)
+	{
+		scheduler->threadCond.Lock();
+		scheduler->maxThreadCount = scheduler->maxConcurrentOperations.load();
+		if (scheduler->threadCount < scheduler->maxThreadCount)
 		{
 			DKObject<DKThread> thread = DKThread::Create(DKFunction(this, &DKOperationQueue::OperationProc)->Invocation());
 			if (thread)
 			{
-				threadCount++;
+				scheduler->threadCount++;
 			}
 		}
-		else
-		{
-			break;
-		}
+		scheduler->threadCond.Unlock();
 	}
-	//size_t numThreads = threadCount;
-	threadCond.Unlock();
-
-	//DKLog("OperationQueue running %u threads (maxConcurrent:%d)\n", (unsigned int)numThreads, maxConcurrentOperations);
 }
 
 void DKOperationQueue::CancelAllOperations()
 {
-	threadCond.Lock();
-
-	operationStateCond.Lock();
-	auto cancelOps = [](Operation& op)
-	{
-		OperationSyncState* st = op.sync.StaticCast<OperationSyncState>();
-		if (st && st->state == OperationSync::StatePending)
-			st->state = OperationSync::StateCancelled;
-	};
-	operationQueue.EnumerateForward(cancelOps);
-	operationQueue.Clear();
-
-	operationStateCond.Broadcast();
-	operationStateCond.Unlock();
-
-	threadCond.Broadcast();
-	threadCond.Unlock();
+	scheduler->CancelAll();
 }
 
 void DKOperationQueue::WaitForCompletion() const
 {
-	DKCriticalSection<DKCondition> guard(threadCond);
-	while (operationQueue.Count() > 0 || activeThreads > 0)
-		threadCond.Wait();
+	DKCriticalSection<DKCondition> guard(scheduler->completionCond);
+	scheduler->completionWaiters.fetch_add(1, std::memory_order_seq_cst);
+	while (scheduler->pendingOperations.load(std::memory_order_seq_cst) > 0 ||
+		   scheduler->activeOperations.load(std::memory_order_seq_cst) > 0)
+		scheduler->completionCond.Wait();
+	scheduler->completionWaiters.fetch_sub(1, std::memory_order_relaxed);
 }
 
 bool DKOperationQueue::WaitForAnyOperation(double timeout) const
 {
 	timeout = Max(timeout, 0.0);
-	DKCriticalSection<DKCondition> guard(threadCond);
-	return threadCond.WaitTimeout(timeout);
+	DKTimer timer;
+	timer.Reset();
 
+	DKCriticalSection<DKCondition> guard(scheduler->completionCond);
+	scheduler->completionWaiters.fetch_add(1, std::memory_order_seq_cst);
+	size_t completed = scheduler->completedOperations.load(std::memory_order_seq_cst);
+	bool result = false;
+	while (true)
+	{
+		if (scheduler->completedOperations.load(std::memory_order_seq_cst) != completed)
+		{
+			result = true;
+			break;
+		}
+		double t = timeout - timer.Elapsed();
+		if (t <= 0.0 || !scheduler->completionCond.WaitTimeout(t))
+			break;
+	}
+	scheduler->completionWaiters.fetch_sub(1, std::memory_order_relaxed);
+	return result;
 }
 
 size_t DKOperationQueue::QueueLength() const
 {
-	DKCriticalSection<DKCondition> guard(threadCond);
-	return operationQueue.Count();
+	return scheduler->pendingOperations.load(std::memory_order_relaxed);
 }
 
 size_t DKOperationQueue::RunningOperations() const
 {
-	DKCriticalSection<DKCondition> guard(threadCond);
-	return activeThreads;
+	return scheduler->activeOperations.load(std::memory_order_relaxed);
 }
 
 size_t DKOperationQueue::RunningThreads() const
 {
-	DKCriticalSection<DKCondition> guard(threadCond);
-	return threadCount;
+	return scheduler->threadCount.load(std::memory_order_relaxed);
+}
+
+void DKOperationQueue::PerformOperation(Operation* op)
+{
+	DKPROFILE_SCOPE("DKOperationQueue::PerformOperation");
+
+	struct Wrapper : public DKOperation
+	{
+		void Perform() const override
+		{
+			if (filter)
+				filter->PerformOperation(op);
+			else
+				op->Perform();
+		}
+		Wrapper(ThreadFilter* f, DKOperation* o) : filter(f), op(o) {}
+		ThreadFilter* filter;
+		DKOperation* op;
+	};
+
+	if (op->sync)
+	{
+		if (op->sync->Begin())
+		{
+			Wrapper wr(filter, op->operation);
+			PerformOperationInsidePool(&wr);
+			op->sync->End(OperationSync::StateProcessed);
+		}
+	}
+	else if (op->operation)
+	{
+		Wrapper wr(filter, op->operation);
+		PerformOperationInsidePool(&wr);
+	}
+	else if (op->function)
+	{
+		struct InlineOperation : public DKOperation
+		{
+			void Perform() const override { function(); }
+			InlineOperation(const DKInlineFunction<void ()>& f) : function(f) {}
+			const DKInlineFunction<void ()>& function;
+		};
+		InlineOperation inlineOp(op->function);
+		Wrapper wr(filter, &inlineOp);
+		PerformOperationInsidePool(&wr);
+	}
+	Scheduler::DeleteOperation(op);
+
+	scheduler->completedOperations.fetch_add(1, std::memory_order_relaxed);
+	scheduler->activeOperations.fetch_sub(1, std::memory_order_seq_cst);
+	scheduler->NotifyCompletion();
 }
 
 void DKOperationQueue::OperationProc()
@@ -235,26 +610,31 @@ void DKOperationQueue::OperationProc()
 	timer.Reset();
 	size_t numOps = 0;
 
-	threadCond.Lock();
-
-	auto PerformOperation = [this](DKOperation* op)
+	// acquire worker slot.
+	Worker* worker = NULL;
+	scheduler->threadCond.Lock();
+	for (size_t i = 0; i < Scheduler::MaxWorkers && worker == NULL; ++i)
 	{
-		struct Wrapper : public DKOperation
+		Worker* w = scheduler->workers[i].load(std::memory_order_relaxed);
+		if (w == NULL)
 		{
-			void Perform() const override
-			{
-				if (filter)
-					filter->PerformOperation(op);
-				else
-					op->Perform();
-			}
-			Wrapper(ThreadFilter* f, DKOperation* o) : filter(f), op(o) {}
-			ThreadFilter* filter;
-			DKOperation* op;
-		};
-		Wrapper wr(filter, op);
-		PerformOperationInsidePool(&wr);
-	};
+			w = new Worker();
+			w->seed = static_cast<uint32_t>(threadId) ^ static_cast<uint32_t>(i);
+			w->running = false;
+			scheduler->workers[i].store(w, std::memory_order_release);
+			scheduler->numWorkerSlots.store(i + 1, std::memory_order_release);
+		}
+		if (!w->running)
+		{
+			w->running = true;
+			worker = w;
+		}
+	}
+	scheduler->threadCond.Unlock();
+	DKASSERT_DEBUG(worker != NULL);
+
+	currentWorker = worker;
+	currentWorkerScheduler = scheduler;
 
 	if (filter)
 		filter->OnThreadInitialized();
@@ -263,66 +643,61 @@ void DKOperationQueue::OperationProc()
 
 	while (true)
 	{
-		DKASSERT_DEBUG(threadCount > 0);
-		if (threadCount > maxThreadCount)
-		{
-			break; // terminate.
-		}
-
-		Operation op = {NULL, NULL};
-		if (operationQueue.PopFront(op))
+		if (scheduler->threadCount.load(std::memory_order_relaxed) > scheduler->maxThreadCount.load(std::memory_order_relaxed))
 		{
-			activeThreads++;
-			threadCond.Unlock();
-
-			OperationSyncState* st = op.sync.StaticCast<OperationSyncState>();
-			if (st)
-			{
-				operationStateCond.Lock();
-				if (st->state == OperationSync::StatePending)
-				{
-					if (op.operation)
-					{
-						st->state = OperationSync::StateExecuting;
-						operationStateCond.Unlock();
-						PerformOperation(op.operation);
-						numOps++;
-						operationStateCond.Lock();
-						st->state = OperationSync::StateProcessed;
-					}
-					else
-					{
-						st->state = OperationSync::StateCancelled;
-					}
-					operationStateCond.Broadcast();
-				}
-				operationStateCond.Unlock();
-			}
-			else if (op.operation)
+			DKCriticalSection<DKCondition> guard(scheduler->threadCond);
+			if (scheduler->threadCount > scheduler->maxThreadCount)
 			{
-				PerformOperation(op.operation);
-				numOps++;
+				// release slot in same section with the check, so that other
+				// threads woken up at once do not terminate together.
+				// move remaining operations to injection queue before
+				// worker slot can be acquired by new thread.
+				scheduler->injectionLock.Lock();
+				for (Operation* op = worker->deque.Pop(); op; op = worker->deque.Pop())
+					scheduler->injectionQueue.PushBack(op);
+				scheduler->injectionLock.Unlock();
+
+				worker->running = false;
+				scheduler->threadCount--;
+				scheduler->exitingThreads++;
+				scheduler->threadCond.Broadcast();
+				break; // terminate.
 			}
+		}
 
-			op.operation = NULL;
-			op.sync = NULL;
-
-			threadCond.Lock();
-			activeThreads--;
-			threadCond.Broadcast();
+		Operation* op = scheduler->Acquire(worker);
+		for (int i = 0; op == NULL && i < Scheduler::SpinCount; ++i)
+		{
+			DKThread::Yield();
+			op = scheduler->Acquire(worker);
 		}
-		else
+		if (op)
 		{
-			threadCond.Wait();
+			PerformOperation(op);
+			numOps++;
+			continue;
 		}
+
+		// park until new operation posted.
+		scheduler->threadCond.Lock();
+		scheduler->sleepingThreads.fetch_add(1, std::memory_order_seq_cst);
+		if (scheduler->pendingOperations.load(std::memory_order_seq_cst) == 0 &&
+			scheduler->threadCount <= scheduler->maxThreadCount)
+			scheduler->threadCond.Wait();
+		scheduler->sleepingThreads.fetch_sub(1, std::memory_order_seq_cst);
+		scheduler->threadCond.Unlock();
 	}
 
+	currentWorker = NULL;
+	currentWorkerScheduler = NULL;
+
 	if (filter)
 		filter->OnThreadTerminate();
 
 	DKLog("DKOperationQueue_Thread:0x%x terminated. (running %f seconds, %lu processed)\n", threadId, timer.Elapsed(), numOps);
 
-	threadCount--;
-	threadCond.Broadcast();
-	threadCond.Unlock();
+	scheduler->threadCond.Lock();
+	scheduler->exitingThreads--;
+	scheduler->threadCond.Broadcast();
+	scheduler->threadCond.Unlock();
 }
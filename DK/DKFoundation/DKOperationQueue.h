@@ -2,13 +2,14 @@
 //  File: DKOperationQueue.h
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2016 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
 #pragma once
 #include "../DKInclude.h"
 #include "DKThread.h"
 #include "DKOperation.h"
+#include "DKInlineFunction.h"
 #include "DKQueue.h"
 #include "DKCondition.h"
 #include "DKSpinLock.h"
@@ -17,6 +18,12 @@ namespace DKFoundation
 {
 	/// Processing operations with multi-threaded.
 	/// This class manages thread pool automatically.
+	///
+	/// Operations are scheduled with work-stealing.
+	/// Each worker thread has its own deque (Chase-Lev), operations posted
+	/// from worker thread are pushed to worker's deque, and other operations
+	/// are pushed to global injection queue. Idle workers steal operations
+	/// from other workers, and park only when no operation is available.
 	class DKGL_API DKOperationQueue
 	{
 	public:
@@ -61,6 +68,8 @@ namespace DKFoundation
 		size_t MaxConcurrentOperations() const;
 
 		void Post(DKOperation* operation);
+		/// post function object without reference counted operation object.
+		void Post(DKInlineFunction<void ()>&& function);
 		DKObject<OperationSync> ProcessAsync(DKOperation* operation);
 		bool Process(DKOperation* operation);	///< wait until done.
 		void CancelAllOperations();			///< cancel all operations.
@@ -72,22 +81,16 @@ namespace DKFoundation
 		size_t RunningThreads() const;		///< Number of active threads.
 
 	private:
-		struct Operation
-		{
-			DKObject<DKOperation> operation;
-			DKObject<OperationSync> sync;
-		};
-		typedef DKQueue<Operation, DKDummyLock> OperationQueue;
-		OperationQueue operationQueue;
-		size_t maxConcurrentOperations;
-		size_t threadCount;			// available threads count
-		size_t maxThreadCount;		// maximum threads count
-		size_t activeThreads;		// working threads count
-		DKCondition threadCond;
+		struct Operation;
+		struct Worker;
+		struct Scheduler;
+		Scheduler* scheduler;	// work-stealing deques, injection queue, counters.
 		DKObject<ThreadFilter> filter;
 
+		void Enqueue(Operation* op);
 		void UpdateThreadPool();
 		void OperationProc();
+		void PerformOperation(Operation* op);
 
 		DKOperationQueue(const DKOperationQueue&);
 		DKOperationQueue& operator = (const DKOperationQueue&) = delete;
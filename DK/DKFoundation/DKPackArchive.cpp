@@ -0,0 +1,512 @@
+//
+//  File: DKPackArchive.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include "DKPackArchive.h"
+#include "DKBuffer.h"
+#include "DKDataStream.h"
+#include "DKFile.h"
+#include "DKFileMap.h"
+#include "DKHash.h"
+#include "DKEndianness.h"
+#include "DKLog.h"
+
+// Archive layout, all values are little-endian.
+//
+//  | Header | entry data (aligned) ... | TOC entries | names (UTF-8) |
+//
+// TOC entries are sorted by (nameHash, name) for binary search.
+// Header.tocHash is XXH64 of TOC entries and names.
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		static const char packArchiveMagic[8] = { 'D', 'K', 'P', 'A', 'C', 'K', 0, 0 };
+		enum : uint32_t
+		{
+			PackArchiveVersion = 1,
+			PackEntryCompressed = 1,
+		};
+
+		struct PackArchiveHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t alignment;
+			uint64_t numEntries;
+			uint64_t tocOffset;
+			uint64_t namesOffset;
+			uint64_t namesSize;
+			uint64_t tocHash;
+		};
+		struct PackArchiveEntry
+		{
+			uint64_t nameHash;
+			uint64_t offset;
+			uint64_t storedSize;
+			uint64_t size;
+			uint64_t contentHash;
+			uint32_t nameOffset;
+			uint32_t nameLength;
+			uint32_t flags;
+			uint32_t reserved;
+		};
+		static_assert(sizeof(PackArchiveHeader) == 56, "Invalid header size");
+		static_assert(sizeof(PackArchiveEntry) == 56, "Invalid entry size");
+
+		FORCEINLINE uint64_t PackNameHash(const void* p, size_t len)
+		{
+			return DKHashXXH64(p, len).digest[0];
+		}
+		FORCEINLINE uint64_t AlignOffset(uint64_t offset, uint64_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+		/// compare (hash, name) of entry.
+		FORCEINLINE int ComparePackEntry(uint64_t hash1, const char* name1, size_t len1,
+										 uint64_t hash2, const char* name2, size_t len2)
+		{
+			if (hash1 != hash2)
+				return hash1 < hash2 ? -1 : 1;
+			int c = memcmp(name1, name2, Min(len1, len2));
+			if (c == 0 && len1 != len2)
+				return len1 < len2 ? -1 : 1;
+			return c;
+		}
+	}
+}
+
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+DKPackArchiver::DKPackArchiver(size_t a)
+	: alignment(Max(a, size_t(1)))
+{
+	DKASSERT_DESC_DEBUG((alignment & (alignment - 1)) == 0, "Alignment must be power of two!");
+}
+
+DKPackArchiver::~DKPackArchiver()
+{
+}
+
+bool DKPackArchiver::Add(const DKString& name, DKData* data)
+{
+	if (name.Length() == 0 || data == NULL || !data->IsReadable())
+		return false;
+
+	Entry entry;
+	const void* p = data->LockShared();
+	entry.originalSize = data->Length();
+	entry.contentHash = DKHashXXH64(p, entry.originalSize).digest[0];
+	data->UnlockShared();
+	entry.data = data;
+	entry.compressed = false;
+
+	entries.Update(name, entry);
+	return true;
+}
+
+bool DKPackArchiver::Add(const DKString& name, DKData* data, const DKCompressor& compressor)
+{
+	if (name.Length() == 0 || data == NULL || !data->IsReadable())
+		return false;
+
+	Entry entry;
+	const void* p = data->LockShared();
+	size_t length = data->Length();
+	entry.originalSize = length;
+	entry.contentHash = DKHashXXH64(p, length).digest[0];
+	DKObject<DKBuffer> compressed = NULL;
+	if (length > 0)
+		compressed = DKBuffer::Compress(compressor, p, length);
+	data->UnlockShared();
+
+	if (compressed && compressed->Length() < length)
+	{
+		entry.data = compressed.SafeCast<DKData>();
+		entry.compressed = true;
+	}
+	else
+	{
+		entry.data = data;
+		entry.compressed = false;
+	}
+	entries.Update(name, entry);
+	return true;
+}
+
+bool DKPackArchiver::Remove(const DKString& name)
+{
+	if (entries.Find(name))
+	{
+		entries.Remove(name);
+		return true;
+	}
+	return false;
+}
+
+size_t DKPackArchiver::NumberOfEntries() const
+{
+	return entries.Count();
+}
+
+size_t DKPackArchiver::Write(DKStream* stream) const
+{
+	if (stream == NULL || !stream->IsWritable())
+		return 0;
+
+	struct SortedEntry
+	{
+		const Entry* entry;
+		DKStringU8 name;
+		uint64_t nameHash;
+	};
+	DKArray<SortedEntry> sorted;
+	sorted.Reserve(entries.Count());
+	entries.EnumerateForward([&sorted](const DKMap<DKString, Entry>::Pair& pair)
+	{
+		SortedEntry se = { &pair.value, DKStringU8(pair.key), 0 };
+		se.nameHash = PackNameHash((const char*)se.name, se.name.Bytes());
+		sorted.Add(se);
+	});
+	sorted.Sort([](const SortedEntry& lhs, const SortedEntry& rhs)
+	{
+		return ComparePackEntry(lhs.nameHash, lhs.name, lhs.name.Bytes(),
+								rhs.nameHash, rhs.name, rhs.name.Bytes()) < 0;
+	});
+
+	// build TOC and names, offsets are determined before writing.
+	const size_t numEntries = sorted.Count();
+	DKArray<uint8_t> toc;
+	toc.Resize(numEntries * sizeof(PackArchiveEntry), 0);
+	PackArchiveEntry* tocEntries = reinterpret_cast<PackArchiveEntry*>((uint8_t*)toc);
+
+	uint64_t offset = AlignOffset(sizeof(PackArchiveHeader), alignment);
+	uint64_t namesSize = 0;
+	for (size_t i = 0; i < numEntries; ++i)
+	{
+		const SortedEntry& se = sorted.Value(i);
+		PackArchiveEntry& te = tocEntries[i];
+		size_t nameLength = se.name.Bytes();
+		if (namesSize + nameLength > 0xffffffffULL)
+		{
+			DKLogE("DKPackArchiver: Too many names!");
+			return 0;
+		}
+		te.nameHash = DKSystemToLittleEndian(se.nameHash);
+		te.offset = DKSystemToLittleEndian(offset);
+		te.storedSize = DKSystemToLittleEndian<uint64_t>(se.entry->data->Length());
+		te.size = DKSystemToLittleEndian(se.entry->originalSize);
+		te.contentHash = DKSystemToLittleEndian(se.entry->contentHash);
+		te.nameOffset = DKSystemToLittleEndian<uint32_t>((uint32_t)namesSize);
+		te.nameLength = DKSystemToLittleEndian<uint32_t>((uint32_t)nameLength);
+		te.flags = DKSystemToLittleEndian<uint32_t>(se.entry->compressed ? uint32_t(PackEntryCompressed) : 0);
+		te.reserved = 0;
+
+		offset = AlignOffset(offset + se.entry->data->Length(), alignment);
+		namesSize += nameLength;
+	}
+	const uint64_t tocOffset = AlignOffset(offset, alignof(PackArchiveEntry));
+	toc.Reserve(toc.Count() + namesSize);
+	for (size_t i = 0; i < numEntries; ++i)
+	{
+		const SortedEntry& se = sorted.Value(i);
+		toc.Add(reinterpret_cast<const uint8_t*>((const char*)se.name), se.name.Bytes());
+	}
+	tocEntries = reinterpret_cast<PackArchiveEntry*>((uint8_t*)toc); // reallocated
+
+	PackArchiveHeader header = {};
+	memcpy(header.magic, packArchiveMagic, sizeof(header.magic));
+	header.version = DKSystemToLittleEndian<uint32_t>(PackArchiveVersion);
+	header.alignment = DKSystemToLittleEndian<uint32_t>((uint32_t)alignment);
+	header.numEntries = DKSystemToLittleEndian<uint64_t>(numEntries);
+	header.tocOffset = DKSystemToLittleEndian(tocOffset);
+	header.namesOffset = DKSystemToLittleEndian<uint64_t>(tocOffset + numEntries * sizeof(PackArchiveEntry));
+	header.namesSize = DKSystemToLittleEndian(namesSize);
+	header.tocHash = DKSystemToLittleEndian(DKHashXXH64((const uint8_t*)toc, toc.Count()).digest[0]);
+
+	// write header, entries, TOC.
+	const uint8_t zero[64] = {};
+	size_t written = 0;
+	auto write = [&](const void* p, size_t s) -> bool
+	{
+		if (s > 0 && stream->Write(p, s) != s)
+			return false;
+		written += s;
+		return true;
+	};
+	auto pad = [&](uint64_t to) -> bool
+	{
+		while (written < to)
+		{
+			if (!write(zero, Min<size_t>(to - written, sizeof(zero))))
+				return false;
+		}
+		return true;
+	};
+
+	bool succeeded = write(&header, sizeof(header));
+	for (size_t i = 0; succeeded && i < numEntries; ++i)
+	{
+		const DKData* data = sorted.Value(i).entry->data;
+		succeeded = pad(DKLittleEndianToSystem(tocEntries[i].offset));
+		if (succeeded)
+		{
+			const void* p = data->LockShared();
+			succeeded = write(p, data->Length());
+			data->UnlockShared();
+		}
+	}
+	succeeded = succeeded && pad(tocOffset) && write((const uint8_t*)toc, toc.Count());
+	if (!succeeded)
+	{
+		DKLogE("DKPackArchiver: Stream write failed.");
+		return 0;
+	}
+	return written;
+}
+
+bool DKPackArchiver::WriteToFile(const DKString& file, bool overwrite) const
+{
+	DKFile::FileInfo info;
+	if (DKFile::GetInfo(file, info) && !overwrite)
+		return false;		// file is exists already.
+
+	DKObject<DKFile> f = DKFile::Create(file, DKFile::ModeOpenNew, DKFile::ModeShareExclusive);
+	if (f)
+		return Write(f) > 0;
+	return false;
+}
+
+DKPackUnarchiver::DKPackUnarchiver()
+	: base(NULL)
+	, length(0)
+	, numEntries(0)
+{
+}
+
+DKPackUnarchiver::~DKPackUnarchiver()
+{
+	if (archive)
+		archive->UnlockShared();
+}
+
+DKObject<DKPackUnarchiver> DKPackUnarchiver::Open(const DKString& file)
+{
+	DKObject<DKFileMap> map = DKFileMap::Open(file, 0, false);
+	if (map)
+	{
+		DKObject<DKPackUnarchiver> pack = Open(map.SafeCast<DKData>());
+		if (pack)
+		{
+			pack->filename = file;
+			return pack;
+		}
+	}
+	return NULL;
+}
+
+DKObject<DKPackUnarchiver> DKPackUnarchiver::Open(DKData* data)
+{
+	if (data == NULL || !data->IsReadable())
+		return NULL;
+
+	// archive is kept locked (and mapped) while opened.
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(data->LockShared());
+	size_t len = data->Length();
+
+	PackArchiveHeader header;
+	if (p == NULL || len < sizeof(header))
+	{
+		data->UnlockShared();
+		return NULL;
+	}
+	memcpy(&header, p, sizeof(header));
+	if (memcmp(header.magic, packArchiveMagic, sizeof(header.magic)) != 0)
+	{
+		data->UnlockShared();	// not a pack archive.
+		return NULL;
+	}
+
+	const char* error = NULL;
+	uint64_t numEntries = DKLittleEndianToSystem(header.numEntries);
+	uint64_t tocOffset = DKLittleEndianToSystem(header.tocOffset);
+	uint64_t namesOffset = DKLittleEndianToSystem(header.namesOffset);
+	uint64_t namesSize = DKLittleEndianToSystem(header.namesSize);
+
+	if (DKLittleEndianToSystem(header.version) != PackArchiveVersion)
+		error = "Unsupported version";
+	else if ((reinterpret_cast<uintptr_t>(p) + tocOffset) % alignof(PackArchiveEntry) != 0)
+		error = "Misaligned table of contents";
+	else if (tocOffset > len || numEntries > (len - tocOffset) / sizeof(PackArchiveEntry) ||
+			 namesOffset != tocOffset + numEntries * sizeof(PackArchiveEntry) ||
+			 namesSize > len - namesOffset)
+		error = "Invalid table of contents";
+	else if (DKHashXXH64(p + tocOffset, namesOffset + namesSize - tocOffset).digest[0] != DKLittleEndianToSystem(header.tocHash))
+		error = "Table of contents hash mismatch";
+
+	if (error)
+	{
+		DKLogE("DKPackUnarchiver: %s.", error);
+		data->UnlockShared();
+		return NULL;
+	}
+
+	DKObject<DKPackUnarchiver> pack = DKOBJECT_NEW DKPackUnarchiver();
+	pack->archive = data;
+	pack->base = p;
+	pack->length = len;
+	pack->numEntries = (size_t)numEntries;
+	return pack;
+}
+
+const PackArchiveEntry* DKPackUnarchiver::TOC(size_t index) const
+{
+	DKASSERT_DEBUG(index < numEntries);
+	const PackArchiveHeader* header = reinterpret_cast<const PackArchiveHeader*>(base);
+	return reinterpret_cast<const PackArchiveEntry*>(base + DKLittleEndianToSystem(header->tocOffset)) + index;
+}
+
+size_t DKPackUnarchiver::NumberOfEntries() const
+{
+	return numEntries;
+}
+
+bool DKPackUnarchiver::GetEntryInfo(size_t index, EntryInfo& info) const
+{
+	if (index < numEntries)
+	{
+		const PackArchiveHeader* header = reinterpret_cast<const PackArchiveHeader*>(base);
+		const PackArchiveEntry* e = TOC(index);
+		uint64_t nameOffset = DKLittleEndianToSystem(e->nameOffset);
+		uint64_t nameLength = DKLittleEndianToSystem(e->nameLength);
+		if (nameOffset + nameLength > DKLittleEndianToSystem(header->namesSize))
+			return false;
+
+		const char* names = reinterpret_cast<const char*>(base + DKLittleEndianToSystem(header->namesOffset));
+		info.name = DKString(DKStringU8(&names[nameOffset], nameLength));
+		info.size = DKLittleEndianToSystem(e->size);
+		info.storedSize = DKLittleEndianToSystem(e->storedSize);
+		info.contentHash = DKLittleEndianToSystem(e->contentHash);
+		info.compressed = (DKLittleEndianToSystem(e->flags) & PackEntryCompressed) != 0;
+		return true;
+	}
+	return false;
+}
+
+size_t DKPackUnarchiver::FindEntry(const DKString& name) const
+{
+	if (numEntries == 0 || name.Length() == 0)
+		return numEntries;
+
+	DKStringU8 key(name);
+	const char* keyName = key;
+	const size_t keyLength = key.Bytes();
+	const uint64_t keyHash = PackNameHash(keyName, keyLength);
+
+	const PackArchiveHeader* header = reinterpret_cast<const PackArchiveHeader*>(base);
+	const char* names = reinterpret_cast<const char*>(base + DKLittleEndianToSystem(header->namesOffset));
+	const uint64_t namesSize = DKLittleEndianToSystem(header->namesSize);
+
+	// lower-bound of (hash, name)
+	size_t begin = 0;
+	size_t count = numEntries;
+	while (count > 0)
+	{
+		size_t mid = count / 2;
+		const PackArchiveEntry* e = TOC(begin + mid);
+		uint64_t nameOffset = DKLittleEndianToSystem(e->nameOffset);
+		uint64_t nameLength = DKLittleEndianToSystem(e->nameLength);
+		if (nameOffset + nameLength > namesSize)
+			return numEntries;	// corrupted
+
+		if (ComparePackEntry(DKLittleEndianToSystem(e->nameHash), &names[nameOffset], nameLength,
+							 keyHash, keyName, keyLength) < 0)
+		{
+			begin += mid + 1;
+			count -= mid + 1;
+		}
+		else
+			count = mid;
+	}
+	if (begin < numEntries)
+	{
+		const PackArchiveEntry* e = TOC(begin);
+		uint64_t nameOffset = DKLittleEndianToSystem(e->nameOffset);
+		uint64_t nameLength = DKLittleEndianToSystem(e->nameLength);
+		if (DKLittleEndianToSystem(e->nameHash) == keyHash &&
+			nameLength == keyLength &&
+			nameOffset + nameLength <= namesSize &&
+			memcmp(&names[nameOffset], keyName, keyLength) == 0)
+			return begin;
+	}
+	return numEntries;
+}
+
+bool DKPackUnarchiver::HasEntry(const DKString& name) const
+{
+	return FindEntry(name) < numEntries;
+}
+
+DKObject<DKData> DKPackUnarchiver::OpenData(const DKString& name) const
+{
+	size_t index = FindEntry(name);
+	if (index < numEntries)
+		return OpenData(index);
+	return NULL;
+}
+
+DKObject<DKData> DKPackUnarchiver::OpenData(size_t index) const
+{
+	if (index < numEntries)
+	{
+		const PackArchiveEntry* e = TOC(index);
+		uint64_t offset = DKLittleEndianToSystem(e->offset);
+		uint64_t storedSize = DKLittleEndianToSystem(e->storedSize);
+		uint64_t size = DKLittleEndianToSystem(e->size);
+		if (offset > length || storedSize > length - offset)
+		{
+			DKLogE("DKPackUnarchiver: Invalid entry (%llu).", (unsigned long long)index);
+			return NULL;
+		}
+		if (DKLittleEndianToSystem(e->flags) & PackEntryCompressed)
+		{
+			DKObject<DKBuffer> buffer = DKBuffer::Decompress(base + offset, storedSize);
+			if (buffer && buffer->Length() == size)
+				return buffer.SafeCast<DKData>();
+			DKLogE("DKPackUnarchiver: Decompression failed (%llu).", (unsigned long long)index);
+			return NULL;
+		}
+		return archive->Slice(offset, storedSize);
+	}
+	return NULL;
+}
+
+DKObject<DKStream> DKPackUnarchiver::OpenStream(const DKString& name) const
+{
+	DKObject<DKData> data = OpenData(name);
+	if (data)
+	{
+		DKObject<DKDataStream> stream = DKOBJECT_NEW DKDataStream(data);
+		return stream.SafeCast<DKStream>();
+	}
+	return NULL;
+}
+
+bool DKPackUnarchiver::Verify(size_t index) const
+{
+	DKObject<DKData> data = OpenData(index);
+	if (data)
+	{
+		const void* p = data->LockShared();
+		uint64_t hash = DKHashXXH64(p, data->Length()).digest[0];
+		data->UnlockShared();
+		return hash == DKLittleEndianToSystem(TOC(index)->contentHash);
+	}
+	return false;
+}
@@ -0,0 +1,139 @@
+//
+//  File: DKPackArchive.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKObject.h"
+#include "DKString.h"
+#include "DKData.h"
+#include "DKStream.h"
+#include "DKArray.h"
+#include "DKMap.h"
+#include "DKCompressor.h"
+
+namespace DKFoundation
+{
+	namespace Private { struct PackArchiveEntry; }
+	/**
+	 @brief
+	 A packed resource archive writer.
+
+	 Archive contains many entries in single file, to be mapped into memory
+	 at once with DKPackUnarchiver.
+	 - Table of contents is sorted by hash of name, for binary search.
+	 - Entries are aligned, uncompressed entry can be used in place.
+	 - Entry can be compressed with DKCompressor individually.
+	 - Each entry has XXH64 hash of uncompressed content.
+
+	 @code
+	  DKPackArchiver packer;
+	  packer.Add("images/icon.png", pngData);                    // stored
+	  packer.Add("data/table.xml", xmlData, DKCompressor::Zstd); // compressed
+	  packer.WriteToFile("/data/assets.dkpack", true);
+	 @endcode
+
+	 @note
+	  Entry data is retained until written. not thread-safe.
+	  Dictionary of compressor should be registered to decompress entry.
+	  (see DKCompressor::RegisterDictionary)
+	 */
+	class DKGL_API DKPackArchiver
+	{
+	public:
+		enum : size_t
+		{
+			DefaultAlignment = 16,
+		};
+
+		DKPackArchiver(size_t alignment = DefaultAlignment);
+		~DKPackArchiver();
+
+		/// add entry without compression, replaces entry which has same name.
+		bool Add(const DKString& name, DKData* data);
+		/// add entry with compression.
+		/// entry is stored without compression if compressed data is not smaller.
+		bool Add(const DKString& name, DKData* data, const DKCompressor& compressor);
+		bool Remove(const DKString& name);
+		size_t NumberOfEntries() const;
+
+		/// write archive to stream, returns number of bytes written.
+		/// returns zero if failed.
+		size_t Write(DKStream* stream) const;
+		bool WriteToFile(const DKString& file, bool overwrite) const;
+
+	private:
+		struct Entry
+		{
+			DKObject<DKData> data;	///< stored data (compressed or not)
+			uint64_t originalSize;
+			uint64_t contentHash;
+			bool compressed;
+		};
+		DKMap<DKString, Entry> entries;
+		size_t alignment;
+
+		DKPackArchiver(const DKPackArchiver&) = delete;
+		DKPackArchiver& operator = (const DKPackArchiver&) = delete;
+	};
+
+	/**
+	 @brief
+	 A packed resource archive reader. (DKPackArchiver output)
+
+	 Whole archive is mapped into memory with DKFileMap, entries are found
+	 without file-system access. Uncompressed entry is returned as slice of
+	 archive, without copying. (see DKData::Slice)
+	 */
+	class DKGL_API DKPackUnarchiver
+	{
+	public:
+		struct EntryInfo
+		{
+			DKString name;
+			uint64_t size;			///< uncompressed size
+			uint64_t storedSize;	///< size in archive
+			uint64_t contentHash;	///< XXH64 of uncompressed content
+			bool compressed;
+		};
+
+		DKPackUnarchiver();
+		~DKPackUnarchiver();
+
+		/// map archive file.
+		static DKObject<DKPackUnarchiver> Open(const DKString& file);
+		/// open archive from data, data is retained.
+		static DKObject<DKPackUnarchiver> Open(DKData* data);
+
+		size_t NumberOfEntries() const;
+		bool GetEntryInfo(size_t index, EntryInfo& info) const;
+		/// index of entry, returns NumberOfEntries() if not found.
+		size_t FindEntry(const DKString& name) const;
+		bool HasEntry(const DKString& name) const;
+
+		/// content of entry. returns slice of archive for uncompressed entry,
+		/// or decompressed buffer for compressed entry.
+		DKObject<DKData> OpenData(const DKString& name) const;
+		DKObject<DKData> OpenData(size_t index) const;
+		DKObject<DKStream> OpenStream(const DKString& name) const;
+		/// compare content hash of entry.
+		bool Verify(size_t index) const;
+
+		const DKString& GetArchiveName() const		{ return filename; }
+
+	private:
+		const Private::PackArchiveEntry* TOC(size_t index) const;
+
+		DKObject<DKData> archive;	// kept locked while opened.
+		const uint8_t* base;
+		size_t length;
+		size_t numEntries;
+		DKString filename;
+
+		DKPackUnarchiver(const DKPackUnarchiver&) = delete;
+		DKPackUnarchiver& operator = (const DKPackUnarchiver&) = delete;
+	};
+}
@@ -0,0 +1,495 @@
+//
+//  File: DKProfiler.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <mach/mach_time.h>
+#define PROFILE_TICK_MACH 1
+#elif defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILE_TICK_TSC 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define PROFILE_TICK_CNTVCT 1
+#endif
+
+#include "DKProfiler.h"
+#include "DKThread.h"
+#include "DKMutex.h"
+#include "DKCriticalSection.h"
+#include "DKAtomicNumber32.h"
+#include "DKAtomicNumber64.h"
+#include "DKArray.h"
+#include "DKMap.h"
+#include "DKMemory.h"
+#include "DKEndianness.h"
+#include "DKBufferedStream.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		enum { ProfileChunkSize = 0x1000 };
+
+		// zone ticks, cheaper than DKTimer::SystemTick (no system call).
+		// TSC is assumed to be invariant, frequency is calibrated with
+		// system ticks when exported.
+		FORCEINLINE static uint64_t ProfileTick()
+		{
+#if PROFILE_TICK_MACH
+			return mach_absolute_time();
+#elif PROFILE_TICK_TSC
+			return __rdtsc();
+#elif PROFILE_TICK_CNTVCT
+			uint64_t t;
+			__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(t));
+			return t;
+#else
+			return DKTimer::SystemTick();
+#endif
+		}
+
+		struct ProfileChunk
+		{
+			DKProfiler::Zone zones[ProfileChunkSize];
+			ProfileChunk* next;
+		};
+
+		// zones of single thread, written by owner thread only.
+		struct ProfileThreadBuffer
+		{
+			ProfileThreadBuffer(DKThread::ThreadId tid)
+				: threadId(tid), first(NULL), writeChunk(NULL), writeIndex(0), depth(0)
+			{
+			}
+			~ProfileThreadBuffer()
+			{
+				ProfileChunk* chunk = first;
+				while (chunk)
+				{
+					ProfileChunk* next = chunk->next;
+					DKFree(chunk);
+					chunk = next;
+				}
+			}
+
+			const DKThread::ThreadId threadId;
+			DKAtomicNumber32 generation;	// capture of zones
+			DKAtomicNumber64 count;			// published zones
+			DKAtomicNumber32 abandoned;		// thread terminated
+
+			ProfileChunk* first;
+			ProfileChunk* writeChunk;
+			size_t writeIndex;
+			uint32_t depth;
+		};
+
+		// constant initialized, used by zones recorded before or after static objects alive.
+		static DKAtomicNumber32 profilerRunning = 0;
+		static DKAtomicNumber32 profilerGeneration = 0;
+		static DKAtomicNumber64 profilerMaxZones = 0;
+		static DKAtomicNumber64 profilerDroppedZones = 0;
+
+		struct ProfilerContext
+		{
+			DKMutex lock;	// buffers, export
+			DKArray<ProfileThreadBuffer*> buffers;
+			uint64_t startTick = 0;			// ProfileTick of Start()
+			DKTimer::Tick startSystemTick = 0;
+
+			~ProfilerContext()
+			{
+				// buffers of running threads could be used.
+				for (ProfileThreadBuffer* buffer : buffers)
+				{
+					if (buffer->abandoned.Load())
+						delete buffer;
+				}
+			}
+			// buffers of current capture, should be called with lock.
+			DKArray<ProfileThreadBuffer*> CapturedBuffersNL()
+			{
+				DKArray<ProfileThreadBuffer*> result;
+				DKAtomicNumber32::Value gen = profilerGeneration.Load();
+				for (ProfileThreadBuffer* buffer : buffers)
+				{
+					if (buffer->generation.LoadAcquire() == gen && buffer->count.LoadAcquire() > 0)
+						result.Add(buffer);
+				}
+				return result;
+			}
+			// frequency of ProfileTick, should be called with lock.
+			uint64_t TickFrequencyNL() const
+			{
+#if PROFILE_TICK_MACH
+				return DKTimer::SystemTickFrequency();
+#elif PROFILE_TICK_TSC
+				// measure TSC rate against system ticks since Start().
+				const DKTimer::Tick systemFreq = DKTimer::SystemTickFrequency();
+				DKTimer::Tick minElapsed = systemFreq / 100;	// 10ms
+				DKTimer::Tick elapsed = DKTimer::SystemTick() - startSystemTick;
+				if (elapsed < minElapsed)
+				{
+					DKThread::Sleep(static_cast<double>(minElapsed - elapsed) / static_cast<double>(systemFreq));
+					elapsed = DKTimer::SystemTick() - startSystemTick;
+				}
+				uint64_t ticks = ProfileTick() - startTick;
+				return static_cast<uint64_t>(static_cast<double>(ticks) * static_cast<double>(systemFreq) / static_cast<double>(elapsed));
+#elif PROFILE_TICK_CNTVCT
+				uint64_t freq;
+				__asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+				return freq;
+#else
+				return DKTimer::SystemTickFrequency();
+#endif
+			}
+		};
+		static ProfilerContext& Profiler()
+		{
+			static ProfilerContext context;
+			return context;
+		}
+
+		static thread_local ProfileThreadBuffer* currentProfileBuffer = NULL;
+		static thread_local bool profileBufferReleased = false;
+		struct ProfileBufferHolder
+		{
+			~ProfileBufferHolder()
+			{
+				ProfileThreadBuffer* buffer = currentProfileBuffer;
+				profileBufferReleased = true;
+				currentProfileBuffer = NULL;
+				if (buffer)
+					buffer->abandoned.Store(1);
+			}
+		};
+		static thread_local ProfileBufferHolder profileBufferHolder;
+
+		static ProfileThreadBuffer* CurrentProfileBuffer()
+		{
+			if (currentProfileBuffer == NULL && !profileBufferReleased)
+			{
+				ProfileBufferHolder& holder = profileBufferHolder; // register destructor
+				(void)holder;
+
+				ProfileThreadBuffer* buffer = new ProfileThreadBuffer(DKThread::CurrentThreadId());
+				ProfilerContext& ctxt = Profiler();
+				DKCriticalSection<DKMutex> guard(ctxt.lock);
+				ctxt.buffers.Add(buffer);
+				currentProfileBuffer = buffer;
+			}
+			return currentProfileBuffer;
+		}
+
+		// iterate zones [0, count) of buffer.
+		template <typename Fn> static void EnumerateZones(const ProfileThreadBuffer* buffer, uint64_t count, Fn&& fn)
+		{
+			const ProfileChunk* chunk = buffer->first;
+			for (uint64_t i = 0; i < count && chunk; chunk = chunk->next)
+			{
+				for (size_t k = 0; k < ProfileChunkSize && i < count; ++k, ++i)
+					fn(chunk->zones[k]);
+			}
+		}
+
+		struct ProfileStreamWriter
+		{
+			DKBufferedStream stream;
+			bool failed;
+
+			ProfileStreamWriter(DKStream* s) : stream(s), failed(false) {}
+			void Write(const void* p, size_t s)
+			{
+				if (!failed && stream.Write(p, s) != s)
+					failed = true;
+			}
+			template <typename T> void WriteLE(T value)
+			{
+				value = DKSystemToLittleEndian(value);
+				Write(&value, sizeof(T));
+			}
+			void Print(const char* fmt, ...)
+			{
+				char buff[256];
+				va_list ap;
+				va_start(ap, fmt);
+				int len = vsnprintf(buff, sizeof(buff), fmt, ap);
+				va_end(ap);
+				if (len > 0)
+					Write(buff, Min(size_t(len), sizeof(buff) - 1));
+			}
+			void PrintJSONString(const char* str)
+			{
+				Write("\"", 1);
+				const char* begin = str;
+				for (const char* p = str; *p; ++p)
+				{
+					unsigned char c = static_cast<unsigned char>(*p);
+					if (c == '"' || c == '\\' || c < 0x20)
+					{
+						Write(begin, p - begin);
+						if (c == '"' || c == '\\')
+						{
+							char esc[2] = { '\\', static_cast<char>(c) };
+							Write(esc, 2);
+						}
+						else
+						{
+							Print("\\u%04x", c);
+						}
+						begin = p + 1;
+					}
+				}
+				Write(begin, strlen(begin));
+				Write("\"", 1);
+			}
+			bool Finish()
+			{
+				if (!stream.Flush())
+					failed = true;
+				return !failed;
+			}
+		};
+	}
+}
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+void DKProfiler::Start(size_t maxZonesPerThread)
+{
+	ProfilerContext& ctxt = Profiler();
+	DKCriticalSection<DKMutex> guard(ctxt.lock);
+
+	// remove buffers of terminated threads.
+	for (size_t i = 0; i < ctxt.buffers.Count(); )
+	{
+		ProfileThreadBuffer* buffer = ctxt.buffers.Value(i);
+		if (buffer->abandoned.Load())
+		{
+			delete buffer;
+			ctxt.buffers.Remove(i);
+		}
+		else
+			++i;
+	}
+	ctxt.startSystemTick = DKTimer::SystemTick();
+	ctxt.startTick = ProfileTick();
+
+	// buffers will be reset by owner threads.
+	profilerGeneration.Increment();
+	profilerMaxZones.Store(maxZonesPerThread);
+	profilerDroppedZones.Store(0);
+	profilerRunning.StoreRelease(1);
+}
+
+void DKProfiler::Stop()
+{
+	profilerRunning.StoreRelease(0);
+}
+
+bool DKProfiler::IsRunning()
+{
+	return profilerRunning.LoadAcquire() != 0;
+}
+
+size_t DKProfiler::NumberOfZones()
+{
+	ProfilerContext& ctxt = Profiler();
+	DKCriticalSection<DKMutex> guard(ctxt.lock);
+
+	size_t num = 0;
+	for (ProfileThreadBuffer* buffer : ctxt.CapturedBuffersNL())
+		num += buffer->count.LoadAcquire();
+	return num;
+}
+
+size_t DKProfiler::NumberOfDroppedZones()
+{
+	return profilerDroppedZones.Load();
+}
+
+DKTimer::Tick DKProfiler::BeginZone()
+{
+	if (profilerRunning.LoadRelaxed() == 0)
+		return 0;
+
+	ProfileThreadBuffer* buffer = CurrentProfileBuffer();
+	if (buffer == NULL)
+		return 0;
+	buffer->depth++;
+	return ProfileTick();
+}
+
+void DKProfiler::EndZone(const char* name, DKTimer::Tick begin)
+{
+	if (begin == 0)
+		return;
+
+	DKTimer::Tick end = ProfileTick();
+	ProfileThreadBuffer* buffer = currentProfileBuffer;
+	if (buffer == NULL)
+		return;
+	DKASSERT_DEBUG(buffer->depth > 0);
+	uint32_t depth = --(buffer->depth);
+
+	if (profilerRunning.LoadRelaxed() == 0)
+		return;
+
+	DKAtomicNumber32::Value gen = profilerGeneration.LoadRelaxed();
+	if (buffer->generation.LoadRelaxed() != gen)
+	{
+		// new capture started, reuse chunks.
+		buffer->count.StoreRelease(0);
+		buffer->generation.StoreRelease(gen);
+		buffer->writeChunk = buffer->first;
+		buffer->writeIndex = 0;
+	}
+	uint64_t count = buffer->count.LoadRelaxed();
+	if (count >= static_cast<uint64_t>(profilerMaxZones.LoadRelaxed()))
+	{
+		profilerDroppedZones.IncrementRelaxed();
+		return;
+	}
+	if (buffer->writeChunk == NULL || buffer->writeIndex == ProfileChunkSize)
+	{
+		ProfileChunk* next = buffer->writeChunk ? buffer->writeChunk->next : buffer->first;
+		if (next == NULL)
+		{
+			next = reinterpret_cast<ProfileChunk*>(DKMalloc(sizeof(ProfileChunk)));
+			if (next == NULL)
+			{
+				profilerDroppedZones.IncrementRelaxed();
+				return;
+			}
+			next->next = NULL;
+			if (buffer->writeChunk)
+				buffer->writeChunk->next = next;
+			else
+				buffer->first = next;
+		}
+		buffer->writeChunk = next;
+		buffer->writeIndex = 0;
+	}
+	Zone& zone = buffer->writeChunk->zones[buffer->writeIndex++];
+	zone.name = name;
+	zone.depth = depth;
+	zone.begin = begin;
+	zone.end = end;
+	buffer->count.StoreRelease(count + 1);
+}
+
+bool DKProfiler::ExportChromeTrace(DKStream* stream)
+{
+	if (stream == NULL || !stream->IsWritable())
+		return false;
+
+	ProfilerContext& ctxt = Profiler();
+	DKCriticalSection<DKMutex> guard(ctxt.lock);
+
+	DKArray<ProfileThreadBuffer*> buffers = ctxt.CapturedBuffersNL();
+	DKArray<uint64_t> counts;
+	counts.Reserve(buffers.Count());
+	DKTimer::Tick base = 0;
+	for (ProfileThreadBuffer* buffer : buffers)
+	{
+		uint64_t count = buffer->count.LoadAcquire();
+		counts.Add(count);
+		EnumerateZones(buffer, count, [&base](const Zone& zone)
+		{
+			if (base == 0 || zone.begin < base)
+				base = zone.begin;
+		});
+	}
+	const double usPerTick = 1000000.0 / static_cast<double>(ctxt.TickFrequencyNL());
+
+	ProfileStreamWriter writer(stream);
+	writer.Print("{\"traceEvents\":[");
+	const char* separator = "\n";
+	for (size_t i = 0; i < buffers.Count(); ++i)
+	{
+		const ProfileThreadBuffer* buffer = buffers.Value(i);
+		const size_t tid = i + 1;
+		writer.Print("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"Thread 0x%llx\"}}",
+					 separator, tid, static_cast<unsigned long long>(buffer->threadId));
+		separator = ",\n";
+		EnumerateZones(buffer, counts.Value(i), [&](const Zone& zone)
+		{
+			writer.Print(",\n{\"name\":");
+			writer.PrintJSONString(zone.name);
+			writer.Print(",\"cat\":\"DKGL\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+						 tid,
+						 static_cast<double>(zone.begin - base) * usPerTick,
+						 static_cast<double>(zone.end - zone.begin) * usPerTick);
+		});
+	}
+	writer.Print("\n],\"displayTimeUnit\":\"ms\"}\n");
+	return writer.Finish();
+}
+
+bool DKProfiler::ExportCapture(DKStream* stream)
+{
+	if (stream == NULL || !stream->IsWritable())
+		return false;
+
+	ProfilerContext& ctxt = Profiler();
+	DKCriticalSection<DKMutex> guard(ctxt.lock);
+
+	DKArray<ProfileThreadBuffer*> buffers = ctxt.CapturedBuffersNL();
+	DKArray<uint64_t> counts;
+	counts.Reserve(buffers.Count());
+
+	// name table, zone name pointers are unique per string literal.
+	DKMap<const char*, uint32_t> nameIndices;
+	DKArray<const char*> names;
+	for (ProfileThreadBuffer* buffer : buffers)
+	{
+		uint64_t count = buffer->count.LoadAcquire();
+		counts.Add(count);
+		EnumerateZones(buffer, count, [&](const Zone& zone)
+		{
+			if (nameIndices.Find(zone.name) == NULL)
+			{
+				nameIndices.Insert(zone.name, static_cast<uint32_t>(names.Count()));
+				names.Add(zone.name);
+			}
+		});
+	}
+
+	ProfileStreamWriter writer(stream);
+	writer.Write("DKProf\0\0", 8);
+	writer.WriteLE<uint32_t>(1);
+	writer.WriteLE<uint32_t>(static_cast<uint32_t>(names.Count()));
+	writer.WriteLE<uint64_t>(ctxt.TickFrequencyNL());
+	writer.WriteLE<uint32_t>(static_cast<uint32_t>(buffers.Count()));
+	writer.WriteLE<uint32_t>(0);
+	for (const char* name : names)
+	{
+		size_t len = strlen(name);
+		writer.WriteLE<uint32_t>(static_cast<uint32_t>(len));
+		writer.Write(name, len);
+	}
+	for (size_t i = 0; i < buffers.Count(); ++i)
+	{
+		const ProfileThreadBuffer* buffer = buffers.Value(i);
+		writer.WriteLE<uint64_t>(buffer->threadId);
+		writer.WriteLE<uint64_t>(counts.Value(i));
+		EnumerateZones(buffer, counts.Value(i), [&](const Zone& zone)
+		{
+			writer.WriteLE<uint32_t>(nameIndices.Find(zone.name)->value);
+			writer.WriteLE<uint32_t>(zone.depth);
+			writer.WriteLE<uint64_t>(zone.begin);
+			writer.WriteLE<uint64_t>(zone.end);
+		});
+	}
+	return writer.Finish();
+}
@@ -0,0 +1,107 @@
+//
+//  File: DKProfiler.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKTimer.h"
+#include "DKStream.h"
+
+namespace DKFoundation
+{
+	/**
+	 @brief
+	 Low-overhead zone profiler.
+
+	 A zone is a named scope measured with CPU counter ticks (TSC on x86,
+	 mach_absolute_time on Apple, DKTimer ticks on others), which are cheaper
+	 than DKTimer. Counter frequency is calibrated with DKTimer when exported.
+	 Zones are recorded into buffers of each thread without locking, and can
+	 be exported as Chrome trace JSON (chrome://tracing, Perfetto) or as
+	 compact binary capture.
+
+	 Zones are instrumented with DKPROFILE_SCOPE macro, which is compiled
+	 only if DKGL_PROFILER_ENABLED is defined. Otherwise the macro expands to
+	 nothing. DKOperationQueue, DKEventLoop operations, DKResourcePool loading,
+	 DKCompressor and DKScene updates are instrumented with same macro.
+
+	 @code
+	  void Game::Update()
+	  {
+	      DKPROFILE_SCOPE("Game::Update");
+	      ...
+	  }
+
+	  DKProfiler::Start();
+	  ...
+	  DKProfiler::Stop();
+	  DKObject<DKFile> file = DKFile::Create(L"trace.json", DKFile::ModeOpenNew, DKFile::ModeShareExclusive);
+	  DKProfiler::ExportChromeTrace(file);
+	 @endcode
+
+	 @note
+	  Zone name should be string literal, only the pointer is recorded.
+	  Start() discards previous capture.
+	  Zones exceeding maxZonesPerThread are dropped.
+
+	  Binary capture format (little-endian):
+	   header: "DKProf\0\0", uint32 version(1), uint32 numNames,
+	           uint64 tickFrequency, uint32 numThreads, uint32 reserved
+	   names: uint32 length, UTF-8 bytes (numNames times)
+	   threads: uint64 threadId, uint64 numZones, followed by zones:
+	            uint32 nameIndex, uint32 depth, uint64 begin, uint64 end
+	 */
+	class DKGL_API DKProfiler
+	{
+	public:
+		struct Zone
+		{
+			const char* name;
+			uint32_t depth;		///< nesting depth, 0 for outermost zone.
+			DKTimer::Tick begin;	///< profiler ticks, not DKTimer::SystemTick.
+			DKTimer::Tick end;
+		};
+
+		/// begin new capture, previous capture is discarded.
+		static void Start(size_t maxZonesPerThread = 0x100000);
+		static void Stop();
+		static bool IsRunning();
+
+		/// number of zones captured, and zones dropped by buffer limit.
+		static size_t NumberOfZones();
+		static size_t NumberOfDroppedZones();
+
+		static bool ExportChromeTrace(DKStream* stream);
+		static bool ExportCapture(DKStream* stream);
+
+		/// zone recording functions, use DKProfileScope instead.
+		/// BeginZone returns zero if profiler is not running.
+		static DKTimer::Tick BeginZone();
+		static void EndZone(const char* name, DKTimer::Tick begin);
+	};
+
+	/// record zone from construction to destruction.
+	class DKProfileScope
+	{
+	public:
+		FORCEINLINE DKProfileScope(const char* n) : name(n), begin(DKProfiler::BeginZone()) {}
+		FORCEINLINE ~DKProfileScope() { DKProfiler::EndZone(name, begin); }
+	private:
+		const char* name;
+		DKTimer::Tick begin;
+
+		DKProfileScope(const DKProfileScope&) = delete;
+		DKProfileScope& operator = (const DKProfileScope&) = delete;
+	};
+}
+
+#ifdef DKGL_PROFILER_ENABLED
+#define DKPROFILE_SCOPE_NAME2(line)		dkProfileScope_ ## line
+#define DKPROFILE_SCOPE_NAME(line)		DKPROFILE_SCOPE_NAME2(line)
+#define DKPROFILE_SCOPE(name)			DKFoundation::DKProfileScope DKPROFILE_SCOPE_NAME(__LINE__)(name)
+#else
+#define DKPROFILE_SCOPE(name)
+#endif
@@ -1,49 +1,207 @@
 //
-//  File: DKSpinLock.h
+//  File: DKSpinLock.cpp
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2016 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
+#ifdef _WIN32
+#include <windows.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")	// WaitOnAddress
+#endif
+#elif defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include "DKSpinLock.h"
 #include "DKThread.h"
+#include "DKTimer.h"
+#include "DKUtils.h"
 
 namespace DKFoundation
 {
 	namespace Private
 	{
-		enum SpinLockState
+		enum : uint32_t
 		{
-			SpinLockStateFree = 0,
-			SpinLockStateLocked = 1,
+			SpinLockMaxSpins = 1024,	// pause count before parking
+			SpinLockMaxBackoff = 64,	// pause count per spin
 		};
+
+		FORCEINLINE void SpinLockPause()
+		{
+#if defined(_MSC_VER)
+			YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+			_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+			__asm__ __volatile__("yield");
+#else
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+		}
+
+		// spinning is useless on single processor system.
+		static bool SpinLockCanSpin()
+		{
+			static const bool multiProcessor = DKNumberOfProcessors() > 1;
+			return multiProcessor;
+		}
+
+		// park current thread while value at addr is equal to 'value'.
+		// can return spuriously.
+		static void SpinLockPark(std::atomic<uint32_t>* addr, uint32_t value)
+		{
+#if defined(_WIN32)
+			::WaitOnAddress(addr, &value, sizeof(value), INFINITE);
+#elif defined(__linux__)
+			::syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+			DKThread::Yield();
+#endif
+		}
+		static void SpinLockWake(std::atomic<uint32_t>* addr)
+		{
+#if defined(_WIN32)
+			::WakeByAddressSingle(addr);
+#elif defined(__linux__)
+			::syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+		}
 	}
 }
 
 using namespace DKFoundation;
 using namespace DKFoundation::Private;
 
-DKSpinLock::DKSpinLock()
-	: state(SpinLockStateFree)
+struct DKSpinLock::StatisticsCounter
 {
-}
+	std::atomic<uint64_t> acquisitions;
+	std::atomic<uint64_t> contentions;
+	std::atomic<uint64_t> spins;
+	std::atomic<uint64_t> parks;
+	std::atomic<uint64_t> waitTicks;
+};
 
 DKSpinLock::~DKSpinLock()
 {
+	delete stats.load(std::memory_order_relaxed);
 }
 
-void DKSpinLock::Lock() const
+void DKSpinLock::LockContended() const
 {
-	while (!TryLock())
-		DKThread::Yield();
+	StatisticsCounter* counter = stats.load(std::memory_order_relaxed);
+	DKTimer::Tick startTick = 0;
+	uint64_t spins = 0;
+	uint64_t parks = 0;
+	if (counter)
+		startTick = DKTimer::SystemTick();
+
+	bool acquired = false;
+	if (SpinLockCanSpin())
+	{
+		// spin with exponential backoff, stop spinning if other thread parked already.
+		uint32_t backoff = 1;
+		while (spins < SpinLockMaxSpins)
+		{
+			uint32_t s = state.load(std::memory_order_relaxed);
+			if (s == StateFree)
+			{
+				if (state.compare_exchange_weak(s, StateLocked, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					acquired = true;
+					break;
+				}
+			}
+			else if (s == StateParked)
+				break;
+
+			for (uint32_t i = 0; i < backoff; ++i)
+				SpinLockPause();
+			spins += backoff;
+			backoff = Min(backoff * 2, uint32_t(SpinLockMaxBackoff));
+		}
+	}
+	if (!acquired)
+	{
+		// mark lock as parked. the thread acquires lock in this state
+		// should wake one of parked threads on unlock.
+		while (state.exchange(StateParked, std::memory_order_acquire) != StateFree)
+		{
+			SpinLockPark(&state, StateParked);
+			parks++;
+		}
+	}
+
+	if (counter)
+	{
+		counter->acquisitions.fetch_add(1, std::memory_order_relaxed);
+		counter->contentions.fetch_add(1, std::memory_order_relaxed);
+		counter->spins.fetch_add(spins, std::memory_order_relaxed);
+		counter->parks.fetch_add(parks, std::memory_order_relaxed);
+		counter->waitTicks.fetch_add(DKTimer::SystemTick() - startTick, std::memory_order_relaxed);
+	}
+}
+
+void DKSpinLock::WakeOne() const
+{
+	SpinLockWake(&state);
+}
+
+void DKSpinLock::CountAcquisition() const
+{
+	stats.load(std::memory_order_relaxed)->acquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DKSpinLock::EnableStatistics()
+{
+	if (stats.load(std::memory_order_acquire) == NULL)
+	{
+		StatisticsCounter* counter = new StatisticsCounter();
+		counter->acquisitions = 0;
+		counter->contentions = 0;
+		counter->spins = 0;
+		counter->parks = 0;
+		counter->waitTicks = 0;
+
+		StatisticsCounter* expected = NULL;
+		if (!stats.compare_exchange_strong(expected, counter, std::memory_order_acq_rel))
+			delete counter;
+	}
 }
 
-bool DKSpinLock::TryLock() const
+bool DKSpinLock::GetStatistics(Statistics& st) const
 {
-	return state.CompareAndSet(SpinLockStateFree, SpinLockStateLocked);
+	StatisticsCounter* counter = stats.load(std::memory_order_acquire);
+	if (counter)
+	{
+		st.acquisitions = counter->acquisitions.load(std::memory_order_relaxed);
+		st.contentions = counter->contentions.load(std::memory_order_relaxed);
+		st.spins = counter->spins.load(std::memory_order_relaxed);
+		st.parks = counter->parks.load(std::memory_order_relaxed);
+		st.waitTime = static_cast<double>(counter->waitTicks.load(std::memory_order_relaxed)) /
+			static_cast<double>(DKTimer::SystemTickFrequency());
+		return true;
+	}
+	return false;
 }
 
-void DKSpinLock::Unlock() const
+void DKSpinLock::ResetStatistics()
 {
-	state = SpinLockStateFree;
+	StatisticsCounter* counter = stats.load(std::memory_order_acquire);
+	if (counter)
+	{
+		counter->acquisitions = 0;
+		counter->contentions = 0;
+		counter->spins = 0;
+		counter->parks = 0;
+		counter->waitTicks = 0;
+	}
 }
@@ -2,31 +2,91 @@
 //  File: DKSpinLock.h
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2016 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
 #pragma once
+#include <atomic>
 #include "../DKInclude.h"
-#include "DKAtomicNumber32.h"
 
 namespace DKFoundation
 {
-	/// a busy-waiting locking class.
-	/// atomic variable used internally.
+	/// @brief an adaptive spin-then-park locking class.
 	/// use this class for short period locking.
 	/// (such as small computation, without I/O.)
+	///
+	/// Uncontended Lock(), Unlock() are inlined single atomic operation.
+	/// On contention, the lock spins for a while with CPU pause instruction
+	/// and exponential backoff, and then parks thread until lock is released.
+	/// (futex on Linux/Android, WaitOnAddress on Windows, yield on others)
+	///
+	/// Contention statistics can be enabled per lock instance with
+	/// EnableStatistics(), counters are kept until lock being destroyed.
 	class DKGL_API DKSpinLock
 	{
 	public:
-		DKSpinLock();
+		/// lock contention counters.
+		struct Statistics
+		{
+			uint64_t acquisitions;	///< number of successful Lock(), TryLock()
+			uint64_t contentions;	///< number of Lock() which could not acquire immediately
+			uint64_t spins;			///< total number of spin iterations (pause)
+			uint64_t parks;			///< number of thread parking
+			double waitTime;		///< total waiting time of contended Lock() in seconds
+		};
+
+		constexpr DKSpinLock() : state(0), stats(NULL) {}
 		~DKSpinLock();
-		void Lock() const;
-		bool TryLock() const;
-		void Unlock() const;
+
+		FORCEINLINE void Lock() const
+		{
+			uint32_t expected = StateFree;
+			if (!state.compare_exchange_weak(expected, StateLocked, std::memory_order_acquire, std::memory_order_relaxed))
+				LockContended();
+			else if (stats.load(std::memory_order_relaxed))
+				CountAcquisition();
+		}
+		FORCEINLINE bool TryLock() const
+		{
+			uint32_t expected = StateFree;
+			if (state.load(std::memory_order_relaxed) == StateFree &&
+				state.compare_exchange_strong(expected, StateLocked, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				if (stats.load(std::memory_order_relaxed))
+					CountAcquisition();
+				return true;
+			}
+			return false;
+		}
+		FORCEINLINE void Unlock() const
+		{
+			if (state.exchange(StateFree, std::memory_order_release) == StateParked)
+				WakeOne();
+		}
+
+		/// enable contention statistics of this lock. (cannot be disabled)
+		void EnableStatistics();
+		/// retrieve contention statistics, returns false if not enabled.
+		bool GetStatistics(Statistics&) const;
+		/// reset contention counters to zero.
+		void ResetStatistics();
 
 	private:
+		enum : uint32_t
+		{
+			StateFree = 0,
+			StateLocked = 1,
+			StateParked = 2,	///< locked, and other threads can be parked.
+		};
+		struct StatisticsCounter;
+
+		void LockContended() const;
+		void WakeOne() const;
+		void CountAcquisition() const;
+
 		DKSpinLock(const DKSpinLock&) = delete;
 		DKSpinLock& operator = (const DKSpinLock&) = delete;
-		mutable DKAtomicNumber32 state;
+		mutable std::atomic<uint32_t> state;
+		std::atomic<StatisticsCounter*> stats;
 	};
 }
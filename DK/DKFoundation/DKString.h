@@ -12,6 +12,8 @@
 #include "DKStringW.h"
 #include "DKMap.h"
 #include "DKSet.h"
+#include "DKHashMap.h"
+#include "DKHashSet.h"
 
 namespace DKFoundation
 {
@@ -53,5 +55,20 @@ namespace DKFoundation
 			return lhs.Compare(rhs);
 		}
 	};
-
+	/// Template Spealization for DKString. (for DKHashMap, DKHashSet)
+	template <> struct DKHashKeyHasher<DKStringW>
+	{
+		uint64_t operator () (const DKStringW& str) const
+		{
+			return Private::DKHashString<DKUniCharW>(str);
+		}
+	};
+	/// Template Spealization for DKString. (for DKHashMap, DKHashSet)
+	template <> struct DKHashKeyHasher<DKStringU8>
+	{
+		uint64_t operator () (const DKStringU8& str) const
+		{
+			return Private::DKHashString<DKUniChar8>(str);
+		}
+	};
 }
@@ -0,0 +1,285 @@
+//
+//  File: DKStringStorage.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include <new>
+#include <atomic>
+#include <string.h>
+#include "../DKInclude.h"
+#include "DKMemory.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		/**
+		 @brief
+		 null-terminated character storage for string classes. (DKStringW, DKStringU8)
+
+		 Short string (up to InlineCapacity characters) is stored in object itself,
+		 without memory allocation.
+		 Longer string is stored in reference counted heap buffer, which is shared
+		 between copies. (copy-on-write)
+		 The buffer is copied when modified through MutableData(), Append() while
+		 it is shared with other storage.
+
+		 Storage object does not have pointer to itself, it can be moved by
+		 DKArray with memory reallocation.
+
+		 Layout:
+		   inline: | characters ... | remaining capacity (0: null-terminator) |
+		   shared: | Buffer* | length | ...              | HeapTag              |
+		 */
+		template <typename CharT, size_t StorageSize> class DKStringStorage
+		{
+			struct Buffer
+			{
+				std::atomic<uint32_t> refCount;
+				size_t capacity;	// number of characters, without null-terminator
+
+				CharT* Data()		{ return reinterpret_cast<CharT*>(this + 1); }
+			};
+			struct Shared
+			{
+				Buffer* buffer;
+				size_t length;
+			};
+		public:
+			enum : size_t { InlineCapacity = StorageSize / sizeof(CharT) - 1 };
+
+			DKStringStorage()
+			{
+				SetInlineLength(0);
+			}
+			DKStringStorage(const DKStringStorage& s)
+			{
+				memcpy(this, &s, sizeof(DKStringStorage));
+				if (!IsInline())
+					shared.buffer->refCount.fetch_add(1, std::memory_order_relaxed);
+			}
+			DKStringStorage(DKStringStorage&& s)
+			{
+				memcpy(this, &s, sizeof(DKStringStorage));
+				s.SetInlineLength(0);
+			}
+			~DKStringStorage()
+			{
+				if (!IsInline())
+					ReleaseBuffer(shared.buffer);
+			}
+
+			DKStringStorage& operator = (const DKStringStorage& s)
+			{
+				if (this != &s)
+				{
+					DKStringStorage tmp(s);
+					Swap(tmp);
+				}
+				return *this;
+			}
+			DKStringStorage& operator = (DKStringStorage&& s)
+			{
+				if (this != &s)
+				{
+					DKStringStorage tmp(static_cast<DKStringStorage&&>(s));
+					Swap(tmp);
+				}
+				return *this;
+			}
+
+			FORCEINLINE bool IsInline() const
+			{
+				return chars[InlineCapacity] != HeapTag;
+			}
+			/// true if buffer is shared with other storage.
+			bool IsShared() const
+			{
+				return !IsInline() && shared.buffer->refCount.load(std::memory_order_acquire) > 1;
+			}
+			FORCEINLINE size_t Length() const
+			{
+				if (IsInline())
+					return InlineCapacity - size_t(chars[InlineCapacity]);
+				return shared.length;
+			}
+			/// null-terminated characters, never returns NULL.
+			FORCEINLINE const CharT* Data() const
+			{
+				if (IsInline())
+					return chars;
+				return shared.buffer->Data();
+			}
+			/// writable characters, copy buffer if shared.
+			CharT* MutableData()
+			{
+				if (IsInline())
+					return chars;
+				if (shared.buffer->refCount.load(std::memory_order_acquire) > 1)
+				{
+					Buffer* buffer = NewBuffer(shared.length);
+					memcpy(buffer->Data(), shared.buffer->Data(), (shared.length + 1) * sizeof(CharT));
+					ReleaseBuffer(shared.buffer);
+					shared.buffer = buffer;
+				}
+				return shared.buffer->Data();
+			}
+
+			void Clear()
+			{
+				if (!IsInline())
+					ReleaseBuffer(shared.buffer);
+				SetInlineLength(0);
+			}
+			/// set characters. (str can be part of this storage)
+			void Assign(const CharT* str, size_t len)
+			{
+				if (len <= InlineCapacity)
+				{
+					Buffer* old = IsInline() ? NULL : shared.buffer;
+					if (len > 0)
+						memmove(chars, str, len * sizeof(CharT));
+					SetInlineLength(len);
+					if (old)
+						ReleaseBuffer(old);
+				}
+				else if (!IsInline() &&
+						 shared.buffer->capacity >= len &&
+						 shared.buffer->refCount.load(std::memory_order_acquire) == 1)
+				{
+					CharT* data = shared.buffer->Data();
+					memmove(data, str, len * sizeof(CharT));
+					data[len] = 0;
+					shared.length = len;
+				}
+				else
+				{
+					Buffer* buffer = NewBuffer(len);
+					memcpy(buffer->Data(), str, len * sizeof(CharT));
+					buffer->Data()[len] = 0;
+					if (!IsInline())
+						ReleaseBuffer(shared.buffer);
+					SetShared(buffer, len);
+				}
+			}
+			/// append characters, grows buffer geometrically. (str can be part of this storage)
+			void Append(const CharT* str, size_t len)
+			{
+				if (len == 0)
+					return;
+
+				const size_t len1 = Length();
+				const size_t total = len1 + len;
+				if (IsInline())
+				{
+					if (total <= InlineCapacity)
+					{
+						memmove(&chars[len1], str, len * sizeof(CharT));
+						SetInlineLength(total);
+						return;
+					}
+					Buffer* buffer = NewBuffer(GrowCapacity(InlineCapacity, total));
+					CharT* data = buffer->Data();
+					memcpy(data, chars, len1 * sizeof(CharT));
+					memcpy(&data[len1], str, len * sizeof(CharT));
+					data[total] = 0;
+					SetShared(buffer, total);
+				}
+				else
+				{
+					Buffer* buffer = shared.buffer;
+					if (buffer->refCount.load(std::memory_order_acquire) == 1)
+					{
+						if (buffer->capacity < total)
+						{
+							// str may point to this buffer.
+							uintptr_t base = reinterpret_cast<uintptr_t>(buffer->Data());
+							uintptr_t offset = reinterpret_cast<uintptr_t>(str) - base;
+							bool alias = reinterpret_cast<uintptr_t>(str) >= base && offset < buffer->capacity * sizeof(CharT);
+
+							size_t capacity = GrowCapacity(buffer->capacity, total);
+							buffer = reinterpret_cast<Buffer*>(DKRealloc(buffer, sizeof(Buffer) + (capacity + 1) * sizeof(CharT)));
+							DKASSERT_DESC(buffer, "Out of memory!");
+							buffer->capacity = capacity;
+							shared.buffer = buffer;
+							if (alias)
+								str = reinterpret_cast<const CharT*>(reinterpret_cast<uintptr_t>(buffer->Data()) + offset);
+						}
+						CharT* data = buffer->Data();
+						memmove(&data[len1], str, len * sizeof(CharT));
+						data[total] = 0;
+					}
+					else
+					{
+						Buffer* newBuffer = NewBuffer(GrowCapacity(len1, total));
+						CharT* data = newBuffer->Data();
+						memcpy(data, buffer->Data(), len1 * sizeof(CharT));
+						memcpy(&data[len1], str, len * sizeof(CharT));
+						data[total] = 0;
+						ReleaseBuffer(buffer);
+						shared.buffer = newBuffer;
+					}
+					shared.length = total;
+				}
+			}
+
+			void Swap(DKStringStorage& s)
+			{
+				unsigned char tmp[sizeof(DKStringStorage)];
+				memcpy(tmp, static_cast<void*>(this), sizeof(DKStringStorage));
+				memcpy(static_cast<void*>(this), static_cast<void*>(&s), sizeof(DKStringStorage));
+				memcpy(static_cast<void*>(&s), tmp, sizeof(DKStringStorage));
+			}
+
+		private:
+			enum : size_t { HeapTag = 0x7f };
+			static_assert(size_t(InlineCapacity) < size_t(HeapTag), "Inline capacity too large");
+			static_assert(sizeof(Shared) + sizeof(CharT) <= StorageSize, "Storage size too small");
+
+			FORCEINLINE void SetInlineLength(size_t len)
+			{
+				DKASSERT_DEBUG(len <= InlineCapacity);
+				chars[len] = 0;
+				chars[InlineCapacity] = static_cast<CharT>(InlineCapacity - len);
+			}
+			FORCEINLINE void SetShared(Buffer* buffer, size_t len)
+			{
+				shared.buffer = buffer;
+				shared.length = len;
+				chars[InlineCapacity] = static_cast<CharT>(HeapTag);
+			}
+			static size_t GrowCapacity(size_t capacity, size_t required)
+			{
+				return Max(capacity + (capacity >> 1), required);
+			}
+			static Buffer* NewBuffer(size_t capacity)
+			{
+				void* p = DKMalloc(sizeof(Buffer) + (capacity + 1) * sizeof(CharT));
+				DKASSERT_DESC(p, "Out of memory!");
+				Buffer* buffer = new(p) Buffer();
+				buffer->refCount.store(1, std::memory_order_relaxed);
+				buffer->capacity = capacity;
+				return buffer;
+			}
+			static void ReleaseBuffer(Buffer* buffer)
+			{
+				// no one can increase counter if it is unique.
+				if (buffer->refCount.load(std::memory_order_acquire) == 1 ||
+					buffer->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					buffer->~Buffer();
+					DKFree(buffer);
+				}
+			}
+
+			union
+			{
+				CharT chars[InlineCapacity + 1];
+				Shared shared;
+			};
+		};
+	}
+}
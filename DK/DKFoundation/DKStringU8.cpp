@@ -82,57 +82,46 @@ DKStringEncoding DKStringU8::SystemEncoding()
 }
 
 DKStringU8::DKStringU8()
-	: stringData(NULL)
 {
 }
 
 DKStringU8::DKStringU8(DKStringU8&& str)
-	: stringData(NULL)
+	: storage(static_cast<Storage&&>(str.storage))
 {
-	stringData = str.stringData;
-	str.stringData = NULL;
 }
 
 DKStringU8::DKStringU8(const DKStringU8& str)
-	: stringData(NULL)
+	: storage(str.storage)
 {
-	this->SetValue(str);
 }
 
 DKStringU8::DKStringU8(const DKUniChar8* str, size_t len)
-	: stringData(NULL)
 {
 	this->SetValue(str, len);
 }
 
 DKStringU8::DKStringU8(const DKUniCharW* str, size_t len)
-	: stringData(NULL)
 {
 	this->SetValue(str, len);
 }
 
 DKStringU8::DKStringU8(const void* str, size_t bytes, DKStringEncoding e)
-	: stringData(NULL)
 {
 	this->SetValue(str, bytes, e);
 }
 
 DKStringU8::DKStringU8(DKUniCharW c)
-	: stringData(NULL)
 {
 	this->SetValue(&c, 1);
 }
 
 DKStringU8::DKStringU8(DKUniChar8 c)
-	: stringData(NULL)
 {
 	this->SetValue(&c, 1);
 }
 
 DKStringU8::~DKStringU8()
 {
-	if (stringData)
-		DKFree(stringData);
 }
 
 DKStringU8 DKStringU8::Format(const DKUniChar8* fmt, ...)
@@ -197,38 +186,21 @@ DKStringU8 DKStringU8::FormatV(const DKUniCharW* fmt, va_list v)
 
 DKStringU8& DKStringU8::Append(const DKStringU8& str)
 {
-	return Append((const DKUniChar8*)str);
+	if (Bytes() == 0)
+		storage = str.storage;
+	else
+		storage.Append(str.storage.Data(), str.Bytes());
+	return *this;
 }
 
 DKStringU8& DKStringU8::Append(const DKUniChar8* str, size_t len)
 {
 	if (str && str[0])
 	{
-		size_t len1 = this->Length();
 		size_t len2 = 0;
 		for (len2 = 0; str[len2] && len2 < len; len2++) {}
 
-		size_t totalLen = len1 + len2;
-		if (totalLen > 0)
-		{
-			DKUniChar8* buff = (DKUniChar8*)DKMalloc(totalLen + 1);
-			DKUniChar8* p = buff;
-			if (len1 > 0)
-			{
-				memcpy(p, stringData, len1);
-				p += len1;
-			}
-			if (len2 > 0)
-			{
-				memcpy(p, str, len2);
-				p += len2;
-			}
-			*p = 0;
-
-			if (stringData)
-				DKFree(stringData);
-			stringData = buff;
-		}
+		storage.Append(str, len2);
 	}
 	return *this;
 }
@@ -249,32 +221,17 @@ DKStringU8& DKStringU8::Append(const void* str, size_t bytes, DKStringEncoding e
 
 DKStringU8& DKStringU8::SetValue(const DKStringU8& str)
 {
-	if (str.stringData == this->stringData)
-		return *this;
-	
-	if (this->stringData)
-		DKFree(this->stringData);
-	this->stringData = NULL;
-	
-	size_t len = str.Length();
-	if (len > 0)
-	{
-		DKASSERT_DEBUG(str.stringData != NULL);
-		this->stringData = (DKUniChar8*)DKMalloc(len+1);
-		memcpy(this->stringData, str.stringData, len);
-		this->stringData[len] = 0;
-	}
+	storage = str.storage;
 	return *this;
 }
 
 DKStringU8& DKStringU8::SetValue(const DKUniChar8* str, size_t len)
 {
-	if (str == stringData && len >= this->Length())
+	if (str == storage.Data() && len >= this->Bytes())
 	{
 		return *this;
 	}
 	
-	DKUniChar8* buff = NULL;
 	if (str && str[0])
 	{
 		for (size_t i = 0; i < len; ++i)
@@ -285,17 +242,10 @@ DKStringU8& DKStringU8::SetValue(const DKUniChar8* str, size_t len)
 				break;
 			}
 		}
-		
-		if (len > 0)
-		{
-			buff = (DKUniChar8*)DKMalloc(len+1);
-			memcpy(buff, str, len);
-			buff[len] = NULL;
-		}
+		storage.Assign(str, len);
 	}
-	if (stringData)
-		DKFree(stringData);
-	stringData = buff;
+	else
+		storage.Clear();
 	
 	return *this;
 }
@@ -308,9 +258,7 @@ DKStringU8& DKStringU8::SetValue(const DKUniCharW* str, size_t len)
 	}
 	else
 	{
-		if (stringData)
-			DKFree(stringData);
-		stringData = NULL;
+		storage.Clear();
 	}
 	return *this;
 }
@@ -330,51 +278,38 @@ DKObject<DKData> DKStringU8::Encode(DKStringEncoding e) const
 
 size_t DKStringU8::Length() const
 {
-	return Private::NumberOfCharactersInUTF8(stringData, Bytes());
+	return Private::NumberOfCharactersInUTF8(storage.Data(), Bytes());
 }
 
 size_t DKStringU8::Bytes() const
 {
-	size_t len = 0;
-	if (stringData)
-	{
-		while (stringData[len])
-			len++;
-	}
-	return len;
+	return storage.Length();
 }
 
 int DKStringU8::Compare(const DKUniChar8* str) const
 {
-	return Private::CompareCaseSensitive(stringData, str);
+	return Private::CompareCaseSensitive(storage.Data(), str);
 }
 
 int DKStringU8::Compare(const DKStringU8& str) const
 {
-	return Private::CompareCaseSensitive(stringData, str.stringData);
+	return Private::CompareCaseSensitive(storage.Data(), str.storage.Data());
 }
 
 int DKStringU8::CompareNoCase(const DKUniChar8* str) const
 {
-	return Private::CompareCaseInsensitive(stringData, str);
+	return Private::CompareCaseInsensitive(storage.Data(), str);
 }
 
 int DKStringU8::CompareNoCase(const DKStringU8& str) const
 {
-	return Private::CompareCaseInsensitive(stringData, str.stringData);
+	return Private::CompareCaseInsensitive(storage.Data(), str.storage.Data());
 }
 
 // assignment operators
 DKStringU8& DKStringU8::operator = (DKStringU8&& str)
 {
-	if (this != &str)
-	{
-		if (stringData)
-			DKFree(stringData);
-
-		stringData = str.stringData;
-		str.stringData = NULL;
-	}
+	storage = static_cast<Storage&&>(str.storage);
 	return *this;
 }
 
@@ -408,9 +343,7 @@ DKStringU8& DKStringU8::operator = (DKUniChar8 ch)
 // conversion operators
 DKStringU8::operator const DKUniChar8* () const
 {
-	if (stringData)
-		return stringData;
-	return "";
+	return storage.Data();
 }
 
 // concatention operators
@@ -469,21 +402,21 @@ DKStringU8 DKStringU8::operator + (DKUniChar8 c) const
 // convert numeric values.
 int64_t DKStringU8::ToInteger() const
 {
-	if (stringData && stringData[0])
-		return strtoll(stringData, 0, 0);
+	if (Bytes() > 0)
+		return strtoll(storage.Data(), 0, 0);
 	return 0LL;
 }
 
 uint64_t DKStringU8::ToUnsignedInteger() const
 {
-	if (stringData && stringData[0])
-		return strtoull(stringData, 0, 0);
+	if (Bytes() > 0)
+		return strtoull(storage.Data(), 0, 0);
 	return 0ULL;
 }
 
 double DKStringU8::ToRealNumber() const
 {
-	if (stringData && stringData[0])
-		return strtod(stringData, 0);
+	if (Bytes() > 0)
+		return strtod(storage.Data(), 0);
 	return 0.0;
 }
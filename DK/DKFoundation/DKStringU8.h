@@ -12,11 +12,15 @@
 #include "DKSet.h"
 #include "DKArray.h"
 #include "DKStringUE.h"
+#include "DKStringStorage.h"
 
 namespace DKFoundation
 {
 	class DKData;
 	/// a string class with UTF-8 encoded character string.
+	/// Short string is stored inline without allocation, longer string buffer
+	/// is shared between copies until modified. (copy-on-write)
+	/// Note: character pointer of short string is invalidated when the object is moved.
 	class DKGL_API DKStringU8
 	{
 	public:
@@ -110,6 +114,7 @@ namespace DKFoundation
 		double ToRealNumber() const;
 
 	private:
-		CharT* stringData;
+		using Storage = Private::DKStringStorage<CharT, 24>;
+		Storage storage;
 	};
 }
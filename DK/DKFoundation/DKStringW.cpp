@@ -123,57 +123,46 @@ DKStringEncoding DKStringW::SystemEncoding()
 
 // DKStringW class
 DKStringW::DKStringW()
-	: stringData(NULL)
 {
 }
 
 DKStringW::DKStringW(DKStringW&& str)
-	: stringData(NULL)
+	: storage(static_cast<Storage&&>(str.storage))
 {
-	stringData = str.stringData;
-	str.stringData = NULL;
 }
 
 DKStringW::DKStringW(const DKStringW& str)
-	: stringData(NULL)
+	: storage(str.storage)
 {
-	this->SetValue(str);
 }
 
 DKStringW::DKStringW(const DKUniCharW* str, size_t len)
-	: stringData(NULL)
 {
 	this->SetValue(str, len);
 }
 
 DKStringW::DKStringW(const DKUniChar8* str, size_t len)
-	: stringData(NULL)
 {
 	this->SetValue(str, len);
 }
 
 DKStringW::DKStringW(const void* str, size_t len, DKStringEncoding e)
-	: stringData(NULL)
 {
 	this->SetValue(str, len, e);
 }
 
 DKStringW::DKStringW(DKUniCharW c)
-	: stringData(NULL)
 {
 	this->SetValue(&c, 1);
 }
 
 DKStringW::DKStringW(DKUniChar8 c)
-	: stringData(NULL)
 {
 	this->SetValue(&c, 1);
 }
 
 DKStringW::~DKStringW()
 {
-	if (stringData)
-		DKFree(stringData);
 }
 
 DKStringW DKStringW::Format(const DKUniChar8* fmt, ...)
@@ -238,13 +227,7 @@ DKStringW DKStringW::FormatV(const DKUniCharW* fmt, va_list v)
 
 size_t DKStringW::Length() const
 {
-	size_t len = 0;
-	if (stringData)
-	{
-		while (stringData[len])
-			len++;
-	}
-	return len;
+	return storage.Length();
 }
 
 size_t DKStringW::Bytes() const
@@ -256,7 +239,7 @@ long DKStringW::Find(DKUniCharW c, long begin) const
 {
 	if (begin < 0)	begin = 0;
 
-	const DKUniCharW *data = stringData;
+	const DKUniCharW *data = storage.Data();
 	size_t len = Length();
 	for (long i = begin; i < (long)len; ++i)
 	{
@@ -278,7 +261,7 @@ long DKStringW::Find(const DKUniCharW* str, long begin) const
 
 	for (long i = begin; i <= maxLength; ++i)
 	{
-		if (wcsncmp(&stringData[i], str, strLength) == 0)
+		if (wcsncmp(&storage.Data()[i], str, strLength) == 0)
 			return (long)i;
 	}
 	return -1;
@@ -298,10 +281,11 @@ long DKStringW::FindAnyCharactersInSet(const CharacterSet& cs, long begin) const
 {
 	if (cs.Count() > 0)
 	{
+		const DKUniCharW* data = storage.Data();
 		size_t len = Length();
 		for (size_t i = begin; i < len; ++i)
 		{
-			if (cs.Contains(this->stringData[i]))
+			if (cs.Contains(data[i]))
 				return (long)i;
 		}
 	}
@@ -317,17 +301,7 @@ DKStringW DKStringW::Right(long index) const
 		if (index < 0)
 			index = 0;
 
-		int count = len - index;
-		if (count < 0)
-			count = 0;
-
-		DKUniCharW* tmp = (DKUniCharW*)DKMalloc((len+1) * sizeof(DKUniCharW));
-		memset(tmp, 0, sizeof(DKUniCharW) * (len+1));
-		wcsncpy(tmp, &stringData[index], count);
-
-		string = tmp;
-
-		DKFree(tmp);
+		string.storage.Assign(&storage.Data()[index], len - index);
 	}
 	return string;
 }
@@ -341,13 +315,7 @@ DKStringW DKStringW::Left(size_t count) const
 		if (count > len)
 			count = len;
 
-		DKUniCharW* tmp = (DKUniCharW*)DKMalloc((len+1) * sizeof(DKUniCharW));
-		memset(tmp, 0 , sizeof(DKUniCharW) * (len+1));
-		wcsncpy(tmp, stringData, count);
-
-		string = tmp;
-
-		DKFree(tmp);
+		string.storage.Assign(storage.Data(), count);
 	}
 	return string;
 }
@@ -362,13 +330,7 @@ DKStringW DKStringW::Mid(long index, size_t count) const
 
 	if (count > 0 && index + count < len)
 	{
-		DKUniCharW* buff = (DKUniCharW*)DKMalloc((count+1) * sizeof(DKUniCharW));
-		wcsncpy(buff, &stringData[index], count);
-		buff[count] = 0;
-
-		string = buff;
-
-		DKFree(buff);
+		string.storage.Assign(&storage.Data()[index], count);
 	}
 	else
 	{
@@ -379,79 +341,76 @@ DKStringW DKStringW::Mid(long index, size_t count) const
 
 DKStringW DKStringW::LowercaseString() const
 {
-	if (stringData)
+	DKStringW ret(*this);
+	size_t len = ret.Length();
+	if (len > 0)
 	{
-		DKUniCharW *buff = (DKUniCharW*)DKMalloc((Length()+1) * sizeof(DKUniCharW));
-		int i;
-		for (i = 0 ; stringData[i] != 0; ++i)
-		{
-			buff[i] = towlower(stringData[i]);
-		}
-		buff[i] = 0;
-
-		DKStringW ret = buff;
-		DKFree(buff);
-		return ret;
+		DKUniCharW* data = ret.storage.MutableData();
+		for (size_t i = 0; i < len; ++i)
+			data[i] = towlower(data[i]);
 	}
-	return DKStringW(L"");			
+	return ret;
 }
 
 DKStringW DKStringW::UppercaseString() const
 {
-	if (stringData)
+	DKStringW ret(*this);
+	size_t len = ret.Length();
+	if (len > 0)
 	{
-		DKUniCharW *buff = (DKUniCharW*)DKMalloc((Length()+1) * sizeof(DKUniCharW));
-		int i;
-		for (i = 0 ; stringData[i] != 0; ++i)
-		{
-			buff[i] = towupper(stringData[i]);
-		}
-		buff[i] = 0;
-
-		DKStringW ret = buff;
-		DKFree(buff);
-		return ret;
+		DKUniCharW* data = ret.storage.MutableData();
+		for (size_t i = 0; i < len; ++i)
+			data[i] = towupper(data[i]);
 	}
-	return DKStringW(L"");			
+	return ret;
 }
 
 int DKStringW::Compare(const DKUniCharW* str) const
 {
-	return Private::CompareCaseSensitive(stringData, str);
+	return Private::CompareCaseSensitive(storage.Data(), str);
 }
 
 int DKStringW::Compare(const DKStringW& str) const
 {
-	return Private::CompareCaseSensitive(stringData, str.stringData);
+	return Private::CompareCaseSensitive(storage.Data(), str.storage.Data());
 }
 
 int DKStringW::CompareNoCase(const DKUniCharW* str) const
 {
-	return Private::CompareCaseInsensitive(stringData, str);
+	return Private::CompareCaseInsensitive(storage.Data(), str);
 }
 
 int DKStringW::CompareNoCase(const DKStringW& str) const
 {
-	return Private::CompareCaseInsensitive(stringData, str.stringData);
+	return Private::CompareCaseInsensitive(storage.Data(), str.storage.Data());
 }
 
 int DKStringW::Replace(const DKUniCharW c1, const DKUniCharW c2)
 {
-	if (!stringData)
+	if (Length() == 0)
 		return 0;
 	if (c1 == c2)
 		return 0;
 	int result = 0;
 	if (c1)
 	{
+		const DKUniCharW* data = storage.Data();
 		if (c2)
 		{
-			for (size_t i = 0; stringData[i]; ++i)
+			// find first character before copying shared buffer.
+			size_t i = 0;
+			while (data[i] && data[i] != c1)
+				++i;
+			if (data[i])
 			{
-				if (stringData[i] == c1)
+				DKUniCharW* mutableData = storage.MutableData();
+				for ( ; mutableData[i]; ++i)
 				{
-					stringData[i] = c2;
-					++result;
+					if (mutableData[i] == c1)
+					{
+						mutableData[i] = c2;
+						++result;
+					}
 				}
 			}
 		}
@@ -460,12 +419,12 @@ int DKStringW::Replace(const DKUniCharW c1, const DKUniCharW c2)
 			size_t len = Length();
 			DKUniCharW* tmp = (DKUniCharW*)DKMalloc((len+1) * sizeof(DKUniCharW));
 			size_t tmpLen = 0;
-			for (size_t i = 0; stringData[i]; ++i)
+			for (size_t i = 0; data[i]; ++i)
 			{
-				if (stringData[i] == c1)
+				if (data[i] == c1)
 					++result;
 				else
-					tmp[tmpLen++] = stringData[i];
+					tmp[tmpLen++] = data[i];
 			}
 			tmp[tmpLen] = 0;
 			this->SetValue(tmp, tmpLen);
@@ -527,10 +486,10 @@ DKStringW& DKStringW::Insert(long index, const DKUniCharW* str)
 		memset(tmp, 0, sizeof(DKUniCharW) * (len + newStrLen + 4));
 		if (index > 0)
 		{
-			wcsncpy(tmp, stringData, index);
+			wcsncpy(tmp, storage.Data(), index);
 		}
 		wcscat(tmp, str);
-		wcscat(tmp, &stringData[index]);
+		wcscat(tmp, &storage.Data()[index]);
 
 		this->SetValue(tmp);
 
@@ -606,7 +565,7 @@ DKStringW::StringArray DKStringW::PathComponents() const
 bool DKStringW::IsWhitespaceCharacterAtIndex(long index) const
 {
 	DKASSERT_DEBUG(Length() > index);
-	return Private::WhitespaceCharacterSet().Contains(stringData[index]);
+	return Private::WhitespaceCharacterSet().Contains(storage.Data()[index]);
 }
 
 DKStringW& DKStringW::TrimWhitespaces()
@@ -672,7 +631,7 @@ DKStringW& DKStringW::RemoveWhitespaces(long begin, long count)
 	{
 		if (!IsWhitespaceCharacterAtIndex(i + begin))
 		{
-			buffer[bufferIndex++] = stringData[i+begin];
+			buffer[bufferIndex++] = storage.Data()[i+begin];
 		}
 	}
 	buffer[bufferIndex] = NULL;
@@ -714,37 +673,21 @@ DKStringW& DKStringW::RemoveSuffix(const DKStringW& str)
 
 DKStringW& DKStringW::Append(const DKStringW& str)
 {
-	return Append((const DKUniCharW*)str);
+	if (Length() == 0)
+		storage = str.storage;
+	else
+		storage.Append(str.storage.Data(), str.Length());
+	return *this;
 }
 
 DKStringW& DKStringW::Append(const DKUniCharW* str, size_t len)
 {
 	if (str && str[0])
 	{
-		size_t len1 = Length();
 		size_t len2 = 0;
 		for (len2 = 0; str[len2] && len2 < len; len2++) {}
 
-		size_t totalLen = len1 + len2;
-
-		if (totalLen > 0)
-		{
-			DKUniCharW* buff = (DKUniCharW*)DKMalloc((len1 + len2 + 1) * sizeof(DKUniCharW));
-			memset(buff, 0, sizeof(DKUniCharW) * (len1 + len2 + 1));
-
-			if (stringData && stringData[0])
-			{
-				wcscat(buff, stringData);
-				//wcscat_s(pNewBuff, nLen+nLen2+4, stringData);
-			}
-
-			wcscat(buff, str);
-			//wcscat_s(pNewBuff, nLen+nLen2+4, str);
-
-			if (stringData)
-				DKFree(stringData);
-			stringData = buff;
-		}
+		storage.Append(str, len2);
 	}
 	return *this;
 }
@@ -765,29 +708,15 @@ DKStringW& DKStringW::Append(const void* str, size_t bytes, DKStringEncoding e)
 
 DKStringW& DKStringW::SetValue(const DKStringW& str)
 {
-	if (str.stringData == this->stringData)
-		return *this;
-
-	if (this->stringData)
-		DKFree(this->stringData);
-	this->stringData = NULL;
-
-	size_t len = str.Length();
-	if (len > 0)
-	{
-		DKASSERT_DEBUG(str.stringData != NULL);
-		this->stringData = (DKUniCharW*)DKMalloc((len+1) * sizeof(DKUniCharW));
-		wcscpy(this->stringData, str.stringData);
-	}
+	storage = str.storage;
 	return *this;
 }
 
 DKStringW& DKStringW::SetValue(const DKUniCharW* str, size_t len)
 {
-	if (str == stringData && len >= this->Length())
+	if (str == storage.Data() && len >= this->Length())
 		return *this;
 
-	DKUniCharW* buff = NULL;
 	if (str && str[0])
 	{
 		for (size_t i = 0; i < len; ++i)
@@ -798,17 +727,10 @@ DKStringW& DKStringW::SetValue(const DKUniCharW* str, size_t len)
 				break;
 			}
 		}
-
-		if (len > 0)
-		{
-			buff = (DKUniCharW*)DKMalloc((len+1) * sizeof(DKUniCharW));
-			memcpy(buff, str, len * sizeof(DKUniCharW));
-			buff[len] = NULL;
-		}
+		storage.Assign(str, len);
 	}
-	if (stringData)
-		DKFree(stringData);
-	stringData = buff;
+	else
+		storage.Clear();
 
 	return *this;
 }
@@ -832,14 +754,7 @@ DKStringW& DKStringW::SetValue(const void* str, size_t bytes, DKStringEncoding e
 // assignment operators
 DKStringW& DKStringW::operator = (DKStringW&& str)
 {
-	if (this != &str)
-	{
-		if (stringData)
-			DKFree(stringData);
-
-		stringData = str.stringData;
-		str.stringData = NULL;
-	}
+	storage = static_cast<Storage&&>(str.storage);
 	return *this;
 }
 
@@ -873,8 +788,8 @@ DKStringW& DKStringW::operator = (DKUniChar8 ch)
 // conversion operators
 DKStringW::operator const DKUniCharW*() const
 {
-	if (this && this->stringData)
-		return (const DKUniCharW*)this->stringData;
+	if (this)
+		return storage.Data();
 	return L"";
 }
 
@@ -938,22 +853,22 @@ DKObject<DKData> DKStringW::Encode(DKStringEncoding e) const
 
 int64_t DKStringW::ToInteger() const
 {
-	if (stringData && stringData[0])
-		return wcstoll(stringData, 0, 0);
+	if (Length() > 0)
+		return wcstoll(storage.Data(), 0, 0);
 	return 0LL;
 }
 
 uint64_t DKStringW::ToUnsignedInteger() const
 {
-	if (stringData && stringData[0])
-		return wcstoull(stringData, 0, 0);
+	if (Length() > 0)
+		return wcstoull(storage.Data(), 0, 0);
 	return 0ULL;
 }
 
 double DKStringW::ToRealNumber() const
 {
-	if (stringData && stringData[0])
-		return wcstod(stringData, 0);
+	if (Length() > 0)
+		return wcstod(storage.Data(), 0);
 	return 0.0;
 }
 
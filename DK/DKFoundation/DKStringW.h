@@ -12,6 +12,7 @@
 #include "DKSet.h"
 #include "DKArray.h"
 #include "DKStringUE.h"
+#include "DKStringStorage.h"
 
 namespace DKFoundation
 {
@@ -19,6 +20,11 @@ namespace DKFoundation
 	/// a unicode string class with wchar_t character string.
 	/// UTF-8, CP367 (ISO-8859, ASCII) are available also.
 	/// (but convert and store with wchar_t string internally.)
+	///
+	/// Short string (up to 23 characters) is stored inline without allocation,
+	/// longer string buffer is shared between copies until modified. (copy-on-write)
+	/// Note: character pointer of short string points into the object itself,
+	/// it is invalidated when the object is moved or destroyed.
 	class DKGL_API DKStringW
 	{
 	public:
@@ -121,6 +127,7 @@ namespace DKFoundation
 		DKStringW& operator = (DKUniChar8 ch);
 
 		// conversion operators
+		/// returned pointer is valid until string is modified, moved or destroyed.
 		operator const DKUniCharW* () const;
 
 		// concatenation operators
@@ -164,6 +171,8 @@ namespace DKFoundation
 		StringArray SplitByWhitespace() const;
 
 	private:
-		CharT* stringData;
+		/// inline storage holds 23 characters, regardless of sizeof(wchar_t).
+		using Storage = Private::DKStringStorage<CharT, 24 * sizeof(CharT)>;
+		Storage storage;
 	};
 }
@@ -0,0 +1,860 @@
+//
+//  File: DKXmlReader.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include "DKXmlReader.h"
+#include "DKBuffer.h"
+#include "DKDataStream.h"
+#include "DKFileMap.h"
+
+namespace DKFoundation
+{
+	namespace Private
+	{
+		FORCEINLINE bool IsXmlWhitespace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+		FORCEINLINE bool IsXmlNameTerminator(char c)
+		{
+			return IsXmlWhitespace(c) || c == '/' || c == '>' || c == '=' || c == '<' || c == '?';
+		}
+		FORCEINLINE char XmlAsciiLower(char c)
+		{
+			return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+		}
+		FORCEINLINE const char* SkipXmlWhitespaces(const char* p, const char* end)
+		{
+			while (p < end && IsXmlWhitespace(*p))
+				++p;
+			return p;
+		}
+		FORCEINLINE const char* ScanXmlName(const char* p, const char* end)
+		{
+			while (p < end && !IsXmlNameTerminator(*p))
+				++p;
+			return p;
+		}
+		/// find sequence, returns end if not found.
+		static const char* FindXmlSequence(const char* p, const char* end, const char* seq, size_t len)
+		{
+			while (p + len <= end)
+			{
+				p = reinterpret_cast<const char*>(memchr(p, seq[0], end - p));
+				if (p == NULL || p + len > end)
+					break;
+				if (memcmp(p, seq, len) == 0)
+					return p;
+				++p;
+			}
+			return end;
+		}
+		static size_t EncodeUTF8(uint32_t c, char* out)
+		{
+			if (c < 0x80)
+			{
+				out[0] = (char)c;
+				return 1;
+			}
+			if (c < 0x800)
+			{
+				out[0] = (char)(0xc0 | (c >> 6));
+				out[1] = (char)(0x80 | (c & 0x3f));
+				return 2;
+			}
+			if (c < 0x10000)
+			{
+				out[0] = (char)(0xe0 | (c >> 12));
+				out[1] = (char)(0x80 | ((c >> 6) & 0x3f));
+				out[2] = (char)(0x80 | (c & 0x3f));
+				return 3;
+			}
+			if (c < 0x110000)
+			{
+				out[0] = (char)(0xf0 | (c >> 18));
+				out[1] = (char)(0x80 | ((c >> 12) & 0x3f));
+				out[2] = (char)(0x80 | ((c >> 6) & 0x3f));
+				out[3] = (char)(0x80 | (c & 0x3f));
+				return 4;
+			}
+			return 0;
+		}
+		/// decode entity at p ('&'), returns length of entity or zero if invalid.
+		static size_t DecodeXmlEntity(const char* p, const char* end, char* out, size_t& outLength)
+		{
+			const char* semicolon = reinterpret_cast<const char*>(memchr(p, ';', Min<size_t>(end - p, 12)));
+			if (semicolon == NULL)
+				return 0;
+			const char* name = p + 1;
+			size_t len = semicolon - name;
+			if (len > 1 && name[0] == '#')
+			{
+				uint32_t c = 0;
+				if (name[1] == 'x')
+				{
+					if (len < 3)
+						return 0;
+					for (const char* s = name + 2; s < semicolon; ++s)
+					{
+						if (*s >= '0' && *s <= '9')			c = c * 16 + (*s - '0');
+						else if (*s >= 'a' && *s <= 'f')	c = c * 16 + (*s - 'a' + 10);
+						else if (*s >= 'A' && *s <= 'F')	c = c * 16 + (*s - 'A' + 10);
+						else return 0;
+					}
+				}
+				else
+				{
+					for (const char* s = name + 1; s < semicolon; ++s)
+					{
+						if (*s >= '0' && *s <= '9')			c = c * 10 + (*s - '0');
+						else return 0;
+					}
+				}
+				outLength = EncodeUTF8(c, out);
+				return outLength > 0 ? len + 2 : 0;
+			}
+			struct { const char* name; size_t length; char c; } const entities[] =
+			{
+				{ "lt", 2, '<' }, { "gt", 2, '>' }, { "amp", 3, '&' }, { "apos", 4, '\'' }, { "quot", 4, '"' },
+			};
+			for (auto& e : entities)
+			{
+				if (e.length == len && memcmp(name, e.name, len) == 0)
+				{
+					out[0] = e.c;
+					outLength = 1;
+					return len + 2;
+				}
+			}
+			return 0;
+		}
+		/// append decoded value to string. line-breaks are normalized,
+		/// whitespaces are normalized also for attribute value.
+		static void AppendXmlValue(DKString& str, const char* p, size_t length, bool attribute)
+		{
+			const char* end = p + length;
+			const char* s = p;
+			while (s < end && *s != '&' && *s != '\r' && !(attribute && (*s == '\n' || *s == '\t')))
+				++s;
+			if (s == end)	// nothing to decode.
+			{
+				if (length > 0)
+					str.Append((const DKUniChar8*)p, length);
+				return;
+			}
+
+			DKArray<char> buffer;
+			buffer.Reserve(length);
+			buffer.Add(p, s - p);
+			while (s < end)
+			{
+				char c = *s;
+				if (c == '&')
+				{
+					char decoded[4];
+					size_t decodedLength = 0;
+					size_t n = DecodeXmlEntity(s, end, decoded, decodedLength);
+					if (n > 0)
+					{
+						buffer.Add(decoded, decodedLength);
+						s += n;
+						continue;
+					}
+				}
+				else if (c == '\r')
+				{
+					if (s + 1 < end && s[1] == '\n')
+						++s;
+					c = attribute ? ' ' : '\n';
+				}
+				else if (attribute && (c == '\n' || c == '\t'))
+				{
+					c = ' ';
+				}
+				buffer.Add(c);
+				++s;
+			}
+			if (buffer.Count() > 0)
+				str.Append((const DKUniChar8*)(const char*)buffer, buffer.Count());
+		}
+	}
+}
+
+using namespace DKFoundation;
+using namespace DKFoundation::Private;
+
+bool DKXmlReader::StringView::Equals(const char* s) const
+{
+	size_t len = strlen(s);
+	return len == length && memcmp(str, s, len) == 0;
+}
+
+bool DKXmlReader::StringView::EqualsNoCase(const char* s) const
+{
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (s[i] == 0 || XmlAsciiLower(str[i]) != XmlAsciiLower(s[i]))
+			return false;
+	}
+	return s[length] == 0;
+}
+
+bool DKXmlReader::StringView::Equals(const StringView& s) const
+{
+	return s.length == length && memcmp(str, s.str, length) == 0;
+}
+
+DKString DKXmlReader::StringView::ToString() const
+{
+	DKString s = L"";
+	if (length > 0)
+		s.SetValue((const DKUniChar8*)str, length);
+	return s;
+}
+
+DKXmlReader::DKXmlReader(DKData* data)
+	: source(data)
+	, nodeType(NodeTypeNone)
+	, error(ErrorNone)
+	, errorMessage(NULL)
+	, errorPosition(NULL)
+	, name{ NULL, 0 }
+	, value{ NULL, 0 }
+	, emptyElement(false)
+	, rootClosed(false)
+{
+	DKASSERT_DEBUG(source != NULL);
+	begin = reinterpret_cast<const char*>(source->LockShared());
+	end = begin + source->Length();
+	pos = begin;
+}
+
+DKXmlReader::~DKXmlReader()
+{
+	source->UnlockShared();
+}
+
+DKObject<DKXmlReader> DKXmlReader::Open(const DKString& file)
+{
+	DKObject<DKFileMap> map = DKFileMap::Open(file, 0, false);
+	if (map)
+		return Open(map.SafeCast<DKData>());
+	return NULL;
+}
+
+DKObject<DKXmlReader> DKXmlReader::Open(const DKData* data)
+{
+	if (data == NULL || !data->IsReadable())
+		return NULL;
+
+	DKObject<DKData> source = const_cast<DKData*>(data);
+	if (!source.IsManaged())
+		source = DKBuffer::Create(data).SafeCast<DKData>();
+	if (source)
+		return DKOBJECT_NEW DKXmlReader(source);
+	return NULL;
+}
+
+DKObject<DKXmlReader> DKXmlReader::Open(DKStream* stream)
+{
+	if (stream && stream->IsReadable())
+	{
+		DKObject<DKDataStream> ds = DKObject<DKStream>(stream).SafeCast<DKDataStream>();
+		DKObject<DKData> data = ds ? ds->Data() : NULL;
+		if (data && data.IsManaged())
+		{
+			// remaining data from current position, without copy.
+			// (slice refers data, unmanaged data should be copied)
+			DKStream::Position pos = ds->CurrentPosition();
+			DKStream::Position remain = ds->RemainLength();
+			data = data->Slice(pos, remain);
+			ds->SetCurrentPosition(pos + remain);
+			return Open(data);
+		}
+		return Open(DKBuffer::Create(stream));
+	}
+	return NULL;
+}
+
+DKXmlReader::NodeType DKXmlReader::SetError(ErrorType e, const char* mesg, const char* at)
+{
+	error = e;
+	errorMessage = mesg;
+	errorPosition = at;
+	nodeType = NodeTypeError;
+	return nodeType;
+}
+
+DKString DKXmlReader::ErrorDescription() const
+{
+	if (error == ErrorNone)
+		return L"";
+	size_t line = 1;
+	for (const char* p = begin; p < errorPosition && p < end; ++p)
+	{
+		if (*p == '\n')
+			line++;
+	}
+	return DKString::Format("%s (line:%zu)", errorMessage, line);
+}
+
+size_t DKXmlReader::Depth() const
+{
+	if (nodeType == NodeTypeStartElement || nodeType == NodeTypeEndElement)
+		return elements.Count() - 1;
+	return elements.Count();
+}
+
+bool DKXmlReader::ReadDeclaration()
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(pos);
+	size_t len = end - pos;
+	if (len >= 3 && p[0] == 0xef && p[1] == 0xbb && p[2] == 0xbf)	// UTF-8 BOM
+	{
+		pos += 3;
+		len -= 3;
+		p += 3;
+	}
+	if (len >= 2 && ((p[0] == 0xfe && p[1] == 0xff) || (p[0] == 0xff && p[1] == 0xfe) || p[0] == 0 || p[1] == 0))
+	{
+		SetError(ErrorUnsupported, "Unsupported encoding", pos);
+		return false;
+	}
+	if (len >= 6 && memcmp(pos, "<?xml", 5) == 0 && IsXmlWhitespace(pos[5]))
+	{
+		const char* declEnd = FindXmlSequence(pos, end, "?>", 2);
+		if (declEnd == end)
+		{
+			SetError(ErrorSyntax, "Invalid XML declaration", pos);
+			return false;
+		}
+		const char* enc = FindXmlSequence(pos, declEnd, "encoding", 8);
+		if (enc != declEnd)
+		{
+			enc = SkipXmlWhitespaces(enc + 8, declEnd);
+			if (enc < declEnd && *enc == '=')
+				enc = SkipXmlWhitespaces(enc + 1, declEnd);
+			if (enc < declEnd && (*enc == '"' || *enc == '\''))
+			{
+				const char* encEnd = reinterpret_cast<const char*>(memchr(enc + 1, *enc, declEnd - enc - 1));
+				if (encEnd)
+				{
+					StringView encoding = { enc + 1, size_t(encEnd - enc - 1) };
+					if (!encoding.EqualsNoCase("UTF-8") && !encoding.EqualsNoCase("UTF8") &&
+						!encoding.EqualsNoCase("US-ASCII") && !encoding.EqualsNoCase("ASCII"))
+					{
+						SetError(ErrorUnsupported, "Unsupported encoding", enc);
+						return false;
+					}
+				}
+			}
+		}
+		pos = declEnd + 2;
+	}
+	return true;
+}
+
+DKXmlReader::NodeType DKXmlReader::Read()
+{
+	if (nodeType == NodeTypeError || nodeType == NodeTypeEndOfDocument)
+		return nodeType;
+
+	if (nodeType == NodeTypeNone)
+	{
+		if (!ReadDeclaration())
+			return nodeType;
+	}
+	else if (emptyElement)	// <Item/>
+	{
+		DKASSERT_DEBUG(nodeType == NodeTypeStartElement);
+		emptyElement = false;
+		attributes.Clear();
+		nodeType = NodeTypeEndElement;
+		return nodeType;
+	}
+	else if (nodeType == NodeTypeEndElement)
+	{
+		elements.Remove(elements.Count() - 1);
+		while (namespaces.Count() > 0 && namespaces.Value(namespaces.Count() - 1).depth >= elements.Count())
+			namespaces.Remove(namespaces.Count() - 1);
+		if (elements.IsEmpty())
+			rootClosed = true;
+	}
+
+	attributes.Clear();
+	name = { NULL, 0 };
+	value = { NULL, 0 };
+
+	while (pos < end)
+	{
+		if (*pos == '<')
+			return ReadMarkup();
+
+		const char* text = pos;
+		const char* next = reinterpret_cast<const char*>(memchr(pos, '<', end - pos));
+		pos = next ? next : end;
+		if (elements.IsEmpty())
+		{
+			// whitespaces only, outside of root element.
+			for (const char* p = text; p < pos; ++p)
+			{
+				if (!IsXmlWhitespace(*p))
+					return SetError(ErrorSyntax, "Text outside of root element", p);
+			}
+			continue;
+		}
+		value = { text, size_t(pos - text) };
+		nodeType = NodeTypeText;
+		return nodeType;
+	}
+	if (!elements.IsEmpty())
+		return SetError(ErrorSyntax, "Unexpected end of document", end);
+	if (!rootClosed)
+		return SetError(ErrorSyntax, "Root element not found", end);
+	nodeType = NodeTypeEndOfDocument;
+	return nodeType;
+}
+
+DKXmlReader::NodeType DKXmlReader::ReadMarkup()
+{
+	DKASSERT_DEBUG(*pos == '<');
+	const char* p = pos + 1;
+	size_t remains = end - p;
+
+	if (remains > 0 && *p == '/')
+		return ReadEndElement();
+
+	if (remains > 0 && *p == '?')	// processing instruction
+	{
+		const char* target = p + 1;
+		const char* targetEnd = ScanXmlName(target, end);
+		const char* piEnd = FindXmlSequence(targetEnd, end, "?>", 2);
+		if (targetEnd == target || piEnd == end)
+			return SetError(ErrorSyntax, "Invalid processing instruction", pos);
+		name = { target, size_t(targetEnd - target) };
+		if (name.EqualsNoCase("xml"))
+			return SetError(ErrorSyntax, "Invalid XML declaration", pos);
+		const char* data = SkipXmlWhitespaces(targetEnd, piEnd);
+		value = { data, size_t(piEnd - data) };
+		pos = piEnd + 2;
+		nodeType = NodeTypeInstruction;
+		return nodeType;
+	}
+	if (remains >= 3 && memcmp(p, "!--", 3) == 0)	// comment
+	{
+		const char* comment = p + 3;
+		const char* commentEnd = FindXmlSequence(comment, end, "-->", 3);
+		if (commentEnd == end)
+			return SetError(ErrorSyntax, "Comment not terminated", pos);
+		value = { comment, size_t(commentEnd - comment) };
+		pos = commentEnd + 3;
+		nodeType = NodeTypeComment;
+		return nodeType;
+	}
+	if (remains >= 8 && memcmp(p, "![CDATA[", 8) == 0)
+	{
+		if (elements.IsEmpty())
+			return SetError(ErrorSyntax, "CDATA outside of root element", pos);
+		const char* data = p + 8;
+		const char* dataEnd = FindXmlSequence(data, end, "]]>", 3);
+		if (dataEnd == end)
+			return SetError(ErrorSyntax, "CDATA not terminated", pos);
+		value = { data, size_t(dataEnd - data) };
+		pos = dataEnd + 3;
+		nodeType = NodeTypeCData;
+		return nodeType;
+	}
+	if (remains >= 8 && memcmp(p, "!DOCTYPE", 8) == 0)
+	{
+		if (!elements.IsEmpty() || rootClosed)
+			return SetError(ErrorSyntax, "Invalid DOCTYPE declaration", pos);
+		const char* n = SkipXmlWhitespaces(p + 8, end);
+		const char* nEnd = ScanXmlName(n, end);
+		if (n == nEnd)
+			return SetError(ErrorSyntax, "Invalid DOCTYPE declaration", pos);
+		name = { n, size_t(nEnd - n) };
+		// skip external-id and internal subset.
+		const char* s = nEnd;
+		int subset = 0;
+		while (s < end)
+		{
+			char c = *s;
+			if (c == '"' || c == '\'')
+			{
+				const char* q = reinterpret_cast<const char*>(memchr(s + 1, c, end - s - 1));
+				if (q == NULL)
+					break;
+				s = q + 1;
+				continue;
+			}
+			if (c == '[')
+				subset++;
+			else if (c == ']')
+				subset--;
+			else if (c == '>' && subset <= 0)
+				break;
+			else if (c == '<' && subset > 0)
+			{
+				if (size_t(end - s) >= 4 && memcmp(s, "<!--", 4) == 0)
+				{
+					s = FindXmlSequence(s + 4, end, "-->", 3);
+					if (s < end) s += 3;
+					continue;
+				}
+				if (size_t(end - s) >= 8 && memcmp(s, "<!ENTITY", 8) == 0)
+					return SetError(ErrorUnsupported, "Entity declaration is not supported", s);
+			}
+			++s;
+		}
+		if (s >= end)
+			return SetError(ErrorSyntax, "DOCTYPE not terminated", pos);
+		value = { nEnd, size_t(s - nEnd) };
+		pos = s + 1;
+		nodeType = NodeTypeDocTypeDecl;
+		return nodeType;
+	}
+	if (remains > 0 && *p == '!')
+		return SetError(ErrorSyntax, "Invalid markup", pos);
+	return ReadStartElement();
+}
+
+DKXmlReader::NodeType DKXmlReader::ReadStartElement()
+{
+	if (rootClosed)
+		return SetError(ErrorSyntax, "Extra content after root element", pos);
+
+	const char* p = pos + 1;
+	const char* nameEnd = ScanXmlName(p, end);
+	if (nameEnd == p)
+		return SetError(ErrorSyntax, "Invalid element name", pos);
+	name = { p, size_t(nameEnd - p) };
+	p = nameEnd;
+
+	const size_t depth = elements.Count();
+	bool empty = false;
+	while (true)
+	{
+		const char* ws = p;
+		p = SkipXmlWhitespaces(p, end);
+		if (p >= end)
+			return SetError(ErrorSyntax, "Element not terminated", pos);
+		if (*p == '>')
+		{
+			++p;
+			break;
+		}
+		if (*p == '/')
+		{
+			if (p + 1 < end && p[1] == '>')
+			{
+				p += 2;
+				empty = true;
+				break;
+			}
+			return SetError(ErrorSyntax, "Invalid element", p);
+		}
+		if (ws == p)
+			return SetError(ErrorSyntax, "Whitespace required before attribute", p);
+
+		const char* attrName = p;
+		p = ScanXmlName(p, end);
+		if (p == attrName)
+			return SetError(ErrorSyntax, "Invalid attribute name", p);
+		AttributeView attr;
+		attr.name = { attrName, size_t(p - attrName) };
+		p = SkipXmlWhitespaces(p, end);
+		if (p >= end || *p != '=')
+			return SetError(ErrorSyntax, "Attribute value required", p);
+		p = SkipXmlWhitespaces(p + 1, end);
+		if (p >= end || (*p != '"' && *p != '\''))
+			return SetError(ErrorSyntax, "Attribute value must be quoted", p);
+		const char* quote = reinterpret_cast<const char*>(memchr(p + 1, *p, end - p - 1));
+		if (quote == NULL)
+			return SetError(ErrorSyntax, "Attribute value not terminated", p);
+		attr.value = { p + 1, size_t(quote - p - 1) };
+		p = quote + 1;
+
+		if (attr.name.Equals("xmlns"))
+		{
+			NamespaceView ns = { { NULL, 0 }, attr.value, depth };
+			namespaces.Add(ns);
+		}
+		else if (attr.name.length > 6 && memcmp(attr.name.str, "xmlns:", 6) == 0)
+		{
+			NamespaceView ns = { { attr.name.str + 6, attr.name.length - 6 }, attr.value, depth };
+			namespaces.Add(ns);
+		}
+		else
+		{
+			attributes.Add(attr);
+		}
+	}
+	pos = p;
+	elements.Add(name);
+	emptyElement = empty;
+	nodeType = NodeTypeStartElement;
+	return nodeType;
+}
+
+DKXmlReader::NodeType DKXmlReader::ReadEndElement()
+{
+	const char* p = pos + 2;
+	const char* nameEnd = ScanXmlName(p, end);
+	StringView n = { p, size_t(nameEnd - p) };
+	p = SkipXmlWhitespaces(nameEnd, end);
+	if (p >= end || *p != '>')
+		return SetError(ErrorSyntax, "Invalid end tag", pos);
+	if (elements.IsEmpty() || !elements.Value(elements.Count() - 1).Equals(n))
+		return SetError(ErrorSyntax, "Mismatched end tag", pos);
+	pos = p + 1;
+	name = n;
+	nodeType = NodeTypeEndElement;
+	return nodeType;
+}
+
+bool DKXmlReader::ReadRootElement()
+{
+	while (elements.IsEmpty() && !rootClosed)
+	{
+		switch (Read())
+		{
+		case NodeTypeStartElement:
+			return true;
+		case NodeTypeError:
+		case NodeTypeEndOfDocument:
+			return false;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+bool DKXmlReader::Skip()
+{
+	if (nodeType != NodeTypeStartElement)
+		return false;
+	const size_t depth = Depth();
+	while (Read() != NodeTypeError)
+	{
+		if (nodeType == NodeTypeEndElement && Depth() == depth)
+			return true;
+	}
+	return false;
+}
+
+DKXmlReader::StringView DKXmlReader::LocalName() const
+{
+	const char* colon = reinterpret_cast<const char*>(memchr(name.str, ':', name.length));
+	if (colon)
+		return { colon + 1, size_t(name.str + name.length - colon - 1) };
+	return name;
+}
+
+DKXmlReader::StringView DKXmlReader::Prefix() const
+{
+	const char* colon = reinterpret_cast<const char*>(memchr(name.str, ':', name.length));
+	if (colon)
+		return { name.str, size_t(colon - name.str) };
+	return { NULL, 0 };
+}
+
+DKXmlReader::StringView DKXmlReader::NamespaceURI() const
+{
+	StringView uri = { NULL, 0 };
+	if (nodeType == NodeTypeStartElement || nodeType == NodeTypeEndElement)
+		LookupNamespace(Prefix(), uri);
+	return uri;
+}
+
+bool DKXmlReader::LookupNamespace(const StringView& prefix, StringView& uri) const
+{
+	for (size_t i = namespaces.Count(); i > 0; --i)
+	{
+		const NamespaceView& ns = namespaces.Value(i - 1);
+		if (ns.prefix.Equals(prefix))
+		{
+			uri = ns.uri;
+			return uri.length > 0;	// xmlns="" undeclares default namespace.
+		}
+	}
+	if (prefix.Equals("xml"))
+	{
+		static const char xmlNamespace[] = "http://www.w3.org/XML/1998/namespace";
+		uri = { xmlNamespace, sizeof(xmlNamespace) - 1 };
+		return true;
+	}
+	return false;
+}
+
+DKString DKXmlReader::Value() const
+{
+	DKString str = L"";
+	AppendValue(str);
+	return str;
+}
+
+void DKXmlReader::AppendValue(DKString& str) const
+{
+	if (nodeType == NodeTypeText)
+		AppendXmlValue(str, value.str, value.length, false);
+	else if (value.length > 0)
+		str.Append((const DKUniChar8*)value.str, value.length);
+}
+
+DKXmlReader::StringView DKXmlReader::AttributeName(size_t index) const
+{
+	if (index < attributes.Count())
+		return attributes.Value(index).name;
+	return { NULL, 0 };
+}
+
+DKXmlReader::StringView DKXmlReader::AttributeLocalName(size_t index) const
+{
+	if (index < attributes.Count())
+	{
+		const StringView& n = attributes.Value(index).name;
+		const char* colon = reinterpret_cast<const char*>(memchr(n.str, ':', n.length));
+		if (colon)
+			return { colon + 1, size_t(n.str + n.length - colon - 1) };
+		return n;
+	}
+	return { NULL, 0 };
+}
+
+DKXmlReader::StringView DKXmlReader::AttributeRawValue(size_t index) const
+{
+	if (index < attributes.Count())
+		return attributes.Value(index).value;
+	return { NULL, 0 };
+}
+
+DKString DKXmlReader::AttributeValue(size_t index) const
+{
+	DKString str = L"";
+	if (index < attributes.Count())
+	{
+		const StringView& v = attributes.Value(index).value;
+		AppendXmlValue(str, v.str, v.length, true);
+	}
+	return str;
+}
+
+size_t DKXmlReader::FindAttribute(const char* localName) const
+{
+	for (size_t i = 0; i < attributes.Count(); ++i)
+	{
+		if (AttributeLocalName(i).EqualsNoCase(localName))
+			return i;
+	}
+	return attributes.Count();
+}
+
+DKObject<DKXmlElement> DKXmlReader::ReadElement()
+{
+	if (nodeType != NodeTypeStartElement)
+		return NULL;
+
+	DKArray<DKXmlElement*> stack;
+	auto findNamespace = [this, &stack](const StringView& prefix) -> DKObject<DKXmlNamespace>
+	{
+		StringView uri;
+		if (!LookupNamespace(prefix, uri))
+			return NULL;
+		for (size_t i = stack.Count(); i > 0; --i)
+		{
+			for (DKXmlNamespace& ns : stack.Value(i - 1)->namespaces)
+			{
+				if (ns.prefix.Compare(prefix.ToString()) == 0 && ns.URI.Compare(uri.ToString()) == 0)
+					return &ns;
+			}
+		}
+		// declared in parent element which is not in this DOM.
+		DKObject<DKXmlNamespace> ns = DKObject<DKXmlNamespace>::New();
+		ns->prefix = prefix.ToString();
+		ns->URI = uri.ToString();
+		return ns;
+	};
+	auto startElement = [&]() -> DKObject<DKXmlElement>
+	{
+		DKObject<DKXmlElement> e = DKObject<DKXmlElement>::New();
+		e->name = LocalName().ToString();
+		const size_t depth = Depth();
+		for (const NamespaceView& nsv : namespaces)
+		{
+			if (nsv.depth == depth)
+			{
+				DKXmlNamespace ns = { nsv.prefix.ToString(), nsv.uri.ToString() };
+				e->namespaces.Add(ns);
+			}
+		}
+		stack.Add(e);
+		e->attributes.Reserve(attributes.Count());
+		for (size_t i = 0; i < attributes.Count(); ++i)
+		{
+			DKXmlAttribute attr;
+			attr.name = AttributeLocalName(i).ToString();
+			attr.value = AttributeValue(i);
+			const StringView& n = attributes.Value(i).name;
+			const char* colon = reinterpret_cast<const char*>(memchr(n.str, ':', n.length));
+			if (colon)
+				attr.ns = findNamespace({ n.str, size_t(colon - n.str) });
+			e->attributes.Add(attr);
+		}
+		e->ns = findNamespace(Prefix());
+		return e;
+	};
+
+	DKObject<DKXmlElement> root = startElement();
+	while (stack.Count() > 0)
+	{
+		DKXmlElement* parent = stack.Value(stack.Count() - 1);
+		switch (Read())
+		{
+		case NodeTypeStartElement:
+			parent->nodes.Add(startElement().SafeCast<DKXmlNode>());
+			break;
+		case NodeTypeEndElement:
+			stack.Remove(stack.Count() - 1);
+			break;
+		case NodeTypeText:
+			{
+				DKObject<DKXmlPCData> pcdata = DKObject<DKXmlPCData>::New();
+				AppendValue(pcdata->value);
+				parent->nodes.Add(pcdata.SafeCast<DKXmlNode>());
+			}
+			break;
+		case NodeTypeCData:
+			{
+				DKObject<DKXmlCData> cdata = DKObject<DKXmlCData>::New();
+				cdata->value.SetValue((const DKUniChar8*)value.str, value.length);
+				parent->nodes.Add(cdata.SafeCast<DKXmlNode>());
+			}
+			break;
+		case NodeTypeComment:
+			{
+				DKObject<DKXmlComment> comment = DKObject<DKXmlComment>::New();
+				comment->value = value.ToString();
+				parent->nodes.Add(comment.SafeCast<DKXmlNode>());
+			}
+			break;
+		case NodeTypeInstruction:
+			{
+				DKObject<DKXmlInstruction> ins = DKObject<DKXmlInstruction>::New();
+				ins->target = name.ToString();
+				ins->data = value.ToString();
+				parent->nodes.Add(ins.SafeCast<DKXmlNode>());
+			}
+			break;
+		case NodeTypeError:
+			return NULL;
+		default:
+			break;
+		}
+	}
+	return root;
+}
@@ -0,0 +1,197 @@
+//
+//  File: DKXmlReader.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKInclude.h"
+#include "DKObject.h"
+#include "DKString.h"
+#include "DKData.h"
+#include "DKStream.h"
+#include "DKArray.h"
+#include "DKXmlDocument.h"
+
+namespace DKFoundation
+{
+	/**
+	 @brief
+	 A pull-style XML reader, reads nodes in document order without building DOM.
+
+	 Names and values are returned as views into source data (UTF-8),
+	 entities are decoded only when value is requested.
+	 Source file is mapped into memory with DKFileMap.
+
+	 @code
+	  DKObject<DKXmlReader> reader = DKXmlReader::Open(L"scene.xml");
+	  while (reader->Read() != DKXmlReader::NodeTypeStartElement) // root
+	      ...
+	  reader->EnumerateChildNodes([](DKXmlReader& r)
+	  {
+	      if (r.CurrentNodeType() == DKXmlReader::NodeTypeStartElement && r.Name().Equals("Item"))
+	          DKString key = r.AttributeValue(r.FindAttribute("key"));
+	  });
+	 @endcode
+
+	 @note
+	  Only UTF-8 (or ASCII) document is supported, entities declared in DTD
+	  are not supported. Read() returns NodeTypeError with ErrorUnsupported
+	  for these documents, use DKXmlDocument instead.
+	  Empty element (<Item/>) is reported as StartElement and EndElement.
+	  Views are valid while reader is alive.
+	 */
+	class DKGL_API DKXmlReader
+	{
+	public:
+		/// UTF-8 string in source data. (not null-terminated)
+		struct StringView
+		{
+			const char* str;
+			size_t length;
+
+			bool IsEmpty() const						{ return length == 0; }
+			bool Equals(const char* s) const;
+			bool EqualsNoCase(const char* s) const;		///< ASCII case insensitive
+			bool Equals(const StringView& s) const;
+			DKString ToString() const;
+		};
+		enum NodeType
+		{
+			NodeTypeNone = 0,		///< Read() is not called yet.
+			NodeTypeStartElement,
+			NodeTypeEndElement,
+			NodeTypeText,			///< Parsed Character Data, includes whitespaces.
+			NodeTypeCData,
+			NodeTypeComment,
+			NodeTypeInstruction,
+			NodeTypeDocTypeDecl,
+			NodeTypeEndOfDocument,
+			NodeTypeError,
+		};
+		enum ErrorType
+		{
+			ErrorNone = 0,
+			ErrorSyntax,			///< malformed document
+			ErrorUnsupported,		///< encoding or DTD entity is not supported.
+		};
+
+		~DKXmlReader();
+
+		/// map file into memory and open.
+		static DKObject<DKXmlReader> Open(const DKString& file);
+		/// open data, managed data is retained. unmanaged data is copied.
+		static DKObject<DKXmlReader> Open(const DKData* data);
+		static DKObject<DKXmlReader> Open(DKStream* stream);
+
+		/// move to next node.
+		NodeType Read();
+		/// move to StartElement of root element, from beginning of document.
+		bool ReadRootElement();
+		/// skip to end of current element, returns false if error occurred.
+		/// reader should be on StartElement, moves to matching EndElement.
+		bool Skip();
+		/// build DOM of current element and move to matching EndElement.
+		DKObject<DKXmlElement> ReadElement();
+		/// call function with each child node of current element, and move to
+		/// matching EndElement. function can consume child element. (Skip, ReadElement)
+		/// returns false if error occurred.
+		template <typename Fn> bool EnumerateChildNodes(Fn&& fn)
+		{
+			if (nodeType != NodeTypeStartElement)
+				return false;
+			const size_t depth = Depth();
+			while (true)
+			{
+				switch (Read())
+				{
+				case NodeTypeEndElement:
+					if (Depth() == depth)
+						return true;
+					break;
+				case NodeTypeError:
+				case NodeTypeEndOfDocument:
+					return false;
+				default:
+					if (Depth() == depth + 1)	// nodes of child element are ignored.
+						fn(*this);
+					break;
+				}
+			}
+			return false;
+		}
+
+		NodeType CurrentNodeType() const		{ return nodeType; }
+		ErrorType Error() const					{ return error; }
+		DKString ErrorDescription() const;
+		/// number of opened elements, StartElement of root element is 0.
+		size_t Depth() const;
+
+		/// qualified name of element, target of instruction, name of DTD.
+		StringView Name() const					{ return name; }
+		StringView LocalName() const;
+		StringView Prefix() const;
+		StringView NamespaceURI() const;
+
+		/// raw value of Text, CData, Comment, Instruction.
+		StringView RawValue() const				{ return value; }
+		/// value with entities decoded.
+		DKString Value() const;
+		/// append Text or CData value to string. (entities decoded)
+		void AppendValue(DKString& str) const;
+
+		size_t NumberOfAttributes() const		{ return attributes.Count(); }
+		StringView AttributeName(size_t index) const;
+		StringView AttributeLocalName(size_t index) const;
+		StringView AttributeRawValue(size_t index) const;
+		DKString AttributeValue(size_t index) const;
+		/// find attribute with local name (case insensitive),
+		/// returns NumberOfAttributes() if not found.
+		size_t FindAttribute(const char* localName) const;
+
+		/// namespace URI of prefix in current scope.
+		bool LookupNamespace(const StringView& prefix, StringView& uri) const;
+
+	private:
+		DKXmlReader(DKData* source);
+
+		struct AttributeView
+		{
+			StringView name;
+			StringView value;
+		};
+		struct NamespaceView
+		{
+			StringView prefix;
+			StringView uri;
+			size_t depth;
+		};
+		NodeType SetError(ErrorType e, const char* mesg, const char* at);
+		bool ReadDeclaration();
+		NodeType ReadMarkup();
+		NodeType ReadStartElement();
+		NodeType ReadEndElement();
+
+		DKObject<DKData> source;	// kept locked while reader alive.
+		const char* begin;
+		const char* end;
+		const char* pos;
+
+		NodeType nodeType;
+		ErrorType error;
+		const char* errorMessage;
+		const char* errorPosition;
+
+		StringView name;
+		StringView value;
+		DKArray<AttributeView> attributes;
+		DKArray<StringView> elements;		// opened elements
+		DKArray<NamespaceView> namespaces;	// declared namespaces in scope
+		bool emptyElement;					// <Item/>, EndElement is pending.
+		bool rootClosed;
+
+		DKXmlReader(const DKXmlReader&) = delete;
+		DKXmlReader& operator = (const DKXmlReader&) = delete;
+	};
+}
@@ -65,6 +65,7 @@ namespace DKFramework {}
 #include "DKFramework/DKMatrix4.h"
 #include "DKFramework/DKModel.h"
 #include "DKFramework/DKMultiSphereShape.h"
+#include "DKFramework/DKPackedVariant.h"
 #include "DKFramework/DKPlane.h"
 #include "DKFramework/DKPoint.h"
 #include "DKFramework/DKPoint2PointConstraint.h"
@@ -158,6 +158,11 @@ bool DKAnimation::GetNodeTransform(const DKString& name, float t, DKTransformUni
 	return GetNodeTransform(IndexOfNode(name), t, output);
 }
 
+bool DKAnimation::GetNodeTransform(const DKAtom& name, float t, DKTransformUnit& output) const
+{
+	return GetNodeTransform(IndexOfNode(name), t, output);
+}
+
 void DKAnimation::SetDuration(float d)
 {
 	if (d > 0)
@@ -236,7 +241,7 @@ bool DKAnimation::AddNode(const Node* node)
 	if (node == NULL)
 		return false;
 
-	if (nodeIndexMap.Find(node->name))
+	if (nodeIndexMap.Find(DKAtom::Lookup(node->name)))
 		return false;
 
 	if (node->IsEmpty())
@@ -261,14 +266,15 @@ bool DKAnimation::AddNode(const Node* node)
 
 bool DKAnimation::AddSamplingNode(const DKString& name, const DKTransformUnit* frames, size_t numFrames)
 {
-	if (nodeIndexMap.Find(name))
+	DKAtom key(name);
+	if (nodeIndexMap.Find(key))
 		return false;
 	if (frames && numFrames > 0)
 	{
 		SamplingNode* node = new SamplingNode();
 		node->name = name;
 		node->frames.Add(frames, numFrames);
-		nodeIndexMap.Update(node->name, nodes.Add(node)); // add new node, and update indexes.
+		nodeIndexMap.Update(key, nodes.Add(node)); // add new node, and update indexes.
 		return true;
 	}
 	return false;
@@ -279,7 +285,8 @@ bool DKAnimation::AddKeyframeNode(const DKString& name,
 								  const KeyframeNode::RotationKey* rotationKeys, size_t numRk,
 								  const KeyframeNode::TranslationKey* translationKeys, size_t numTk)
 {
-	if (nodeIndexMap.Find(name))
+	DKAtom key(name);
+	if (nodeIndexMap.Find(key))
 		return false;
 	if ((scaleKeys && numSk > 0) || (rotationKeys && numRk > 0) || (translationKeys && numTk > 0))
 	{
@@ -293,7 +300,7 @@ bool DKAnimation::AddKeyframeNode(const DKString& name,
 
 		if (!node->IsEmpty())
 		{
-			nodeIndexMap.Update(node->name, nodes.Add(node));
+			nodeIndexMap.Update(key, nodes.Add(node));
 			return true;
 		}
 		node->~KeyframeNode();
@@ -304,7 +311,11 @@ bool DKAnimation::AddKeyframeNode(const DKString& name,
 
 void DKAnimation::RemoveNode(const DKString& name)
 {
-	DKMap<DKString, size_t>::Pair* indexPtr = nodeIndexMap.Find(name);
+	DKAtom key = DKAtom::Lookup(name);
+	if (key.IsNull() && name.Length() > 0)
+		return;		// not interned, node not exists.
+
+	decltype(nodeIndexMap)::Pair* indexPtr = nodeIndexMap.Find(key);
 	if (indexPtr)
 	{
 		size_t index = indexPtr->value;
@@ -312,7 +323,7 @@ void DKAnimation::RemoveNode(const DKString& name)
 		nodes.Remove(index);
 		delete n;
 	}
-	nodeIndexMap.Remove(name);
+	nodeIndexMap.Remove(key);
 }
 
 void DKAnimation::RemoveAllNodes()
@@ -333,7 +344,15 @@ size_t DKAnimation::NodeCount() const
 
 DKAnimation::NodeIndex DKAnimation::IndexOfNode(const DKString& name) const
 {
-	const DKMap<DKString, size_t>::Pair* indexPtr = nodeIndexMap.Find(name);
+	DKAtom key = DKAtom::Lookup(name);
+	if (key.IsNull() && name.Length() > 0)
+		return invalidNodeIndex;	// not interned, node not exists.
+	return IndexOfNode(key);
+}
+
+DKAnimation::NodeIndex DKAnimation::IndexOfNode(const DKAtom& name) const
+{
+	const decltype(nodeIndexMap)::Pair* indexPtr = nodeIndexMap.Find(name);
 	if (indexPtr)
 		return indexPtr->value;
 	return invalidNodeIndex;
@@ -91,12 +91,15 @@ namespace DKFramework
 		void		RemoveAllNodes();
 		size_t		NodeCount() const;
 		NodeIndex	IndexOfNode(const DKString& name) const;
+		NodeIndex	IndexOfNode(const DKAtom& name) const;
 		const Node*	NodeAtIndex(NodeIndex index) const;
 
 		/// calculate transform at time ( 0.0 <= t <= 1.0 )
 		bool GetNodeTransform(NodeIndex index, float t, DKTransformUnit& output) const;
 		/// calculate transform at time ( 0.0 <= t <= 1.0 )
 		bool GetNodeTransform(const DKString& name, float t, DKTransformUnit& output) const;
+		/// calculate transform at time ( 0.0 <= t <= 1.0 )
+		bool GetNodeTransform(const DKAtom& name, float t, DKTransformUnit& output) const;
 
 		/// generate snap-shot.
 		/// snap-shot can be combined with other animation object. (interpolated altogether)
@@ -126,7 +129,7 @@ namespace DKFramework
 	private:
 		float	duration;
 
-		DKMap<DKString, size_t> nodeIndexMap; // for fast search
+		DKHashMap<DKAtom, size_t> nodeIndexMap; // for fast search
 		DKArray<Node*>	nodes;
 	};
 }
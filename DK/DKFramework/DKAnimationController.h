@@ -17,7 +17,7 @@ namespace DKFramework
 	class DKGL_API DKAnimatedTransform
 	{
 	public:
-		typedef DKString NodeId;
+		typedef DKAtom NodeId;
 		virtual ~DKAnimatedTransform() {}
 		virtual void Update(double timeDelta, DKTimeTick tick) {}
 		virtual bool GetTransform(const NodeId& key, DKTransformUnit& out) = 0;
@@ -156,17 +156,22 @@ void DKDynamicsScene::Update(double tickDelta, DKTimeTick tick)
 
 	PrepareUpdateNode();
 
-	if (dynamicsFixedFPS > 0.001)	// fixed frame rate for calculate physics (frame per second)
+	if (true)
 	{
-		const double fixedTimeStep = 1.0 / dynamicsFixedFPS;
-		int maxSubStep = ceil(tickDelta * dynamicsFixedFPS) + 1;
-		DKASSERT_DEBUG( maxSubStep > 0 );
-		DKASSERT_DEBUG( tickDelta < maxSubStep * fixedTimeStep );
-		static_cast<btDiscreteDynamicsWorld*>(context->world)->stepSimulation(tickDelta, maxSubStep, fixedTimeStep);
-	}
-	else
-	{
-		static_cast<btDiscreteDynamicsWorld*>(context->world)->stepSimulation(tickDelta);
+		DKPROFILE_SCOPE("DKDynamicsScene::StepSimulation");
+
+		if (dynamicsFixedFPS > 0.001)	// fixed frame rate for calculate physics (frame per second)
+		{
+			const double fixedTimeStep = 1.0 / dynamicsFixedFPS;
+			int maxSubStep = ceil(tickDelta * dynamicsFixedFPS) + 1;
+			DKASSERT_DEBUG( maxSubStep > 0 );
+			DKASSERT_DEBUG( tickDelta < maxSubStep * fixedTimeStep );
+			static_cast<btDiscreteDynamicsWorld*>(context->world)->stepSimulation(tickDelta, maxSubStep, fixedTimeStep);
+		}
+		else
+		{
+			static_cast<btDiscreteDynamicsWorld*>(context->world)->stepSimulation(tickDelta);
+		}
 	}
 
 	UpdateObjectSceneStates();
@@ -131,7 +131,20 @@ size_t DKModel::NumberOfDescendants() const
 
 DKModel* DKModel::FindDescendant(const DKString& name)
 {
-	if (Name() == name)
+	DKAtom atom = DKAtom::Lookup(name);
+	if (atom.IsNull() && name.Length() > 0)
+		return NULL;	// not interned, no object has this name.
+	return FindDescendant(atom);
+}
+
+const DKModel* DKModel::FindDescendant(const DKString& name) const
+{
+	return const_cast<DKModel&>(*this).FindDescendant(name);
+}
+
+DKModel* DKModel::FindDescendant(const DKAtom& name)
+{
+	if (NameAtom() == name)
 		return this;
 	for (DKModel* obj : children)
 	{
@@ -142,7 +155,7 @@ DKModel* DKModel::FindDescendant(const DKString& name)
 	return NULL;
 }
 
-const DKModel* DKModel::FindDescendant(const DKString& name) const
+const DKModel* DKModel::FindDescendant(const DKAtom& name) const
 {
 	return const_cast<DKModel&>(*this).FindDescendant(name);
 }
@@ -287,8 +300,9 @@ void DKModel::SetLocalTransform(const DKNSTransform& t)
 
 void DKModel::CreateNamedObjectMap(NamedObjectMap& map)
 {
-	if (Name().Length() > 0)
-		map.Insert(Name(), this);
+	DKAtom name = NameAtom();
+	if (!name.IsNull())
+		map.Insert(name, this);
 
 	for (DKModel* c : children)
 		c->CreateNamedObjectMap(map);
@@ -352,7 +366,7 @@ void DKModel::OnUpdateKinematic(double timeDelta, DKTimeTick tick)
 	{
 		this->animation->Update(timeDelta, tick);
 		DKTransformUnit tu;
-		if (this->animation->GetTransform(this->Name(), tu))
+		if (this->animation->GetTransform(this->NameAtom(), tu))
 		{
 			DKNSTransform trans = DKNSTransform(tu.rotation, tu.translation);
 			this->SetLocalTransform(trans);
@@ -39,7 +39,7 @@ namespace DKFramework
 			TypeConstraint,
 			TypeAction,
 		};
-		using NamedObjectMap = DKMap<DKString, DKModel*>;
+		using NamedObjectMap = DKHashMap<DKAtom, DKModel*>;
 		using UUIDObjectMap = DKMap<DKUuid, DKModel*>;
 
 		using Enumerator = DKFunctionSignature<bool(DKModel*)>;
@@ -69,6 +69,8 @@ namespace DKFramework
 		size_t NumberOfDescendants() const;
 		DKModel* FindDescendant(const DKString&);
 		const DKModel* FindDescendant(const DKString&) const;
+		DKModel* FindDescendant(const DKAtom&);
+		const DKModel* FindDescendant(const DKAtom&) const;
 		DKModel* FindCommonAncestor(DKModel*, DKModel*, Type t = TypeCustom);
 
 		DKModel* ChildAtIndex(unsigned int i)					{ return children.Value(i); }
@@ -0,0 +1,805 @@
+//
+//  File: DKPackedVariant.cpp
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#include <string.h>
+#include "DKPackedVariant.h"
+
+// Packed variant format (little-endian, nodes are 4 bytes aligned)
+//
+//  Header: "DKVPak"(6), version(uint16), root-offset(uint32), length(uint32)
+//  Node: type(uint32, DKVariant::Type), payload
+//   Integer, Float: 8 bytes
+//   Vector, Matrix, Quaternion: float x N
+//   RationalNumber: numerator(int64), denominator(int64)
+//   String: length(uint32), UTF-8 bytes, null
+//   DateTime: seconds(uint64), microseconds(uint32)
+//   Data: length(uint32), bytes
+//   StructData: element-size(uint32), num-layouts(uint32), length(uint32),
+//               layouts, (align 4), bytes
+//   Array: count(uint32), node-offset(uint32) x count
+//   Pairs: count(uint32), (key-offset(uint32), node-offset(uint32)) x count
+//          sorted by key (UTF-8 bytes order)
+//   Key: length(uint32), UTF-8 bytes, null (shared by pairs)
+
+#define DKPACKEDVARIANT_MAGIC			"DKVPak"
+#define DKPACKEDVARIANT_MAGIC_LENGTH	6
+#define DKPACKEDVARIANT_VERSION			1
+#define DKPACKEDVARIANT_HEADER_SIZE		16
+#define DKPACKEDVARIANT_KEY_PATH_DELIMITER	'.'
+
+namespace DKFramework
+{
+	namespace Private
+	{
+		FORCEINLINE uint32_t ReadPackedUInt32(const uint8_t* p)
+		{
+			uint32_t v;
+			memcpy(&v, p, sizeof(v));
+			return DKLittleEndianToSystem(v);
+		}
+		FORCEINLINE uint64_t ReadPackedUInt64(const uint8_t* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, sizeof(v));
+			return DKLittleEndianToSystem(v);
+		}
+		FORCEINLINE void ReadPackedFloats(const uint8_t* p, float* out, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint32_t v = ReadPackedUInt32(&p[i * 4]);
+				memcpy(&out[i], &v, sizeof(float));
+			}
+		}
+		FORCEINLINE int ComparePackedKey(const char* k1, size_t len1, const char* k2, size_t len2)
+		{
+			int r = memcmp(k1, k2, Min(len1, len2));
+			if (r == 0)
+				return (len1 < len2) ? -1 : (len1 > len2 ? 1 : 0);
+			return r;
+		}
+		/// convert byte-order of arithmetic fields of structured data.
+		static void SwapStructuredDataByteOrder(uint8_t* p, size_t length, size_t elementSize, const DKVariant::StructElem* layout, size_t numLayouts)
+		{
+			for (size_t pos = 0; pos + elementSize <= length; pos += elementSize)
+			{
+				uint8_t* field = &p[pos];
+				size_t n = 0;
+				for (size_t i = 0; i < numLayouts; ++i)
+				{
+					uint8_t e = static_cast<uint8_t>(layout[i]);
+					uint8_t fieldSize = e & 0x0f;
+					if (n + fieldSize > elementSize)
+						break;
+					if ((e & 0xf0) == 0)
+					{
+						for (size_t k = 0; k < fieldSize / 2; ++k)
+						{
+							uint8_t t = field[k];
+							field[k] = field[fieldSize - k - 1];
+							field[fieldSize - k - 1] = t;
+						}
+					}
+					field += fieldSize;
+					n += fieldSize;
+				}
+			}
+		}
+
+		struct PackedVariantEncoder
+		{
+			DKArray<uint8_t> output;
+			DKMap<DKString, uint32_t> keys;	// shared keys
+			bool failed = false;
+
+			uint32_t Offset() const
+			{
+				return static_cast<uint32_t>(output.Count());
+			}
+			void Write(const void* p, size_t s)
+			{
+				output.Add(reinterpret_cast<const uint8_t*>(p), s);
+			}
+			void WriteUInt32(uint32_t v)
+			{
+				v = DKSystemToLittleEndian(v);
+				Write(&v, sizeof(v));
+			}
+			void WriteUInt64(uint64_t v)
+			{
+				v = DKSystemToLittleEndian(v);
+				Write(&v, sizeof(v));
+			}
+			void WriteFloats(const float* v, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					uint32_t n;
+					memcpy(&n, &v[i], sizeof(float));
+					WriteUInt32(n);
+				}
+			}
+			void Align4()
+			{
+				size_t pad = (4 - (output.Count() & 3)) & 3;
+				if (pad)
+					output.Add(uint8_t(0), pad);
+			}
+			uint32_t BeginNode(DKVariant::Type t)
+			{
+				Align4();
+				uint32_t offset = Offset();
+				WriteUInt32(static_cast<uint32_t>(t));
+				return offset;
+			}
+			void WriteString(const DKStringU8& str)
+			{
+				uint32_t len = static_cast<uint32_t>(str.Bytes());
+				WriteUInt32(len);
+				Write((const char*)str, len);
+				output.Add(uint8_t(0));
+			}
+			uint32_t Key(const DKString& key)
+			{
+				auto p = keys.Find(key);
+				if (p)
+					return p->value;
+				Align4();
+				uint32_t offset = Offset();
+				WriteString(DKStringU8(key));
+				keys.Insert(key, offset);
+				return offset;
+			}
+
+			// write children first, returns offset of node.
+			uint32_t Encode(const DKVariant& v)
+			{
+				if (failed)
+					return 0;
+
+				uint32_t offset = 0;
+				switch (v.ValueType())
+				{
+				case DKVariant::TypeInteger:
+					offset = BeginNode(DKVariant::TypeInteger);
+					WriteUInt64(static_cast<uint64_t>(v.Integer()));
+					break;
+				case DKVariant::TypeFloat:
+					{
+						DKVariant::VFloat f = v.Float();
+						uint64_t n;
+						memcpy(&n, &f, sizeof(n));
+						offset = BeginNode(DKVariant::TypeFloat);
+						WriteUInt64(n);
+					}
+					break;
+				case DKVariant::TypeVector2:
+					offset = BeginNode(DKVariant::TypeVector2);
+					WriteFloats(v.Vector2().val, 2);
+					break;
+				case DKVariant::TypeVector3:
+					offset = BeginNode(DKVariant::TypeVector3);
+					WriteFloats(v.Vector3().val, 3);
+					break;
+				case DKVariant::TypeVector4:
+					offset = BeginNode(DKVariant::TypeVector4);
+					WriteFloats(v.Vector4().val, 4);
+					break;
+				case DKVariant::TypeMatrix2:
+					offset = BeginNode(DKVariant::TypeMatrix2);
+					WriteFloats(v.Matrix2().val, 4);
+					break;
+				case DKVariant::TypeMatrix3:
+					offset = BeginNode(DKVariant::TypeMatrix3);
+					WriteFloats(v.Matrix3().val, 9);
+					break;
+				case DKVariant::TypeMatrix4:
+					offset = BeginNode(DKVariant::TypeMatrix4);
+					WriteFloats(v.Matrix4().val, 16);
+					break;
+				case DKVariant::TypeQuaternion:
+					offset = BeginNode(DKVariant::TypeQuaternion);
+					WriteFloats(v.Quaternion().val, 4);
+					break;
+				case DKVariant::TypeRationalNumber:
+					offset = BeginNode(DKVariant::TypeRationalNumber);
+					WriteUInt64(static_cast<uint64_t>(v.RationalNumber().Numerator()));
+					WriteUInt64(static_cast<uint64_t>(v.RationalNumber().Denominator()));
+					break;
+				case DKVariant::TypeString:
+					offset = BeginNode(DKVariant::TypeString);
+					WriteString(DKStringU8(v.String()));
+					break;
+				case DKVariant::TypeDateTime:
+					offset = BeginNode(DKVariant::TypeDateTime);
+					WriteUInt64(static_cast<uint64_t>(v.DateTime().SecondsSinceEpoch()));
+					WriteUInt32(static_cast<uint32_t>(v.DateTime().Microsecond()));
+					break;
+				case DKVariant::TypeData:
+					{
+						const DKVariant::VData& data = v.Data();
+						size_t len = data.Length();
+						if (len > 0xffffffffULL)
+						{
+							failed = true;
+							return 0;
+						}
+						offset = BeginNode(DKVariant::TypeData);
+						WriteUInt32(static_cast<uint32_t>(len));
+						if (len > 0)
+						{
+							Write(data.LockShared(), len);
+							data.UnlockShared();
+						}
+					}
+					break;
+				case DKVariant::TypeStructData:
+					{
+						const DKVariant::VStructuredData& stData = v.StructuredData();
+						size_t len = stData.data ? stData.data->Length() : 0;
+						size_t numLayouts = stData.layout.Count();
+						if (len > 0xffffffffULL || stData.elementSize > 0xffffffffULL)
+						{
+							failed = true;
+							return 0;
+						}
+						offset = BeginNode(DKVariant::TypeStructData);
+						WriteUInt32(static_cast<uint32_t>(stData.elementSize));
+						WriteUInt32(static_cast<uint32_t>(numLayouts));
+						WriteUInt32(static_cast<uint32_t>(len));
+						Write((const DKVariant::StructElem*)stData.layout, numLayouts);
+						Align4();
+						if (len > 0)
+						{
+							size_t pos = output.Count();
+							Write(stData.data->LockShared(), len);
+							stData.data->UnlockShared();
+							if (DKRuntimeByteOrder() != DKByteOrder::LittleEndian)
+								SwapStructuredDataByteOrder(&((uint8_t*)output)[pos], len, stData.elementSize, stData.layout, numLayouts);
+						}
+					}
+					break;
+				case DKVariant::TypeArray:
+					{
+						const DKVariant::VArray& a = v.Array();
+						DKVariant::VArray::CriticalSection guard(a.lock);
+						DKArray<uint32_t> nodes;
+						nodes.Reserve(a.Count());
+						for (const DKVariant& e : a)
+						{
+							nodes.Add(Encode(e));
+							if (failed)
+								return 0;
+						}
+						offset = BeginNode(DKVariant::TypeArray);
+						WriteUInt32(static_cast<uint32_t>(nodes.Count()));
+						for (uint32_t n : nodes)
+							WriteUInt32(n);
+					}
+					break;
+				case DKVariant::TypePairs:
+					{
+						struct Entry
+						{
+							DKStringU8 key;
+							uint32_t keyOffset;
+							uint32_t nodeOffset;
+						};
+						DKArray<Entry> entries;
+						const DKVariant::VPairs& pairs = v.Pairs();
+						DKVariant::VPairs::CriticalSection guard(pairs.lock);
+						entries.Reserve(pairs.Count());
+						pairs.EnumerateForward([&](const DKVariant::VPairs::Pair& pair)
+						{
+							if (failed)
+								return;
+							uint32_t keyOffset = Key(pair.key);
+							uint32_t nodeOffset = Encode(pair.value);
+							entries.Add(Entry{ DKStringU8(pair.key), keyOffset, nodeOffset });
+						});
+						if (failed)
+							return 0;
+						entries.Sort([](const Entry& lhs, const Entry& rhs)
+						{
+							return ComparePackedKey(lhs.key, lhs.key.Bytes(), rhs.key, rhs.key.Bytes()) < 0;
+						});
+						offset = BeginNode(DKVariant::TypePairs);
+						WriteUInt32(static_cast<uint32_t>(entries.Count()));
+						for (const Entry& e : entries)
+						{
+							WriteUInt32(e.keyOffset);
+							WriteUInt32(e.nodeOffset);
+						}
+					}
+					break;
+				default:
+					offset = BeginNode(DKVariant::TypeUndefined);
+					break;
+				}
+				if (output.Count() > 0xffffffffULL)
+				{
+					failed = true;
+					return 0;
+				}
+				return offset;
+			}
+
+			bool Pack(const DKVariant& v)
+			{
+				output.Clear();
+				keys.Clear();
+				failed = false;
+
+				output.Add(uint8_t(0), DKPACKEDVARIANT_HEADER_SIZE);
+				uint32_t root = Encode(v);
+				if (failed)
+				{
+					DKLog("DKPackedVariant Error: data too large.\n");
+					return false;
+				}
+
+				uint8_t* header = output;
+				memcpy(header, DKPACKEDVARIANT_MAGIC, DKPACKEDVARIANT_MAGIC_LENGTH);
+				uint16_t version = DKSystemToLittleEndian(uint16_t(DKPACKEDVARIANT_VERSION));
+				uint32_t rootOffset = DKSystemToLittleEndian(root);
+				uint32_t length = DKSystemToLittleEndian(Offset());
+				memcpy(&header[6], &version, sizeof(version));
+				memcpy(&header[8], &rootOffset, sizeof(rootOffset));
+				memcpy(&header[12], &length, sizeof(length));
+				return true;
+			}
+		};
+	}
+}
+
+using namespace DKFramework;
+using namespace DKFramework::Private;
+
+DKPackedVariant::DKPackedVariant(DKData* data)
+	: source(data)
+	, bytes(NULL)
+	, length(0)
+{
+	bytes = reinterpret_cast<const uint8_t*>(source->LockShared());
+	length = source->Length();
+}
+
+DKPackedVariant::~DKPackedVariant()
+{
+	source->UnlockShared();
+}
+
+DKObject<DKBuffer> DKPackedVariant::Pack(const DKVariant& v, DKAllocator& alloc)
+{
+	PackedVariantEncoder encoder;
+	if (encoder.Pack(v))
+		return DKBuffer::Create((uint8_t*)encoder.output, encoder.output.Count(), alloc);
+	return NULL;
+}
+
+bool DKPackedVariant::Pack(const DKVariant& v, DKStream* stream)
+{
+	if (stream && stream->IsWritable())
+	{
+		PackedVariantEncoder encoder;
+		if (encoder.Pack(v))
+		{
+			size_t len = encoder.output.Count();
+			return stream->Write((uint8_t*)encoder.output, len) == len;
+		}
+	}
+	return false;
+}
+
+DKObject<DKPackedVariant> DKPackedVariant::Open(const DKString& file)
+{
+	DKObject<DKFileMap> map = DKFileMap::Open(file, 0, false);
+	if (map)
+		return Open(map.SafeCast<DKData>());
+	return NULL;
+}
+
+DKObject<DKPackedVariant> DKPackedVariant::Open(const DKData* data)
+{
+	if (data == NULL || !data->IsReadable())
+		return NULL;
+
+	bool valid = IsPackedData(data->LockShared(), data->Length());
+	data->UnlockShared();
+	if (!valid)
+		return NULL;
+
+	DKObject<DKData> source = const_cast<DKData*>(data);
+	if (!source.IsManaged())
+		source = DKBuffer::Create(data).SafeCast<DKData>();
+	if (source)
+		return DKOBJECT_NEW DKPackedVariant(source);
+	return NULL;
+}
+
+bool DKPackedVariant::IsPackedData(const void* p, size_t length)
+{
+	if (p && length >= DKPACKEDVARIANT_HEADER_SIZE)
+	{
+		const uint8_t* header = reinterpret_cast<const uint8_t*>(p);
+		if (memcmp(header, DKPACKEDVARIANT_MAGIC, DKPACKEDVARIANT_MAGIC_LENGTH) == 0)
+		{
+			uint16_t version;
+			memcpy(&version, &header[6], sizeof(version));
+			uint32_t root = ReadPackedUInt32(&header[8]);
+			uint32_t len = ReadPackedUInt32(&header[12]);
+			return DKLittleEndianToSystem(version) <= DKPACKEDVARIANT_VERSION &&
+				len <= length &&
+				(root & 3) == 0 &&
+				root >= DKPACKEDVARIANT_HEADER_SIZE &&
+				size_t(root) + 4 <= len;
+		}
+	}
+	return false;
+}
+
+DKPackedVariant::Value DKPackedVariant::Root() const
+{
+	return Value(this, ReadPackedUInt32(&bytes[8]));
+}
+
+const uint8_t* DKPackedVariant::Value::Payload(size_t size) const
+{
+	if (pack)
+	{
+		size_t begin = size_t(offset) + 4;
+		if (begin + size <= pack->length)
+			return &pack->bytes[begin];
+	}
+	return NULL;
+}
+
+DKVariant::Type DKPackedVariant::Value::ValueType() const
+{
+	if (pack)
+		return static_cast<DKVariant::Type>(ReadPackedUInt32(&pack->bytes[offset]));
+	return DKVariant::TypeUndefined;
+}
+
+DKVariant::VInteger DKPackedVariant::Value::Integer() const
+{
+	if (ValueType() == DKVariant::TypeInteger)
+	{
+		if (const uint8_t* p = Payload(8))
+			return static_cast<DKVariant::VInteger>(ReadPackedUInt64(p));
+	}
+	return 0;
+}
+
+DKVariant::VFloat DKPackedVariant::Value::Float() const
+{
+	if (ValueType() == DKVariant::TypeFloat)
+	{
+		if (const uint8_t* p = Payload(8))
+		{
+			uint64_t n = ReadPackedUInt64(p);
+			DKVariant::VFloat f;
+			memcpy(&f, &n, sizeof(f));
+			return f;
+		}
+	}
+	return 0.0;
+}
+
+#define DKPACKEDVARIANT_FLOATS_ACCESSOR(name, count)					\
+DKVariant::V##name DKPackedVariant::Value::name() const					\
+{																		\
+	DKVariant::V##name value;											\
+	if (ValueType() == DKVariant::Type##name)							\
+	{																	\
+		if (const uint8_t* p = Payload(count * 4))						\
+			ReadPackedFloats(p, value.val, count);						\
+	}																	\
+	return value;														\
+}
+
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Vector2, 2)
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Vector3, 3)
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Vector4, 4)
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Matrix2, 4)
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Matrix3, 9)
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Matrix4, 16)
+DKPACKEDVARIANT_FLOATS_ACCESSOR(Quaternion, 4)
+
+DKVariant::VRationalNumber DKPackedVariant::Value::RationalNumber() const
+{
+	if (ValueType() == DKVariant::TypeRationalNumber)
+	{
+		if (const uint8_t* p = Payload(16))
+		{
+			using Integer = DKVariant::VRationalNumber::Integer;
+			return DKVariant::VRationalNumber(static_cast<Integer>(ReadPackedUInt64(p)),
+											  static_cast<Integer>(ReadPackedUInt64(&p[8])));
+		}
+	}
+	return DKVariant::VRationalNumber();
+}
+
+const char* DKPackedVariant::Value::StringUTF8(size_t* length) const
+{
+	if (ValueType() == DKVariant::TypeString)
+	{
+		if (const uint8_t* p = Payload(4))
+		{
+			uint32_t len = ReadPackedUInt32(p);
+			if (Payload(size_t(4) + len + 1))
+			{
+				if (length)
+					*length = len;
+				return reinterpret_cast<const char*>(&p[4]);
+			}
+		}
+	}
+	if (length)
+		*length = 0;
+	return "";
+}
+
+DKVariant::VString DKPackedVariant::Value::String() const
+{
+	size_t len;
+	const char* str = StringUTF8(&len);
+	DKVariant::VString s = L"";
+	if (len > 0)
+		s.SetValue(reinterpret_cast<const DKUniChar8*>(str), len);
+	return s;
+}
+
+DKVariant::VDateTime DKPackedVariant::Value::DateTime() const
+{
+	if (ValueType() == DKVariant::TypeDateTime)
+	{
+		if (const uint8_t* p = Payload(12))
+			return DKVariant::VDateTime(ReadPackedUInt64(p), ReadPackedUInt32(&p[8]));
+	}
+	return DKVariant::VDateTime(0ULL, 0U);
+}
+
+DKObject<DKData> DKPackedVariant::Value::Data() const
+{
+	if (ValueType() == DKVariant::TypeData)
+	{
+		if (const uint8_t* p = Payload(4))
+		{
+			uint32_t len = ReadPackedUInt32(p);
+			if (Payload(size_t(4) + len))
+				return pack->source->Slice(size_t(offset) + 8, len);
+		}
+	}
+	return NULL;
+}
+
+DKVariant::VStructuredData DKPackedVariant::Value::StructuredData() const
+{
+	DKVariant::VStructuredData stData;
+	stData.elementSize = 0;
+	if (ValueType() == DKVariant::TypeStructData)
+	{
+		if (const uint8_t* p = Payload(12))
+		{
+			uint32_t elementSize = ReadPackedUInt32(p);
+			uint32_t numLayouts = ReadPackedUInt32(&p[4]);
+			uint32_t len = ReadPackedUInt32(&p[8]);
+			size_t dataOffset = (size_t(12) + numLayouts + 3) & ~size_t(3);
+			if (Payload(dataOffset + len))
+			{
+				stData.elementSize = elementSize;
+				stData.layout.Add(reinterpret_cast<const DKVariant::StructElem*>(&p[12]), numLayouts);
+				if (len > 0)
+				{
+					if (DKRuntimeByteOrder() == DKByteOrder::LittleEndian)
+					{
+						stData.data = pack->source->Slice(size_t(offset) + 4 + dataOffset, len);
+					}
+					else
+					{
+						DKObject<DKBuffer> buffer = DKBuffer::Create(&p[dataOffset], len);
+						SwapStructuredDataByteOrder(reinterpret_cast<uint8_t*>(buffer->LockExclusive()), len, elementSize, stData.layout, numLayouts);
+						buffer->UnlockExclusive();
+						stData.data = buffer.SafeCast<DKData>();
+					}
+				}
+			}
+		}
+	}
+	return stData;
+}
+
+size_t DKPackedVariant::Value::Count() const
+{
+	DKVariant::Type t = ValueType();
+	if (t == DKVariant::TypeArray || t == DKVariant::TypePairs)
+	{
+		if (const uint8_t* p = Payload(4))
+		{
+			size_t count = ReadPackedUInt32(p);
+			size_t entrySize = (t == DKVariant::TypeArray) ? 4 : 8;
+			if (Payload(4 + count * entrySize))
+				return count;
+		}
+	}
+	return 0;
+}
+
+DKPackedVariant::Value DKPackedVariant::Value::ValueAtIndex(size_t index) const
+{
+	DKVariant::Type t = ValueType();
+	if (index < Count())
+	{
+		const uint8_t* p = Payload(4);
+		uint32_t node = (t == DKVariant::TypeArray) ?
+			ReadPackedUInt32(&p[4 + index * 4]) : ReadPackedUInt32(&p[4 + index * 8 + 4]);
+		// children are written before parent, reject others to prevent
+		// infinite recursion with corrupted data.
+		if ((node & 3) == 0 && node < offset)
+			return Value(pack, node);
+	}
+	return Value();
+}
+
+const char* DKPackedVariant::Value::KeyAtIndex(size_t index, size_t* length) const
+{
+	if (ValueType() == DKVariant::TypePairs && index < Count())
+	{
+		const uint8_t* p = Payload(4);
+		size_t key = ReadPackedUInt32(&p[4 + index * 8]);
+		if (key + 4 <= pack->length)
+		{
+			uint32_t len = ReadPackedUInt32(&pack->bytes[key]);
+			if (key + 4 + len + 1 <= pack->length)
+			{
+				if (length)
+					*length = len;
+				return reinterpret_cast<const char*>(&pack->bytes[key + 4]);
+			}
+		}
+	}
+	if (length)
+		*length = 0;
+	return NULL;
+}
+
+DKPackedVariant::Value DKPackedVariant::Value::Find(const DKString& key) const
+{
+	DKStringU8 k(key);
+	return Find((const char*)k, k.Bytes());
+}
+
+DKPackedVariant::Value DKPackedVariant::Value::Find(const char* key, size_t length) const
+{
+	if (ValueType() == DKVariant::TypePairs)
+	{
+		size_t begin = 0;
+		size_t end = Count();
+		while (begin < end)
+		{
+			size_t mid = begin + (end - begin) / 2;
+			size_t len;
+			const char* k = KeyAtIndex(mid, &len);
+			if (k == NULL)
+				break;
+			int cmp = ComparePackedKey(k, len, key, length);
+			if (cmp == 0)
+				return ValueAtIndex(mid);
+			if (cmp < 0)
+				begin = mid + 1;
+			else
+				end = mid;
+		}
+	}
+	return Value();
+}
+
+DKPackedVariant::Value DKPackedVariant::Value::FindAtKeyPath(const DKString& path) const
+{
+	DKStringU8 p(path);
+	return FindAtKeyPath((const char*)p, p.Bytes());
+}
+
+DKPackedVariant::Value DKPackedVariant::Value::FindAtKeyPath(const char* path, size_t length) const
+{
+	if (length == 0)
+		return *this;
+
+	if (ValueType() == DKVariant::TypePairs)
+	{
+		// try longest key first, shortest depth.
+		size_t keyLength = length;
+		while (true)
+		{
+			Value v = Find(path, keyLength);
+			if (v.IsValid())
+			{
+				if (keyLength == length)
+					return v;
+				v = v.FindAtKeyPath(&path[keyLength + 1], length - keyLength - 1);
+				if (v.IsValid())
+					return v;
+			}
+			while (keyLength > 0 && path[keyLength - 1] != DKPACKEDVARIANT_KEY_PATH_DELIMITER)
+				--keyLength;
+			if (keyLength == 0)
+				break;
+			--keyLength;	// exclude delimiter
+		}
+	}
+	return Value();
+}
+
+DKVariant DKPackedVariant::Value::Materialize() const
+{
+	DKVariant::Type t = ValueType();
+	switch (t)
+	{
+	case DKVariant::TypeInteger:		return DKVariant(Integer());
+	case DKVariant::TypeFloat:			return DKVariant(Float());
+	case DKVariant::TypeVector2:		return DKVariant(Vector2());
+	case DKVariant::TypeVector3:		return DKVariant(Vector3());
+	case DKVariant::TypeVector4:		return DKVariant(Vector4());
+	case DKVariant::TypeMatrix2:		return DKVariant(Matrix2());
+	case DKVariant::TypeMatrix3:		return DKVariant(Matrix3());
+	case DKVariant::TypeMatrix4:		return DKVariant(Matrix4());
+	case DKVariant::TypeQuaternion:		return DKVariant(Quaternion());
+	case DKVariant::TypeRationalNumber:	return DKVariant(RationalNumber());
+	case DKVariant::TypeString:			return DKVariant(String());
+	case DKVariant::TypeDateTime:		return DKVariant(DateTime());
+	case DKVariant::TypeData:
+		{
+			DKVariant v(DKVariant::TypeData);
+			DKObject<DKData> data = Data();
+			if (data)
+			{
+				v.SetData(data->LockShared(), data->Length());	// copy
+				data->UnlockShared();
+			}
+			return v;
+		}
+	case DKVariant::TypeStructData:
+		{
+			DKVariant::VStructuredData stData = StructuredData();
+			if (stData.data)	// copy
+				stData.data = DKBuffer::Create(stData.data).SafeCast<DKData>();
+			return DKVariant(stData);
+		}
+	case DKVariant::TypeArray:
+		{
+			DKVariant v(DKVariant::TypeArray);
+			DKVariant::VArray& a = v.Array();
+			size_t count = Count();
+			a.Reserve(count);
+			for (size_t i = 0; i < count; ++i)
+				a.Add(ValueAtIndex(i).Materialize());
+			return v;
+		}
+	case DKVariant::TypePairs:
+		{
+			DKVariant v(DKVariant::TypePairs);
+			DKVariant::VPairs& pairs = v.Pairs();
+			size_t count = Count();
+			for (size_t i = 0; i < count; ++i)
+			{
+				size_t len;
+				const char* key = KeyAtIndex(i, &len);
+				if (key)
+				{
+					DKString k = L"";
+					k.SetValue(reinterpret_cast<const DKUniChar8*>(key), len);
+					pairs.Update(k, ValueAtIndex(i).Materialize());
+				}
+			}
+			return v;
+		}
+	default:
+		break;
+	}
+	return DKVariant();
+}
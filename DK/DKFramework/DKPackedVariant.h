@@ -0,0 +1,120 @@
+//
+//  File: DKPackedVariant.h
+//  Author: Hongtae Kim (tiff2766@gmail.com)
+//
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
+//
+
+#pragma once
+#include "../DKFoundation.h"
+#include "DKVariant.h"
+
+namespace DKFramework
+{
+	/**
+	 @brief
+	 Read-only, offset-indexed binary encoding of DKVariant.
+
+	 Packed data can be queried in place (mapped file can be used) without
+	 building DKVariant tree. Array elements and pair values are located by
+	 offsets, keys of pairs are sorted and found with binary search.
+	 Use Materialize() to build DKVariant when values need to be modified.
+
+	 @code
+	  DKObject<DKBuffer> data = DKPackedVariant::Pack(config);
+	  data->WriteToFile(L"config.dkpv", true);
+	  ...
+	  DKObject<DKPackedVariant> pv = DKPackedVariant::Open(L"config.dkpv");
+	  DKPackedVariant::Value v = pv->Root().FindAtKeyPath(L"Display.Resolution");
+	  if (v.ValueType() == DKVariant::TypeVector2)
+	      DKVector2 res = v.Vector2();
+	 @endcode
+
+	 @note
+	  Data is little-endian, offsets are 32-bit. (4GB max)
+	  Value accessors return default value (zero, empty) if type mismatched.
+	  Value objects are valid while DKPackedVariant object is alive.
+	 */
+	class DKGL_API DKPackedVariant
+	{
+	public:
+		class DKGL_API Value
+		{
+		public:
+			Value() : pack(NULL), offset(0) {}
+
+			bool IsValid() const		{ return pack != NULL; }
+			DKVariant::Type ValueType() const;
+
+			DKVariant::VInteger Integer() const;
+			DKVariant::VFloat Float() const;
+			DKVariant::VVector2 Vector2() const;
+			DKVariant::VVector3 Vector3() const;
+			DKVariant::VVector4 Vector4() const;
+			DKVariant::VMatrix2 Matrix2() const;
+			DKVariant::VMatrix3 Matrix3() const;
+			DKVariant::VMatrix4 Matrix4() const;
+			DKVariant::VQuaternion Quaternion() const;
+			DKVariant::VRationalNumber RationalNumber() const;
+			DKVariant::VString String() const;
+			/// UTF-8 string in packed data, null-terminated.
+			const char* StringUTF8(size_t* length = NULL) const;
+			DKVariant::VDateTime DateTime() const;
+			/// slice of packed data, without copying.
+			DKObject<DKData> Data() const;
+			DKVariant::VStructuredData StructuredData() const;
+
+			/// number of elements of Array or Pairs.
+			size_t Count() const;
+			/// element of Array, value of Pairs (sorted by key)
+			Value ValueAtIndex(size_t index) const;
+			/// key of Pairs, UTF-8 null-terminated.
+			const char* KeyAtIndex(size_t index, size_t* length = NULL) const;
+
+			/// find value of Pairs with key.
+			Value Find(const DKString& key) const;
+			Value Find(const char* key, size_t length) const;
+			/// find descendant with key-path (see DKVariant::FindObjectAtKeyPath)
+			/// returns the object with the shortest depth.
+			Value FindAtKeyPath(const DKString& path) const;
+
+			/// build DKVariant tree of this value.
+			DKVariant Materialize() const;
+
+		private:
+			friend class DKPackedVariant;
+			Value(const DKPackedVariant* p, uint32_t off) : pack(p), offset(off) {}
+			const uint8_t* Payload(size_t size) const;
+			Value FindAtKeyPath(const char* path, size_t length) const;
+
+			const DKPackedVariant* pack;
+			uint32_t offset;
+		};
+
+		~DKPackedVariant();
+
+		/// encode variant, returns NULL if failed.
+		static DKObject<DKBuffer> Pack(const DKVariant& v, DKAllocator& alloc = DKAllocator::DefaultAllocator());
+		static bool Pack(const DKVariant& v, DKStream* stream);
+
+		/// map file into memory and open.
+		static DKObject<DKPackedVariant> Open(const DKString& file);
+		/// open packed data, managed data is retained. unmanaged data is copied.
+		static DKObject<DKPackedVariant> Open(const DKData* data);
+		/// true if data begins with packed variant header.
+		static bool IsPackedData(const void* p, size_t length);
+
+		Value Root() const;
+		DKVariant Materialize() const	{ return Root().Materialize(); }
+
+	private:
+		DKPackedVariant(DKData* source);
+
+		DKObject<DKData> source;	// kept locked while object alive.
+		const uint8_t* bytes;
+		size_t length;
+
+		DKPackedVariant(const DKPackedVariant&) = delete;
+		DKPackedVariant& operator = (const DKPackedVariant&) = delete;
+	};
+}
@@ -484,7 +484,7 @@ void DKPropertySet::EnumerateBackward(const Enumerator* e) const
 }
 
 template <typename T, typename... Args>
-void DKPropertySet::CallbackObservers(const DKString& key, const DKMap<DKString, ObserverMap<DKObject<T>>>& target, Args&&... args) const
+void DKPropertySet::CallbackObservers(const DKString& key, const DKHashMap<DKString, ObserverMap<DKObject<T>>>& target, Args&&... args) const
 {
 	callbackLock.Lock();
 	DKArray<DKObject<T>> callbacks;
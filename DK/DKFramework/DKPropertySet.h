@@ -84,12 +84,12 @@ namespace DKFramework
 		DKVariant dataSet;
 
 		DKSpinLock callbackLock;
-		template <typename T> using ObserverMap = DKMap<ObserverContext, T>;
-		DKMap<DKString, ObserverMap<DKObject<InsertionCallback>>> insertionCallbacks;
-		DKMap<DKString, ObserverMap<DKObject<ModificationCallback>>> modificationCallbacks;
-		DKMap<DKString, ObserverMap<DKObject<DeletionCallback>>> deletionCallbacks;
+		template <typename T> using ObserverMap = DKHashMap<ObserverContext, T>;
+		DKHashMap<DKString, ObserverMap<DKObject<InsertionCallback>>> insertionCallbacks;
+		DKHashMap<DKString, ObserverMap<DKObject<ModificationCallback>>> modificationCallbacks;
+		DKHashMap<DKString, ObserverMap<DKObject<DeletionCallback>>> deletionCallbacks;
 
 		template <typename T, typename... Args>
-		void CallbackObservers(const DKString& key, const DKMap<DKString, ObserverMap<DKObject<T>>>& target, Args&&... args) const;
+		void CallbackObservers(const DKString& key, const DKHashMap<DKString, ObserverMap<DKObject<T>>>& target, Args&&... args) const;
 	};
 }
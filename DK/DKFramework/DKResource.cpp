@@ -12,7 +12,7 @@ using namespace DKFramework;
 
 DKResource::DKResource()
 : allocator(NULL)
-, objectName("")
+, objectName()
 , objectUUID(DKUuid::Create())
 {
 }
@@ -23,10 +23,15 @@ DKResource::~DKResource()
 
 void DKResource::SetName(const DKString& name)
 {
-	objectName = name;
+	objectName = DKAtom(name);
 }
 
 const DKString& DKResource::Name() const
+{
+	return objectName.String();
+}
+
+DKAtom DKResource::NameAtom() const
 {
 	return objectName;
 }
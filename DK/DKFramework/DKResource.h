@@ -24,8 +24,10 @@ namespace DKFramework
 		DKResource();
 		virtual ~DKResource();
 
+		/// name is interned as DKAtom.
 		virtual void SetName(const DKString& name);
 		const DKString& Name() const;
+		DKAtom NameAtom() const;
 		virtual void SetUUID(const DKUuid& uuid);
 		const DKUuid& UUID() const;
 
@@ -43,7 +45,7 @@ namespace DKFramework
 		DKAllocator& Allocator();
 
 	private:
-		DKString objectName;
+		DKAtom objectName;
 		DKUuid objectUUID;
 		DKAllocator* allocator;
 
@@ -220,39 +220,93 @@ DKObject<DKResource> DKResourceLoader::ResourceFromXML(const DKXmlElement* e)
 	return res;
 }
 
-DKObject<DKResource> DKResourceLoader::ResourceFromData(const DKData* data, const DKString& name)
+DKObject<DKResource> DKResourceLoader::ResourceFromXML(DKXmlReader& reader)
 {
 	DKObject<DKResource> res = NULL;
-	if (data)
+	if (reader.CurrentNodeType() == DKXmlReader::NodeTypeStartElement)
 	{
-		DKObject<ResourceLoader> loader = FindExtLoader(name.LowercaseString());
-		if (loader)
+		DKString URI = reader.NamespaceURI().ToString();
+		DKString name = reader.LocalName().ToString();
+
+		if (GetAllocator(URI, name))
 		{
-			const void* p = data->LockShared();
-			size_t len = data->Length();
-			if (p && len > 0)
+			// resource object deserialize with DOM.
+			DKObject<DKXmlElement> e = reader.ReadElement();
+			if (e)
+				res = ResourceFromXML(e);
+		}
+		else
+		{
+			// Open with DKSerializer.
+			DKAllocator& alloc = this->Allocator();
+			DKObject<DKResource> obj = NULL;
+
+			auto selector = [&alloc, &obj](const DKString& name) -> DKObject<DKSerializer>
 			{
-				DKObject<DKData> data2 = DKData::StaticData(p, len);
-				if (data2)
+				ResourceAllocator* allocator = GetAllocator(L"", name);
+				if (allocator)
 				{
-					DKAllocator& alloc = this->Allocator();
-					DKDataStream stream(data2);
-					DKObject<DKResource> obj = loader->Invoke(&stream, alloc);
+					obj = allocator->Invoke(alloc);
 					if (obj)
 					{
 						if (obj->allocator == NULL)
 							obj->allocator = &alloc;
-						res = obj;
+						return obj->Serializer();
 					}
 				}
+				DKLog("DKResourceLoader Warning: DKSerializer Class(%ls) not found!\n", (const wchar_t*)name);
+				return NULL;
+			};
+
+			if (DKSerializer::RestoreObject(reader, this, DKFunction(selector)))
+				res = obj;
+		}
+	}
+	return res;
+}
+
+DKObject<DKResource> DKResourceLoader::ResourceFromData(const DKData* data, const DKString& name)
+{
+	DKObject<DKResource> res = NULL;
+	if (data)
+	{
+		DKObject<ResourceLoader> loader = FindExtLoader(name.LowercaseString());
+		if (loader)
+		{
+			// read managed data directly, loader can retain it (or slice of it).
+			// otherwise, read transient data while locked.
+			DKObject<DKData> source = const_cast<DKData*>(data);
+			bool locked = !source.IsManaged();
+			if (locked)
+				source = DKData::StaticData(data->LockShared(), data->Length());
+
+			if (source && source->Length() > 0)
+			{
+				DKAllocator& alloc = this->Allocator();
+				DKDataStream stream(source);
+				DKObject<DKResource> obj = loader->Invoke(&stream, alloc);
+				if (obj)
+				{
+					if (obj->allocator == NULL)
+						obj->allocator = &alloc;
+					res = obj;
+				}
 			}
-			data->UnlockShared();
+			source = NULL;
+			if (locked)
+				data->UnlockShared();
 		}
 		if (res == NULL)
 		{
-			// try to open with XML (DKXmlDocument)
-			DKObject<DKXmlDocument> xmlDoc = DKXmlDocument::Open(DKXmlDocument::TypeXML, data);
-			if (xmlDoc)
+			// try to open with XML reader, DKXmlDocument if document is not supported.
+			DKObject<DKXmlReader> reader = DKXmlReader::Open(data);
+			DKObject<DKXmlDocument> xmlDoc = NULL;
+			if (reader && reader->ReadRootElement())
+			{
+				res = this->ResourceFromXML(*reader);
+			}
+			else if ((reader == NULL || reader->Error() == DKXmlReader::ErrorUnsupported) &&
+					 (xmlDoc = DKXmlDocument::Open(DKXmlDocument::TypeXML, data)) != NULL)
 			{
 				res = this->ResourceFromXML(xmlDoc->RootElement());
 			}
@@ -351,6 +405,11 @@ DKObject<DKResource> DKResourceLoader::ResourceFromFile(const DKString& path, co
 	}
 	else
 	{
+		// mapped file can be sliced by loaders, without copying.
+		DKObject<DKFileMap> map = DKFileMap::Open(path, 0, false);
+		if (map)
+			return this->ResourceFromData(map.SafeCast<DKData>(), name);
+
 		DKObject<DKFile> file = DKFile::Create(path, DKFile::ModeOpenReadOnly, DKFile::ModeShareAll);
 		if (file)
 			return this->ResourceFromStream(file.SafeCast<DKStream>(), name);
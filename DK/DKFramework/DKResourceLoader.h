@@ -39,6 +39,8 @@ namespace DKFramework
 		virtual ~DKResourceLoader();
 
 		DKObject<DKResource> ResourceFromXML(const DKXmlElement* element);
+		/// reader should be on StartElement, reader moves to end of element.
+		DKObject<DKResource> ResourceFromXML(DKXmlReader& reader);
 		DKObject<DKResource> ResourceFromData(const DKData* data, const DKString& name);
 		DKObject<DKResource> ResourceFromStream(DKStream* stream, const DKString& name);
 		DKObject<DKResource> ResourceFromFile(const DKString& path, const DKString& name);
@@ -69,6 +69,25 @@ DKResourcePool::Locator* DKResourcePool::AddLocatorForPath(const DKString& path)
 			};
 			locator = DKOBJECT_NEW DirLocator(dir);
 		}
+		else if (DKObject<DKPackUnarchiver> pack = DKPackUnarchiver::Open(path); pack)	// pack archive
+		{
+			struct PackLocator : public Locator
+			{
+				DKObject<DKPackUnarchiver> pack;
+
+				PackLocator(DKPackUnarchiver* p) : pack(p) {}
+				DKString FindSystemPath(const DKString&) const { return ""; }
+				DKObject<DKStream> OpenStream(const DKString& name) const
+				{
+					return pack->OpenStream(name);
+				}
+				DKObject<DKData> OpenData(const DKString& name) const
+				{
+					return pack->OpenData(name);
+				}
+			};
+			locator = DKOBJECT_NEW PackLocator(pack);
+		}
 		else	 // zip file with prefix (".../mydata.zip/prefix")
 		{
 			size_t len = path.Length();
@@ -192,12 +211,25 @@ DKObject<DKStream> DKResourcePool::OpenResourceStream(const DKString& name) cons
 	return NULL;
 }
 
+DKObject<DKData> DKResourcePool::OpenResourceData(const DKString& name) const
+{
+	DKCriticalSection<DKSpinLock> guard(this->lock);
+	for (const NamedLocator& loc : locators)
+	{
+		DKObject<DKData> data = loc.locator->OpenData(name);
+		if (data)
+			return data;
+	}
+	return NULL;
+}
+
 void DKResourcePool::AddResource(const DKString& name, DKResource* res)
 {
 	if (name.Length() > 0 && res)
 	{
+		DKAtom key(name);
 		DKCriticalSection<DKSpinLock> guard(this->lock);
-		resources.Update(name, res);
+		resources.Update(key, res);
 	}
 }
 
@@ -205,21 +237,28 @@ void DKResourcePool::AddResourceData(const DKString& name, DKData* data)
 {
 	if (name.Length() > 0 && data)
 	{
+		DKAtom key(name);
 		DKCriticalSection<DKSpinLock> guard(this->lock);
-		resourceData.Update(name, data);
+		resourceData.Update(key, data);
 	}
 }
 
 void DKResourcePool::RemoveResource(const DKString& name)
 {
+	DKAtom key = DKAtom::Lookup(name);
+	if (key.IsNull())
+		return;
 	DKCriticalSection<DKSpinLock> guard(this->lock);
-	resources.Remove(name);
+	resources.Remove(key);
 }
 
 void DKResourcePool::RemoveResourceData(const DKString& name)
 {
+	DKAtom key = DKAtom::Lookup(name);
+	if (key.IsNull())
+		return;
 	DKCriticalSection<DKSpinLock> guard(this->lock);
-	resourceData.Remove(name);
+	resourceData.Remove(key);
 }
 
 void DKResourcePool::RemoveAllResourceData()
@@ -244,8 +283,8 @@ void DKResourcePool::RemoveAll()
 void DKResourcePool::ClearUnreferencedObjects()
 {
 	DKCriticalSection<DKSpinLock> guard(this->lock);
-	using ResInfo = DKMapPair<DKString, DKObject<DKResource>::Ref>;
-	using DataInfo = DKMapPair<DKString, DKObject<DKData>::Ref>;
+	using ResInfo = DKMapPair<DKAtom, DKObject<DKResource>::Ref>;
+	using DataInfo = DKMapPair<DKAtom, DKObject<DKData>::Ref>;
 
 	// collect weak-refs of all objects.
 	DKArray<ResInfo> resRefs;
@@ -286,6 +325,14 @@ void DKResourcePool::ClearUnreferencedObjects()
 }
 
 DKObject<DKResource> DKResourcePool::FindResource(const DKString& name) const
+{
+	DKAtom key = DKAtom::Lookup(name);
+	if (key.IsNull())
+		return NULL;	// not interned, resource not exists.
+	return FindResource(key);
+}
+
+DKObject<DKResource> DKResourcePool::FindResource(const DKAtom& name) const
 {
 	DKCriticalSection<DKSpinLock> guard(this->lock);
 	const ResourceMap::Pair* p = resources.Find(name);
@@ -296,6 +343,14 @@ DKObject<DKResource> DKResourcePool::FindResource(const DKString& name) const
 }
 
 DKObject<DKData> DKResourcePool::FindResourceData(const DKString& name) const
+{
+	DKAtom key = DKAtom::Lookup(name);
+	if (key.IsNull())
+		return NULL;	// not interned, resource not exists.
+	return FindResourceData(key);
+}
+
+DKObject<DKData> DKResourcePool::FindResourceData(const DKAtom& name) const
 {
 	DKCriticalSection<DKSpinLock> guard(this->lock);
 	const DataMap::Pair* p = resourceData.Find(name);
@@ -307,6 +362,8 @@ DKObject<DKData> DKResourcePool::FindResourceData(const DKString& name) const
 
 DKObject<DKResource> DKResourcePool::LoadResource(const DKString& name)
 {
+	DKPROFILE_SCOPE("DKResourcePool::LoadResource");
+
 	DKObject<DKResource> ret = FindResource(name);
 	if (ret)
 		return ret;
@@ -315,24 +372,33 @@ DKObject<DKResource> DKResourcePool::LoadResource(const DKString& name)
 	{
 		if (name.Left(7).CompareNoCase(L"http://") && name.Left(6).CompareNoCase(L"ftp://") && name.Left(7).CompareNoCase(L"file://"))
 		{
-			// open stream (includes zip-file contents)
-			DKObject<DKStream> stream = OpenResourceStream(name);
-			if (stream)
-				ret = DKResourceLoader::ResourceFromStream(stream, name);
+			// use previous loaded data or mapped file, contents are sliced without copying.
+			DKString path = L"";
+			DKObject<DKData> data = FindResourceData(name);
+			if (data == NULL)
+			{
+				path = ResourceFilePath(name);
+				if (path.Length() > 0)
+					ret = DKResourceLoader::ResourceFromFile(path, name);
+				else
+					data = OpenResourceData(name);
+			}
+			if (data)
+				ret = DKResourceLoader::ResourceFromData(data, name);
+			if (ret == NULL)
+			{
+				// open stream (includes zip-file contents)
+				DKObject<DKStream> stream = OpenResourceStream(name);
+				if (stream)
+					ret = DKResourceLoader::ResourceFromStream(stream, name);
+			}
+			if (ret == NULL && path.Length() == 0)
+				ret = DKResourceLoader::ResourceFromFile(name, name);
 		}
 		else
 		{
 			ret = DKResourceLoader::ResourceFromFile(name, name);
 		}
-
-		if (ret == NULL)
-		{
-			DKString path = ResourceFilePath(name);
-			if (path.Length() == 0)
-				path = name;
-
-			ret = DKResourceLoader::ResourceFromFile(path, name);
-		}
 	}
 
 	if (ret)
@@ -351,6 +417,8 @@ DKObject<DKResource> DKResourcePool::LoadResource(const DKString& name)
 
 DKObject<DKData> DKResourcePool::LoadResourceData(const DKString& name, bool mapFileIfPossible)
 {
+	DKPROFILE_SCOPE("DKResourcePool::LoadResourceData");
+
 	DKObject<DKData> ret = FindResourceData(name);
 	if (ret)
 		return ret;
@@ -367,10 +435,12 @@ DKObject<DKData> DKResourcePool::LoadResourceData(const DKString& name, bool map
 				if (ret == NULL)
 					ret = DKBuffer::Create(path);
 			}
-			else	// file could not be located. (or could be zip-file contents)
+			else	// file could not be located. (or could be archive contents)
 			{
-				// open stream first (includes zip-file contents)
-				DKObject<DKStream> stream = OpenResourceStream(name);
+				// pack archive contents, without copying.
+				ret = OpenResourceData(name);
+				// open stream (includes zip-file contents)
+				DKObject<DKStream> stream = ret ? NULL : OpenResourceStream(name);
 				if (stream)
 					ret = DKBuffer::Create(stream);
 				if (ret == NULL && mapFileIfPossible)
@@ -395,6 +465,63 @@ DKObject<DKData> DKResourcePool::LoadResourceData(const DKString& name, bool map
 	return ret;
 }
 
+void DKResourcePool::LoadResourceDataAsync(const DKString& name, DKInlineFunction<void (DKData*)>&& callback, DKEventLoop* eventLoop)
+{
+	DKObject<DKData> ret = FindResourceData(name);
+	if (ret == NULL && name.Length() > 0 &&
+		name.Left(7).CompareNoCase(L"http://") && name.Left(6).CompareNoCase(L"ftp://") && name.Left(7).CompareNoCase(L"file://"))
+	{
+		DKString path = ResourceFilePath(name);
+		DKObject<DKFile> file = NULL;
+		if (path.Length() > 0)
+			file = DKFile::Create(path, DKFile::ModeOpenReadOnly, DKFile::ModeShareAll);
+		if (file)
+		{
+			size_t length = file->TotalLength();
+			DKObject<DKBuffer> buffer = DKBuffer::Create(NULL, length);
+			// buffer is not shared with others until read completed,
+			// content address will not be changed.
+			void* p = buffer->LockExclusive();
+			buffer->UnlockExclusive();
+
+			DKObject<DKResourcePool> pool = this;
+			file->ReadAsync(p, length, 0, [pool, name, buffer, length, cb = static_cast<DKInlineFunction<void (DKData*)>&&>(callback)](size_t numRead) mutable
+			{
+				DKObject<DKData> data = NULL;
+				if (numRead == length)
+				{
+					data = buffer.SafeCast<DKData>();
+					pool->AddResourceData(name, data);
+					DKLog("Resource Data \"%ls\" loaded. (%llu bytes)\n", (const wchar_t*)name, (unsigned long long)length);
+				}
+				else
+				{
+					DKLogE("Failed to load resource data \"%ls\".\n", (const wchar_t*)name);
+				}
+				if (cb)
+					cb(data);
+			}, eventLoop);
+			return;
+		}
+	}
+	// loaded already, or not a file in file-system.
+	if (ret == NULL)
+		ret = LoadResourceData(name);
+
+	if (callback)
+	{
+		if (eventLoop)
+		{
+			eventLoop->Post([ret, cb = static_cast<DKInlineFunction<void (DKData*)>&&>(callback)]() mutable
+			{
+				cb(ret);
+			});
+		}
+		else
+			callback(ret);
+	}
+}
+
 DKObject<DKResourcePool> DKResourcePool::Clone() const
 {	
 	DKObject<DKResourcePool> pool = DKObject<DKResourcePool>::New();
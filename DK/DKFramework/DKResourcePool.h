@@ -17,7 +17,8 @@ namespace DKFramework
 	 Loads resources which used by DKFramework.
 	 @details
 	 You set your paths for file located, you can also set path as zip file's
-	 content by calling AddSearchPath().
+	 content or pack archive (DKPackArchiver) by calling AddSearchPath().
+	 Pack archive is mapped into memory, stored entries are used without copying.
 	 A locator that can find destination file from system directory or specified
 	 zip file content. You can use your custom locator to locating your data also.
 	 Subclass DKResourcePool::Locator and call DKResourcePool::AddLocator().
@@ -36,6 +37,7 @@ namespace DKFramework
 	  pool.AddSearchPath("/data/dir");                 // add search path of '/data/dir'
 	  pool.AddSearchPath("/data/dir/file.zip");        // add search path of 'file.zip'
 	  pool.AddSearchPath("/data/dir/file.zip/prefix"); // add search path of 'file.zip/prefix*'
+	  pool.AddSearchPath("/data/dir/assets.dkpack");   // add search path of pack archive
 
 	  pool.LoadResource("MyFile.dat");   // load 'MyFile.data' and restore object.
 	  pool.LoadResourceData("MyFile.dat"); // load 'MyFile.data' data only.
@@ -52,6 +54,8 @@ namespace DKFramework
 			virtual ~Locator() {}
 			virtual DKString FindSystemPath(const DKString&) const = 0;
 			virtual DKObject<DKStream> OpenStream(const DKString&) const = 0;
+			/// data in memory (without copying) if locator can provide.
+			virtual DKObject<DKData> OpenData(const DKString&) const { return NULL; }
 		};
 
 		DKResourcePool();
@@ -71,12 +75,19 @@ namespace DKFramework
 
 		/// find resource object from pool. (previous loaded)
 		DKObject<DKResource> FindResource(const DKString& name) const;
+		DKObject<DKResource> FindResource(const DKAtom& name) const;
 		/// find resource data from pool. (previous loaded)
 		DKObject<DKData> FindResourceData(const DKString& name) const;
+		DKObject<DKData> FindResourceData(const DKAtom& name) const;
 		/// load resource object. recycles if object loaded already.
 		DKObject<DKResource> LoadResource(const DKString& name);
 		/// load resource data. recycles if data loaded already.
 		DKObject<DKData> LoadResourceData(const DKString& name, bool mapFileIfPossible = true);
+		/// load resource data asynchronously with DKAsyncIO, callback is invoked with
+		/// loaded data (NULL if failed), on eventLoop if provided or on I/O thread.
+		/// resources which are not located in file-system (zip-file contents, URL)
+		/// are loaded synchronously by LoadResourceData().
+		void LoadResourceDataAsync(const DKString& name, DKInlineFunction<void (DKData*)>&& callback, DKEventLoop* eventLoop = NULL);
 
 		/// insert resource object into pool.
 		void AddResource(const DKString& name, DKResource* res);
@@ -100,6 +111,8 @@ namespace DKFramework
 		DKString ResourceFilePath(const DKString& name) const;
 		/// open resource as stream.
 		DKObject<DKStream> OpenResourceStream(const DKString& name) const;
+		/// open resource data from locators which provide data in memory. (pack archive)
+		DKObject<DKData> OpenResourceData(const DKString& name) const;
 
 		DKObject<DKResourcePool> Clone() const;
 
@@ -115,8 +128,8 @@ namespace DKFramework
 		};
 		DKArray<NamedLocator> locators;
 
-		typedef DKMap<DKString, DKObject<DKResource>>						ResourceMap;
-		typedef DKMap<DKString, DKObject<DKData>>			DataMap;
+		typedef DKHashMap<DKAtom, DKObject<DKResource>>		ResourceMap;
+		typedef DKHashMap<DKAtom, DKObject<DKData>>			DataMap;
 		ResourceMap			resources;
 		DataMap				resourceData;
 
@@ -904,6 +904,8 @@ DKScene::~DKScene()
 
 void DKScene::Update(double tickDelta, DKTimeTick tick)
 {
+	DKPROFILE_SCOPE("DKScene::Update");
+
 	DKASSERT_DEBUG(context);
 	DKASSERT_DEBUG(context->world);
 
@@ -978,18 +980,97 @@ void DKScene::CleanupUpdateNode()
 
 void DKScene::UpdateObjectKinematics(double tickDelta, DKTimeTick tick)
 {
+	DKUpdateQueue* queue = updateQueue;
+	if (queue == NULL)
+	{
+		for (DKModel* m : updatePendingObjects)
+		{
+			m->UpdateKinematic(tickDelta, tick);
+		}
+		return;
+	}
+
+	queue->tick = tick;
+	queue->tickDelta = tickDelta;
+	queue->tickDate = DKDateTime::Now();
+
+	// animation can be shared between object trees, it should be
+	// updated only once before trees get transform from it.
+	DKSet<DKAnimatedTransform*> animations;
+	DKArray<DKArray<DKAnimatedTransform*>> treeAnimations;
+	treeAnimations.Reserve(updatePendingObjects.Count());
+	DKArray<DKModel*> nodes;
 	for (DKModel* m : updatePendingObjects)
 	{
-		m->UpdateKinematic(tickDelta, tick);
+		DKSet<DKAnimatedTransform*> dependencies;
+		nodes.Add(m);
+		while (nodes.Count() > 0)
+		{
+			DKModel* node = nodes.Value(nodes.Count() - 1);
+			nodes.Remove(nodes.Count() - 1);
+
+			if (DKAnimatedTransform* animation = node->Animation(); animation)
+				dependencies.Insert(animation);
+			for (unsigned int i = 0; i < node->NumberOfChildren(); ++i)
+				nodes.Add(node->ChildAtIndex(i));
+		}
+		animations.Union(dependencies);
+
+		DKArray<DKAnimatedTransform*> deps;
+		deps.Reserve(dependencies.Count());
+		dependencies.EnumerateForward([&deps](DKAnimatedTransform* animation)
+		{
+			deps.Add(animation);
+		});
+		treeAnimations.Add(std::move(deps));
+	}
+
+	animations.EnumerateForward([queue, tickDelta, tick](DKAnimatedTransform* animation)
+	{
+		queue->Enqueue(DKFunction([animation, tickDelta, tick](DKUpdateQueueSynchronizer&)
+		{
+			animation->Update(tickDelta, tick);
+		}), animation);
+	});
+	for (size_t i = 0; i < updatePendingObjects.Count(); ++i)
+	{
+		DKModel* m = updatePendingObjects.Value(i);
+		const DKArray<DKAnimatedTransform*>& deps = treeAnimations.Value(i);
+		queue->Enqueue(DKFunction([m, deps, tickDelta, tick](DKUpdateQueueSynchronizer& sync)
+		{
+			for (DKAnimatedTransform* animation : deps)
+				sync.Synchronize(animation);
+			m->UpdateKinematic(tickDelta, tick);
+		}), m);
 	}
+	queue->Complete();
 }
 
 void DKScene::UpdateObjectSceneStates()
 {
+	DKUpdateQueue* queue = updateQueue;
+	if (queue == NULL)
+	{
+		for (DKModel* m : updatePendingObjects)
+		{
+			m->UpdateSceneState(DKNSTransform::identity);
+		}
+		return;
+	}
+
 	for (DKModel* m : updatePendingObjects)
 	{
-		m->UpdateSceneState(DKNSTransform::identity);
+		queue->Enqueue(DKFunction([m](DKUpdateQueueSynchronizer&)
+		{
+			m->UpdateSceneState(DKNSTransform::identity);
+		}), m);
 	}
+	queue->Complete();
+}
+
+void DKScene::SetUpdateQueue(DKUpdateQueue* queue)
+{
+	updateQueue = queue;
 }
 
 #if 0
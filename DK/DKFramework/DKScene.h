@@ -11,6 +11,7 @@
 #include "DKColor.h"
 #include "DKModel.h"
 #include "DKCollisionObject.h"
+#include "DKUpdateQueue.h"
 
 namespace DKFramework
 {
@@ -82,6 +83,15 @@ namespace DKFramework
 		void Enumerate(BEnumerator* e) const;
 		void Enumerate(VEnumerator* e) const;
 
+		/// set update queue for object kinematics and scene states.
+		/// each root object tree is updated as a queue function, animations
+		/// shared between trees are updated first and synchronized.
+		/// objects are updated serially in calling thread if queue is NULL. (default)
+		/// @note queue should not be changed while Update() is in progress.
+		void SetUpdateQueue(DKUpdateQueue* queue);
+		DKUpdateQueue* UpdateQueue()				{ return updateQueue; }
+		const DKUpdateQueue* UpdateQueue() const	{ return updateQueue; }
+
 	protected:
 		CollisionWorldContext* context;
 		DKScene(CollisionWorldContext* ctxt);
@@ -103,6 +113,7 @@ namespace DKFramework
 		DKSpinLock lock;
 
 		DKArray<DKObject<DKModel>> updatePendingObjects;
+		DKObject<DKUpdateQueue> updateQueue;
 
 		DKScene(const DKScene&);
 		DKScene& operator = (const DKScene&);
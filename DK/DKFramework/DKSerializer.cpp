@@ -999,6 +999,215 @@ bool DKSerializer::DeserializeXMLOperations(const DKXmlElement* e, DKArray<DKObj
 	return EntityRestore().ExtractOperations(this, restoreEntities, entities);
 }
 
+bool DKSerializer::DeserializeXMLOperations(DKXmlReader& reader, DKArray<DKObject<DeserializerEntity>>& entities, DKResourceLoader* loader) const
+{
+	if (reader.CurrentNodeType() != DKXmlReader::NodeTypeStartElement ||
+		!reader.LocalName().EqualsNoCase("DKSerializer"))
+		return false;
+
+	EntityRestore::Entity restoreEntities;
+
+	struct ExternalResource
+	{
+		DKString key;
+		DKObject<DKResource> res;
+		bool LoadFromReader(DKXmlReader& reader, DKResourceLoader* loader)
+		{
+			key = L"";
+			res = NULL;
+
+			if (reader.LocalName().EqualsNoCase("External"))
+			{
+				DKString objectKey = reader.AttributeValue(reader.FindAttribute("key"));
+				DKString externalFile = reader.AttributeValue(reader.FindAttribute("file"));
+				if (externalFile.Length() > 0)
+				{
+					if (loader)
+						res = loader->LoadResource(externalFile);
+					reader.Skip();
+				}
+				else
+				{
+					bool loaded = false;
+					reader.EnumerateChildNodes([&](DKXmlReader& r)
+					{
+						if (loaded || loader == NULL)
+							return;
+						if (r.CurrentNodeType() == DKXmlReader::NodeTypeStartElement)
+						{
+							res = loader->ResourceFromXML(r);
+							loaded = true;
+						}
+						else if (r.CurrentNodeType() == DKXmlReader::NodeTypeCData)
+						{
+							DKXmlReader::StringView value = r.RawValue();
+							DKObject<DKBuffer> compressed = DKBuffer::Base64Decode(value.str, value.length);
+							if (compressed)
+							{
+								DKObject<DKBuffer> data = compressed->Decompress();
+								if (data)
+								{
+									res = loader->ResourceFromData(data, L"");
+									loaded = true;
+								}
+							}
+						}
+					});
+				}
+				if (res)
+				{
+					key = objectKey;
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	DKCriticalSection<DKSpinLock> guard(lock);
+
+	// class-id verification
+	DKString classId = reader.AttributeValue(reader.FindAttribute("class"));
+	if (this->resourceClass.Compare(classId))
+	{
+		DKLog("DKSerializer::Deserialize failed: ClassId mismatch. (%ls != %ls)\n", (const wchar_t*)this->resourceClass, (const wchar_t*)classId);
+		return false;
+	}
+
+	// read XML and extract data.
+	bool result = reader.EnumerateChildNodes([&](DKXmlReader& node1)
+	{
+		if (node1.CurrentNodeType() != DKXmlReader::NodeTypeStartElement)
+			return;
+
+		DKXmlReader::StringView name = node1.LocalName();
+		if (name.EqualsNoCase("Local"))
+		{
+			DKXmlReader::StringView type = node1.AttributeRawValue(node1.FindAttribute("type"));
+			// variant import
+			if (type.EqualsNoCase("xml"))
+			{
+				bool imported = false;
+				node1.EnumerateChildNodes([&](DKXmlReader& node2)
+				{
+					if (!imported && node2.CurrentNodeType() == DKXmlReader::NodeTypeStartElement)
+						imported = restoreEntities.deserializer->rootValue.ImportXML(node2);
+				});
+			}
+			else if (type.EqualsNoCase("binary"))
+			{
+				bool imported = false;
+				node1.EnumerateChildNodes([&](DKXmlReader& node2)
+				{
+					if (!imported && node2.CurrentNodeType() == DKXmlReader::NodeTypeCData)
+					{
+						DKXmlReader::StringView value = node2.RawValue();
+						DKObject<DKBuffer> compressed = DKBuffer::Base64Decode(value.str, value.length);
+						if (compressed)
+						{
+							DKObject<DKBuffer> d = compressed->Decompress();
+							if (d)
+							{
+								DKDataStream stream(d);
+								imported = restoreEntities.deserializer->rootValue.ImportStream(&stream);
+							}
+						}
+					}
+				});
+			}
+		}
+		else if (name.EqualsNoCase("Include"))
+		{
+			// include node
+			DKString objectKey = node1.AttributeValue(node1.FindAttribute("key"));
+			bool included = false;
+			node1.EnumerateChildNodes([&](DKXmlReader& incNode)
+			{
+				if (included || incNode.CurrentNodeType() != DKXmlReader::NodeTypeStartElement)
+					return;
+				included = true;
+				const EntityMap::Pair* ep = this->entityMap.Find(objectKey);
+				if (ep)
+				{
+					const SerializerEntity* se = ep->value->Serializer();
+					if (se && se->serializer)
+					{
+						EntityRestore::DeserializerArray de;
+						if (se->serializer->DeserializeXMLOperations(incNode, de, loader))
+						{
+							restoreEntities.includes.Insert(objectKey, de);
+						}
+					}
+				}
+			});
+		}
+		else if (name.EqualsNoCase("External"))
+		{
+			// load external resource, add to restoreEntities.externals.
+			ExternalResource ex;
+			if (ex.LoadFromReader(node1, loader))
+			{
+				if (ex.key.Length() > 0 && ex.res != NULL)
+					restoreEntities.deserializer->externals.Insert(ex.key, ex.res);
+			}
+		}
+		else if (name.EqualsNoCase("ExternalArray"))
+		{
+			DKString objectKey = node1.AttributeValue(node1.FindAttribute("key"));
+			if (objectKey.Length() > 0)
+			{
+				bool loadError = false;
+				ExternalArrayType eat;
+				node1.EnumerateChildNodes([&](DKXmlReader& node2)
+				{
+					if (!loadError && node2.CurrentNodeType() == DKXmlReader::NodeTypeStartElement &&
+						node2.LocalName().EqualsNoCase("External"))
+					{
+						ExternalResource ex;
+						if (ex.LoadFromReader(node2, loader) && ex.res != NULL)
+							eat.Add(ex.res);
+						else
+							loadError = true;
+					}
+				});
+				if (loadError == false)
+					restoreEntities.deserializer->externalArrays.Insert(objectKey, eat);
+			}
+		}
+		else if (name.EqualsNoCase("ExternalMap"))
+		{
+			DKString objectKey = node1.AttributeValue(node1.FindAttribute("key"));
+			if (objectKey.Length() > 0)
+			{
+				bool loadError = false;
+				ExternalMapType emt;
+				node1.EnumerateChildNodes([&](DKXmlReader& node2)
+				{
+					if (!loadError && node2.CurrentNodeType() == DKXmlReader::NodeTypeStartElement &&
+						node2.LocalName().EqualsNoCase("External"))
+					{
+						ExternalResource ex;
+						if (ex.LoadFromReader(node2, loader) && ex.key.Length() > 0 && ex.res != NULL)
+							emt.Insert(ex.key, ex.res);
+						else
+							loadError = true;
+					}
+				});
+				if (loadError == false)
+					restoreEntities.deserializer->externalMaps.Insert(objectKey, emt);
+			}
+		}
+	});
+	if (!result)
+	{
+		DKLog("DKSerializer::Deserialize failed: %ls\n", (const wchar_t*)reader.ErrorDescription());
+		return false;
+	}
+
+	// generate operations (DKOperation)
+	return EntityRestore().ExtractOperations(this, restoreEntities, entities);
+}
+
 bool DKSerializer::Deserialize(const DKXmlElement* e, DKResourceLoader* loader) const
 {
 	// To determine, object can be restored, generate restore operation in advance.
@@ -1035,6 +1244,39 @@ bool DKSerializer::Deserialize(const DKXmlElement* e, DKResourceLoader* loader)
 	return false;
 }
 
+bool DKSerializer::Deserialize(DKXmlReader& reader, DKResourceLoader* loader) const
+{
+	DKArray<DKObject<DeserializerEntity>> deserializers;
+
+	if (DeserializeXMLOperations(reader, deserializers, loader))
+	{
+		for (size_t i = 0; i < deserializers.Count(); ++i)
+		{
+			if (deserializers.Value(i)->callback)
+				deserializers.Value(i)->callback->Invoke(StateDeserializeBegin);
+		}
+
+		for (size_t i = 0; i < deserializers.Count(); ++i)
+		{
+			DeserializerEntity* de = deserializers.Value(i);
+			for (size_t k = 0; k < de->operations.Count(); ++k)
+				de->operations.Value(k)->Perform();
+
+			// clear value (finished)
+			de->operations.Clear();
+			de->rootValue.SetValueType(DKVariant::TypeUndefined);
+		}
+
+		for (size_t i = 0; i < deserializers.Count(); ++i)
+		{
+			if (deserializers.Value(i)->callback)
+				deserializers.Value(i)->callback->Invoke(StateDeserializeSucceed);
+		}
+		return true;
+	}
+	return false;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // DKSerializer binary format layout
 //
@@ -1298,6 +1540,10 @@ size_t DKSerializer::SerializeBinary(SerializeForm sf, DKStream* output) const
 
 	DKCriticalSection<DKSpinLock> guard(this->lock);
 
+	// header and chunk fields are coalesced into large writes.
+	DKBufferedStream bufferedOutput(output);
+	output = &bufferedOutput;
+
 	bool serializeSucceed = false;
 	size_t numBytesWritten = 0;
 
@@ -1353,6 +1599,7 @@ size_t DKSerializer::SerializeBinary(SerializeForm sf, DKStream* output) const
 			{
 				uint64_t numChunks = queryEntities.chunks.Count();
 				size_t wrote = output->Write(&numChunks, sizeof(numChunks));
+				numBytesWritten += wrote;
 				if (wrote != sizeof(numChunks))
 					proceed = false;
 			}
@@ -1461,6 +1708,8 @@ size_t DKSerializer::SerializeBinary(SerializeForm sf, DKStream* output) const
 						break;
 				}
 			}
+			if (proceed && !bufferedOutput.Flush())
+				proceed = false;
 			if (proceed)
 			{
 				serializeSucceed = true;
@@ -1806,13 +2055,9 @@ bool DKSerializer::DeserializeBinaryOperations(DKStream* s, DKArray<DKObject<Des
 
 			if (data)
 			{
+				// slice of source data, without copying.
 				DKStream::Position pos = s->CurrentPosition();
-				const char* ptr = (const char*)data->LockShared();
-				const void* p = &ptr[pos];
-
-				entityLoader(objectKey, containerKey, type, ctype, unpackedSize, DKData::StaticData(p, dataLength), loader, restoreEntities, this->entityMap);
-
-				data->UnlockShared();
+				entityLoader(objectKey, containerKey, type, ctype, unpackedSize, data->Slice(pos, dataLength), loader, restoreEntities, this->entityMap);
 				pos += dataLength;
 				s->SetCurrentPosition(pos);
 			}
@@ -1895,13 +2140,30 @@ bool DKSerializer::Deserialize(DKStream* s, DKResourceLoader* p) const
 		s->SetCurrentPosition(pos);
 		if (validHeader)	// format is binary
 		{
+			if (s->IsSeekable() && dynamic_cast<DKDataStream*>(s) == NULL)
+			{
+				// read-ahead, unread bytes are given back when finished.
+				DKBufferedStream bufferedStream(s);
+				return DeserializeBinary(&bufferedStream, p);
+			}
 			return DeserializeBinary(s, p);
 		}
-		else // try to open with XMLParser.
+		else // XML, read from data.
 		{
-			DKObject<DKXmlDocument> doc = DKXmlDocument::Open(DKXmlDocument::TypeXML, s);
-			if (doc)
-				return Deserialize(doc->RootElement(), p);
+			DKObject<DKDataStream> ds = DKObject<DKStream>(s).SafeCast<DKDataStream>();
+			DKObject<DKData> data = NULL;
+			if (ds && ds->Data())
+			{
+				// remaining data from current position, without copy.
+				DKStream::Position pos = ds->CurrentPosition();
+				DKStream::Position remain = ds->RemainLength();
+				data = ds->Data()->Slice(pos, remain);
+				ds->SetCurrentPosition(pos + remain);
+			}
+			else
+				data = DKBuffer::Create(s);
+			if (data)
+				return Deserialize(data, p);
 		}
 	}
 	return false;
@@ -1926,6 +2188,13 @@ bool DKSerializer::Deserialize(const DKData* d, DKResourceLoader* p) const
 
 		if (validHeader)		// format is binary
 		{
+			DKObject<DKData> source = const_cast<DKData*>(d);
+			if (source.IsManaged())
+			{
+				// chunks are sliced from source data directly.
+				DKDataStream stream(source);
+				return DeserializeBinary(&stream, p);
+			}
 			const void* ptr = d->LockShared();
 			DKObject<DKData> data = DKData::StaticData(ptr, d->Length());
 			DKDataStream stream(data);
@@ -1934,11 +2203,17 @@ bool DKSerializer::Deserialize(const DKData* d, DKResourceLoader* p) const
 			d->UnlockShared();
 			return ret;
 		}
-		else // try to open with XMLParser.
+		else // try to open with XML reader, DKXmlDocument if document is not supported.
 		{
-			DKObject<DKXmlDocument> doc = DKXmlDocument::Open(DKXmlDocument::TypeXML, d);
-			if (doc)
-				return Deserialize(doc->RootElement(), p);
+			DKObject<DKXmlReader> reader = DKXmlReader::Open(d);
+			if (reader && reader->ReadRootElement())
+				return Deserialize(*reader, p);
+			if (reader == NULL || reader->Error() == DKXmlReader::ErrorUnsupported)
+			{
+				DKObject<DKXmlDocument> doc = DKXmlDocument::Open(DKXmlDocument::TypeXML, d);
+				if (doc)
+					return Deserialize(doc->RootElement(), p);
+			}
 		}
 	}
 	return false;
@@ -2045,6 +2320,22 @@ bool DKSerializer::RestoreObject(const DKXmlElement* e, DKResourceLoader* p, Sel
 	return false;
 }
 
+bool DKSerializer::RestoreObject(DKXmlReader& reader, DKResourceLoader* p, Selector* sel)
+{
+	if (sel && reader.CurrentNodeType() == DKXmlReader::NodeTypeStartElement &&
+		reader.LocalName().EqualsNoCase("DKSerializer"))
+	{
+		size_t index = reader.FindAttribute("class");
+		if (index < reader.NumberOfAttributes())
+		{
+			DKObject<DKSerializer> s = sel->Invoke(reader.AttributeValue(index));
+			if (s)
+				return s->Deserialize(reader, p);
+		}
+	}
+	return false;
+}
+
 bool DKSerializer::RestoreObject(DKStream* s, DKResourceLoader* p, Selector* sel)
 {
 	if (s && s->IsReadable() && sel)
@@ -2063,13 +2354,30 @@ bool DKSerializer::RestoreObject(DKStream* s, DKResourceLoader* p, Selector* sel
 		s->SetCurrentPosition(pos);
 		if (validHeader)	// format is binary
 		{
+			if (s->IsSeekable() && dynamic_cast<DKDataStream*>(s) == NULL)
+			{
+				// read-ahead, unread bytes are given back when finished.
+				DKBufferedStream bufferedStream(s);
+				return DeserializeBinary(&bufferedStream, p, sel);
+			}
 			return DeserializeBinary(s, p, sel);
 		}
-		else
+		else // XML, read from data.
 		{
-			DKObject<DKXmlDocument> doc = DKXmlDocument::Open(DKXmlDocument::TypeXML, s);
-			if (doc)
-				return RestoreObject(doc->RootElement(), p, sel);
+			DKObject<DKDataStream> ds = DKObject<DKStream>(s).SafeCast<DKDataStream>();
+			DKObject<DKData> data = NULL;
+			if (ds && ds->Data())
+			{
+				// remaining data from current position, without copy.
+				DKStream::Position pos = ds->CurrentPosition();
+				DKStream::Position remain = ds->RemainLength();
+				data = ds->Data()->Slice(pos, remain);
+				ds->SetCurrentPosition(pos + remain);
+			}
+			else
+				data = DKBuffer::Create(s);
+			if (data)
+				return RestoreObject(data, p, sel);
 		}
 	}
 	return false;
@@ -2094,6 +2402,12 @@ bool DKSerializer::RestoreObject(const DKData* d, DKResourceLoader* p, Selector*
 
 		if (validHeader)
 		{
+			DKObject<DKData> source = const_cast<DKData*>(d);
+			if (source.IsManaged())
+			{
+				DKDataStream stream(source);
+				return DeserializeBinary(&stream, p, sel);
+			}
 			const void* ptr2 = d->LockShared();
 			DKObject<DKData> data = DKData::StaticData(ptr2, d->Length());
 			DKDataStream stream(data);
@@ -2102,11 +2416,17 @@ bool DKSerializer::RestoreObject(const DKData* d, DKResourceLoader* p, Selector*
 			d->UnlockShared();
 			return ret;
 		}
-		else
+		else // try to open with XML reader, DKXmlDocument if document is not supported.
 		{
-			DKObject<DKXmlDocument> doc = DKXmlDocument::Open(DKXmlDocument::TypeXML, d);
-			if (doc)
-				return RestoreObject(doc->RootElement(), p, sel);
+			DKObject<DKXmlReader> reader = DKXmlReader::Open(d);
+			if (reader && reader->ReadRootElement())
+				return RestoreObject(*reader, p, sel);
+			if (reader == NULL || reader->Error() == DKXmlReader::ErrorUnsupported)
+			{
+				DKObject<DKXmlDocument> doc = DKXmlDocument::Open(DKXmlDocument::TypeXML, d);
+				if (doc)
+					return RestoreObject(doc->RootElement(), p, sel);
+			}
 		}
 	}
 	return false;
@@ -160,11 +160,15 @@ namespace DKFramework
 		size_t Serialize(SerializeForm sf, DKStream* output) const;
 		DKObject<DKXmlElement> SerializeXML(SerializeForm sf) const;
 		bool Deserialize(const DKXmlElement* e, DKResourceLoader* p) const;
+		/// deserialize with XML reader, reader should be on StartElement.
+		/// reader moves to end of element.
+		bool Deserialize(DKXmlReader& reader, DKResourceLoader* p) const;
 		bool Deserialize(DKStream* s, DKResourceLoader* p) const;
 		bool Deserialize(const DKData* d, DKResourceLoader* p) const;
 
 		typedef DKFunctionSignature<DKObject<DKSerializer> (const DKString&)> Selector;
 		static bool RestoreObject(const DKXmlElement* e, DKResourceLoader* p, Selector* sel);
+		static bool RestoreObject(DKXmlReader& reader, DKResourceLoader* p, Selector* sel);
 		static bool RestoreObject(DKStream* s, DKResourceLoader* p, Selector* sel);
 		static bool RestoreObject(const DKData* d, DKResourceLoader* p, Selector* sel);
 
@@ -242,6 +246,7 @@ namespace DKFramework
 		};
 
 		bool DeserializeXMLOperations(const DKXmlElement* e, DKArray<DKObject<DeserializerEntity>>& entities, DKResourceLoader* pool) const;
+		bool DeserializeXMLOperations(DKXmlReader& reader, DKArray<DKObject<DeserializerEntity>>& entities, DKResourceLoader* pool) const;
 		bool DeserializeBinaryOperations(DKStream* s, DKArray<DKObject<DeserializerEntity>>& entities, DKResourceLoader* pool) const;
 		size_t SerializeBinary(SerializeForm sf, DKStream* output) const;
 		bool DeserializeBinary(DKStream* s, DKResourceLoader* p) const;
@@ -2,25 +2,269 @@
 //  File: DKUpdateQueue.cpp
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2017 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
+#include <atomic>
 #include "DKUpdateQueue.h"
 
 using namespace DKFramework;
 
+namespace DKFramework
+{
+	namespace Private
+	{
+		/// @brief update functions of a frame, shared by serial and parallel queue.
+		/// Each function (task) can be processed by operation-queue thread,
+		/// by thread calls Complete(), or by thread waiting for it with
+		/// Synchronize(). Task state transition (Pending -> Running) is done
+		/// with CAS, so that any task being processed only once.
+		class UpdateBatch
+		{
+		public:
+			enum TaskState : int
+			{
+				TaskPending = 0,
+				TaskRunning,
+				TaskFinished,
+			};
+			struct Task : public DKOperation
+			{
+				UpdateBatch* batch;
+				DKObject<DKUpdateQueue::Function> function;
+				void* object;
+				DKTimeTick tick;
+				double tickDelta;
+				DKDateTime tickDate;
+				mutable std::atomic<int> state;
+				mutable std::atomic<bool> completed;	// finished or SetComplete() called.
+
+				void Perform() const override
+				{
+					// task can be processed already by other thread.
+					if (state.load(std::memory_order_acquire) == TaskPending)
+						batch->Run(const_cast<Task*>(this));
+				}
+			};
+			struct TaskSynchronizer : public DKUpdateQueue::Synchronizer
+			{
+				UpdateBatch* batch;
+				Task* task;
+
+				void SetComplete() override
+				{
+					batch->SetComplete(task);
+				}
+				void Synchronize(void* object) override
+				{
+					batch->Synchronize(task, object);
+				}
+				void Enqueue(DKUpdateQueue::Function* fn, void* object) override
+				{
+					batch->Add(fn, object, tick, tickDelta, tickDate);
+				}
+			};
+
+			UpdateBatch(DKOperationQueue* q)
+				: operationQueue(q)
+				, unfinished(0)
+				, waiters(0)
+			{
+			}
+			~UpdateBatch()
+			{
+				DKASSERT_DEBUG(unfinished == 0);
+			}
+
+			void Add(DKUpdateQueue::Function* fn, void* object, DKTimeTick tick, double tickDelta, const DKDateTime& tickDate)
+			{
+				if (fn == NULL)
+					return;
+
+				DKObject<Task> task = DKOBJECT_NEW Task();
+				task->batch = this;
+				task->function = fn;
+				task->object = object;
+				task->tick = tick;
+				task->tickDelta = tickDelta;
+				task->tickDate = tickDate;
+				task->state = TaskPending;
+				task->completed = false;
+
+				unfinished.fetch_add(1, std::memory_order_relaxed);
+				lock.Lock();
+				tasks.Add(task);
+				if (object)
+					objectTasks.Update(object, task);	// last one wins
+				lock.Unlock();
+
+				if (operationQueue)
+					operationQueue->Post(task);
+			}
+
+			void Run(Task* task)
+			{
+				int expected = TaskPending;
+				if (!task->state.compare_exchange_strong(expected, TaskRunning, std::memory_order_acq_rel))
+					return;
+
+				TaskSynchronizer sync;
+				sync.batch = this;
+				sync.task = task;
+				sync.tick = task->tick;
+				sync.tickDelta = task->tickDelta;
+				sync.tickDate = task->tickDate;
+				task->function->Invoke(sync);
+
+				SetComplete(task);
+				task->state.store(TaskFinished, std::memory_order_release);
+				unfinished.fetch_sub(1, std::memory_order_seq_cst);
+				Notify();
+			}
+
+			void SetComplete(Task* task)
+			{
+				if (!task->completed.exchange(true, std::memory_order_seq_cst))
+					Notify();
+			}
+
+			void Synchronize(Task* current, void* object)
+			{
+				if (object == NULL)
+					return;
+
+				Task* task = NULL;
+				lock.Lock();
+				auto p = objectTasks.Find(object);
+				if (p)
+					task = p->value;
+				lock.Unlock();
+
+				if (task == NULL || task == current)
+					return;
+
+				// process dependency in current thread if it is not started yet.
+				Run(task);
+
+				if (!task->completed.load(std::memory_order_seq_cst))
+				{
+					Wait([task] { return task->completed.load(std::memory_order_seq_cst); });
+				}
+			}
+
+			/// process pending tasks in calling thread, and wait for all tasks to finish.
+			void Complete()
+			{
+				for (size_t i = 0; ; ++i)
+				{
+					Task* task = NULL;
+					lock.Lock();
+					if (i < tasks.Count())
+						task = tasks.Value(i);
+					lock.Unlock();
+
+					if (task == NULL)
+						break;
+					Run(task);
+				}
+
+				if (unfinished.load(std::memory_order_seq_cst) > 0)
+				{
+					Wait([this] { return unfinished.load(std::memory_order_seq_cst) == 0; });
+				}
+
+				lock.Lock();
+				tasks.Clear();
+				objectTasks.Clear();
+				lock.Unlock();
+			}
+
+		private:
+			template <typename T> void Wait(T&& isDone)
+			{
+				waiters.fetch_add(1, std::memory_order_seq_cst);
+				condition.Lock();
+				while (!isDone())
+					condition.Wait();
+				condition.Unlock();
+				waiters.fetch_sub(1, std::memory_order_relaxed);
+			}
+			void Notify()
+			{
+				// state was changed with seq_cst before reading waiters,
+				// a waiter either sees new state or gets broadcast.
+				if (waiters.load(std::memory_order_seq_cst) > 0)
+				{
+					condition.Lock();
+					condition.Broadcast();
+					condition.Unlock();
+				}
+			}
+
+			DKOperationQueue* operationQueue;
+			DKSpinLock lock;
+			DKArray<DKObject<Task>> tasks;
+			DKHashMap<void*, Task*> objectTasks;
+			std::atomic<size_t> unfinished;
+			std::atomic<size_t> waiters;
+			DKCondition condition;
+		};
+	}
+}
+using namespace DKFramework::Private;
+
+struct DKSerialUpdateQueue::Batch : public UpdateBatch
+{
+	Batch() : UpdateBatch(NULL) {}
+};
+
+struct DKParallelUpdateQueue::Batch : public UpdateBatch
+{
+	Batch(DKOperationQueue* q) : UpdateBatch(q) {}
+};
+
 DKSerialUpdateQueue::DKSerialUpdateQueue()
+	: batch(new Batch())
 {
 }
 
 DKSerialUpdateQueue::~DKSerialUpdateQueue()
 {
+	batch->Complete();
+	delete batch;
+}
+
+void DKSerialUpdateQueue::Complete()
+{
+	batch->Complete();
 }
 
-DKParallelUpdateQueue::DKParallelUpdateQueue()
+void DKSerialUpdateQueue::Enqueue(Function* fn, void* object)
 {
+	batch->Add(fn, object, tick, tickDelta, tickDate);
+}
+
+DKParallelUpdateQueue::DKParallelUpdateQueue(DKOperationQueue* queue)
+	: operationQueue(queue)
+	, batch(NULL)
+{
+	if (operationQueue == NULL)
+		operationQueue = DKOBJECT_NEW DKOperationQueue();
+	batch = new Batch(operationQueue);
 }
 
 DKParallelUpdateQueue::~DKParallelUpdateQueue()
 {
+	batch->Complete();
+	delete batch;
+}
+
+void DKParallelUpdateQueue::Complete()
+{
+	batch->Complete();
+}
+
+void DKParallelUpdateQueue::Enqueue(Function* fn, void* object)
+{
+	batch->Add(fn, object, tick, tickDelta, tickDate);
 }
@@ -2,7 +2,7 @@
 //  File: DKUpdateQueue.h
 //  Author: Hongtae Kim (tiff2766@gmail.com)
 //
-//  Copyright (c) 2004-2017 Hongtae Kim. All rights reserved.
+//  Copyright (c) 2004-2020 Hongtae Kim. All rights reserved.
 //
 
 #pragma once
@@ -11,29 +11,65 @@
 
 namespace DKFramework
 {
+	class DKAsynchronousUpdatable;
+
 	/// @brief
 	/// object update queue, enables parallel updates
+	///
+	/// Enqueue update functions for a frame, and call Complete() to wait
+	/// until all functions are finished. (frame barrier)
+	/// An update function can wait for other object's update with
+	/// Synchronizer::Synchronize(object), if the object was enqueued in
+	/// the same frame with Enqueue(fn, object).
+	///
+	/// Example:
+	/// @code
+	///  queue->tick = tick; ...
+	///  queue->Enqueue(DKFunction(...), model);
+	///  queue->Enqueue(DKFunction([=](DKUpdateQueueSynchronizer& sync)
+	///  {
+	///      sync.Synchronize(model);  // wait for model update
+	///      ...
+	///  }));
+	///  queue->Complete();  // wait for all updates
+	/// @endcode
+	///
+	/// @note
+	///  Dependency should be enqueued before function which synchronizes it,
+	///  parallel queue starts function immediately, Synchronize() does not
+	///  wait for object which is not enqueued yet.
+	///  If an object enqueued multiple times, last one will be synchronized.
+	///  Circular dependency (two objects synchronize each other) makes deadlock.
+	///  Do not call Complete() from update function.
+	///
 	/// @see DKParallelUpdateQueue for parallel update.
-	/// @see DKSeiralUpdateQueue for serial update.
+	/// @see DKSerialUpdateQueue for serial update.
 	class DKUpdateQueue
 	{
 	public:
+		struct Synchronizer;
+		using Function = DKFunctionSignature<void(Synchronizer&)>;
+
 		struct Synchronizer
 		{
 			DKTimeTick tick;
 			double tickDelta;
 			DKDateTime tickDate;
 
+			virtual ~Synchronizer() {}
 			virtual void SetComplete() = 0; ///< Set this update process is just finished.
 			virtual void Synchronize(void*) = 0; ///< Wait for other object to finish
-			virtual void Enqueue(DKFunctionSignature<void(Synchronizer&)>) = 0; ///< enqueue follow up object
+			virtual void Enqueue(Function*, void* object = NULL) = 0; ///< enqueue follow up object
 		};
 
-		DKUpdateQueue() {}
+		DKUpdateQueue() : tick(0), tickDelta(0.0) {}
 		virtual ~DKUpdateQueue() {}
 
 		virtual void Complete() = 0; ///< Wait all objects are finished.
-		virtual void Enqueue(DKFunctionSignature<void(Synchronizer&)> fn) = 0;
+		/// enqueue update function, object is used as key for Synchronizer::Synchronize.
+		virtual void Enqueue(Function* fn, void* object = NULL) = 0;
+		/// enqueue DKAsynchronousUpdatable::Update with object as key.
+		void Enqueue(DKAsynchronousUpdatable* obj);
 
 		DKTimeTick tick;
 		double tickDelta;
@@ -48,21 +84,50 @@ namespace DKFramework
 		virtual void Update(DKUpdateQueueSynchronizer&) = 0;
 	};
 
+	inline void DKUpdateQueue::Enqueue(DKAsynchronousUpdatable* obj)
+	{
+		if (obj)
+			Enqueue(DKFunction(obj, &DKAsynchronousUpdatable::Update), obj);
+	}
+
 	/// @brief
 	/// serial update queue
+	/// functions are processed in calling thread of Complete().
 	class DKGL_API DKSerialUpdateQueue : public DKUpdateQueue
 	{
 	public:
 		DKSerialUpdateQueue();
 		~DKSerialUpdateQueue();
+
+		void Complete() override;
+		void Enqueue(Function* fn, void* object = NULL) override;
+		using DKUpdateQueue::Enqueue;
+
+	private:
+		struct Batch;
+		Batch* batch;
 	};
 
 	/// @brief
 	/// parallel (multi threaded) update queue
+	/// functions are processed by DKOperationQueue as soon as enqueued,
+	/// calling thread of Complete() also processes pending functions.
+	/// Synchronize() processes pending function of dependency in
+	/// current thread, or waits until other thread finishes it.
 	class DKGL_API DKParallelUpdateQueue : public DKUpdateQueue
 	{
 	public:
-		DKParallelUpdateQueue();
+		/// create own operation queue if queue is NULL
+		DKParallelUpdateQueue(DKOperationQueue* queue = NULL);
 		~DKParallelUpdateQueue();
+
+		void Complete() override;
+		void Enqueue(Function* fn, void* object = NULL) override;
+		using DKUpdateQueue::Enqueue;
+
+	private:
+		struct Batch;
+		DKObject<DKOperationQueue> operationQueue;
+		Batch* batch;
 	};
 }
@@ -106,7 +106,11 @@ namespace DKFramework
 						v2 == DKString::CharT('2') ||
 						v2 == DKString::CharT('4') ||
 						v2 == DKString::CharT('8'))
+					{
+						uint8_t size = static_cast<uint8_t>(v2 - DKString::CharT('0'));
+						out = static_cast<StructElem>(v1 == DKString::CharT('a') ? size : uint8_t(0x100 - size));
 						return true;
+					}
 				}
 			}
 			return false;
@@ -161,6 +165,118 @@ namespace DKFramework
 			return true;
 		}
 
+		static bool ConvertStringToStructElementLayout(const DKString& str, DKArray<StructElem>& layout)
+		{
+			DKString::StringArray layoutStrArray = str.Split(L",");
+			for (DKString& elemStr : layoutStrArray)
+			{
+				DKString s = elemStr.TrimWhitespaces();
+				StructElem el;
+				if (ConvertStringToStructElement(s, el))
+					layout.Add(el);
+				else
+				{
+					layout.Clear();
+					DKLog("Warning: DKVariant::VStructuredData.layout is invalid!\n");
+					return false;
+				}
+			}
+			return true;
+		}
+		// set value of scalar types (not container, data) from XML text.
+		static void SetVariantValueWithXMLString(DKVariant& v, DKString& value)
+		{
+			if (v.ValueType() == DKVariant::TypeString)
+			{
+				v.String() = static_cast<DKString&&>(value);
+			}
+			else if (v.ValueType() == DKVariant::TypeRationalNumber)
+			{
+				DKString::IntegerArray intArray = value.ToIntegerArray(L"/");
+				DKVariant::VRationalNumber::Integer val[2] = { 0LL, 1LL };
+				for (size_t i = 0; i < 2 && i < intArray.Count(); ++i)
+					val[i] = intArray.Value(i);
+				v.RationalNumber() = DKVariant::VRationalNumber(val[0], val[1]);
+			}
+			else if (v.ValueType() == DKVariant::TypeDateTime)
+			{
+				if (!DKDateTime::GetDateTime(v.DateTime(), value))
+				{
+					v.DateTime() = DKDateTime(0, 0);
+				}
+			}
+			else if (v.ValueType() == DKVariant::TypeInteger)
+			{
+				v.Integer() = value.ToInteger();
+			}
+			else if (v.ValueType() == DKVariant::TypeFloat)
+			{
+				v.Float() = value.ToRealNumber();
+			}
+			else
+			{
+				DKString::RealNumberArray floatArray = value.ToRealNumberArray(L",");
+				if (v.ValueType() == DKVariant::TypeVector2)
+				{
+					if (floatArray.Count() < 2)
+						v.Vector2() = DKVariant::VVector2(0, 0);
+					else
+						v.Vector2() = DKVariant::VVector2(floatArray.Value(0), floatArray.Value(1));
+				}
+				else if (v.ValueType() == DKVariant::TypeVector3)
+				{
+					if (floatArray.Count() < 3)
+						v.Vector3() = DKVariant::VVector3(0, 0, 0);
+					else
+						v.Vector3() = DKVariant::VVector3(floatArray.Value(0), floatArray.Value(1), floatArray.Value(2));
+				}
+				else if (v.ValueType() == DKVariant::TypeVector4)
+				{
+					if (floatArray.Count() < 4)
+						v.Vector4() = DKVariant::VVector4(0, 0, 0, 0);
+					else
+						v.Vector4() = DKVariant::VVector4(floatArray.Value(0), floatArray.Value(1), floatArray.Value(2), floatArray.Value(3));
+				}
+				else if (v.ValueType() == DKVariant::TypeMatrix2)
+				{
+					if (floatArray.Count() < 4)
+						v.Matrix2().SetIdentity();
+					else
+					{
+						for (int i = 0; i < 4; ++i)
+							v.Matrix2().val[i] = floatArray.Value(i);
+					}
+				}
+				else if (v.ValueType() == DKVariant::TypeMatrix3)
+				{
+					if (floatArray.Count() < 9)
+						v.Matrix3().SetIdentity();
+					else
+					{
+						for (int i = 0; i < 9; ++i)
+							v.Matrix3().val[i] = floatArray.Value(i);
+					}
+				}
+				else if (v.ValueType() == DKVariant::TypeMatrix4)
+				{
+					if (floatArray.Count() < 16)
+						v.Matrix4().SetIdentity();
+					else
+					{
+						for (int i = 0; i < 16; ++i)
+							v.Matrix4().val[i] = floatArray.Value(i);
+					}
+				}
+				else if (v.ValueType() == DKVariant::TypeQuaternion)
+				{
+					if (floatArray.Count() < 4)
+						v.Quaternion().Identity();
+					else
+						v.Quaternion() = DKVariant::VQuaternion(floatArray.Value(0), floatArray.Value(1), floatArray.Value(2), floatArray.Value(3));
+				}
+			}
+		}
+
 		struct DataProxy
 		{
 			DKObject<DKData> data;
@@ -811,20 +927,7 @@ bool DKVariant::ImportXML(const DKXmlElement* e)
 								}
 							}
 						}
-						DKString::StringArray layoutStrArray = layoutData.Split(L",");
-						for (DKString& elemStr : layoutStrArray)
-						{
-							DKString s = elemStr.TrimWhitespaces();
-							StructElem el;
-							if (ConvertStringToStructElement(s, el))
-								stData.layout.Add(el);
-							else
-							{
-								stData.layout.Clear();
-								DKLog("Warning: DKVariant::VStructuredData.layout is invalid!\n");
-								break;
-							}
-						}
+						ConvertStringToStructElementLayout(layoutData, stData.layout);
 						break;
 					}
 				}
@@ -864,99 +967,191 @@ bool DKVariant::ImportXML(const DKXmlElement* e)
 					value.Append(e->nodes.Value(i).SafeCast<DKXmlPCData>()->value);
 				}
 			}
-			if (this->ValueType() == TypeString)
-			{
-				this->String() = static_cast<DKString&&>(value);
-			}
-			else if (this->ValueType() == TypeRationalNumber)
+			SetVariantValueWithXMLString(*this, value);
+		}
+		return true;
+	}
+	return false;
+}
+
+bool DKVariant::ImportXML(DKXmlReader& reader)
+{
+	if (reader.CurrentNodeType() != DKXmlReader::NodeTypeStartElement ||
+		!reader.LocalName().EqualsNoCase("DKVariant"))
+		return false;
+
+	static const struct { const char* name; Type type; } xmlTypes[] =
+	{
+		{ "integer", TypeInteger },
+		{ "float", TypeFloat },
+		{ "vector2", TypeVector2 },
+		{ "vector3", TypeVector3 },
+		{ "vector4", TypeVector4 },
+		{ "matrix2", TypeMatrix2 },
+		{ "matrix3", TypeMatrix3 },
+		{ "matrix4", TypeMatrix4 },
+		{ "quaternion", TypeQuaternion },
+		{ "rationalnumber", TypeRationalNumber },
+		{ "string", TypeString },
+		{ "datetime", TypeDateTime },
+		{ "data", TypeData },
+		{ "structdata", TypeStructData },
+		{ "array", TypeArray },
+		{ "pairs", TypePairs },
+	};
+	this->SetValueType(TypeUndefined);
+	DKXmlReader::StringView typeName = reader.AttributeRawValue(reader.FindAttribute("type"));
+	for (auto& t : xmlTypes)
+	{
+		if (typeName.EqualsNoCase(t.name))
+		{
+			this->SetValueType(t.type);
+			break;
+		}
+	}
+
+	bool result = false;
+	if (this->ValueType() == TypeArray)
+	{
+		VArray va;
+		result = reader.EnumerateChildNodes([&va](DKXmlReader& r)
+		{
+			if (r.CurrentNodeType() == DKXmlReader::NodeTypeStartElement &&
+				r.LocalName().EqualsNoCase("DKVariant"))
 			{
-				DKString::IntegerArray intArray = value.ToIntegerArray(L"/");
-				VRationalNumber::Integer val[2] = { 0LL, 1LL };
-				for (size_t i = 0; i < 2 && i < intArray.Count(); ++i)
-					val[i] = intArray.Value(i);
-				this->RationalNumber() = VRationalNumber(val[0], val[1]);
+				DKVariant v;
+				v.ImportXML(r);
+				va.Add(static_cast<DKVariant&&>(v));
 			}
-			else if (this->ValueType() == TypeDateTime)
+		});
+		this->Array() = static_cast<VArray&&>(va);
+	}
+	else if (this->ValueType() == TypePairs)
+	{
+		VPairs vm;
+		result = reader.EnumerateChildNodes([&vm](DKXmlReader& r)
+		{
+			if (r.CurrentNodeType() == DKXmlReader::NodeTypeStartElement &&
+				r.LocalName().EqualsNoCase("Node"))
 			{
-				if (!DKDateTime::GetDateTime(this->DateTime(), value))
+				bool keyFound = false;
+				DKString key = L"";
+				DKVariant value;
+				r.EnumerateChildNodes([&](DKXmlReader& r2)
 				{
-					this->DateTime() = DKDateTime(0, 0);
-				}
-			}
-			else if (this->ValueType() == TypeInteger)
-			{
-				this->Integer() = value.ToInteger();
+					if (r2.CurrentNodeType() == DKXmlReader::NodeTypeStartElement)
+					{
+						if (r2.LocalName().EqualsNoCase("Key"))
+						{
+							r2.EnumerateChildNodes([&key](DKXmlReader& r3)
+							{
+								if (r3.CurrentNodeType() == DKXmlReader::NodeTypeText ||
+									r3.CurrentNodeType() == DKXmlReader::NodeTypeCData)
+									r3.AppendValue(key);
+							});
+							keyFound = true;
+						}
+						else if (r2.LocalName().EqualsNoCase("DKVariant"))
+						{
+							value.ImportXML(r2);
+						}
+					}
+				});
+				if (keyFound)
+					vm.Update(key, value);
 			}
-			else if (this->ValueType() == TypeFloat)
+		});
+		this->Pairs() = static_cast<VPairs&&>(vm);
+	}
+	else if (this->ValueType() == TypeData)
+	{
+		DKObject<DKBuffer> compressed = NULL;
+		bool found = false;
+		result = reader.EnumerateChildNodes([&](DKXmlReader& r)
+		{
+			if (!found && r.CurrentNodeType() == DKXmlReader::NodeTypeCData)
 			{
-				this->Float() = value.ToRealNumber();
+				DKXmlReader::StringView value = r.RawValue();
+				compressed = DKBuffer::Base64Decode(value.str, value.length);
+				found = true;
 			}
-			else
+		});
+		if (compressed)
+		{
+			DKObject<DKBuffer> d = compressed->Decompress();
+			this->SetData(d);
+		}
+		else
+			this->SetData(0);
+	}
+	else if (this->ValueType() == TypeStructData)
+	{
+		DKByteOrder dataByteOrder = DKRuntimeByteOrder();
+		VStructuredData& stData = this->StructuredData();
+		bool layoutFound = false;
+		DKObject<DKBuffer> data = NULL;
+		result = reader.EnumerateChildNodes([&](DKXmlReader& r)
+		{
+			if (r.CurrentNodeType() == DKXmlReader::NodeTypeStartElement)
 			{
-				DKString::RealNumberArray floatArray = value.ToRealNumberArray(L",");
-				if (this->ValueType() == TypeVector2)
-				{
-					if (floatArray.Count() < 2)
-						this->Vector2() = VVector2(0, 0);
-					else
-						this->Vector2() = VVector2(floatArray.Value(0), floatArray.Value(1));
-				}
-				else if (this->ValueType() == TypeVector3)
-				{
-					if (floatArray.Count() < 3)
-						this->Vector3() = VVector3(0, 0, 0);
-					else
-						this->Vector3() = VVector3(floatArray.Value(0), floatArray.Value(1), floatArray.Value(2));
-				}
-				else if (this->ValueType() == TypeVector4)
+				if (!layoutFound && r.LocalName().EqualsNoCase("layout"))
 				{
-					if (floatArray.Count() < 4)
-						this->Vector4() = VVector4(0, 0, 0, 0);
-					else
-						this->Vector4() = VVector4(floatArray.Value(0), floatArray.Value(1), floatArray.Value(2), floatArray.Value(3));
-				}
-				else if (this->ValueType() == TypeMatrix2)
-				{
-					if (floatArray.Count() < 4)
-						this->Matrix2().SetIdentity();
-					else
+					layoutFound = true;
+					for (size_t i = 0; i < r.NumberOfAttributes(); ++i)
 					{
-						for (int i = 0; i < 4; ++i)
-							this->Matrix2().val[i] = floatArray.Value(i);
-					}
-				}
-				else if (this->ValueType() == TypeMatrix3)
-				{
-					if (floatArray.Count() < 9)
-						this->Matrix3().SetIdentity();
-					else
-					{
-						for (int i = 0; i < 9; ++i)
-							this->Matrix3().val[i] = floatArray.Value(i);
+						DKXmlReader::StringView name = r.AttributeLocalName(i);
+						if (name.EqualsNoCase("elementSize"))
+						{
+							stData.elementSize = r.AttributeValue(i).ToUnsignedInteger();
+						}
+						else if (name.EqualsNoCase("byteorder"))
+						{
+							DKXmlReader::StringView bo = r.AttributeRawValue(i);
+							if (bo.EqualsNoCase("BE"))
+								dataByteOrder = DKByteOrder::BigEndian;
+							else if (bo.EqualsNoCase("LE"))
+								dataByteOrder = DKByteOrder::LittleEndian;
+						}
 					}
-				}
-				else if (this->ValueType() == TypeMatrix4)
-				{
-					if (floatArray.Count() < 16)
-						this->Matrix4().SetIdentity();
-					else
+					DKString layoutData = L"";
+					r.EnumerateChildNodes([&layoutData](DKXmlReader& r2)
 					{
-						for (int i = 0; i < 16; ++i)
-							this->Matrix4().val[i] = floatArray.Value(i);
-					}
-				}
-				else if (this->ValueType() == TypeQuaternion)
-				{
-					if (floatArray.Count() < 4)
-						this->Quaternion().Identity();
-					else
-						this->Quaternion() = VQuaternion(floatArray.Value(0), floatArray.Value(1), floatArray.Value(2), floatArray.Value(3));
+						if (r2.CurrentNodeType() == DKXmlReader::NodeTypeText)
+							r2.AppendValue(layoutData);
+					});
+					ConvertStringToStructElementLayout(layoutData, stData.layout);
 				}
 			}
+			else if (data == NULL && r.CurrentNodeType() == DKXmlReader::NodeTypeCData)
+			{
+				DKXmlReader::StringView value = r.RawValue();
+				DKObject<DKBuffer> compressed = DKBuffer::Base64Decode(value.str, value.length);
+				if (compressed)
+					data = compressed->Decompress();
+			}
+		});
+		// layout is required to convert byte order.
+		if (data)
+		{
+			stData.data = data;
+			if (!ConvertStructuredDataByteOrder(stData, dataByteOrder))
+			{
+				DKLogE("Error: DKVariant::VStructuredData data byte order error!\n");
+			}
 		}
-		return true;
 	}
-	return false;
+	else
+	{
+		DKString value = L"";
+		result = reader.EnumerateChildNodes([&value](DKXmlReader& r)
+		{
+			if (r.CurrentNodeType() == DKXmlReader::NodeTypeText)
+				r.AppendValue(value);
+		});
+		if (this->ValueType() != TypeUndefined)
+			SetVariantValueWithXMLString(*this, value);
+	}
+	return result;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1022,6 +1217,12 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 		errorDesc = L"Invalid stream.";
 		goto FAILED;
 	}
+	if (dynamic_cast<DKBufferedStream*>(stream) == NULL)
+	{
+		// coalesce small writes of nested values.
+		DKBufferedStream bufferedStream(stream);
+		return ExportStream(&bufferedStream, byteOrder) && bufferedStream.Flush();
+	}
 
 	switch (valueType)
 	{
@@ -1079,6 +1280,21 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 				v = this->bigEndian ? DKSystemToBigEndian(v) : DKSystemToLittleEndian(v);
 				return stream->Write(&v, sizeof(uint64_t)) == sizeof(uint64_t);
 			}
+			bool Write(const uint32_t* v, size_t count)	// up to 16 values
+			{
+				DKASSERT_DEBUG(count <= 16);
+				uint32_t tmp[16];
+				for (size_t i = 0; i < count; ++i)
+					tmp[i] = this->bigEndian ? DKSystemToBigEndian(v[i]) : DKSystemToLittleEndian(v[i]);
+				size_t len = sizeof(uint32_t) * count;
+				return stream->Write(tmp, len) == len;
+			}
+			bool WriteBytes(const void* p, uint64_t len)	// length-prefixed bytes
+			{
+				if (!Write(len))
+					return false;
+				return len == 0 || stream->Write(p, len) == len;
+			}
 		} output = { stream, byteOrder == DKByteOrder::BigEndian };
 
 		// version
@@ -1115,85 +1331,64 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 		else if (valueType == TypeVector2)
 		{
 			VVector2 value = this->Vector2();
-			for (int i = 0; i < 2; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 2))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeVector3)
 		{
 			VVector3 value = this->Vector3();
-			for (int i = 0; i < 3; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 3))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeVector4)
 		{
 			VVector4 value = this->Vector4();
-			for (int i = 0; i < 4; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 4))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeMatrix2)
 		{
 			VMatrix2 value = this->Matrix2();
-			for (int i = 0; i < 4; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 4))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeMatrix3)
 		{
 			VMatrix3 value = this->Matrix3();
-			for (int i = 0; i < 9; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 9))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeMatrix4)
 		{
 			VMatrix4 value = this->Matrix4();
-			for (int i = 0; i < 16; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 16))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeQuaternion)
 		{
 			VQuaternion value = this->Quaternion();
-			for (int i = 0; i < 4; ++i)
+			if (!output.Write(reinterpret_cast<const uint32_t*>(value.val), 4))
 			{
-				if (!output.Write(*reinterpret_cast<uint32_t*>(&value.val[i])))
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
+				errorDesc = L"Failed to write to stream.";
+				goto FAILED;
 			}
 		}
 		else if (valueType == TypeRationalNumber)
@@ -1212,13 +1407,7 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 		else if (valueType == TypeString)
 		{
 			DKStringU8 str(this->String());
-			uint64_t len = str.Bytes();
-			if (!output.Write(len))
-			{
-				errorDesc = L"Failed to write to stream.";
-				goto FAILED;
-			}
-			if (len > 0 && stream->Write((const char*)str, len) != len)
+			if (!output.WriteBytes((const char*)str, str.Bytes()))
 			{
 				errorDesc = L"Failed to write to stream.";
 				goto FAILED;
@@ -1240,14 +1429,7 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 		else if (valueType == TypeData)
 		{
 			const void* ptr = this->Data().LockShared();
-			uint64_t len = this->Data().Length();
-			if (!output.Write(len))
-			{
-				this->Data().UnlockShared();
-				errorDesc = L"Failed to write to stream.";
-				goto FAILED;
-			}
-			if (len > 0 && stream->Write(ptr, len) != len)
+			if (!output.WriteBytes(ptr, this->Data().Length()))
 			{
 				this->Data().UnlockShared();
 				errorDesc = L"Failed to write to stream.";
@@ -1298,7 +1480,7 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 								switch (fieldSize)
 								{
 								case 1:
-									succeeded = stream->Write(p2, 1) == 1;
+									succeeded = stream->Write(p2, 1) == 1; break;
 								case 2:
 									succeeded = output.Write(reinterpret_cast<const uint16_t*>(p2)[0]); break;
 								case 4:
@@ -1381,13 +1563,7 @@ bool DKVariant::ExportStream(DKStream* stream, DKByteOrder byteOrder) const
 				const VPairs::Pair* pair = a.Value(i);
 				DKStringU8 key(pair->key);
 
-				uint64_t keyLen = key.Bytes();
-				if (!output.Write(keyLen))  // key length
-				{
-					errorDesc = L"Failed to write to stream.";
-					goto FAILED;
-				}
-				if (keyLen > 0 && stream->Write((const char*)key, keyLen) != keyLen)	// key (utf8)
+				if (!output.WriteBytes((const char*)key, key.Bytes()))	// key (length, utf8)
 				{
 					errorDesc = L"Failed to write to stream.";
 					goto FAILED;
@@ -1432,6 +1608,14 @@ bool DKVariant::ImportStream(DKStream* stream)
 		errorDesc = L"Invalid stream.";
 		goto FAILED;
 	}
+	if (stream->IsSeekable() &&
+		dynamic_cast<DKDataStream*>(stream) == NULL &&
+		dynamic_cast<DKBufferedStream*>(stream) == NULL)
+	{
+		// read-ahead, unread bytes are given back when finished.
+		DKBufferedStream bufferedStream(stream);
+		return ImportStream(&bufferedStream);
+	}
 
 	char name[64];
 	if (stream->Read(name, headerLen) != headerLen)
@@ -2361,6 +2545,9 @@ bool DKVariant::IsEqual(const DKVariant& v) const
 		case TypeQuaternion:
 			result = this->Quaternion() == v.Quaternion();
 			break;
+		case TypeRationalNumber:
+			result = this->RationalNumber() == v.RationalNumber();
+			break;
 		case TypeString:
 			result = this->String() == v.String();
 			break;
@@ -135,6 +135,7 @@ namespace DKFramework
 
 		DKObject<DKXmlElement> ExportXML() const; ///< generate XML
 		bool ImportXML(const DKXmlElement* e); ///< import from XML
+		bool ImportXML(DKXmlReader& reader); ///< import from XML reader, reader moves to end of element.
 
 		bool ExportStream(DKStream* stream, DKByteOrder byteOrder = DKByteOrder::Unknown) const; ///< generate binary data
 		bool ImportStream(DKStream* stream); ///< import from binary data
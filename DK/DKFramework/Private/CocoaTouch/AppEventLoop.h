@@ -28,6 +28,7 @@ namespace DKFramework::Private::iOS
 
         DKObject<PendingState> Post(const DKOperation* operation, double delay) override;
         DKObject<PendingState> Post(const DKOperation* operation, const DKDateTime& runAfter) override;
+        using DKEventLoop::Post;
 
     private:
         void DispatchAndInstallTimer();
@@ -40,9 +40,9 @@ bool ComputeCommandEncoder::Encoder::Encode(VkCommandBuffer commandBuffer)
     {
         bs->CollectImageViewLayouts(state.imageLayoutMap, state.imageViewLayoutMap);
     }
-    for (EncoderCommand* c : setupCommands)
+    for (EncoderCommand& c : setupCommands)
     {
-        c->Invoke(commandBuffer, state);
+        c.Invoke(commandBuffer, state);
     }
     // Set image layout transition
     state.imageLayoutMap.EnumerateForward([&](decltype(state.imageLayoutMap)::Pair& pair)
@@ -58,13 +58,13 @@ bool ComputeCommandEncoder::Encoder::Encode(VkCommandBuffer commandBuffer)
                          state.encoder->commandBuffer->QueueFamily()->familyIndex,
                          commandBuffer);
     });
-    for (EncoderCommand* c : commands)
+    for (EncoderCommand& c : commands)
     {
-        c->Invoke(commandBuffer, state);
+        c.Invoke(commandBuffer, state);
     }
-    for (EncoderCommand* c : cleanupCommands)
+    for (EncoderCommand& c : cleanupCommands)
     {
-        c->Invoke(commandBuffer, state);
+        c.Invoke(commandBuffer, state);
     }
     return true;
 }
@@ -132,7 +132,7 @@ void ComputeCommandEncoder::SetResources(uint32_t index, const DKShaderBindingSe
         encoder->shaderBindingSets.Add(bindingSet);
     }
 
-    DKObject<EncoderCommand> preCommand = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand preCommand = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         if (bindingSet)
         {
@@ -147,10 +147,10 @@ void ComputeCommandEncoder::SetResources(uint32_t index, const DKShaderBindingSe
                 state.encoder->descriptorSets.Add(ds);
             }
         }
-    });
-    encoder->setupCommands.Add(preCommand);
+    };
+    encoder->setupCommands.Add(std::move(preCommand));
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         if (state.pipelineState)
         {
@@ -174,8 +174,8 @@ void ComputeCommandEncoder::SetResources(uint32_t index, const DKShaderBindingSe
                                     0,      // dynamic offsets
                                     0);
         }
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
 }
 
 void ComputeCommandEncoder::SetComputePipelineState(const DKComputePipelineState* ps)
@@ -183,22 +183,22 @@ void ComputeCommandEncoder::SetComputePipelineState(const DKComputePipelineState
     DKASSERT_DEBUG(dynamic_cast<const ComputePipelineState*>(ps));
     const ComputePipelineState* pipeline = static_cast<const ComputePipelineState*>(ps);
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
         state.pipelineState = const_cast<ComputePipelineState*>(pipeline);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->pipelineStateObjects.Add(const_cast<ComputePipelineState*>(pipeline));
 }
 
 void ComputeCommandEncoder::Dispatch(uint32_t numGroupsX, uint32_t numGroupsY, uint32_t numGroupsZ)
 {
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState & state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState & state) mutable
     {
         vkCmdDispatch(commandBuffer, numGroupsX, numGroupsY, numGroupsZ);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
 }
 
 #endif //#if DKGL_ENABLE_VULKAN
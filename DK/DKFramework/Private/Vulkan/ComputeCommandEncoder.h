@@ -27,7 +27,7 @@ namespace DKFramework::Private::Vulkan
             ShaderBindingSet::ImageViewLayoutMap imageViewLayoutMap;
             DKMap<ShaderBindingSet*, DescriptorSet*> bindingSetMap;
         };
-        using EncoderCommand = DKFunctionSignature<void(VkCommandBuffer, EncodingState&)>;
+        using EncoderCommand = DKInlineFunction<void(VkCommandBuffer, EncodingState&)>;
         class Encoder : public CommandEncoder
         {
         public:
@@ -44,9 +44,9 @@ namespace DKFramework::Private::Vulkan
             DKArray<DKObject<DKGpuSemaphore>> semaphores;
 
             class CommandBuffer* commandBuffer;
-            DKArray<DKObject<EncoderCommand>> commands;
-            DKArray<DKObject<EncoderCommand>> setupCommands;
-            DKArray<DKObject<EncoderCommand>> cleanupCommands;
+            DKArray<EncoderCommand> commands;
+            DKArray<EncoderCommand> setupCommands;
+            DKArray<EncoderCommand> cleanupCommands;
         };
         DKObject<Encoder> encoder;
 
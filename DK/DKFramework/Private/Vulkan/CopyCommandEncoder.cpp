@@ -35,17 +35,17 @@ bool CopyCommandEncoder::Encoder::Encode(VkCommandBuffer commandBuffer)
 {
     // recording commands
     EncodingState state = { this };
-    for (EncoderCommand* c : setupCommands)
+    for (EncoderCommand& c : setupCommands)
     {
-        c->Invoke(commandBuffer, state);
+        c.Invoke(commandBuffer, state);
     }
-    for (EncoderCommand* c : commands)
+    for (EncoderCommand& c : commands)
     {
-        c->Invoke(commandBuffer, state);
+        c.Invoke(commandBuffer, state);
     }
-    for (EncoderCommand* c : cleanupCommands)
+    for (EncoderCommand& c : cleanupCommands)
     {
-        c->Invoke(commandBuffer, state);
+        c.Invoke(commandBuffer, state);
     }
     return true;
 }
@@ -128,14 +128,14 @@ void CopyCommandEncoder::CopyFromBufferToBuffer(const DKGpuBuffer* src,
 
     VkBufferCopy region = {srcOffset, dstOffset, size};
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         vkCmdCopyBuffer(commandBuffer,
                         srcBuffer->buffer,
                         dstBuffer->buffer,
                         1, &region);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->buffers.Add(const_cast<DKGpuBuffer*>(src));
     encoder->buffers.Add(const_cast<DKGpuBuffer*>(dst));
 }
@@ -196,7 +196,7 @@ void CopyCommandEncoder::CopyFromBufferToTexture(const DKGpuBuffer* src,
     region.imageExtent = { size.width, size.height, size.depth };
     SetupSubresource(dstOffset, 1, pixelFormat, region.imageSubresource);
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         image->SetLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                          VK_ACCESS_TRANSFER_WRITE_BIT,
@@ -210,8 +210,8 @@ void CopyCommandEncoder::CopyFromBufferToTexture(const DKGpuBuffer* src,
                                image->image,
                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                                1, &region);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->buffers.Add(const_cast<DKGpuBuffer*>(src));
     encoder->textures.Add(const_cast<DKTexture*>(dst));
 }
@@ -272,7 +272,7 @@ void CopyCommandEncoder::CopyFromTextureToBuffer(const DKTexture* src,
     region.imageExtent = { size.width, size.height,size.depth };
     SetupSubresource(srcOffset, 1, pixelFormat, region.imageSubresource);
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         image->SetLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                          VK_ACCESS_TRANSFER_READ_BIT,
@@ -286,8 +286,8 @@ void CopyCommandEncoder::CopyFromTextureToBuffer(const DKTexture* src,
                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                                buffer->buffer,
                                1, &region);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->textures.Add(const_cast<DKTexture*>(src));
     encoder->buffers.Add(const_cast<DKGpuBuffer*>(dst));
 }
@@ -369,7 +369,7 @@ void CopyCommandEncoder::CopyFromTextureToTexture(const DKTexture* src,
     imageMemoryBarriers[1].image = srcImage->image;
     SetupSubresource(dstOffset, 1, 1, dstPixelFormat, imageMemoryBarriers[1].subresourceRange);
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         srcImage->SetLayout(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                             VK_ACCESS_TRANSFER_READ_BIT,
@@ -391,8 +391,8 @@ void CopyCommandEncoder::CopyFromTextureToTexture(const DKTexture* src,
                        dstImage->image,
                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                        1, &region);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->textures.Add(const_cast<DKTexture*>(src));
     encoder->textures.Add(const_cast<DKTexture*>(dst));
 }
@@ -415,15 +415,15 @@ void CopyCommandEncoder::FillBuffer(const DKGpuBuffer* buffer, size_t offset, si
                      uint32_t(value) << 8 |
                      uint32_t(value));
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         vkCmdFillBuffer(commandBuffer,
                         buf->buffer,
                         static_cast<VkDeviceSize>(offset),
                         static_cast<VkDeviceSize>(length),
                         data);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->buffers.Add(const_cast<DKGpuBuffer*>(buffer));
 }
 
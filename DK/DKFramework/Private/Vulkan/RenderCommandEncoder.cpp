@@ -249,8 +249,8 @@ bool RenderCommandEncoder::Encoder::Encode(VkCommandBuffer commandBuffer)
         bs->CollectImageViewLayouts(state.imageLayoutMap, state.imageViewLayoutMap);
     }
     // process pre-renderpass commands
-    for (EncoderCommand* c : setupCommands)
-        c->Invoke(commandBuffer, state);
+    for (EncoderCommand& c : setupCommands)
+        c.Invoke(commandBuffer, state);
 
     // Set image layout transition
     state.imageLayoutMap.EnumerateForward([&](decltype(state.imageLayoutMap)::Pair& pair)
@@ -300,14 +300,14 @@ bool RenderCommandEncoder::Encoder::Encode(VkCommandBuffer commandBuffer)
     vkCmdSetScissor(commandBuffer, 0, 1, &scissorRect);
    
     // recording commands
-    for (EncoderCommand* c : commands)
-        c->Invoke(commandBuffer, state);
+    for (EncoderCommand& c : commands)
+        c.Invoke(commandBuffer, state);
     // end render pass
     vkCmdEndRenderPass(commandBuffer);
 
     // process post-renderpass commands
-    for (EncoderCommand* c : cleanupCommands)
-        c->Invoke(commandBuffer, state);
+    for (EncoderCommand& c : cleanupCommands)
+        c.Invoke(commandBuffer, state);
 
     return true;
 }
@@ -373,11 +373,11 @@ void RenderCommandEncoder::SetViewport(const DKViewport& v)
 		viewport.y = viewport.y + viewport.height; // set origin to lower-left.
 		viewport.height = -(viewport.height); // negative height.
 	}
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
 }
 
 void RenderCommandEncoder::SetRenderPipelineState(const DKRenderPipelineState* ps)
@@ -385,12 +385,12 @@ void RenderCommandEncoder::SetRenderPipelineState(const DKRenderPipelineState* p
 	DKASSERT_DEBUG(dynamic_cast<const RenderPipelineState*>(ps));
 	const RenderPipelineState* pipeline = static_cast<const RenderPipelineState*>(ps);
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer buffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer buffer, EncodingState& state) mutable
     {
         vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
         state.pipelineState = const_cast<RenderPipelineState*>(pipeline);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->pipelineStateObjects.Add(const_cast<RenderPipelineState*>(pipeline));
 }
 
@@ -421,7 +421,7 @@ void RenderCommandEncoder::SetVertexBuffers(const DKGpuBuffer** buffers, const s
 
             encoder->buffers.Add(const_cast<DKGpuBuffer*>(bufferObject));
         }
-        DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+        EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
         {
             size_t numBuffers = bufferObjects.Count();
             size_t numOffsets = bufferOffsets.Count();
@@ -429,8 +429,8 @@ void RenderCommandEncoder::SetVertexBuffers(const DKGpuBuffer** buffers, const s
             DKASSERT_DEBUG(numBuffers == count);
 
             vkCmdBindVertexBuffers(commandBuffer, index, count, (VkBuffer*)bufferObjects, (VkDeviceSize*)bufferOffsets);
-        });
-        encoder->commands.Add(command);
+        };
+        encoder->commands.Add(std::move(command));
     }
 	else if (count > 0)
 	{
@@ -438,11 +438,11 @@ void RenderCommandEncoder::SetVertexBuffers(const DKGpuBuffer** buffers, const s
         DKASSERT_DEBUG(dynamic_cast<const BufferView*>(bufferObject) != nullptr);
         const Buffer* buf = static_cast<const BufferView*>(bufferObject)->buffer;
         VkDeviceSize of = offsets[0];
-        DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+        EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
         {
             vkCmdBindVertexBuffers(commandBuffer, index, count, &buf->buffer, &of);
-        });
-        encoder->commands.Add(command);
+        };
+        encoder->commands.Add(std::move(command));
         encoder->buffers.Add(const_cast<DKGpuBuffer*>(bufferObject));
     }
 }
@@ -464,11 +464,11 @@ void RenderCommandEncoder::SetIndexBuffer(const DKGpuBuffer* indexBuffer, size_t
 		DKLogE("ERROR: Unknown index type!");
 		return;
 	}
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& es) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& es) mutable
     {
         vkCmdBindIndexBuffer(commandBuffer, buffer->buffer, offset, indexType);
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
     encoder->buffers.Add(const_cast<DKGpuBuffer*>(indexBuffer));
 }
 
@@ -476,11 +476,11 @@ void RenderCommandEncoder::Draw(uint32_t numVertices, uint32_t numInstances, uin
 {
     if (numInstances > 0)
     {
-        DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+        EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
         {
             vkCmdDraw(commandBuffer, numVertices, numInstances, baseVertex, baseInstance);
-        });
-        encoder->commands.Add(command);
+        };
+        encoder->commands.Add(std::move(command));
     }
 }
 
@@ -488,11 +488,11 @@ void RenderCommandEncoder::DrawIndexed(uint32_t numIndices, uint32_t numInstance
 {
 	if (numInstances > 0)
 	{
-        DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+        EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
         {
             vkCmdDrawIndexed(commandBuffer, numIndices, numInstances, indexOffset, vertexOffset, baseInstance);
-        });
-        encoder->commands.Add(command);
+        };
+        encoder->commands.Add(std::move(command));
 	}
 }
 
@@ -507,7 +507,7 @@ void RenderCommandEncoder::SetResources(uint32_t index, const DKShaderBindingSet
         encoder->shaderBindingSets.Add(bindingSet);
     }
 
-    DKObject<EncoderCommand> preCommand = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand preCommand = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         if (bindingSet)
         {
@@ -522,10 +522,10 @@ void RenderCommandEncoder::SetResources(uint32_t index, const DKShaderBindingSet
                 state.encoder->descriptorSets.Add(ds);
             }
         }
-    });
-    encoder->setupCommands.Add(preCommand);
+    };
+    encoder->setupCommands.Add(std::move(preCommand));
 
-    DKObject<EncoderCommand> command = DKFunction([=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
+    EncoderCommand command = [=](VkCommandBuffer commandBuffer, EncodingState& state) mutable
     {
         if (state.pipelineState)
         {
@@ -549,8 +549,8 @@ void RenderCommandEncoder::SetResources(uint32_t index, const DKShaderBindingSet
                                     0,      // dynamic offsets
                                     0);
         }
-    });
-    encoder->commands.Add(command);
+    };
+    encoder->commands.Add(std::move(command));
 }
 
 #endif //#if DKGL_ENABLE_VULKAN
@@ -29,7 +29,7 @@ namespace DKFramework::Private::Vulkan
             ShaderBindingSet::ImageViewLayoutMap imageViewLayoutMap;
             DKMap<ShaderBindingSet*, DescriptorSet*> bindingSetMap;
         };
-        using EncoderCommand = DKFunctionSignature<void(VkCommandBuffer, EncodingState&)>;
+        using EncoderCommand = DKInlineFunction<void(VkCommandBuffer, EncodingState&)>;
         class Encoder : public CommandEncoder
         {
         public:
@@ -52,9 +52,9 @@ namespace DKFramework::Private::Vulkan
             VkRenderPass	 renderPass;
 
             class CommandBuffer* commandBuffer;
-            DKArray<DKObject<EncoderCommand>> commands;
-            DKArray<DKObject<EncoderCommand>> setupCommands;    // before renderPass
-            DKArray<DKObject<EncoderCommand>> cleanupCommands;  // after renderPass
+            DKArray<EncoderCommand> commands;
+            DKArray<EncoderCommand> setupCommands;    // before renderPass
+            DKArray<EncoderCommand> cleanupCommands;  // after renderPass
         };
         DKObject<Encoder> encoder;
 
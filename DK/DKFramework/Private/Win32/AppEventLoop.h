@@ -24,6 +24,7 @@ namespace DKFramework::Private::Win32
 
         DKObject<PendingState> Post(const DKOperation* operation, double delay) override;
         DKObject<PendingState> Post(const DKOperation* operation, const DKDateTime& runAfter) override;
+        using DKEventLoop::Post;
 
     private:
         DKApplication* appInstance;